@@ -12,7 +12,7 @@ import { Console } from './components/Console';
 import { useSocket } from './hooks/useSocket';
 
 import { useEditorStore } from './stores/useEditorStore';
-import type { EditorState } from './stores/useEditorStore';
+import type { EditorState, FileNode } from './stores/useEditorStore';
 import { getLanguageFromExtension, flattenTree, isLanguageSupported, isDataFile } from './lib/file-utils';
 import { cn } from './lib/utils';
 
@@ -31,8 +31,33 @@ function LoadingSpinner() {
   );
 }
 
+// Idle time after the last edit before cpp/java sources are compiled in the background
+const BUILD_DEBOUNCE_MS = 1500;
+
+// Files sent with a run: sources of the entry file's language plus data files
+function collectRunFiles(files: Record<string, FileNode>, rootIds: string[], activeFileId: string, activeLanguage: string) {
+  return flattenTree(files, rootIds)
+    .filter(f => {
+      // Include source files of the same language
+      if (getLanguageFromExtension(f.name) === activeLanguage) {
+        return true;
+      }
+      // Always include data files
+      if (isDataFile(f.name)) {
+        return true;
+      }
+      return false;
+    })
+    .map(f => ({
+      name: f.name,
+      path: f.path,
+      content: f.content,
+      toBeExec: f.id === activeFileId,
+    }));
+}
+
 function EditorPage() {
-  const { runCode, stopCode, disconnect } = useSocket();
+  const { runCode, requestBuild, stopCode, disconnect } = useSocket();
   const files = useEditorStore((state: EditorState) => state.files);
   const rootIds = useEditorStore((state: EditorState) => state.rootIds);
   const activeFileId = useEditorStore((state: EditorState) => state.activeFileId);
@@ -101,31 +126,31 @@ function EditorPage() {
     if (!activeLanguage || !isLanguageSupported(activeLanguage)) return;
 
     // Get all files and filter to compatible ones (same language OR data files)
-    const allFiles = flattenTree(files, rootIds);
-    const compatibleFiles = allFiles
-      .filter(f => {
-        // Include source files of the same language
-        if (getLanguageFromExtension(f.name) === activeLanguage) {
-          return true;
-        }
-        // Always include data files
-        if (isDataFile(f.name)) {
-          return true;
-        }
-        return false;
-      })
-      .map(f => ({
-        name: f.name,
-        path: f.path,
-        content: f.content,
-        toBeExec: f.id === activeFileId,
-      }));
+    const compatibleFiles = collectRunFiles(files, rootIds, activeFileId!, activeLanguage);
 
     if (compatibleFiles.length > 0 && activeFileId) {
       runCode(activeFileId, activeFile.path, compatibleFiles, activeLanguage);
     }
   }, [activeFileId, files, rootIds, runCode]);
 
+  // Speculative build: once edits (or a save) settle, compile cpp/java sources in
+  // the background so compile errors show early and Run only has to execute.
+  // The server ignores sources it has already built
+  useEffect(() => {
+    const activeFile = activeFileId ? files[activeFileId] : null;
+    if (!activeFileId || !activeFile) return;
+    const activeLanguage = getLanguageFromExtension(activeFile.name);
+    if (activeLanguage !== 'cpp' && activeLanguage !== 'java') return;
+
+    const timer = setTimeout(() => {
+      const buildFiles = collectRunFiles(files, rootIds, activeFileId, activeLanguage);
+      if (buildFiles.length > 0) {
+        requestBuild(buildFiles, activeLanguage);
+      }
+    }, BUILD_DEBOUNCE_MS);
+    return () => clearTimeout(timer);
+  }, [activeFileId, files, rootIds, requestBuild]);
+
   // Handle stop button click
   const handleStopClick = useCallback(() => {
     if (activeFileId) {
@@ -39,9 +39,11 @@ export function CodeEditor({ onRunClick, onStopClick }: CodeEditorProps) {
   const closeTab = useEditorStore((state: EditorState) => state.closeTab);
   const updateContent = useEditorStore((state: EditorState) => state.updateContent);
   const markAsSaved = useEditorStore((state: EditorState) => state.markAsSaved);
+  const buildResult = useEditorStore((state: EditorState) => state.buildResult);
 
   // Reference to Monaco editor instance
   const editorRef = useRef<editor.IStandaloneCodeEditor | null>(null);
+  const monacoRef = useRef<Monaco | null>(null);
 
   const activeFile = activeFileId ? files[activeFileId] : null;
   const activeConsole = activeFileId ? consoles[activeFileId] : null;
@@ -67,6 +69,7 @@ export function CodeEditor({ onRunClick, onStopClick }: CodeEditorProps) {
   }
 
   const handleEditorWillMount = useCallback((monaco: Monaco) => {
+    monacoRef.current = monaco;
     // Ensure all necessary languages are registered and available
     // This fixes issues with language support like Java syntax highlighting
     const languages = ['java', 'python', 'javascript', 'cpp', 'c'];
@@ -110,6 +113,27 @@ export function CodeEditor({ onRunClick, onStopClick }: CodeEditorProps) {
 
   }, [activeFile, execLanguage, isRunning, handleRunClick]);
 
+  // Compile errors of the latest background build, shown as markers in the open file
+  const activeFilePath = activeFile?.path;
+  useEffect(() => {
+    const monaco = monacoRef.current;
+    const model = editorRef.current?.getModel();
+    if (!monaco || !model) return;
+
+    const diagnostics = buildResult?.diagnostics.filter(d => d.path === activeFilePath) ?? [];
+    monaco.editor.setModelMarkers(model, 'coderunner-build', diagnostics.map(d => {
+      const line = Math.min(d.line, model.getLineCount());
+      return {
+        severity: d.severity === 'error' ? monaco.MarkerSeverity.Error : monaco.MarkerSeverity.Warning,
+        message: d.message,
+        startLineNumber: line,
+        startColumn: d.column,
+        endLineNumber: line,
+        endColumn: model.getLineMaxColumn(line),
+      };
+    }));
+  }, [buildResult, activeFilePath]);
+
   // Cleanup editor reference on unmount
   useEffect(() => {
     return () => {
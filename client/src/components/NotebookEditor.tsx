@@ -61,7 +61,7 @@ export function NotebookEditor({
     getCellExecution,
     initCellExecution,
     clearCellOutputs,
-  } = useNotebookKernel(fileId);
+  } = useNotebookKernel(fileId, language);
 
   // Initialize cell execution state for all cells
   useEffect(() => {
@@ -1,6 +1,7 @@
 /**
  * Admin Dashboard – Load Tests Tab
- * Browse past load test reports, view details with charts, delete reports
+ * Browse past load test reports, view details with charts, delete reports.
+ * Also shows the latest regression suite runs against their baseline.
  */
 
 import { useState, useEffect, useCallback } from 'react';
@@ -10,7 +11,7 @@ import { Button } from '../ui/button';
 import {
   BarChart, Bar, XAxis, YAxis, CartesianGrid, Tooltip, ResponsiveContainer,
 } from 'recharts';
-import { Trash2, ChevronDown, ChevronUp, RefreshCw, FileBarChart, Clock, Zap, Activity } from 'lucide-react';
+import { Trash2, ChevronDown, ChevronUp, RefreshCw, FileBarChart, Clock, Zap, Activity, GitCompare } from 'lucide-react';
 
 interface ReportSummary {
   id: string;
@@ -35,6 +36,51 @@ interface ReportSummary {
   };
 }
 
+interface RegressionRunSummary {
+  id: string;
+  date: string;
+  languages: string[];
+  scenarios: string[];
+  baselineVersion: number | null;
+  passed: boolean | null;
+  regressed: number;
+}
+
+interface ComparisonRow {
+  language: string;
+  scenario: string;
+  stage: string;
+  baselineP95: number | null;
+  currentP95: number | null;
+  deltaMs: number | null;
+  deltaPct: number | null;
+  status: 'unchanged' | 'regressed' | 'improved' | 'new' | 'missing';
+}
+
+interface RegressionRun {
+  id: string;
+  samples: number;
+  results: Record<string, Record<string, { samples: number; errors: number; mismatches: number }>>;
+  comparison: {
+    baselineVersion: number;
+    thresholdPct: number;
+    minDeltaMs: number;
+    regressed: number;
+    missing: number;
+    improved: number;
+    passed: boolean;
+    rows: ComparisonRow[];
+  } | null;
+}
+
+const STATUS_CLASSES: Record<ComparisonRow['status'], string> = {
+  regressed: 'text-red-600',
+  missing: 'text-orange-600',
+  improved: 'text-emerald-600',
+  new: 'text-muted-foreground',
+  unchanged: 'text-muted-foreground',
+};
+
 interface LoadTestsTabProps {
   adminKey: string;
 }
@@ -73,6 +119,39 @@ export function LoadTestsTab({ adminKey }: LoadTestsTabProps) {
 
   useEffect(() => { fetchReports(); }, [fetchReports]);
 
+  const [regressionRuns, setRegressionRuns] = useState<RegressionRunSummary[]>([]);
+  const [regressionRun, setRegressionRun] = useState<RegressionRun | null>(null);
+  const [showAllStages, setShowAllStages] = useState(false);
+
+  const fetchRegressionRun = useCallback(async (id: string) => {
+    try {
+      const res = await fetch(`/admin/regression-runs/${id}`, { headers: { 'X-Admin-Key': adminKey } });
+      if (res.ok) {
+        setRegressionRun(await res.json());
+      }
+    } catch { /* ignore */ }
+  }, [adminKey]);
+
+  const fetchRegressionRuns = useCallback(async () => {
+    if (!adminKey) return;
+    try {
+      const res = await fetch('/admin/regression-runs', { headers: { 'X-Admin-Key': adminKey } });
+      if (res.ok) {
+        const data = await res.json();
+        const runs: RegressionRunSummary[] = Array.isArray(data) ? [...data].reverse() : [];
+        setRegressionRuns(runs);
+        if (runs.length > 0) fetchRegressionRun(runs[0].id);
+      }
+    } catch { /* ignore */ }
+  }, [adminKey, fetchRegressionRun]);
+
+  useEffect(() => { fetchRegressionRuns(); }, [fetchRegressionRuns]);
+
+  const handleRefresh = () => {
+    fetchReports();
+    fetchRegressionRuns();
+  };
+
   const handleExpand = async (id: string) => {
     if (expandedId === id) {
       setExpandedId(null);
@@ -137,12 +216,104 @@ export function LoadTestsTab({ adminKey }: LoadTestsTabProps) {
           <h3 className="text-lg font-semibold">Load Test Reports</h3>
           <p className="text-sm text-muted-foreground">Browse and analyze past load test results</p>
         </div>
-        <Button variant="outline" size="sm" onClick={fetchReports} disabled={loading}>
+        <Button variant="outline" size="sm" onClick={handleRefresh} disabled={loading}>
           <RefreshCw className={`h-3.5 w-3.5 mr-2 ${loading ? 'animate-spin' : ''}`} />
           Refresh
         </Button>
       </div>
 
+      {/* Regression Suite vs Baseline */}
+      {regressionRuns.length > 0 && (
+        <Card className="shadow-sm">
+          <CardContent className="py-4 space-y-3">
+            <div className="flex items-center gap-3">
+              <GitCompare className="h-4 w-4 text-muted-foreground" />
+              <div className="flex-1">
+                <div className="text-sm font-medium">Regression Suite</div>
+                <div className="text-xs text-muted-foreground">
+                  {regressionRun?.comparison
+                    ? `p95 per language, scenario and stage vs baseline v${regressionRun.comparison.baselineVersion} ` +
+                      `(threshold +${regressionRun.comparison.thresholdPct}% and +${regressionRun.comparison.minDeltaMs}ms)`
+                    : 'No baseline to compare against'}
+                </div>
+              </div>
+              {regressionRun?.comparison && (
+                <Badge variant={regressionRun.comparison.passed ? 'secondary' : 'destructive'} className="text-[10px]">
+                  {regressionRun.comparison.passed
+                    ? 'Passed'
+                    : `${regressionRun.comparison.regressed} regressed, ${regressionRun.comparison.missing} missing`}
+                </Badge>
+              )}
+              <select
+                value={regressionRun?.id ?? ''}
+                onChange={e => fetchRegressionRun(e.target.value)}
+                className="px-3 py-1.5 rounded-md text-xs border border-border bg-card text-foreground"
+              >
+                {regressionRuns.map(run => (
+                  <option key={run.id} value={run.id}>
+                    {new Date(run.date).toLocaleString()}{run.passed === false ? ' ✗' : ''}
+                  </option>
+                ))}
+              </select>
+            </div>
+
+            {regressionRun?.comparison && (
+              <>
+                <div className="overflow-x-auto">
+                  <table className="w-full text-xs">
+                    <thead>
+                      <tr className="text-muted-foreground border-b">
+                        <th className="text-left py-2 px-2">Language</th>
+                        <th className="text-left py-2 px-2">Scenario</th>
+                        <th className="text-left py-2 px-2">Stage</th>
+                        <th className="text-right py-2 px-2">Baseline P95</th>
+                        <th className="text-right py-2 px-2">P95</th>
+                        <th className="text-right py-2 px-2">Delta</th>
+                        <th className="text-left py-2 px-2">Status</th>
+                      </tr>
+                    </thead>
+                    <tbody>
+                      {regressionRun.comparison.rows
+                        .filter(row => showAllStages || row.status !== 'unchanged' || row.stage === 'totalMs')
+                        .map(row => (
+                          <tr key={`${row.language}/${row.scenario}/${row.stage}`} className="border-b border-border/50 hover:bg-muted/30">
+                            <td className="py-1.5 px-2 capitalize">{row.language}</td>
+                            <td className="py-1.5 px-2">{row.scenario}</td>
+                            <td className="py-1.5 px-2 font-mono">{row.stage}</td>
+                            <td className="py-1.5 px-2 text-right font-mono">{row.baselineP95 ?? '—'}{row.baselineP95 !== null && 'ms'}</td>
+                            <td className="py-1.5 px-2 text-right font-mono">{row.currentP95 ?? '—'}{row.currentP95 !== null && 'ms'}</td>
+                            <td className={`py-1.5 px-2 text-right font-mono ${STATUS_CLASSES[row.status]}`}>
+                              {row.deltaMs === null ? '—' : `${row.deltaMs > 0 ? '+' : ''}${row.deltaMs}ms`}
+                              {row.deltaPct !== null && ` (${row.deltaPct > 0 ? '+' : ''}${row.deltaPct}%)`}
+                            </td>
+                            <td className={`py-1.5 px-2 capitalize ${STATUS_CLASSES[row.status]}`}>{row.status}</td>
+                          </tr>
+                        ))}
+                    </tbody>
+                  </table>
+                </div>
+                <button
+                  onClick={() => setShowAllStages(v => !v)}
+                  className="text-[10px] text-muted-foreground hover:text-foreground"
+                >
+                  {showAllStages ? 'Show changes and totals only' : 'Show all stages'}
+                </button>
+              </>
+            )}
+
+            {regressionRun && Object.entries(regressionRun.results).flatMap(([lang, byScenario]) =>
+              Object.entries(byScenario)
+                .filter(([, r]) => r.errors > 0 || r.mismatches > 0)
+                .map(([scenario, r]) => (
+                  <div key={`${lang}/${scenario}`} className="text-[10px] text-orange-600">
+                    {lang}/{scenario}: {r.errors} failed run(s), {r.mismatches} run(s) outside the scenario
+                  </div>
+                ))
+            )}
+          </CardContent>
+        </Card>
+      )}
+
       {reports.length === 0 ? (
         <Card className="shadow-sm">
           <CardContent className="py-16 text-center">
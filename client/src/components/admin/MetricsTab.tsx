@@ -34,7 +34,10 @@ interface PipelineData {
     fileTransferMs: number;
     executionMs: number;
     cleanupMs: number;
+    compileMs?: number;
+    runMs?: number;
     containerReused: boolean;
+    dominantPhase?: string;
   }[];
 }
 
@@ -329,6 +332,7 @@ export function MetricsTab({ adminKey, dailyMetrics }: MetricsTabProps) {
                     <th className="text-right py-2 px-2">Cleanup</th>
                     <th className="text-right py-2 px-2 font-bold">Total</th>
                     <th className="text-center py-2 px-2">Reused</th>
+                    <th className="text-left py-2 px-2">Dominant</th>
                   </tr>
                 </thead>
                 <tbody>
@@ -339,7 +343,12 @@ export function MetricsTab({ adminKey, dailyMetrics }: MetricsTabProps) {
                       <td className="py-1.5 px-2 text-right font-mono">{exec.networkMs}ms</td>
                       <td className="py-1.5 px-2 text-right font-mono">{exec.containerMs}ms</td>
                       <td className="py-1.5 px-2 text-right font-mono">{exec.fileTransferMs}ms</td>
-                      <td className="py-1.5 px-2 text-right font-mono">{exec.executionMs}ms</td>
+                      <td className="py-1.5 px-2 text-right font-mono">
+                        {exec.executionMs}ms
+                        {exec.compileMs !== undefined && (
+                          <span className="text-muted-foreground"> ({exec.compileMs}+{exec.runMs ?? 0})</span>
+                        )}
+                      </td>
                       <td className="py-1.5 px-2 text-right font-mono">{exec.cleanupMs}ms</td>
                       <td className="py-1.5 px-2 text-right font-mono font-bold text-orange-500">{exec.totalMs}ms</td>
                       <td className="py-1.5 px-2 text-center">
@@ -347,6 +356,7 @@ export function MetricsTab({ adminKey, dailyMetrics }: MetricsTabProps) {
                           {exec.containerReused ? 'Yes' : 'No'}
                         </Badge>
                       </td>
+                      <td className="py-1.5 px-2">{exec.dominantPhase ?? '—'}</td>
                     </tr>
                   ))}
                 </tbody>
@@ -26,8 +26,9 @@ export interface CellExecution {
 /**
  * Hook for managing notebook kernel communication
  * Independent from the regular console execution system
+ * `language` is the notebook's metadata language (e.g. "python", "c++")
  */
-export function useNotebookKernel(notebookId: string) {
+export function useNotebookKernel(notebookId: string, language: string = 'python') {
   const [kernelId, setKernelId] = useState<string | null>(null);
   const [kernelStatus, setKernelStatus] = useState<KernelStatus>('disconnected');
   const [cellExecutions, setCellExecutions] = useState<Map<string, CellExecution>>(new Map());
@@ -73,8 +74,8 @@ export function useNotebookKernel(notebookId: string) {
     const sock = getSocket() || connectSocket();
     setKernelStatus('starting');
     setError(null);
-    sock.emit('kernel:start', { notebookId, language: 'python' });
-  }, [notebookId, kernelStatus]);
+    sock.emit('kernel:start', { notebookId, language });
+  }, [notebookId, language, kernelStatus]);
 
   // Execute cell
   const executeCell = useCallback((cellId: string, code: string) => {
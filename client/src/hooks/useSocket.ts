@@ -53,6 +53,15 @@ export const useSocket = () => {
     []
   );
 
+  // Compile in the background so a later Run only executes (cpp/java; results
+  // arrive as 'build:result'). Skipped while disconnected: it is only a head start
+  const requestBuild = useCallback((files: ExecutionFile[], language: string) => {
+    const socket = getSocket();
+    if (socket?.connected) {
+      socket.emit('build', { language, files });
+    }
+  }, []);
+
   const sendInput = useCallback((input: string) => {
     const socket = getSocket();
     if (socket?.connected) {
@@ -82,6 +91,7 @@ export const useSocket = () => {
 
   return {
     runCode,
+    requestBuild,
     sendInput,
     stopCode,
     disconnect,
@@ -0,0 +1,39 @@
+import { describe, it, expect } from 'vitest';
+import { parseBuildDiagnostics } from './build-diagnostics';
+
+describe('parseBuildDiagnostics', () => {
+  it('should parse gcc errors and warnings with columns', () => {
+    const output = [
+      "main.cpp: In function 'int main()':",
+      "main.cpp:5:3: error: expected ';' before 'return'",
+      'lib/util.h:2:10: fatal error: missing.h: No such file or directory',
+      "main.cpp:3:7: warning: unused variable 'x' [-Wunused-variable]",
+      '    5 |   return 0;',
+    ].join('\n');
+
+    expect(parseBuildDiagnostics(output)).toEqual([
+      { path: 'main.cpp', line: 5, column: 3, severity: 'error', message: "expected ';' before 'return'" },
+      { path: 'lib/util.h', line: 2, column: 10, severity: 'error', message: 'missing.h: No such file or directory' },
+      { path: 'main.cpp', line: 3, column: 7, severity: 'warning', message: "unused variable 'x' [-Wunused-variable]" },
+    ]);
+  });
+
+  it('should parse javac errors from both the daemon and the cold path', () => {
+    const output = [
+      "/app/Main.java:3: error: ';' expected",
+      '        int x = 1',
+      '                 ^',
+      './src/Util.java:7: error: cannot find symbol',
+      '1 error',
+    ].join('\n');
+
+    expect(parseBuildDiagnostics(output)).toEqual([
+      { path: 'Main.java', line: 3, column: 1, severity: 'error', message: "';' expected" },
+      { path: 'src/Util.java', line: 7, column: 1, severity: 'error', message: 'cannot find symbol' },
+    ]);
+  });
+
+  it('should return nothing for clean builds', () => {
+    expect(parseBuildDiagnostics('')).toEqual([]);
+  });
+});
@@ -0,0 +1,49 @@
+/**
+ * Compiler diagnostics from speculative builds.
+ *
+ * The server compiles cpp/java sources in the background and sends back the
+ * compiler's stderr (`build:result`). This module parses the gcc and javac
+ * diagnostic lines (`file:line[:col]: error: message`) so the editor can mark
+ * errors before the code is run.
+ */
+
+export interface BuildDiagnostic {
+  /** Path relative to the workspace root, as used in the editor */
+  path: string;
+  line: number;
+  /** 1-based column; javac reports none */
+  column: number;
+  severity: 'error' | 'warning';
+  message: string;
+}
+
+export interface BuildResult {
+  language: string;
+  status: 'ok' | 'error';
+  diagnostics: BuildDiagnostic[];
+  compileMs?: number;
+  receivedAt: number;
+}
+
+const DIAGNOSTIC_LINE = /^(.+?):(\d+):(?:(\d+):)?\s*(fatal error|error|warning):\s*(.*)$/;
+
+/** Strip the container's working directory (daemon builds report absolute paths) */
+function normalizePath(path: string): string {
+  return path.replace(/^\/app\//, '').replace(/^\.\//, '');
+}
+
+export function parseBuildDiagnostics(output: string): BuildDiagnostic[] {
+  const diagnostics: BuildDiagnostic[] = [];
+  for (const line of output.split('\n')) {
+    const match = DIAGNOSTIC_LINE.exec(line.trimEnd());
+    if (!match) continue;
+    diagnostics.push({
+      path: normalizePath(match[1]),
+      line: parseInt(match[2], 10),
+      column: match[3] ? parseInt(match[3], 10) : 1,
+      severity: match[4] === 'warning' ? 'warning' : 'error',
+      message: match[5],
+    });
+  }
+  return diagnostics;
+}
@@ -1,5 +1,6 @@
 import { io, Socket } from 'socket.io-client';
 import { useEditorStore } from '@/stores/useEditorStore';
+import { parseBuildDiagnostics } from '@/lib/build-diagnostics';
 
 // Dynamically determine server URL:
 // 1. Use VITE_SERVER_URL env var if set
@@ -30,6 +31,7 @@ const attachListeners = (sock: Socket) => {
   sock.off('output');
   sock.off('exit');
   sock.off('error');
+  sock.off('build:result');
 
   sock.on('output', (data: { sessionId: string; type: 'stdout' | 'stderr'; data: string }) => {
     const store = useEditorStore.getState();
@@ -54,6 +56,17 @@ const attachListeners = (sock: Socket) => {
     }
   });
 
+  // Background compile of the open cpp/java sources (see useSocket.requestBuild)
+  sock.on('build:result', (data: { language: string; status: 'ok' | 'error'; diagnostics: string; compileMs?: number }) => {
+    useEditorStore.getState().setBuildResult({
+      language: data.language,
+      status: data.status,
+      diagnostics: parseBuildDiagnostics(data.diagnostics),
+      compileMs: data.compileMs,
+      receivedAt: Date.now(),
+    });
+  });
+
   sock.on('error', (data: { sessionId?: string; message: string }) => {
     const store = useEditorStore.getState();
     if (data.sessionId) {
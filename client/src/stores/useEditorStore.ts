@@ -1,6 +1,7 @@
 import { create } from 'zustand';
 import { persist, createJSONStorage } from 'zustand/middleware';
 import { idbStorage } from '@/lib/idb-storage';
+import type { BuildResult } from '@/lib/build-diagnostics';
 
 // Constants for storage limits
 export const MAX_FILE_SIZE = 500 * 1024; // 500KB per file
@@ -65,6 +66,8 @@ export interface EditorState {
   consoles: Record<string, ConsoleState>; // fileId -> console state
   activeConsoleId: string | null;
   selectedFilesForRun: string[];
+  // Latest speculative build of the session (not persisted)
+  buildResult: BuildResult | null;
 
   // Actions - File management
   addFile: (name: string, parentId: string | null) => { success: boolean; error?: string; id?: string };
@@ -94,6 +97,9 @@ export interface EditorState {
   setConsoleExecutionTime: (fileId: string, time: number) => void;
   getConsoleByFileId: (fileId: string) => ConsoleState | undefined;
 
+  // Speculative builds
+  setBuildResult: (result: BuildResult | null) => void;
+
   // Utilities
   getFileById: (id: string) => FileNode | undefined;
   getAllFiles: () => FileNode[];
@@ -127,6 +133,7 @@ export const useEditorStore = create<EditorState>()(
       consoles: {},
       activeConsoleId: null,
       selectedFilesForRun: [],
+      buildResult: null,
 
       // File management actions
       addFile: (name: string, parentId: string | null) => {
@@ -558,6 +565,10 @@ export const useEditorStore = create<EditorState>()(
         });
       },
 
+      setBuildResult: (result: BuildResult | null) => {
+        set({ buildResult: result });
+      },
+
       setConsoleExecutionTime: (fileId: string, time: number) => {
         set(state => {
           const console = state.consoles[fileId];
@@ -0,0 +1,647 @@
+/*
+ * cr-agent: execution agent for session containers (EXEC_AGENT, default on).
+ * Used by the server's agent transport (server/src/agent.ts).
+ *
+ * Usage: cr-agent [command [args...]]
+ *
+ * Runs as the container's main process. The server attaches to the container
+ * once and speaks a framed protocol over the agent's stdin/stdout, so runs,
+ * file uploads and reads no longer go through Docker exec/archive calls. The
+ * optional command (e.g. a resident compile service) is started as a child and
+ * stopped with the agent; without one the agent just idles like `tail -f`.
+ *
+ * Frame: type (1 byte) | channel (u32 BE) | length (u32 BE) | payload
+ *
+ * Server -> agent
+ *   'H' hello                  -> 'h' protocol version
+ *   'X' exec   cwd\0command\0[NAME=value\0...]
+ *   'I' stdin data for the channel; empty payload closes stdin
+ *   'K' signal (1 byte) to the channel's process group
+ *   'P' pause / 'R' resume reading the channel's output
+ *   'F' put    dir\0 then per file: pathlen u32 | mode u32 | size u32 | path | data
+ *   'G' get    path             -> 'r' status byte (0 = ok) + content
+ *
+ * Agent -> server
+ *   'o' / 'e'  stdout / stderr data
+ *   'x' exit   "<code> <user_us> <sys_us> <maxrss_kb> <wall_us>"
+ *   'r' reply  status byte (0 = ok) followed by data or an error message
+ *
+ * Exit codes follow the shell: 128 + signal for signalled processes. Output a
+ * process wrote before exiting is always sent ahead of its exit frame.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PROTOCOL_VERSION "cr-agent 1"
+#define MAX_EXECS 64
+#define MAX_FRAME (64u * 1024u * 1024u)
+#define READ_CHUNK 65536
+
+struct buffer {
+    char *data;
+    size_t len;
+    size_t cap;
+};
+
+struct exec {
+    int used;
+    uint32_t channel;
+    pid_t pid;
+    int out_fd;
+    int err_fd;
+    int in_fd;
+    int in_closing; /* close stdin once `input` is drained */
+    int paused;
+    int exited;
+    int status;
+    struct rusage usage;
+    long long started_us;
+    long long ended_us;
+    struct buffer input;
+};
+
+static struct exec execs[MAX_EXECS];
+static struct buffer inbox;
+static int stdin_open = 1;
+static pid_t child_pid = -1;
+static int sigchld_pipe[2];
+static volatile sig_atomic_t terminating;
+
+static long long now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static long timeval_us(struct timeval tv)
+{
+    return (long)tv.tv_sec * 1000000L + tv.tv_usec;
+}
+
+static void buffer_append(struct buffer *b, const char *data, size_t len)
+{
+    if (b->len + len > b->cap) {
+        size_t cap = b->cap ? b->cap : 4096;
+        while (cap < b->len + len) cap *= 2;
+        char *grown = realloc(b->data, cap);
+        if (!grown) {
+            fprintf(stderr, "cr-agent: out of memory\n");
+            exit(1);
+        }
+        b->data = grown;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+}
+
+static void buffer_consume(struct buffer *b, size_t len)
+{
+    memmove(b->data, b->data + len, b->len - len);
+    b->len -= len;
+}
+
+static void buffer_free(struct buffer *b)
+{
+    free(b->data);
+    b->data = NULL;
+    b->len = b->cap = 0;
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void write_all(int fd, const void *data, size_t len)
+{
+    const char *p = data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            /* The server detached; keep running so it can re-attach */
+            return;
+        }
+        p += n;
+        len -= n;
+    }
+}
+
+static void send_frame(char type, uint32_t channel, const void *payload, size_t len)
+{
+    unsigned char header[9];
+    header[0] = type;
+    put_u32(header + 1, channel);
+    put_u32(header + 5, len);
+    write_all(STDOUT_FILENO, header, sizeof header);
+    if (len) write_all(STDOUT_FILENO, payload, len);
+}
+
+static void send_reply(uint32_t channel, int ok, const char *data, size_t len)
+{
+    char *payload = malloc(len + 1);
+    if (!payload) return;
+    payload[0] = ok ? 0 : 1;
+    if (len) memcpy(payload + 1, data, len);
+    send_frame('r', channel, payload, len + 1);
+    free(payload);
+}
+
+static void send_error(uint32_t channel, const char *what, const char *path)
+{
+    char message[512];
+    int n = snprintf(message, sizeof message, "%s %s: %s", what, path, strerror(errno));
+    send_reply(channel, 0, message, n < 0 ? 0 : (size_t)n);
+}
+
+static struct exec *find_exec(uint32_t channel)
+{
+    for (int i = 0; i < MAX_EXECS; i++) {
+        if (execs[i].used && execs[i].channel == channel) return &execs[i];
+    }
+    return NULL;
+}
+
+static void close_fd(int *fd)
+{
+    if (*fd >= 0) {
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+/* Forward whatever the pipe holds; returns 0 once the pipe reached EOF */
+static int relay_output(struct exec *e, int *fd, char type)
+{
+    char chunk[READ_CHUNK];
+    for (;;) {
+        ssize_t n = read(*fd, chunk, sizeof chunk);
+        if (n > 0) {
+            send_frame(type, e->channel, chunk, n);
+            if (!e->exited) return 1; /* one chunk per poll round keeps channels fair */
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) return 1;
+        close_fd(fd);
+        return 0;
+    }
+}
+
+static void finish_exec(struct exec *e)
+{
+    int code;
+    if (WIFEXITED(e->status)) code = WEXITSTATUS(e->status);
+    else if (WIFSIGNALED(e->status)) code = 128 + WTERMSIG(e->status);
+    else code = 1;
+
+    /* Output written before the exit is in the pipes; late writes from
+     * background processes are dropped, as Docker does for exec streams */
+    if (e->out_fd >= 0) relay_output(e, &e->out_fd, 'o');
+    if (e->err_fd >= 0) relay_output(e, &e->err_fd, 'e');
+    close_fd(&e->out_fd);
+    close_fd(&e->err_fd);
+    close_fd(&e->in_fd);
+
+    char report[128];
+    int n = snprintf(report, sizeof report, "%d %ld %ld %ld %lld", code,
+                     timeval_us(e->usage.ru_utime), timeval_us(e->usage.ru_stime),
+                     e->usage.ru_maxrss, e->ended_us - e->started_us);
+    send_frame('x', e->channel, report, n);
+
+    buffer_free(&e->input);
+    memset(e, 0, sizeof *e);
+}
+
+static void start_exec(uint32_t channel, char *payload, size_t len)
+{
+    char *end = payload + len;
+    char *cwd = payload;
+    char *cwd_end = memchr(cwd, '\0', len);
+    char *command = cwd_end ? cwd_end + 1 : NULL;
+    char *command_end = command && command < end ? memchr(command, '\0', end - command) : NULL;
+    if (!command_end) {
+        send_frame('x', channel, "127 0 0 0 0", 11);
+        return;
+    }
+
+    struct exec *e = NULL;
+    for (int i = 0; i < MAX_EXECS; i++) {
+        if (!execs[i].used) {
+            e = &execs[i];
+            break;
+        }
+    }
+    int in[2], out[2], err[2];
+    if (!e || find_exec(channel) || pipe2(in, O_CLOEXEC) < 0) {
+        send_frame('x', channel, "126 0 0 0 0", 11);
+        return;
+    }
+    if (pipe2(out, O_CLOEXEC) < 0) {
+        close(in[0]);
+        close(in[1]);
+        send_frame('x', channel, "126 0 0 0 0", 11);
+        return;
+    }
+    if (pipe2(err, O_CLOEXEC) < 0) {
+        close(in[0]);
+        close(in[1]);
+        close(out[0]);
+        close(out[1]);
+        send_frame('x', channel, "126 0 0 0 0", 11);
+        return;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        /* Own process group so 'K' reaches everything the command started */
+        setpgid(0, 0);
+        signal(SIGPIPE, SIG_DFL);
+        signal(SIGCHLD, SIG_DFL);
+        dup2(in[0], STDIN_FILENO);
+        dup2(out[1], STDOUT_FILENO);
+        dup2(err[1], STDERR_FILENO);
+        for (char *var = command_end + 1; var < end; var += strlen(var) + 1) {
+            if (strchr(var, '=')) putenv(var);
+        }
+        if (chdir(cwd) < 0) {
+            fprintf(stderr, "cr-agent: %s: %s\n", cwd, strerror(errno));
+            _exit(126);
+        }
+        execl("/bin/sh", "sh", "-c", command, (char *)NULL);
+        _exit(127);
+    }
+
+    close(in[0]);
+    close(out[1]);
+    close(err[1]);
+    if (pid < 0) {
+        close(in[1]);
+        close(out[0]);
+        close(err[0]);
+        send_frame('x', channel, "126 0 0 0 0", 11);
+        return;
+    }
+    setpgid(pid, pid);
+
+    memset(e, 0, sizeof *e);
+    e->used = 1;
+    e->channel = channel;
+    e->pid = pid;
+    e->in_fd = in[1];
+    e->out_fd = out[0];
+    e->err_fd = err[0];
+    e->started_us = now_us();
+    fcntl(e->in_fd, F_SETFL, O_NONBLOCK);
+    fcntl(e->out_fd, F_SETFL, O_NONBLOCK);
+    fcntl(e->err_fd, F_SETFL, O_NONBLOCK);
+}
+
+static void flush_input(struct exec *e)
+{
+    while (e->in_fd >= 0 && e->input.len > 0) {
+        ssize_t n = write(e->in_fd, e->input.data, e->input.len);
+        if (n > 0) {
+            buffer_consume(&e->input, n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) return;
+        /* The process closed its stdin */
+        close_fd(&e->in_fd);
+        e->input.len = 0;
+    }
+    if (e->in_closing && e->input.len == 0) close_fd(&e->in_fd);
+}
+
+static int make_parents(char *path)
+{
+    for (char *p = path + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        int rc = mkdir(path, 0755);
+        *p = '/';
+        if (rc < 0 && errno != EEXIST) return -1;
+    }
+    return 0;
+}
+
+static int write_file(const char *path, uint32_t mode, const char *data, size_t len)
+{
+    char tmp[4200];
+    snprintf(tmp, sizeof tmp, "%s.cr-agent-%d", path, (int)getpid());
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode ? mode : 0644);
+    if (fd < 0) return -1;
+    fchmod(fd, mode ? mode : 0644);
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = write(fd, data + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            close(fd);
+            unlink(tmp);
+            return -1;
+        }
+        done += n;
+    }
+    close(fd);
+    /* Rename so a concurrently running program never sees a half-written file */
+    if (rename(tmp, path) < 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+static void put_files(uint32_t channel, char *payload, size_t len)
+{
+    char *dir_end = memchr(payload, '\0', len);
+    if (!dir_end) {
+        send_reply(channel, 0, "malformed put", 13);
+        return;
+    }
+    const char *dir = payload;
+    size_t pos = dir_end - payload + 1;
+
+    while (pos < len) {
+        if (len - pos < 12) {
+            send_reply(channel, 0, "malformed put", 13);
+            return;
+        }
+        uint32_t path_len = get_u32((unsigned char *)payload + pos);
+        uint32_t mode = get_u32((unsigned char *)payload + pos + 4);
+        uint32_t size = get_u32((unsigned char *)payload + pos + 8);
+        pos += 12;
+        if (path_len == 0 || path_len > 4000 || (size_t)path_len + size > len - pos) {
+            send_reply(channel, 0, "malformed put", 13);
+            return;
+        }
+
+        char path[4100];
+        snprintf(path, sizeof path, "%s/%.*s", dir, (int)path_len, payload + pos);
+        if (make_parents(path) < 0 || write_file(path, mode & 07777, payload + pos + path_len, size) < 0) {
+            send_error(channel, "put", path);
+            return;
+        }
+        pos += path_len + size;
+    }
+    send_reply(channel, 1, NULL, 0);
+}
+
+static void get_file(uint32_t channel, const char *payload, size_t len)
+{
+    char path[4100];
+    snprintf(path, sizeof path, "%.*s", (int)(len < 4096 ? len : 4096), payload);
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || (uint64_t)st.st_size >= MAX_FRAME) {
+        if (fd >= 0) close(fd);
+        send_reply(channel, 0, NULL, 0);
+        return;
+    }
+
+    char *content = malloc(st.st_size + 1);
+    size_t done = 0;
+    while (content && done < (size_t)st.st_size) {
+        ssize_t n = read(fd, content + 1 + done, st.st_size - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += n;
+    }
+    close(fd);
+    if (!content) {
+        send_reply(channel, 0, NULL, 0);
+        return;
+    }
+    content[0] = 0;
+    send_frame('r', channel, content, done + 1);
+    free(content);
+}
+
+static void handle_frame(char type, uint32_t channel, char *payload, size_t len)
+{
+    struct exec *e;
+    switch (type) {
+    case 'H':
+        send_frame('h', channel, PROTOCOL_VERSION, strlen(PROTOCOL_VERSION));
+        break;
+    case 'X':
+        start_exec(channel, payload, len);
+        break;
+    case 'I':
+        if (!(e = find_exec(channel)) || e->in_fd < 0) break;
+        if (len == 0) e->in_closing = 1;
+        else buffer_append(&e->input, payload, len);
+        flush_input(e);
+        break;
+    case 'K':
+        if ((e = find_exec(channel)) && !e->exited) {
+            kill(-e->pid, len ? (unsigned char)payload[0] : SIGKILL);
+        }
+        break;
+    case 'P':
+        if ((e = find_exec(channel))) e->paused = 1;
+        break;
+    case 'R':
+        if ((e = find_exec(channel))) e->paused = 0;
+        break;
+    case 'F':
+        put_files(channel, payload, len);
+        break;
+    case 'G':
+        get_file(channel, payload, len);
+        break;
+    default:
+        fprintf(stderr, "cr-agent: unknown frame type 0x%02x\n", (unsigned char)type);
+    }
+}
+
+static void read_server(void)
+{
+    char chunk[READ_CHUNK];
+    ssize_t n = read(STDIN_FILENO, chunk, sizeof chunk);
+    if (n < 0 && (errno == EINTR || errno == EAGAIN)) return;
+    if (n <= 0) {
+        /* Detached: runs already started finish on their own */
+        stdin_open = 0;
+        return;
+    }
+    buffer_append(&inbox, chunk, n);
+
+    while (inbox.len >= 9) {
+        uint32_t len = get_u32((unsigned char *)inbox.data + 5);
+        if (len > MAX_FRAME) {
+            fprintf(stderr, "cr-agent: frame of %u bytes rejected\n", len);
+            stdin_open = 0;
+            return;
+        }
+        if (inbox.len < 9 + (size_t)len) break;
+        handle_frame(inbox.data[0], get_u32((unsigned char *)inbox.data + 1), inbox.data + 9, len);
+        buffer_consume(&inbox, 9 + len);
+    }
+}
+
+static void reap(void)
+{
+    char drain[64];
+    while (read(sigchld_pipe[0], drain, sizeof drain) > 0) {
+    }
+
+    for (;;) {
+        int status;
+        struct rusage usage;
+        pid_t pid = wait4(-1, &status, WNOHANG, &usage);
+        if (pid <= 0) break;
+        if (pid == child_pid) {
+            child_pid = -1;
+            continue;
+        }
+        for (int i = 0; i < MAX_EXECS; i++) {
+            if (execs[i].used && execs[i].pid == pid) {
+                execs[i].exited = 1;
+                execs[i].status = status;
+                execs[i].usage = usage;
+                execs[i].ended_us = now_us();
+                finish_exec(&execs[i]);
+                break;
+            }
+        }
+        /* Anything else is an orphan reparented to us (we are PID 1) */
+    }
+}
+
+static void on_sigchld(int sig)
+{
+    (void)sig;
+    int saved = errno;
+    write(sigchld_pipe[1], "c", 1);
+    errno = saved;
+}
+
+static void on_terminate(int sig)
+{
+    (void)sig;
+    terminating = 1;
+    write(sigchld_pipe[1], "t", 1);
+}
+
+int main(int argc, char **argv)
+{
+    if (pipe2(sigchld_pipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+        perror("pipe");
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sa.sa_handler = on_sigchld;
+    sigaction(SIGCHLD, &sa, NULL);
+    sa.sa_flags = SA_RESTART;
+    sa.sa_handler = on_terminate;
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (argc > 1) {
+        child_pid = fork();
+        if (child_pid == 0) {
+            signal(SIGPIPE, SIG_DFL);
+            int devnull = open("/dev/null", O_RDWR);
+            dup2(devnull, STDIN_FILENO);
+            dup2(STDERR_FILENO, STDOUT_FILENO); /* stdout carries frames */
+            execvp(argv[1], argv + 1);
+            perror(argv[1]);
+            _exit(127);
+        }
+    }
+
+    struct pollfd fds[1 + 1 + MAX_EXECS * 3];
+    struct exec *owners[1 + 1 + MAX_EXECS * 3];
+    char kinds[1 + 1 + MAX_EXECS * 3];
+
+    while (!terminating) {
+        int n = 0;
+        fds[n] = (struct pollfd){ .fd = sigchld_pipe[0], .events = POLLIN };
+        owners[n] = NULL;
+        kinds[n++] = 's';
+        if (stdin_open) {
+            fds[n] = (struct pollfd){ .fd = STDIN_FILENO, .events = POLLIN };
+            owners[n] = NULL;
+            kinds[n++] = 'i';
+        }
+        for (int i = 0; i < MAX_EXECS; i++) {
+            struct exec *e = &execs[i];
+            if (!e->used) continue;
+            if (!e->paused && e->out_fd >= 0) {
+                fds[n] = (struct pollfd){ .fd = e->out_fd, .events = POLLIN };
+                owners[n] = e;
+                kinds[n++] = 'o';
+            }
+            if (!e->paused && e->err_fd >= 0) {
+                fds[n] = (struct pollfd){ .fd = e->err_fd, .events = POLLIN };
+                owners[n] = e;
+                kinds[n++] = 'e';
+            }
+            if (e->in_fd >= 0 && e->input.len > 0) {
+                fds[n] = (struct pollfd){ .fd = e->in_fd, .events = POLLOUT };
+                owners[n] = e;
+                kinds[n++] = 'w';
+            }
+        }
+
+        if (poll(fds, n, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            return 1;
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (!fds[i].revents) continue;
+            struct exec *e = owners[i];
+            /* An earlier entry may have finished this exec */
+            if (e && !e->used) continue;
+            switch (kinds[i]) {
+            case 's': reap(); break;
+            case 'i': read_server(); break;
+            case 'o': if (e->out_fd == fds[i].fd) relay_output(e, &e->out_fd, 'o'); break;
+            case 'e': if (e->err_fd == fds[i].fd) relay_output(e, &e->err_fd, 'e'); break;
+            case 'w': if (e->in_fd == fds[i].fd) flush_input(e); break;
+            }
+        }
+    }
+
+    for (int i = 0; i < MAX_EXECS; i++) {
+        if (execs[i].used) kill(-execs[i].pid, SIGKILL);
+    }
+    if (child_pid > 0) {
+        kill(child_pid, SIGTERM);
+        waitpid(child_pid, NULL, 0);
+    }
+    return 0;
+}
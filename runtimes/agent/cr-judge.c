@@ -0,0 +1,401 @@
+/*
+ * cr-judge: run one program against many test cases and judge each run.
+ * Used by the server's test-case run mode (server/src/testCases.ts).
+ *
+ * Usage: cr-judge [-d] [-o <output-bytes>] <cases-dir> <parallel> <program> [args...]
+ *
+ * <cases-dir>/manifest has one line per case, case i on line i (from 0):
+ *   <time_ms> <memory_kb> <compare>
+ * Case i reads <cases-dir>/<i>.in; with compare=1 its stdout is compared with
+ * <cases-dir>/<i>.exp line by line, ignoring trailing whitespace and trailing
+ * blank lines. stderr goes to <i>.err, which is cut to ERR_KEEP bytes afterwards
+ * so the server only ever reads a short preview.
+ *
+ * The judged program must not be able to see the answers or touch another
+ * case's output:
+ *   - every <i>.exp is read into memory and unlinked before the first case starts;
+ *   - stdout goes to an <i>.out that is unlinked right after it is opened, and
+ *     is compared through the judge's own descriptor;
+ *   - with CAP_SETUID/CAP_SETGID/CAP_KILL (file capabilities in the runtime
+ *     images), each running case gets its own uid, JUDGE_UID_BASE + its slot,
+ *     so cases can neither write the cases dir nor reach each other through
+ *     /proc. Without them the cases run as the judge's uid and only the first
+ *     two points hold.
+ *
+ * Up to <parallel> cases run at once, each in its own process group with:
+ *   - a wall-clock limit of time_ms (the group is killed) and RLIMIT_CPU;
+ *   - RLIMIT_FSIZE of <output-bytes> (-o, default 16 MiB);
+ *   - with -d, RLIMIT_DATA of memory_kb (native programs only: VMs reserve
+ *     far more address space than they use). Peak RSS is judged for all.
+ *
+ * Writes <cases-dir>/results, one line per case in case order:
+ *   <verdict> <wall_us> <cpu_us> <maxrss_kb> <exit_code> <signal>
+ */
+
+#include <fcntl.h>
+#include <grp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_CASES 1024
+#define ERR_KEEP 1024
+#define POLL_NS 1000000L
+#define JUDGE_UID_BASE 20000
+
+struct test_case {
+    long time_ms;
+    long memory_kb;
+    int compare;
+    pid_t pid;
+    long long started_ns;
+    int timed_out;
+    int done;
+    const char *verdict;
+    long long wall_us;
+    long cpu_us;
+    long maxrss_kb;
+    int exit_code;
+    int signal;
+    char *expected;
+    size_t expected_len;
+    int out_fd;
+    int slot;
+};
+
+static struct test_case cases[MAX_CASES];
+static const char *dir;
+static int isolate;
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static long timeval_us(struct timeval tv)
+{
+    return (long)tv.tv_sec * 1000000L + tv.tv_usec;
+}
+
+static void case_path(char *buf, size_t size, int index, const char *ext)
+{
+    snprintf(buf, size, "%s/%d.%s", dir, index, ext);
+}
+
+/* Drop trailing spaces, tabs, CRs and the newline */
+static size_t trim(char *line, ssize_t len)
+{
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' ||
+                       line[len - 1] == ' ' || line[len - 1] == '\t'))
+        len--;
+    return (size_t)len;
+}
+
+/* Length of the next line, or -1 at end of file */
+static ssize_t next_line(FILE *f, char **line, size_t *cap)
+{
+    ssize_t len = getline(line, cap, f);
+    return len < 0 ? -1 : (ssize_t)trim(*line, len);
+}
+
+/* Only blank lines left */
+static int rest_blank(FILE *f, char **line, size_t *cap, ssize_t len)
+{
+    while (len == 0)
+        len = next_line(f, line, cap);
+    return len < 0;
+}
+
+/* The whole file in memory (NUL-terminated), or NULL */
+static char *read_all(const char *path, size_t *len)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+    size_t cap = 4096, used = 0;
+    char *buf = malloc(cap);
+    ssize_t n;
+    while (buf && (n = read(fd, buf + used, cap - used - 1)) > 0) {
+        used += (size_t)n;
+        if (cap - used < 2) {
+            char *grown = realloc(buf, cap * 2);
+            if (!grown) {
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+    }
+    close(fd);
+    if (buf) {
+        buf[used] = '\0';
+        *len = used;
+    }
+    return buf;
+}
+
+static int outputs_match(int index)
+{
+    struct test_case *c = &cases[index];
+    int match = 0;
+    char *a = NULL, *b = NULL;
+    size_t acap = 0, bcap = 0;
+
+    /* The output file is unlinked; read it back through the judge's descriptor */
+    int fd = lseek(c->out_fd, 0, SEEK_SET) == 0 ? dup(c->out_fd) : -1;
+    FILE *out = fd >= 0 ? fdopen(fd, "r") : NULL;
+    if (!out && fd >= 0)
+        close(fd);
+    /* fmemopen rejects a zero-length buffer */
+    FILE *exp = !c->expected ? NULL
+        : c->expected_len > 0 ? fmemopen(c->expected, c->expected_len, "r")
+        : fopen("/dev/null", "r");
+
+    if (out && exp) {
+        for (;;) {
+            ssize_t alen = next_line(out, &a, &acap);
+            ssize_t blen = next_line(exp, &b, &bcap);
+            if (alen < 0 || blen < 0) {
+                match = alen < 0 ? rest_blank(exp, &b, &bcap, blen) : rest_blank(out, &a, &acap, alen);
+                break;
+            }
+            if (alen != blen || memcmp(a, b, (size_t)alen) != 0)
+                break;
+        }
+    }
+    free(a);
+    free(b);
+    if (out)
+        fclose(out);
+    if (exp)
+        fclose(exp);
+    return match;
+}
+
+/* Whether cases can run under their own uids (root, or the file capabilities) */
+static int can_isolate(void)
+{
+    pid_t pid = fork();
+    if (pid == 0)
+        _exit(setgroups(0, NULL) == 0 && setgid(JUDGE_UID_BASE) == 0 && setuid(JUDGE_UID_BASE) == 0 ? 0 : 1);
+    int status;
+    return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static pid_t start_case(int index, int limit_data, rlim_t output_bytes, char **argv)
+{
+    struct test_case *c = &cases[index];
+    char in_path[4096], out_path[4096], err_path[4096];
+    case_path(in_path, sizeof in_path, index, "in");
+    case_path(out_path, sizeof out_path, index, "out");
+    case_path(err_path, sizeof err_path, index, "err");
+
+    /* Opened by the judge, so the case needs no access to the cases dir */
+    int in = open(in_path, O_RDONLY | O_CLOEXEC);
+    if (in < 0)
+        in = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    c->out_fd = open(out_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (c->out_fd >= 0)
+        unlink(out_path);
+    int err = open(err_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    pid_t pid = fork();
+    if (pid > 0)
+        setpgid(pid, pid); /* also here, so a kill never misses the group */
+    if (pid != 0) {
+        if (in >= 0)
+            close(in);
+        if (err >= 0)
+            close(err);
+        return pid;
+    }
+
+    setpgid(0, 0);
+    if (in < 0 || c->out_fd < 0 || err < 0)
+        _exit(126);
+    dup2(in, STDIN_FILENO);
+    dup2(c->out_fd, STDOUT_FILENO);
+    dup2(err, STDERR_FILENO);
+
+    if (isolate) {
+        uid_t uid = (uid_t)(JUDGE_UID_BASE + c->slot);
+        if (setgroups(0, NULL) < 0 || setgid(uid) < 0 || setuid(uid) < 0)
+            _exit(126);
+    }
+
+    rlim_t cpu_s = (rlim_t)(c->time_ms / 1000 + 1);
+    struct rlimit cpu = { cpu_s, cpu_s + 1 };
+    struct rlimit fsize = { output_bytes, output_bytes };
+    setrlimit(RLIMIT_CPU, &cpu);
+    setrlimit(RLIMIT_FSIZE, &fsize);
+    if (limit_data && c->memory_kb > 0) {
+        struct rlimit data = { (rlim_t)c->memory_kb * 1024, (rlim_t)c->memory_kb * 1024 };
+        setrlimit(RLIMIT_DATA, &data);
+    }
+
+    signal(SIGPIPE, SIG_DFL);
+    execvp(argv[0], argv);
+    perror(argv[0]);
+    _exit(127);
+}
+
+static void judge(int index, int status, struct rusage *ru)
+{
+    struct test_case *c = &cases[index];
+    char err_path[4096];
+
+    c->done = 1;
+    c->wall_us = (now_ns() - c->started_ns) / 1000;
+    c->cpu_us = timeval_us(ru->ru_utime) + timeval_us(ru->ru_stime);
+    c->maxrss_kb = ru->ru_maxrss;
+    c->exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    c->signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+
+    /* Whatever the program left running in its group goes too */
+    kill(-c->pid, SIGKILL);
+
+    case_path(err_path, sizeof err_path, index, "err");
+    struct stat st;
+    if (stat(err_path, &st) == 0 && st.st_size > ERR_KEEP && truncate(err_path, ERR_KEEP) < 0)
+        perror(err_path);
+
+    if (c->timed_out || c->signal == SIGXCPU || c->cpu_us / 1000 > c->time_ms)
+        c->verdict = "time_limit";
+    else if (c->signal == SIGXFSZ)
+        c->verdict = "output_limit";
+    else if (c->memory_kb > 0 && c->maxrss_kb > c->memory_kb)
+        c->verdict = "memory_limit";
+    else if (c->signal != 0 || c->exit_code != 0)
+        c->verdict = "runtime_error";
+    else if (!c->compare)
+        c->verdict = "ok";
+    else
+        c->verdict = outputs_match(index) ? "accepted" : "wrong_answer";
+
+    close(c->out_fd);
+    c->out_fd = -1;
+    free(c->expected);
+    c->expected = NULL;
+}
+
+int main(int argc, char **argv)
+{
+    int limit_data = 0;
+    rlim_t output_bytes = 16 << 20;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "+do:")) != -1) {
+        if (opt == 'd')
+            limit_data = 1;
+        else if (opt == 'o')
+            output_bytes = (rlim_t)atoll(optarg);
+        else
+            return 2;
+    }
+    if (argc - optind < 3) {
+        fprintf(stderr, "usage: %s [-d] [-o bytes] <cases-dir> <parallel> <program> [args...]\n", argv[0]);
+        return 2;
+    }
+    dir = argv[optind];
+    int parallel = atoi(argv[optind + 1]);
+    char **program = argv + optind + 2;
+    if (parallel < 1)
+        parallel = 1;
+
+    char path[4096];
+    snprintf(path, sizeof path, "%s/manifest", dir);
+    FILE *manifest = fopen(path, "r");
+    if (!manifest) {
+        perror(path);
+        return 2;
+    }
+    int count = 0;
+    while (count < MAX_CASES &&
+           fscanf(manifest, "%ld %ld %d", &cases[count].time_ms, &cases[count].memory_kb, &cases[count].compare) == 3)
+        count++;
+    fclose(manifest);
+
+    /* From here on the answers exist only in the judge's memory */
+    prctl(PR_SET_DUMPABLE, 0);
+    for (int i = 0; i < count; i++) {
+        cases[i].out_fd = -1;
+        case_path(path, sizeof path, i, "exp");
+        if (cases[i].compare)
+            cases[i].expected = read_all(path, &cases[i].expected_len);
+        unlink(path);
+    }
+    chmod(dir, 0755);
+    isolate = can_isolate();
+
+    /* Running cases never share a slot, and so never share a uid */
+    static int slot_busy[MAX_CASES];
+    int next = 0, running = 0;
+    while (next < count || running > 0) {
+        while (running < parallel && next < count) {
+            int slot = 0;
+            while (slot_busy[slot])
+                slot++;
+            slot_busy[slot] = 1;
+            cases[next].slot = slot;
+            cases[next].started_ns = now_ns();
+            cases[next].pid = start_case(next, limit_data, output_bytes, program);
+            if (cases[next].pid < 0) {
+                perror("fork");
+                return 2;
+            }
+            running++;
+            next++;
+        }
+
+        int status;
+        struct rusage ru;
+        pid_t pid = wait4(-1, &status, WNOHANG, &ru);
+        if (pid > 0) {
+            for (int i = 0; i < next; i++) {
+                if (cases[i].pid == pid && !cases[i].done) {
+                    judge(i, status, &ru);
+                    slot_busy[cases[i].slot] = 0;
+                    running--;
+                    break;
+                }
+            }
+            continue;
+        }
+
+        long long now = now_ns();
+        for (int i = 0; i < next; i++) {
+            struct test_case *c = &cases[i];
+            if (!c->done && !c->timed_out && now - c->started_ns > c->time_ms * 1000000LL) {
+                c->timed_out = 1;
+                kill(-c->pid, SIGKILL);
+            }
+        }
+        struct timespec pause = { 0, POLL_NS };
+        nanosleep(&pause, NULL);
+    }
+
+    snprintf(path, sizeof path, "%s/results", dir);
+    FILE *results = fopen(path, "w");
+    if (!results) {
+        perror(path);
+        return 2;
+    }
+    for (int i = 0; i < count; i++) {
+        struct test_case *c = &cases[i];
+        fprintf(results, "%s %lld %ld %ld %d %d\n", c->verdict, c->wall_us, c->cpu_us, c->maxrss_kb,
+                c->exit_code, c->signal);
+    }
+    fclose(results);
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * cr-bench: run a program repeatedly and record per-run wall and CPU time.
+ * Used by the server's benchmark run mode (server/src/benchmark.ts).
+ *
+ * Usage: cr-bench <runs> <budget-ms> <results-file> <program> [args...]
+ *
+ * Writes one line per run to <results-file>:
+ *   <wall_ns> <user_us> <sys_us> <exit_code>
+ *
+ * stdin is /dev/null for every run and only the first run's stdout/stderr reach
+ * the caller. No new run is started once <budget-ms> has elapsed. Stops at the
+ * first failing run and exits with its code.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static long timeval_us(struct timeval tv)
+{
+    return (long)tv.tv_sec * 1000000L + tv.tv_usec;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 5) {
+        fprintf(stderr, "usage: %s <runs> <budget-ms> <results-file> <program> [args...]\n", argv[0]);
+        return 2;
+    }
+
+    int runs = atoi(argv[1]);
+    long long budget_ns = atoll(argv[2]) * 1000000LL;
+
+    FILE *results = fopen(argv[3], "w");
+    if (!results) {
+        perror(argv[3]);
+        return 2;
+    }
+
+    int devnull = open("/dev/null", O_RDWR);
+    if (devnull < 0) {
+        perror("/dev/null");
+        return 2;
+    }
+
+    long long started = now_ns();
+    int exit_code = 0;
+
+    for (int i = 0; i < runs; i++) {
+        if (i > 0 && now_ns() - started > budget_ns)
+            break;
+
+        long long t0 = now_ns();
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 2;
+        }
+        if (pid == 0) {
+            dup2(devnull, STDIN_FILENO);
+            if (i > 0) {
+                dup2(devnull, STDOUT_FILENO);
+                dup2(devnull, STDERR_FILENO);
+            }
+            execv(argv[4], argv + 4);
+            perror(argv[4]);
+            _exit(127);
+        }
+
+        int status;
+        struct rusage usage;
+        if (wait4(pid, &status, 0, &usage) < 0) {
+            perror("wait4");
+            return 2;
+        }
+        long long wall_ns = now_ns() - t0;
+        int code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+
+        fprintf(results, "%lld %ld %ld %d\n", wall_ns, timeval_us(usage.ru_utime), timeval_us(usage.ru_stime), code);
+        fflush(results);
+
+        if (code != 0) {
+            exit_code = code;
+            break;
+        }
+    }
+
+    fclose(results);
+    return exit_code;
+}
@@ -0,0 +1,6 @@
+// Precompiled <iostream> plus <vector> and <algorithm>, which most exercises use.
+// Applied only to programs that include all three headers themselves (see
+// PCH_VARIANTS in server/src/cppBuild.ts).
+#include <algorithm>
+#include <iostream>
+#include <vector>
@@ -0,0 +1,5 @@
+// Precompiled <iostream>, the only system header of most simple programs.
+// The server force-includes a variant (via -include) only when the program
+// includes every header it lists itself, so no declarations are added — keep
+// PCH_VARIANTS in server/src/cppBuild.ts in sync with the pch/ files.
+#include <iostream>
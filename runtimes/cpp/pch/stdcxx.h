@@ -0,0 +1,2 @@
+// Precompiled <bits/stdc++.h> for programs that include the whole library.
+#include <bits/stdc++.h>
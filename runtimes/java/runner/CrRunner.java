@@ -0,0 +1,560 @@
+/*
+ * CrRunner: warm compile-and-run daemon for java session containers.
+ * Used by the server's java run command (server/src/javaRunner.ts) through the
+ * cr-java-run client; cr-java-daemon keeps it running.
+ *
+ * Protocol (spool directory, default /home/runner/.cr-java):
+ *   work/<id>/{stdin,stdout,stderr}  FIFOs created by the client
+ *   queue/<id>.req                   request: working dir, main class, timeout (s),
+ *                                    optionally a class cache directory
+ *   work/<id>/accepted               the request, moved here when a run starts
+ *   work/<id>/exit                   exit code, written before stdout/stderr close
+ *   ready / busy                     daemon state, checked by the client
+ *
+ * Each run compiles every .java file under the working directory in-process with
+ * javax.tools, loads the classes in a fresh class loader and invokes main in its
+ * own thread group with System.in/out/err routed to the run's FIFOs. System.exit
+ * ends the run instead of the JVM. A run that times out, loses its client or
+ * leaves threads behind makes the daemon halt; cr-java-daemon starts a new one.
+ *
+ * With a class cache directory (named by the server after the sources' content
+ * hash), classes are compiled into it once and later runs of the same sources
+ * skip javac. An empty main class only builds: speculative builds use it to
+ * fill the cache before the user presses Run.
+ */
+
+import java.io.BufferedOutputStream;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.io.OutputStreamWriter;
+import java.io.PrintStream;
+import java.io.Writer;
+import java.lang.reflect.InvocationTargetException;
+import java.lang.reflect.Method;
+import java.lang.reflect.Modifier;
+import java.net.URL;
+import java.net.URLClassLoader;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.FileSystems;
+import java.nio.file.Files;
+import java.nio.file.NoSuchFileException;
+import java.nio.file.Path;
+import java.nio.file.Paths;
+import java.nio.file.StandardCopyOption;
+import java.nio.file.StandardWatchEventKinds;
+import java.nio.file.WatchService;
+import java.security.Permission;
+import java.time.Instant;
+import java.util.List;
+import java.util.concurrent.TimeUnit;
+import java.util.stream.Collectors;
+import java.util.stream.Stream;
+import javax.tools.JavaCompiler;
+import javax.tools.StandardJavaFileManager;
+import javax.tools.ToolProvider;
+
+public final class CrRunner {
+    private static final Path SPOOL = Paths.get(System.getProperty("cr.spool", "/home/runner/.cr-java"));
+    private static final Path QUEUE = SPOOL.resolve("queue");
+    private static final Path WORK = SPOOL.resolve("work");
+    private static final String BUILD_RUN_MARKER = "___BUILD___run=";
+    private static final String BUILD_CACHE_MARKER = "___BUILD___cache=";
+    /** Class cache entries kept per container; older ones are evicted on each miss */
+    private static final int MAX_CACHED_CLASSES = 8;
+    /** Exit code reported when the daemon gives up on a run (matches timeout(1)) */
+    private static final int KILLED_EXIT = 137;
+
+    private static final PrintStream LOG = System.err;
+    private static final RoutedOutput ROUTED_OUT = new RoutedOutput(false);
+    private static final RoutedOutput ROUTED_ERR = new RoutedOutput(true);
+    private static final PrintStream STDOUT = new PrintStream(ROUTED_OUT, true, StandardCharsets.UTF_8);
+    private static final PrintStream STDERR = new PrintStream(ROUTED_ERR, true, StandardCharsets.UTF_8);
+    private static final InputStream STDIN = new RoutedInput();
+
+    private static volatile Run current;
+    private static Thread daemonThread;
+    private static int runCount;
+
+    public static void main(String[] args) throws Exception {
+        Files.createDirectories(QUEUE);
+        Files.createDirectories(WORK);
+        daemonThread = Thread.currentThread();
+        System.setSecurityManager(new ExitTrap());
+        System.setIn(STDIN);
+        System.setOut(STDOUT);
+        System.setErr(STDERR);
+
+        JavaCompiler javac = ToolProvider.getSystemJavaCompiler();
+        warmUp(javac);
+        Files.write(SPOOL.resolve("ready"), String.valueOf(ProcessHandle.current().pid()).getBytes());
+        LOG.println("[cr-runner] ready");
+
+        try (WatchService watcher = FileSystems.getDefault().newWatchService()) {
+            QUEUE.register(watcher, StandardWatchEventKinds.ENTRY_CREATE);
+            while (true) {
+                for (Path request : pendingRequests()) {
+                    accept(javac, request);
+                }
+                // Events only wake us up; the directory listing is the source of truth
+                var key = watcher.poll(1, TimeUnit.SECONDS);
+                if (key != null) {
+                    key.pollEvents();
+                    key.reset();
+                }
+            }
+        }
+    }
+
+    private static List<Path> pendingRequests() throws IOException {
+        try (Stream<Path> entries = Files.list(QUEUE)) {
+            return entries.filter(p -> p.getFileName().toString().endsWith(".req")).sorted().collect(Collectors.toList());
+        }
+    }
+
+    /** Claim a queued request (the client may withdraw it concurrently) and run it */
+    private static void accept(JavaCompiler javac, Path request) throws Exception {
+        String name = request.getFileName().toString();
+        Path dir = WORK.resolve(name.substring(0, name.length() - ".req".length()));
+        Path accepted = dir.resolve("accepted");
+        try {
+            Files.move(request, accepted, StandardCopyOption.ATOMIC_MOVE);
+        } catch (NoSuchFileException e) {
+            return;
+        }
+
+        List<String> lines = Files.readAllLines(accepted);
+        if (lines.size() < 3) {
+            Files.deleteIfExists(accepted);
+            return;
+        }
+        Path cwd = Paths.get(lines.get(0));
+        String mainClass = lines.get(1);
+        long timeoutMs = Long.parseLong(lines.get(2).trim()) * 1000L;
+        Path classes = lines.size() > 3 && !lines.get(3).isEmpty() ? cwd.resolve(lines.get(3)) : null;
+
+        Path busy = SPOOL.resolve("busy");
+        Files.write(busy, name.getBytes());
+        try {
+            execute(javac, dir, cwd, classes, mainClass, timeoutMs);
+        } finally {
+            Files.deleteIfExists(busy);
+        }
+    }
+
+    private static void execute(JavaCompiler javac, Path dir, Path cwd, Path classes, String mainClass, long timeoutMs) throws Exception {
+        // Open order matches the client: it reads stdout/stderr and writes stdin
+        OutputStream out = new BufferedOutputStream(new FileOutputStream(dir.resolve("stdout").toFile()), 128);
+        OutputStream err = new BufferedOutputStream(new FileOutputStream(dir.resolve("stderr").toFile()), 128);
+        InputStream in = new FileInputStream(dir.resolve("stdin").toFile());
+
+        Run run = new Run(++runCount, out, err, in);
+        current = run;
+        Thread main = new Thread(run.group, () -> run.finish(compileAndRun(javac, run, cwd, classes, mainClass)), "main");
+        main.start();
+
+        boolean clean = run.await(main, System.currentTimeMillis() + timeoutMs);
+        current = null;
+
+        Integer result = run.result();
+        int code = result != null ? result : KILLED_EXIT;
+        Path exit = dir.resolve("exit.tmp");
+        Files.write(exit, String.valueOf(code).getBytes());
+        Files.move(exit, dir.resolve("exit"), StandardCopyOption.ATOMIC_MOVE);
+
+        closeQuietly(out);
+        closeQuietly(err);
+        closeQuietly(in);
+        if (run.loader != null) closeQuietly(run.loader);
+
+        // User code may have replaced the standard streams
+        System.setIn(STDIN);
+        System.setOut(STDOUT);
+        System.setErr(STDERR);
+        // Return the run's garbage to the OS before the next one (SerialGC shrinks the heap)
+        System.gc();
+
+        if (!clean) {
+            LOG.println("[cr-runner] run " + run.id + " did not finish cleanly, restarting");
+            Runtime.getRuntime().halt(1);
+        }
+    }
+
+    /**
+     * Compile like `javac -d . $(find . -name "*.java")` (into the class cache
+     * directory instead of cwd when given, unless it is already there), then run
+     * like `java <mainClass>`. An empty main class stops after compiling.
+     */
+    private static int compileAndRun(JavaCompiler javac, Run run, Path cwd, Path classes, String mainClass) {
+        PrintStream stderr = System.err;
+        try {
+            boolean cached = classes != null && Files.isDirectory(classes);
+            if (classes != null) {
+                stderr.println(BUILD_CACHE_MARKER + (cached ? "hit" : "miss"));
+            }
+            if (!cached) {
+                int status = compile(javac, stderr, cwd, classes);
+                if (status != 0) {
+                    return status;
+                }
+            }
+
+            Instant now = Instant.now();
+            stderr.println(BUILD_RUN_MARKER + (now.getEpochSecond() * 1_000_000_000L + now.getNano()));
+            if (mainClass.isEmpty()) {
+                return 0;
+            }
+
+            URL[] classPath = classes != null
+                    ? new URL[] { classes.toUri().toURL(), cwd.toUri().toURL() }
+                    : new URL[] { cwd.toUri().toURL() };
+            URLClassLoader loader = new URLClassLoader(classPath, ClassLoader.getPlatformClassLoader());
+            run.loader = loader;
+            Thread.currentThread().setContextClassLoader(loader);
+
+            Class<?> cls;
+            try {
+                cls = Class.forName(mainClass, true, loader);
+            } catch (ClassNotFoundException | LinkageError e) {
+                stderr.println("Error: Could not find or load main class " + mainClass);
+                stderr.println("Caused by: " + e);
+                return 1;
+            }
+
+            Method entry;
+            try {
+                entry = cls.getMethod("main", String[].class);
+            } catch (NoSuchMethodException e) {
+                entry = null;
+            }
+            if (entry == null || !Modifier.isStatic(entry.getModifiers())) {
+                stderr.println("Error: Main method not found in class " + mainClass + ", please define the main method as:");
+                stderr.println("   public static void main(String[] args)");
+                return 1;
+            }
+
+            try {
+                entry.invoke(null, (Object) new String[0]);
+            } catch (InvocationTargetException e) {
+                Throwable cause = e.getCause();
+                if (cause instanceof ExitRequest) {
+                    return ((ExitRequest) cause).status;
+                }
+                stderr.print("Exception in thread \"main\" ");
+                cause.printStackTrace(stderr);
+                return 1;
+            }
+            return 0;
+        } catch (ExitRequest e) {
+            return e.status;
+        } catch (Throwable t) {
+            stderr.println("[cr-runner] " + t);
+            return 1;
+        }
+    }
+
+    /**
+     * Compile every .java file under cwd into cwd, or into `classes` when given.
+     * Cache entries are built next to their final name and renamed into place, so
+     * an entry only ever exists complete.
+     */
+    private static int compile(JavaCompiler javac, PrintStream stderr, Path cwd, Path classes) throws IOException {
+        List<Path> sources;
+        try (Stream<Path> files = Files.walk(cwd)) {
+            sources = files.filter(p -> p.toString().endsWith(".java") && Files.isRegularFile(p)).sorted().collect(Collectors.toList());
+        }
+        if (sources.isEmpty()) {
+            stderr.println("error: no source files");
+            return 2;
+        }
+
+        Path target = cwd;
+        if (classes != null) {
+            target = classes.resolveSibling(classes.getFileName() + ".tmp");
+            deleteTree(target);
+            Files.createDirectories(target);
+        }
+
+        Writer diagnostics = new OutputStreamWriter(stderr, StandardCharsets.UTF_8);
+        boolean compiled;
+        try (StandardJavaFileManager files = javac.getStandardFileManager(null, null, StandardCharsets.UTF_8)) {
+            compiled = javac.getTask(diagnostics, files, null, List.of("-d", target.toString(), "-classpath", target.toString()), null,
+                    files.getJavaFileObjectsFromPaths(sources)).call();
+        }
+        diagnostics.flush();
+        if (!compiled) {
+            if (classes != null) deleteTree(target);
+            return 1;
+        }
+
+        if (classes != null) {
+            try {
+                Files.move(target, classes, StandardCopyOption.ATOMIC_MOVE);
+            } catch (IOException e) {
+                // A cold fallback run of the same sources finished first
+                if (!Files.isDirectory(classes)) throw e;
+                deleteTree(target);
+            }
+            evictClasses(classes.getParent());
+        }
+        return 0;
+    }
+
+    /** Keep the MAX_CACHED_CLASSES most recently built cache entries */
+    private static void evictClasses(Path cacheDir) throws IOException {
+        List<Path> entries;
+        try (Stream<Path> list = Files.list(cacheDir)) {
+            entries = list.filter(p -> Files.isDirectory(p) && !p.getFileName().toString().endsWith(".tmp"))
+                    .sorted((a, b) -> Long.compare(b.toFile().lastModified(), a.toFile().lastModified()))
+                    .collect(Collectors.toList());
+        }
+        for (Path stale : entries.subList(Math.min(MAX_CACHED_CLASSES, entries.size()), entries.size())) {
+            deleteTree(stale);
+        }
+    }
+
+    private static void deleteTree(Path root) throws IOException {
+        if (!Files.exists(root)) return;
+        try (Stream<Path> files = Files.walk(root)) {
+            files.sorted((a, b) -> b.compareTo(a)).forEach(p -> p.toFile().delete());
+        }
+    }
+
+    /** Compile and run a trivial program so javac's classes are loaded and JIT-compiled */
+    private static void warmUp(JavaCompiler javac) {
+        try {
+            Path dir = Files.createTempDirectory("cr-warmup");
+            Files.writeString(dir.resolve("Warmup.java"),
+                    "import java.util.*;\npublic class Warmup { public static void main(String[] a) { System.out.println(new ArrayList<>(List.of(a)).size()); } }\n");
+            for (int i = 0; i < 3; i++) {
+                try (StandardJavaFileManager files = javac.getStandardFileManager(null, null, StandardCharsets.UTF_8)) {
+                    javac.getTask(null, files, null, List.of("-d", dir.toString()), null,
+                            files.getJavaFileObjects(dir.resolve("Warmup.java"))).call();
+                }
+            }
+            try (Stream<Path> files = Files.walk(dir)) {
+                files.sorted((a, b) -> b.compareTo(a)).forEach(p -> p.toFile().delete());
+            }
+        } catch (Exception e) {
+            LOG.println("[cr-runner] warm-up failed: " + e);
+        }
+    }
+
+    /**
+     * The run a stream or exit call belongs to. Runs execute one at a time, so
+     * every thread except the daemon's own belongs to the current run - including
+     * shared pool threads (parallel streams, CompletableFuture) it started.
+     */
+    private static Run activeRun() {
+        Run run = current;
+        return run != null && Thread.currentThread() != daemonThread ? run : null;
+    }
+
+    private static void closeQuietly(java.io.Closeable c) {
+        try {
+            c.close();
+        } catch (IOException e) {
+            // Client already gone
+        }
+    }
+
+    /** One execution: its thread group, streams and outcome */
+    private static final class Run {
+        final int id;
+        final ThreadGroup group;
+        final OutputStream out;
+        final OutputStream err;
+        final InputStream in;
+        /** Status passed to System.exit, if it was called */
+        volatile Integer exitCode;
+        /** Outcome of main (and of compiling) once it returned */
+        volatile Integer mainCode;
+        volatile boolean clientGone;
+        volatile URLClassLoader loader;
+
+        Run(int id, OutputStream out, OutputStream err, InputStream in) {
+            this.id = id;
+            this.group = new ThreadGroup("run-" + id);
+            this.out = out;
+            this.err = err;
+            this.in = in;
+        }
+
+        Integer result() {
+            return exitCode != null ? exitCode : mainCode;
+        }
+
+        synchronized void finish(int code) {
+            mainCode = code;
+            notifyAll();
+        }
+
+        /** System.exit from any thread of the run ends it right away */
+        synchronized void requestExit(int status) {
+            if (exitCode == null) exitCode = status;
+            notifyAll();
+        }
+
+        /**
+         * Wait until main returned and no non-daemon thread is left (as the JVM
+         * would), System.exit was called, the client went away or the deadline
+         * passed. Returns false when threads of the run are still alive.
+         */
+        boolean await(Thread main, long deadline) throws InterruptedException {
+            synchronized (this) {
+                while (true) {
+                    if (exitCode != null || clientGone || System.currentTimeMillis() >= deadline) break;
+                    if (mainCode != null && !hasLiveThreads(false)) break;
+                    wait(mainCode != null ? 5 : 50);
+                }
+            }
+            flushQuietly(out);
+            flushQuietly(err);
+            if (result() == null || clientGone) return false;
+
+            // Let threads unwinding from System.exit finish, then check for leftovers
+            long grace = System.currentTimeMillis() + 200;
+            while (hasLiveThreads(true) && System.currentTimeMillis() < grace) {
+                Thread.sleep(5);
+            }
+            return !hasLiveThreads(true);
+        }
+
+        private boolean hasLiveThreads(boolean includeDaemons) {
+            Thread[] threads = new Thread[group.activeCount() + 8];
+            int n = group.enumerate(threads, true);
+            for (int i = 0; i < n; i++) {
+                if (threads[i].isAlive() && (includeDaemons || !threads[i].isDaemon())) return true;
+            }
+            return false;
+        }
+
+        private static void flushQuietly(OutputStream s) {
+            try {
+                s.flush();
+            } catch (IOException e) {
+                // Client already gone
+            }
+        }
+    }
+
+    /** System.out/err: the current run's FIFO for its threads, the daemon log otherwise */
+    private static final class RoutedOutput extends OutputStream {
+        private final boolean stderr;
+
+        RoutedOutput(boolean stderr) {
+            this.stderr = stderr;
+        }
+
+        @Override
+        public void write(int b) throws IOException {
+            Run run = activeRun();
+            if (run == null) {
+                LOG.write(b);
+                return;
+            }
+            try {
+                (stderr ? run.err : run.out).write(b);
+            } catch (IOException e) {
+                gone(run);
+                throw e;
+            }
+        }
+
+        @Override
+        public void write(byte[] b, int off, int len) throws IOException {
+            Run run = activeRun();
+            if (run == null) {
+                LOG.write(b, off, len);
+                return;
+            }
+            try {
+                (stderr ? run.err : run.out).write(b, off, len);
+            } catch (IOException e) {
+                gone(run);
+                throw e;
+            }
+        }
+
+        @Override
+        public void flush() throws IOException {
+            Run run = activeRun();
+            if (run == null) {
+                LOG.flush();
+                return;
+            }
+            try {
+                (stderr ? run.err : run.out).flush();
+            } catch (IOException e) {
+                gone(run);
+                throw e;
+            }
+        }
+
+        private static void gone(Run run) {
+            synchronized (run) {
+                run.clientGone = true;
+                run.notifyAll();
+            }
+        }
+    }
+
+    /** System.in: the current run's FIFO for its threads, EOF otherwise */
+    private static final class RoutedInput extends InputStream {
+        private InputStream source() {
+            Run run = activeRun();
+            return run != null ? run.in : null;
+        }
+
+        @Override
+        public int read() throws IOException {
+            InputStream in = source();
+            return in == null ? -1 : in.read();
+        }
+
+        @Override
+        public int read(byte[] b, int off, int len) throws IOException {
+            InputStream in = source();
+            return in == null ? -1 : in.read(b, off, len);
+        }
+
+        @Override
+        public int available() throws IOException {
+            InputStream in = source();
+            return in == null ? 0 : in.available();
+        }
+    }
+
+    /** Thrown from System.exit in run threads; carries the status */
+    private static final class ExitRequest extends SecurityException {
+        private static final long serialVersionUID = 1L;
+        final int status;
+
+        ExitRequest(int status) {
+            super("System.exit(" + status + ")");
+            this.status = status;
+        }
+    }
+
+    /** Permits everything except ending the daemon from a run thread */
+    private static final class ExitTrap extends SecurityManager {
+        @Override
+        public void checkPermission(Permission perm) {
+        }
+
+        @Override
+        public void checkPermission(Permission perm, Object context) {
+        }
+
+        @Override
+        public void checkExit(int status) {
+            Run run = activeRun();
+            if (run != null) {
+                run.requestExit(status);
+                throw new ExitRequest(status);
+            }
+        }
+    }
+}
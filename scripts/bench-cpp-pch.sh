@@ -0,0 +1,45 @@
+#!/bin/bash
+# Compare g++ compile times with and without the precompiled headers baked
+# into the cpp-runtime image, and with mold as the linker, using the C++
+# programs from the test corpus. Each program gets the PCH variant the server
+# would pick (selectPrecompiledHeader in server/src/cppBuild.ts): the largest
+# one whose headers the program includes itself.
+#
+# Usage: scripts/bench-cpp-pch.sh [runs-per-program]
+
+set -e
+
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+PROGRAMS_DIR="$SCRIPT_DIR/../server/tests/programs/cpp"
+IMAGE="${CPP_RUNTIME_IMAGE:-cpp-runtime}"
+RUNS="${1:-5}"
+
+docker run --rm -v "$PROGRAMS_DIR:/src:ro" -e RUNS="$RUNS" "$IMAGE" sh -c '
+  P=/opt/coderunner/pch
+  ms() { echo $(( $(date +%s%N) / 1000000 )); }
+  avg() {
+    total=0
+    for i in $(seq "$RUNS"); do
+      start=$(ms); "$@" -o /tmp/app 2>/dev/null; total=$(( total + $(ms) - start ))
+    done
+    echo $(( total / RUNS ))
+  }
+  includes() { grep -q "^[[:space:]]*#[[:space:]]*include[[:space:]]*<$2>" "$1"; }
+  variant() {
+    for v in stdcxx containers iostream; do
+      ok=1
+      for h in $(sed -n "s/^#include <\(.*\)>/\1/p" "$P/$v.h"); do includes "$1" "$h" || ok=0; done
+      [ $ok -eq 1 ] && { echo "$v"; return; }
+    done
+    echo none
+  }
+  printf "%-28s %-11s %10s %10s %14s\n" program variant "no-pch(ms)" "pch(ms)" "pch+mold(ms)"
+  for f in /src/*.cpp; do
+    v=$(variant "$f")
+    pch=""; [ "$v" != none ] && pch="-include $P/$v.h"
+    printf "%-28s %-11s %10s %10s %14s\n" "$(basename "$f")" "$v" \
+      "$(avg g++ -O0 -g "$f")" \
+      "$(avg g++ -O0 -g $pch "$f")" \
+      "$(avg g++ -O0 -g $pch -fuse-ld=mold "$f")"
+  done
+'
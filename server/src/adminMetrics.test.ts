@@ -154,7 +154,9 @@ describe('AdminMetricsService', () => {
             expect(today.latency.average).toBe(300); // (100+200+300+400+500) / 5
             expect(today.latency.lowest).toBe(100);
             expect(today.latency.highest).toBe(500);
-            expect(today.latency.median).toBe(300);
+            // Percentiles come from the latency histogram, within its bucket error
+            expect(today.latency.median).toBeGreaterThanOrEqual(300);
+            expect(today.latency.median).toBeLessThanOrEqual(309);
         });
     });
 
@@ -379,6 +381,48 @@ describe('AdminMetricsService', () => {
         });
     });
 
+    describe('getRollups', () => {
+        it('should count requests, errors and latency per language in the current minute', () => {
+            adminMetrics.trackRequest({
+                type: 'api', language: 'python', executionTime: 40, success: true, sessionId: 's1', clientId: 'c1',
+            });
+            adminMetrics.trackRequest({
+                type: 'api', language: 'python', executionTime: 400, success: false, sessionId: 's2', clientId: 'c1',
+            });
+            adminMetrics.trackRequest({
+                type: 'api', language: 'cpp', executionTime: 1200, success: true, sessionId: 's3', clientId: 'c2',
+            });
+
+            const rollups = adminMetrics.getRollups(5);
+            expect(rollups.minutes).toBe(5);
+            expect(rollups.requests).toBe(3);
+            expect(rollups.errors).toBe(1);
+            expect(rollups.series).toHaveLength(1);
+            expect(rollups.byLanguage.python).toEqual({
+                requests: 2, errors: 1, avgMs: 220, p50Ms: 50, p95Ms: 400, maxMs: 400,
+            });
+            expect(rollups.byLanguage.cpp.p50Ms).toBe(1200);
+        });
+
+        it('should leave out minutes outside the window', () => {
+            jest.useFakeTimers({ now: Date.now() });
+            try {
+                adminMetrics.trackRequest({
+                    type: 'api', language: 'java', executionTime: 10, success: true, sessionId: 's1', clientId: 'c1',
+                });
+                jest.setSystemTime(Date.now() + 3 * 60 * 1000);
+                adminMetrics.trackRequest({
+                    type: 'api', language: 'java', executionTime: 10, success: true, sessionId: 's2', clientId: 'c1',
+                });
+
+                expect(adminMetrics.getRollups(1).requests).toBe(1);
+                expect(adminMetrics.getRollups(10).series).toHaveLength(2);
+            } finally {
+                jest.useRealTimers();
+            }
+        });
+    });
+
     describe('resetAllMetrics', () => {
         it('should clear all data', () => {
             adminMetrics.trackRequest({
@@ -1,10 +1,18 @@
 /**
  * Admin Metrics Tracking Service
  * Tracks detailed metrics for admin dashboard and reporting
+ *
+ * Everything here is bounded and O(1) per request: the request history and
+ * server snapshots are ring buffers, daily latencies are fixed-memory
+ * histograms, and per-minute rollups (count, errors and a coarse latency
+ * histogram per language) are updated as requests come in. Dashboard queries
+ * read the rollups in O(minutes × languages) instead of scanning the history.
  */
 
 import * as os from 'os';
 import { logger } from './logger';
+import { LatencyHistogram, PROMETHEUS_BUCKETS_MS, exportBucketIndex } from './histogram';
+import { RingBuffer } from './ringBuffer';
 
 export interface RequestMetrics {
   requestId: string;
@@ -41,11 +49,58 @@ export interface DailyMetrics {
   totalRequests: number;
   successfulRequests: number;
   failedRequests: number;
-  requestLatencies: number[];
+  latency: LatencyHistogram;
   requestsByLanguage: Map<string, number>;
   requestsByType: Map<string, number>;
 }
 
+/** Requests of one language within a rollup minute */
+export interface LanguageRollup {
+  requests: number;
+  errors: number;
+  sumMs: number;
+  maxMs: number;
+  /** Non-cumulative counts per PROMETHEUS_BUCKETS_MS bound, plus +Inf */
+  buckets: Uint32Array;
+}
+
+export interface MinuteRollup {
+  /** Start of the minute, ms since the epoch */
+  minute: number;
+  requests: number;
+  errors: number;
+  languages: Map<string, LanguageRollup>;
+}
+
+const MINUTE_MS = 60 * 1000;
+
+function emptyLanguageRollup(): LanguageRollup {
+  return { requests: 0, errors: 0, sumMs: 0, maxMs: 0, buckets: new Uint32Array(PROMETHEUS_BUCKETS_MS.length + 1) };
+}
+
+/** Upper bound of the bucket holding the p-th percentile (the largest sample for +Inf) */
+function coarsePercentile(rollup: LanguageRollup, p: number): number {
+  if (rollup.requests === 0) return 0;
+  const rank = Math.max(1, Math.ceil((p / 100) * rollup.requests));
+  let seen = 0;
+  for (let i = 0; i < PROMETHEUS_BUCKETS_MS.length; i++) {
+    seen += rollup.buckets[i];
+    if (seen >= rank) return Math.min(PROMETHEUS_BUCKETS_MS[i], rollup.maxMs);
+  }
+  return rollup.maxMs;
+}
+
+function formatLanguageRollup(rollup: LanguageRollup) {
+  return {
+    requests: rollup.requests,
+    errors: rollup.errors,
+    avgMs: rollup.requests > 0 ? Math.round(rollup.sumMs / rollup.requests) : 0,
+    p50Ms: coarsePercentile(rollup, 50),
+    p95Ms: coarsePercentile(rollup, 95),
+    maxMs: rollup.maxMs,
+  };
+}
+
 export interface ServerSnapshot {
   timestamp: Date;
   activeWorkers: number;
@@ -57,13 +112,11 @@ export interface ServerSnapshot {
 
 class AdminMetricsService {
   private dailyMetrics: Map<string, DailyMetrics> = new Map();
-  private requestHistory: RequestMetrics[] = [];
-  private maxRequestHistory: number = 10000; // Keep last 10k requests in memory
-  private maxLatenciesPerDay: number = 10000; // Cap latencies per day to bound memory
+  private requestHistory = new RingBuffer<RequestMetrics>(10000); // Keep last 10k requests in memory
   private activeClients: Set<string> = new Set();
   private activeExecutions: Set<string> = new Set();
-  private serverSnapshots: ServerSnapshot[] = [];
-  private maxSnapshots: number = 1440; // Keep 24 hours of minute-by-minute snapshots
+  private serverSnapshots = new RingBuffer<ServerSnapshot>(1440); // Keep 24 hours of minute-by-minute snapshots
+  private rollups = new RingBuffer<MinuteRollup>(1440); // 24 hours of per-minute rollups
 
   // System monitoring
   private systemMetrics: SystemMetrics = {
@@ -171,7 +224,7 @@ class AdminMetricsService {
         totalRequests: 0,
         successfulRequests: 0,
         failedRequests: 0,
-        requestLatencies: [],
+        latency: new LatencyHistogram(),
         requestsByLanguage: new Map(),
         requestsByType: new Map(),
       });
@@ -192,9 +245,7 @@ class AdminMetricsService {
 
     // Add to request history
     this.requestHistory.push(fullRequest);
-    if (this.requestHistory.length > this.maxRequestHistory) {
-      this.requestHistory.shift();
-    }
+    this.addToRollup(fullRequest);
 
     // Update daily metrics
     const date = this.getTodayDate();
@@ -207,11 +258,7 @@ class AdminMetricsService {
       metrics.failedRequests++;
     }
 
-    metrics.requestLatencies.push(request.executionTime);
-    // Cap latencies array to prevent unbounded memory growth
-    if (metrics.requestLatencies.length > this.maxLatenciesPerDay) {
-      metrics.requestLatencies.shift();
-    }
+    metrics.latency.record(request.executionTime);
     metrics.uniqueClients.add(request.clientId);
 
     // Update language stats
@@ -223,6 +270,36 @@ class AdminMetricsService {
     metrics.requestsByType.set(request.type, typeCount + 1);
   }
 
+  /**
+   * Count a request into the rollup of its minute, starting a new one when the
+   * minute has changed (minutes without requests have no rollup)
+   */
+  private addToRollup(request: RequestMetrics): void {
+    const minute = Math.floor(request.timestamp.getTime() / MINUTE_MS) * MINUTE_MS;
+    let rollup = this.rollups.newest();
+    if (!rollup || rollup.minute !== minute) {
+      rollup = { minute, requests: 0, errors: 0, languages: new Map() };
+      this.rollups.push(rollup);
+    }
+
+    let language = rollup.languages.get(request.language);
+    if (!language) {
+      language = emptyLanguageRollup();
+      rollup.languages.set(request.language, language);
+    }
+
+    const ms = Math.max(0, Math.round(request.executionTime));
+    rollup.requests++;
+    language.requests++;
+    if (!request.success) {
+      rollup.errors++;
+      language.errors++;
+    }
+    language.sumMs += ms;
+    if (ms > language.maxMs) language.maxMs = ms;
+    language.buckets[exportBucketIndex(ms)]++;
+  }
+
   /**
    * Track container creation
    */
@@ -277,9 +354,6 @@ class AdminMetricsService {
     };
 
     this.serverSnapshots.push(snapshot);
-    if (this.serverSnapshots.length > this.maxSnapshots) {
-      this.serverSnapshots.shift();
-    }
   }
 
   /**
@@ -305,8 +379,7 @@ class AdminMetricsService {
    * Format daily metrics for JSON response
    */
   private formatDailyMetrics(metrics: DailyMetrics): any {
-    const latencies = metrics.requestLatencies;
-    const sortedLatencies = [...latencies].sort((a, b) => a - b);
+    const latency = metrics.latency;
 
     return {
       date: metrics.date,
@@ -320,21 +393,14 @@ class AdminMetricsService {
           ? '100%'
           : Math.round((metrics.successfulRequests / metrics.totalRequests) * 100) + '%')
         : '0%',
+      // Percentiles are histogram estimates (within ~3%); lowest/highest are exact
       latency: {
-        average: latencies.length > 0
-          ? Math.round(latencies.reduce((a, b) => a + b, 0) / latencies.length)
-          : 0,
-        lowest: sortedLatencies.length > 0 ? sortedLatencies[0] : 0,
-        highest: sortedLatencies.length > 0 ? sortedLatencies[sortedLatencies.length - 1] : 0,
-        median: sortedLatencies.length > 0
-          ? sortedLatencies[Math.floor(sortedLatencies.length / 2)]
-          : 0,
-        p95: sortedLatencies.length > 0
-          ? sortedLatencies[Math.floor(sortedLatencies.length * 0.95)]
-          : 0,
-        p99: sortedLatencies.length > 0
-          ? sortedLatencies[Math.floor(sortedLatencies.length * 0.99)]
-          : 0,
+        average: latency.count > 0 ? Math.round(latency.sumMs / latency.count) : 0,
+        lowest: latency.minMs,
+        highest: latency.maxMs,
+        median: latency.percentile(50),
+        p95: latency.percentile(95),
+        p99: latency.percentile(99),
       },
       requestsByLanguage: Object.fromEntries(metrics.requestsByLanguage),
       requestsByType: Object.fromEntries(metrics.requestsByType),
@@ -366,24 +432,76 @@ class AdminMetricsService {
    * Get recent snapshots
    */
   getRecentSnapshots(count: number = 60): ServerSnapshot[] {
-    return this.serverSnapshots.slice(-count);
+    return this.serverSnapshots.last(count);
   }
 
   /**
-   * Get request history for a date range
+   * Get request history for a date range (the newest `limit` matches, oldest first).
+   * History is in arrival order, so the walk from the newest entry stops at the
+   * first one before startDate.
    */
   getRequestHistory(startDate?: Date, endDate?: Date, limit: number = 100): RequestMetrics[] {
-    let filtered = this.requestHistory;
+    const matches: RequestMetrics[] = [];
 
-    if (startDate) {
-      filtered = filtered.filter(r => r.timestamp >= startDate);
+    for (let i = 0; i < this.requestHistory.size && matches.length < limit; i++) {
+      const request = this.requestHistory.fromNewest(i)!;
+      if (endDate && request.timestamp > endDate) continue;
+      if (startDate && request.timestamp < startDate) break;
+      matches.push(request);
     }
 
-    if (endDate) {
-      filtered = filtered.filter(r => r.timestamp <= endDate);
+    return matches.reverse();
+  }
+
+  /**
+   * Per-minute request rollups for the last `minutes` minutes: one entry per
+   * minute that had requests (oldest first), plus per-language totals over the
+   * window. Percentiles are upper bounds of the coarse PROMETHEUS_BUCKETS_MS buckets.
+   */
+  getRollups(minutes: number = 60): any {
+    const now = Date.now();
+    const window = Math.max(1, Math.min(Math.floor(minutes), this.rollups.capacity));
+    const from = Math.floor(now / MINUTE_MS) * MINUTE_MS - (window - 1) * MINUTE_MS;
+
+    const totals = new Map<string, LanguageRollup>();
+    const series: any[] = [];
+    let requests = 0;
+    let errors = 0;
+
+    for (let i = 0; i < this.rollups.size; i++) {
+      const rollup = this.rollups.fromNewest(i)!;
+      if (rollup.minute < from) break;
+
+      requests += rollup.requests;
+      errors += rollup.errors;
+      const byLanguage: Record<string, any> = {};
+      for (const [language, stats] of rollup.languages) {
+        byLanguage[language] = formatLanguageRollup(stats);
+
+        const total = totals.get(language) ?? emptyLanguageRollup();
+        total.requests += stats.requests;
+        total.errors += stats.errors;
+        total.sumMs += stats.sumMs;
+        total.maxMs = Math.max(total.maxMs, stats.maxMs);
+        for (let b = 0; b < stats.buckets.length; b++) total.buckets[b] += stats.buckets[b];
+        totals.set(language, total);
+      }
+      series.push({
+        timestamp: new Date(rollup.minute).toISOString(),
+        requests: rollup.requests,
+        errors: rollup.errors,
+        byLanguage,
+      });
     }
 
-    return filtered.slice(-limit);
+    return {
+      minutes: window,
+      from: new Date(from).toISOString(),
+      requests,
+      errors,
+      byLanguage: Object.fromEntries([...totals].map(([language, total]) => [language, formatLanguageRollup(total)])),
+      series: series.reverse(),
+    };
   }
 
   /**
@@ -472,10 +590,11 @@ class AdminMetricsService {
    */
   resetAllMetrics(): void {
     this.dailyMetrics.clear();
-    this.requestHistory = [];
+    this.requestHistory.clear();
+    this.rollups.clear();
     this.activeClients.clear();
     this.activeExecutions.clear();
-    this.serverSnapshots = [];
+    this.serverSnapshots.clear();
 
     // Re-initialize today's metrics
     this.initializeDailyMetrics(this.getTodayDate());
@@ -6,7 +6,14 @@
 import { Router, Request, Response, NextFunction } from 'express';
 import { adminMetrics } from './adminMetrics';
 import { sessionPool } from './pool';
-import { getNetworkStats, getNetworkMetrics, getSubnetStats, resetNetworkMetrics } from './networkManager';
+import { sharedPostgres } from './sharedPostgres';
+import { getAgentStats } from './dockerClient';
+import { dockerHosts } from './dockerHosts';
+import { clusterState } from './clusterState';
+import { batchRunner } from './batchRunner';
+import { checkpointManager } from './checkpoints';
+import { speculativeBuilds } from './speculativeBuild';
+import { getNetworkStats, getNetworkMetrics, getSubnetStats, getNetworkPoolStats, resetNetworkMetrics } from './networkManager';
 import { pipelineMetrics } from './pipelineMetrics';
 
 import { config } from './config';
@@ -69,7 +76,7 @@ router.get('/stats', adminAuth, async (req: Request, res: Response) => {
     try {
       const indexModule = await import('./index');
       if (indexModule.executionQueue) {
-        queueStats = indexModule.executionQueue.getStats();
+        queueStats = indexModule.executionQueue.getDetailedStats();
       }
     } catch (err) {
       // If we can't import, use default values
@@ -90,6 +97,7 @@ router.get('/stats', adminAuth, async (req: Request, res: Response) => {
         created: poolMetrics.containersCreated,
         reused: poolMetrics.containersReused,
         deleted: poolMetrics.containersDeleted,
+        lost: poolMetrics.containersLost,
         cleanupErrors: poolMetrics.cleanupErrors,
       },
       networks: {
@@ -99,7 +107,15 @@ router.get('/stats', adminAuth, async (req: Request, res: Response) => {
         created: networkMetrics.networksCreated,
         deleted: networkMetrics.networksDeleted,
         cleanupErrors: networkMetrics.cleanupErrors,
+        pool: getNetworkPoolStats(),
       },
+      sqlBackend: sharedPostgres.getStats(),
+      agents: getAgentStats(),
+      checkpoints: checkpointManager.getStats(),
+      speculativeBuilds: speculativeBuilds.getStats(),
+      dockerHosts: dockerHosts.getStats(),
+      cluster: clusterState.getStats(),
+      batch: batchRunner.getStats(),
       executions: {
         queued: queueStats.queued,
         active: queueStats.active,
@@ -115,6 +131,42 @@ router.get('/stats', adminAuth, async (req: Request, res: Response) => {
   }
 });
 
+/**
+ * GET /admin/hosts - Docker hosts with their state, load and placements
+ */
+router.get('/hosts', adminAuth, (req: Request, res: Response) => {
+  res.json(dockerHosts.getStats());
+});
+
+/**
+ * POST /admin/hosts/:name/drain - Stop placing new sessions on a host.
+ * Sessions already there keep running until they end.
+ */
+router.post('/hosts/:name/drain', adminAuth, (req: Request, res: Response) => {
+  if (!dockerHosts.drain(req.params.name)) {
+    return res.status(404).json({ error: `Unknown Docker host: ${req.params.name}` });
+  }
+  res.json({ success: true, host: dockerHosts.getStats().hosts.find(h => h.name === req.params.name) });
+});
+
+/**
+ * POST /admin/hosts/:name/undrain - Place new sessions on a drained host again
+ */
+router.post('/hosts/:name/undrain', adminAuth, (req: Request, res: Response) => {
+  if (!dockerHosts.undrain(req.params.name)) {
+    return res.status(404).json({ error: `Unknown Docker host: ${req.params.name}` });
+  }
+  res.json({ success: true, host: dockerHosts.getStats().hosts.find(h => h.name === req.params.name) });
+});
+
+/**
+ * GET /admin/cluster - Server instances with their load (all of them when
+ * CLUSTER_STATE_URL is set; other stats are those of the answering instance)
+ */
+router.get('/cluster', adminAuth, (req: Request, res: Response) => {
+  res.json(clusterState.getStats());
+});
+
 /**
  * GET /admin/metrics/today - Today's metrics
  */
@@ -198,6 +250,7 @@ router.post('/reset', adminAuth, async (req: Request, res: Response) => {
     adminMetrics.resetAllMetrics();
     sessionPool.resetMetrics();
     resetNetworkMetrics();
+    speculativeBuilds.resetStats();
 
     res.json({
       success: true,
@@ -224,6 +277,18 @@ router.get('/snapshots', adminAuth, (req: Request, res: Response) => {
   }
 });
 
+/**
+ * GET /admin/rollups - Per-minute request counts, errors and latency by language
+ */
+router.get('/rollups', adminAuth, (req: Request, res: Response) => {
+  try {
+    const minutes = parseInt(req.query.minutes as string) || 60;
+    res.json(adminMetrics.getRollups(minutes));
+  } catch (error: any) {
+    res.status(500).json({ error: error.message });
+  }
+});
+
 /**
  * GET /admin/history - Request history
  */
@@ -323,14 +388,103 @@ router.delete('/load-test-reports/:id', adminAuth, (req: Request, res: Response)
   }
 });
 
+/**
+ * GET /admin/regression-runs - List performance regression suite runs
+ */
+router.get('/regression-runs', adminAuth, (req: Request, res: Response) => {
+  try {
+    const { getRuns } = require('../tests/utils/baseline-manager');
+    res.json(getRuns());
+  } catch (error: any) {
+    res.status(500).json({ error: `Failed to get regression runs: ${error.message}` });
+  }
+});
+
+/**
+ * GET /admin/regression-runs/:id - A regression run with its baseline comparison
+ */
+router.get('/regression-runs/:id', adminAuth, (req: Request, res: Response) => {
+  try {
+    const { getRun } = require('../tests/utils/baseline-manager');
+    const run = getRun(req.params.id);
+
+    if (!run) {
+      return res.status(404).json({ error: 'Regression run not found' });
+    }
+
+    res.json(run);
+  } catch (error: any) {
+    res.status(500).json({ error: `Failed to get regression run: ${error.message}` });
+  }
+});
+
+/**
+ * GET /admin/regression-baselines - List performance baseline versions
+ */
+router.get('/regression-baselines', adminAuth, (req: Request, res: Response) => {
+  try {
+    const { getBaselines } = require('../tests/utils/baseline-manager');
+    res.json(getBaselines());
+  } catch (error: any) {
+    res.status(500).json({ error: `Failed to get baselines: ${error.message}` });
+  }
+});
+
 /**
  * GET /admin/pipeline-metrics - Execution pipeline latency breakdown
- * Returns per-stage p50/p95/p99 percentiles, by-language stats, and slow execution log
+ * Returns per-stage p50/p90/p95/p99 percentiles, by-language stats, and slow execution log
  */
 router.get('/pipeline-metrics', adminAuth, (req: Request, res: Response) => {
   res.json(pipelineMetrics.getStats());
 });
 
+/**
+ * GET /admin/prometheus - Prometheus scrape endpoint
+ * Stage duration histograms per language, pipeline/build cache counters and queue gauges.
+ * Scrape with the X-Admin-Key header (http_headers in the scrape config).
+ */
+router.get('/prometheus', adminAuth, async (req: Request, res: Response) => {
+  let body = pipelineMetrics.renderPrometheus();
+
+  // Queue gauges - import at runtime to avoid circular dependency
+  try {
+    const indexModule = await import('./index');
+    if (indexModule.executionQueue) {
+      const queueStats = indexModule.executionQueue.getStats();
+      body += [
+        '# HELP coderunner_queue_tasks Tasks waiting in the execution queue.',
+        '# TYPE coderunner_queue_tasks gauge',
+        `coderunner_queue_tasks ${queueStats.queued}`,
+        '# HELP coderunner_queue_active_tasks Tasks currently executing.',
+        '# TYPE coderunner_queue_active_tasks gauge',
+        `coderunner_queue_active_tasks ${queueStats.active}`,
+        '# HELP coderunner_queue_concurrency_limit Current concurrency limit (cost units with adaptive concurrency).',
+        '# TYPE coderunner_queue_concurrency_limit gauge',
+        `coderunner_queue_concurrency_limit ${queueStats.concurrencyLimit}`,
+        '',
+      ].join('\n');
+    }
+  } catch (err) {
+    logger.warn('Admin', `Could not import executionQueue: ${err}`);
+  }
+
+  const { hosts } = dockerHosts.getStats();
+  body += [
+    '# HELP coderunner_docker_host_containers Containers tracked on a Docker host.',
+    '# TYPE coderunner_docker_host_containers gauge',
+    ...hosts.map(h => `coderunner_docker_host_containers{host="${h.name}",state="${h.state}"} ${h.containers}`),
+    '# HELP coderunner_docker_host_sessions Sessions pinned to a Docker host.',
+    '# TYPE coderunner_docker_host_sessions gauge',
+    ...hosts.map(h => `coderunner_docker_host_sessions{host="${h.name}"} ${h.sessions}`),
+    '# HELP coderunner_docker_host_placements_total Sessions placed on a Docker host.',
+    '# TYPE coderunner_docker_host_placements_total counter',
+    ...hosts.map(h => `coderunner_docker_host_placements_total{host="${h.name}"} ${h.placements}`),
+    '',
+  ].join('\n');
+
+  res.type('text/plain; version=0.0.4').send(body);
+});
+
 /**
  * GET /admin/logs - Centralized server logs
  * Query params: limit, level, category, search, sinceId
@@ -0,0 +1,181 @@
+/**
+ * Tests for the execution agent protocol
+ * The connection is wired to an in-process fake agent; no container is involved.
+ */
+
+import {
+  AgentConnection,
+  FrameDecoder,
+  agentContainerCommand,
+  encodeExec,
+  encodeFrame,
+  encodePut,
+  parseExitReport,
+  AGENT_PATH,
+  AGENT_PROTOCOL,
+} from './agent';
+
+interface Frame {
+  type: string;
+  channel: number;
+  payload: Buffer;
+}
+
+/** Connection whose frames are recorded and answered by `respond` */
+function fakeAgent(respond: (frame: Frame, reply: (type: string, payload?: Buffer) => void) => void) {
+  const received: Frame[] = [];
+  let connection: AgentConnection;
+  const decoder = new FrameDecoder((type, channel, payload) => {
+    const frame = { type, channel, payload: Buffer.from(payload) };
+    received.push(frame);
+    respond(frame, (replyType, replyPayload) => {
+      // Split the reply to exercise reassembly across chunks
+      const bytes = encodeFrame(replyType, channel, replyPayload);
+      setImmediate(() => {
+        connection.receive(bytes.subarray(0, 5));
+        connection.receive(bytes.subarray(5));
+      });
+    });
+  });
+  connection = new AgentConnection('container-0123456789', (data) => decoder.push(data));
+  return { connection, received };
+}
+
+describe('FrameDecoder', () => {
+  it('should reassemble frames split and batched across chunks', () => {
+    const frames: Frame[] = [];
+    const decoder = new FrameDecoder((type, channel, payload) => frames.push({ type, channel, payload: Buffer.from(payload) }));
+    const bytes = Buffer.concat([encodeFrame('o', 1, Buffer.from('hello')), encodeFrame('x', 1, Buffer.from('0'))]);
+
+    decoder.push(bytes.subarray(0, 3));
+    decoder.push(bytes.subarray(3, 17));
+    decoder.push(bytes.subarray(17));
+
+    expect(frames.map(f => [f.type, f.channel, f.payload.toString()])).toEqual([['o', 1, 'hello'], ['x', 1, '0']]);
+  });
+});
+
+describe('encoding', () => {
+  it('should encode exec requests as NUL-separated fields', () => {
+    expect(encodeExec('echo hi', '/app', ['A=1']).toString()).toBe('/app\0echo hi\0A=1\0');
+  });
+
+  it('should encode uploads with per-file headers', () => {
+    const payload = encodePut('/app', [{ path: 'a.py', content: 'x', mode: 0o755 }]);
+    expect(payload.subarray(0, 5).toString()).toBe('/app\0');
+    expect(payload.readUInt32BE(5)).toBe(4);
+    expect(payload.readUInt32BE(9)).toBe(0o755);
+    expect(payload.readUInt32BE(13)).toBe(1);
+    expect(payload.subarray(17).toString()).toBe('a.pyx');
+  });
+
+  it('should parse exit reports with resource usage', () => {
+    expect(parseExitReport(Buffer.from('3 1500 250 2048 12000'))).toEqual({
+      exitCode: 3,
+      usage: { userMs: 1.5, systemMs: 0.25, maxRssKb: 2048, wallMs: 12 },
+    });
+    expect(parseExitReport(Buffer.from('137'))).toEqual({ exitCode: 137, usage: null });
+  });
+});
+
+describe('AgentConnection', () => {
+  it('should accept an agent that answers the hello', async () => {
+    const { connection } = fakeAgent((frame, reply) => {
+      if (frame.type === 'H') reply('h', Buffer.from(AGENT_PROTOCOL));
+    });
+    await expect(connection.hello(1000)).resolves.toBe(true);
+  });
+
+  it('should reject a main process that never answers', async () => {
+    const { connection } = fakeAgent(() => {});
+    await expect(connection.hello(20)).resolves.toBe(false);
+  });
+
+  it('should stream output and report the exit status', async () => {
+    const { connection, received } = fakeAgent((frame, reply) => {
+      if (frame.type === 'I' && frame.payload.length > 0) reply('o', frame.payload);
+      if (frame.type === 'I' && frame.payload.length === 0) {
+        reply('e', Buffer.from('warn\n'));
+        reply('x', Buffer.from('0 100 0 512 2000'));
+      }
+    });
+
+    const run = connection.exec('cat', { env: ['A=1'] });
+    const stdout: string[] = [];
+    const stderr: string[] = [];
+    run.stdout.on('data', (chunk: Buffer) => stdout.push(chunk.toString()));
+    run.stderr.on('data', (chunk: Buffer) => stderr.push(chunk.toString()));
+    run.stdin.write('line\n');
+    run.stdin.end();
+
+    const status = await run.exited;
+    expect(status.exitCode).toBe(0);
+    expect(status.usage?.maxRssKb).toBe(512);
+    expect(stdout.join('')).toBe('line\n');
+    expect(stderr.join('')).toBe('warn\n');
+    expect(received[0]).toMatchObject({ type: 'X', payload: encodeExec('cat', '/app', ['A=1']) });
+    expect(connection.activeExecs).toBe(0);
+  });
+
+  it('should signal, pause and resume by channel', () => {
+    const { connection, received } = fakeAgent(() => {});
+    const run = connection.exec('sleep 10');
+
+    run.pause();
+    run.resume();
+    run.kill();
+
+    const channel = received[0].channel;
+    expect(received.slice(1).map(f => [f.type, f.channel])).toEqual([['P', channel], ['R', channel], ['K', channel]]);
+    expect(received[3].payload[0]).toBe(9);
+  });
+
+  it('should upload files and read them back', async () => {
+    const files = new Map<string, Buffer>();
+    const { connection } = fakeAgent((frame, reply) => {
+      if (frame.type === 'F') {
+        files.set('/app/main.py', Buffer.from('print(1)'));
+        reply('r', Buffer.from([0]));
+      }
+      if (frame.type === 'G') {
+        const content = files.get(frame.payload.toString());
+        reply('r', content ? Buffer.concat([Buffer.from([0]), content]) : Buffer.from([1]));
+      }
+    });
+
+    const bytes = await connection.putFiles('/app', [{ path: 'main.py', content: 'print(1)' }]);
+    expect(bytes).toBeGreaterThan(0);
+    expect((await connection.readFile('/app/main.py'))?.toString()).toBe('print(1)');
+    expect(await connection.readFile('/app/missing')).toBeNull();
+  });
+
+  it('should surface upload errors', async () => {
+    const { connection } = fakeAgent((frame, reply) => {
+      if (frame.type === 'F') reply('r', Buffer.concat([Buffer.from([1]), Buffer.from('put /app/x: No space left on device')]));
+    });
+    await expect(connection.putFiles('/app', [{ path: 'x', content: '' }])).rejects.toThrow('No space left');
+  });
+
+  it('should end running execs when the connection closes', async () => {
+    const onClose = jest.fn();
+    const connection = new AgentConnection('container-0123456789', () => {}, onClose);
+    const run = connection.exec('sleep 10');
+
+    connection.close();
+
+    await expect(run.exited).resolves.toEqual({ exitCode: -1, usage: null });
+    expect(onClose).toHaveBeenCalled();
+    expect(() => connection.exec('true')).toThrow('closed');
+  });
+});
+
+describe('agentContainerCommand', () => {
+  it('should fall back to the plain command on images without the agent', () => {
+    expect(agentContainerCommand()).toEqual([
+      '/bin/sh', '-c', `[ -x ${AGENT_PATH} ] && exec ${AGENT_PATH}; exec tail -f /dev/null`, 'sh',
+    ]);
+    expect(agentContainerCommand(['/opt/service'])).toEqual([
+      '/bin/sh', '-c', `[ -x ${AGENT_PATH} ] && exec ${AGENT_PATH} "$@"; exec "$@"`, 'sh', '/opt/service',
+    ]);
+  });
+});
@@ -0,0 +1,309 @@
+/**
+ * In-Container Execution Agent
+ *
+ * Session containers run cr-agent (runtimes/agent/cr-agent.c) as their main
+ * process. The server attaches to the container once and multiplexes every run
+ * of the session over that one stream, so a run costs no Docker Engine API
+ * calls: no exec create/start/inspect, no putArchive/getArchive, no cleanup
+ * execs. The agent streams stdout/stderr, reports the exit code with the
+ * process's resource usage and kills the whole process group on request.
+ *
+ * dockerClient.ts routes execs, uploads and reads through a connected agent and
+ * falls back to the Docker API for containers without one (older images, SQL
+ * containers, runs as another user).
+ *
+ * Frames are `type (1) | channel (u32 BE) | length (u32 BE) | payload`; see the
+ * header of cr-agent.c for the message types.
+ */
+
+import { PassThrough, Writable } from 'stream';
+import { logger } from './logger';
+import type { FileEntry } from './dockerClient';
+
+/** Version string the agent answers a hello with */
+export const AGENT_PROTOCOL = 'cr-agent 1';
+
+/** Agent binary baked into the runtime images (copied from agent-runtime) */
+export const AGENT_PATH = '/opt/coderunner/bin/cr-agent';
+
+const HEADER_BYTES = 9;
+const MAX_FRAME_BYTES = 64 * 1024 * 1024;
+
+/** Resource usage of a finished process, from wait4() in the container */
+export interface ResourceUsage {
+  userMs: number;
+  systemMs: number;
+  maxRssKb: number;
+  wallMs: number;
+}
+
+export interface AgentExitStatus {
+  exitCode: number;
+  usage: ResourceUsage | null;
+}
+
+export interface AgentExec {
+  stdout: PassThrough;
+  stderr: PassThrough;
+  stdin: Writable;
+  /** Resolves once the process exited and all of its output was pushed */
+  exited: Promise<AgentExitStatus>;
+  /** Signal the process group (SIGKILL by default) */
+  kill: (signal?: number) => void;
+  pause: () => void;
+  resume: () => void;
+}
+
+export function encodeFrame(type: string, channel: number, payload: Buffer = Buffer.alloc(0)): Buffer {
+  const header = Buffer.alloc(HEADER_BYTES);
+  header.write(type, 0, 1, 'latin1');
+  header.writeUInt32BE(channel >>> 0, 1);
+  header.writeUInt32BE(payload.length, 5);
+  return Buffer.concat([header, payload]);
+}
+
+/** Splits the agent's output stream back into frames */
+export class FrameDecoder {
+  private pending = Buffer.alloc(0);
+
+  constructor(private readonly onFrame: (type: string, channel: number, payload: Buffer) => void) {}
+
+  push(chunk: Buffer): void {
+    this.pending = this.pending.length ? Buffer.concat([this.pending, chunk]) : chunk;
+    while (this.pending.length >= HEADER_BYTES) {
+      const length = this.pending.readUInt32BE(5);
+      if (length > MAX_FRAME_BYTES) throw new Error(`Agent frame of ${length} bytes rejected`);
+      if (this.pending.length < HEADER_BYTES + length) break;
+      const type = String.fromCharCode(this.pending[0]);
+      const channel = this.pending.readUInt32BE(1);
+      const payload = this.pending.subarray(HEADER_BYTES, HEADER_BYTES + length);
+      this.pending = this.pending.subarray(HEADER_BYTES + length);
+      this.onFrame(type, channel, payload);
+    }
+  }
+}
+
+/** `cwd\0command\0NAME=value\0...` */
+export function encodeExec(command: string, workDir: string, env: string[] = []): Buffer {
+  return Buffer.from([workDir, command, ...env].map(part => `${part}\0`).join(''), 'utf-8');
+}
+
+/** `dir\0` followed by `pathlen | mode | size | path | data` per file */
+export function encodePut(destDir: string, files: FileEntry[]): Buffer {
+  const parts: Buffer[] = [Buffer.from(`${destDir}\0`, 'utf-8')];
+  for (const file of files) {
+    const path = Buffer.from(file.path, 'utf-8');
+    const content = Buffer.isBuffer(file.content) ? file.content : Buffer.from(file.content, 'utf-8');
+    const header = Buffer.alloc(12);
+    header.writeUInt32BE(path.length, 0);
+    header.writeUInt32BE(file.mode ?? 0o644, 4);
+    header.writeUInt32BE(content.length, 8);
+    parts.push(header, path, content);
+  }
+  return Buffer.concat(parts);
+}
+
+/** `<code> <user_us> <sys_us> <maxrss_kb> <wall_us>` */
+export function parseExitReport(payload: Buffer): AgentExitStatus {
+  const [code, user, sys, rss, wall] = payload.toString('latin1').trim().split(/\s+/).map(Number);
+  const exitCode = Number.isFinite(code) ? code : -1;
+  if (![user, sys, rss, wall].every(Number.isFinite)) return { exitCode, usage: null };
+  return {
+    exitCode,
+    usage: { userMs: user / 1000, systemMs: sys / 1000, maxRssKb: rss, wallMs: wall / 1000 },
+  };
+}
+
+interface PendingReply {
+  resolve: (reply: { ok: boolean; data: Buffer }) => void;
+  reject: (err: Error) => void;
+}
+
+interface ActiveExec {
+  stdout: PassThrough;
+  stderr: PassThrough;
+  resolve: (status: AgentExitStatus) => void;
+}
+
+/**
+ * One attached agent. `write` sends raw bytes to the agent's stdin; agent
+ * stdout must be fed to `receive` (already demultiplexed from Docker's framing).
+ */
+export class AgentConnection {
+  private nextChannel = 1;
+  private readonly replies = new Map<number, PendingReply>();
+  private readonly execs = new Map<number, ActiveExec>();
+  private readonly decoder = new FrameDecoder((type, channel, payload) => this.onFrame(type, channel, payload));
+  private closed = false;
+
+  constructor(
+    readonly containerId: string,
+    private readonly write: (data: Buffer) => void,
+    private readonly onClose: () => void = () => {},
+  ) {}
+
+  get isOpen(): boolean {
+    return !this.closed;
+  }
+
+  get activeExecs(): number {
+    return this.execs.size;
+  }
+
+  receive(chunk: Buffer): void {
+    try {
+      this.decoder.push(chunk);
+    } catch (err: any) {
+      logger.warn('Agent', `${this.containerId.substring(0, 12)}: ${err.message}`);
+      this.close();
+    }
+  }
+
+  /** Resolves true once the agent answered with the expected protocol version */
+  async hello(timeoutMs: number): Promise<boolean> {
+    try {
+      const reply = await this.request('H', Buffer.alloc(0), timeoutMs);
+      return reply.data.toString('latin1') === AGENT_PROTOCOL;
+    } catch {
+      return false;
+    }
+  }
+
+  exec(command: string, options: { workDir?: string; env?: string[] } = {}): AgentExec {
+    if (this.closed) throw new Error('Agent connection closed');
+    const channel = this.allocateChannel();
+    const stdout = new PassThrough();
+    const stderr = new PassThrough();
+
+    const exited = new Promise<AgentExitStatus>((resolve) => {
+      this.execs.set(channel, { stdout, stderr, resolve });
+    });
+    this.send('X', channel, encodeExec(command, options.workDir ?? '/app', options.env));
+
+    const stdin = new Writable({
+      write: (chunk: Buffer | string, _encoding, callback) => {
+        if (this.execs.has(channel)) {
+          this.send('I', channel, Buffer.isBuffer(chunk) ? chunk : Buffer.from(chunk));
+        }
+        callback();
+      },
+      final: (callback) => {
+        if (this.execs.has(channel)) this.send('I', channel);
+        callback();
+      },
+    });
+
+    return {
+      stdout,
+      stderr,
+      stdin,
+      exited,
+      kill: (signal = 9) => {
+        if (this.execs.has(channel)) this.send('K', channel, Buffer.from([signal]));
+      },
+      pause: () => {
+        if (this.execs.has(channel)) this.send('P', channel);
+      },
+      resume: () => {
+        if (this.execs.has(channel)) this.send('R', channel);
+      },
+    };
+  }
+
+  /** Write files under destDir; resolves to the bytes sent */
+  async putFiles(destDir: string, files: FileEntry[], timeoutMs = 30_000): Promise<number> {
+    const payload = encodePut(destDir, files);
+    const reply = await this.request('F', payload, timeoutMs);
+    if (!reply.ok) throw new Error(reply.data.toString('utf-8') || 'Agent upload failed');
+    return payload.length;
+  }
+
+  /** Contents of a regular file, or null when it doesn't exist */
+  async readFile(filePath: string, timeoutMs = 30_000): Promise<Buffer | null> {
+    const reply = await this.request('G', Buffer.from(filePath, 'utf-8'), timeoutMs);
+    return reply.ok ? reply.data : null;
+  }
+
+  /** Fail everything in flight; the streams of running execs end with exit code -1 */
+  close(): void {
+    if (this.closed) return;
+    this.closed = true;
+    for (const reply of this.replies.values()) reply.reject(new Error('Agent connection closed'));
+    this.replies.clear();
+    for (const active of this.execs.values()) {
+      active.stdout.end();
+      active.stderr.end();
+      active.resolve({ exitCode: -1, usage: null });
+    }
+    this.execs.clear();
+    this.onClose();
+  }
+
+  private request(type: string, payload: Buffer, timeoutMs: number): Promise<{ ok: boolean; data: Buffer }> {
+    if (this.closed) return Promise.reject(new Error('Agent connection closed'));
+    const channel = this.allocateChannel();
+    return new Promise((resolve, reject) => {
+      const timer = setTimeout(() => {
+        this.replies.delete(channel);
+        reject(new Error(`Agent request timed out after ${timeoutMs}ms`));
+      }, timeoutMs);
+      this.replies.set(channel, {
+        resolve: (reply) => { clearTimeout(timer); resolve(reply); },
+        reject: (err) => { clearTimeout(timer); reject(err); },
+      });
+      this.send(type, channel, payload);
+    });
+  }
+
+  private onFrame(type: string, channel: number, payload: Buffer): void {
+    switch (type) {
+      case 'o':
+      case 'e': {
+        const active = this.execs.get(channel);
+        if (active) (type === 'o' ? active.stdout : active.stderr).write(Buffer.from(payload));
+        break;
+      }
+      case 'x': {
+        const active = this.execs.get(channel);
+        if (!active) break;
+        this.execs.delete(channel);
+        active.stdout.end();
+        active.stderr.end();
+        active.resolve(parseExitReport(payload));
+        break;
+      }
+      case 'h':
+      case 'r': {
+        const reply = this.replies.get(channel);
+        if (!reply) break;
+        this.replies.delete(channel);
+        const ok = type === 'h' || payload[0] === 0;
+        reply.resolve({ ok, data: Buffer.from(type === 'h' ? payload : payload.subarray(1)) });
+        break;
+      }
+      default:
+        logger.debug('Agent', `${this.containerId.substring(0, 12)}: unexpected frame '${type}'`);
+    }
+  }
+
+  private send(type: string, channel: number, payload?: Buffer): void {
+    this.write(encodeFrame(type, channel, payload));
+  }
+
+  private allocateChannel(): number {
+    const channel = this.nextChannel;
+    this.nextChannel = this.nextChannel >= 0xffffffff ? 1 : this.nextChannel + 1;
+    return channel;
+  }
+}
+
+/**
+ * Container command running `inner` under the agent when the image ships it,
+ * and `inner` alone (or the plain idle process) otherwise.
+ */
+export function agentContainerCommand(inner?: string[]): string[] {
+  if (!inner) {
+    return ['/bin/sh', '-c', `[ -x ${AGENT_PATH} ] && exec ${AGENT_PATH}; exec tail -f /dev/null`, 'sh'];
+  }
+  return ['/bin/sh', '-c', `[ -x ${AGENT_PATH} ] && exec ${AGENT_PATH} "$@"; exec "$@"`, 'sh', ...inner];
+}
@@ -0,0 +1,92 @@
+/**
+ * Tests for the batch runner
+ * Jobs are stubs; assertions are on lanes, session reuse, ordering and cancellation.
+ */
+
+import { BatchRunner, type BatchJob, type BatchResult } from './batchRunner';
+import { ExecutionQueue } from './executionQueue';
+
+function job(index: number, language: string, run?: BatchJob['run']): BatchJob {
+  return {
+    index,
+    id: `job-${index}`,
+    language,
+    run: run ?? (async () => ({ stdout: `out-${index}`, stderr: '', exitCode: 0 })),
+  };
+}
+
+describe('BatchRunner', () => {
+  it('should run each language in its own reused lane sessions', async () => {
+    const runner = new BatchRunner(new ExecutionQueue(4, 100, 60000));
+    const sessions: string[] = [];
+    const record: BatchJob['run'] = async (sessionId) => {
+      sessions.push(sessionId);
+      return { stdout: '', stderr: '', exitCode: 0 };
+    };
+    const released = jest.fn().mockResolvedValue(undefined);
+    const results: BatchResult[] = [];
+
+    const summary = await runner.run(
+      [job(0, 'python', record), job(1, 'cpp', record), job(2, 'python', record), job(3, 'python', record)],
+      { onResult: r => results.push(r), releaseSession: released, lanesPerLanguage: 1 },
+    );
+
+    expect(new Set(sessions).size).toBe(2);
+    expect(sessions.filter(s => s.endsWith('-python-0'))).toHaveLength(3);
+    expect(released).toHaveBeenCalledTimes(2);
+    expect(results.map(r => r.index).sort()).toEqual([0, 1, 2, 3]);
+    expect(summary).toMatchObject({ done: true, total: 4, succeeded: 4, failed: 0, cancelled: 0 });
+  });
+
+  it('should report results as jobs finish, not in request order', async () => {
+    const runner = new BatchRunner(new ExecutionQueue(4, 100, 60000));
+    let finishSlow: () => void = () => {};
+    const slow: BatchJob['run'] = () => new Promise(resolve => {
+      finishSlow = () => resolve({ stdout: '', stderr: '', exitCode: 0 });
+    });
+    const order: number[] = [];
+
+    const done = runner.run([job(0, 'java', slow), job(1, 'java')], {
+      onResult: r => {
+        order.push(r.index);
+        if (r.index === 1) finishSlow();
+      },
+      releaseSession: async () => undefined,
+      lanesPerLanguage: 2,
+    });
+
+    await done;
+    expect(order).toEqual([1, 0]);
+  });
+
+  it('should count failed and thrown jobs and keep going', async () => {
+    const runner = new BatchRunner(new ExecutionQueue(1, 100, 60000));
+    const results: BatchResult[] = [];
+
+    const summary = await runner.run([
+      job(0, 'python', async () => ({ stdout: '', stderr: 'boom', exitCode: 1 })),
+      job(1, 'python', async () => { throw new Error('container gone'); }),
+      job(2, 'python'),
+    ], { onResult: r => results.push(r), releaseSession: async () => undefined });
+
+    expect(summary).toMatchObject({ succeeded: 1, failed: 2 });
+    expect(results.find(r => r.index === 1)).toMatchObject({ id: 'job-1', error: 'container gone' });
+  });
+
+  it('should stop taking jobs once cancelled and release its sessions', async () => {
+    const runner = new BatchRunner(new ExecutionQueue(1, 100, 60000));
+    let cancelled = false;
+    const released = jest.fn().mockResolvedValue(undefined);
+
+    const summary = await runner.run([job(0, 'python'), job(1, 'python'), job(2, 'python')], {
+      onResult: () => { cancelled = true; },
+      releaseSession: released,
+      isCancelled: () => cancelled,
+      lanesPerLanguage: 1,
+    });
+
+    expect(summary).toMatchObject({ succeeded: 1, cancelled: 2 });
+    expect(released).toHaveBeenCalledTimes(1);
+    expect(runner.getStats()).toMatchObject({ batches: 1, activeBatches: 0, cancelled: 2 });
+  });
+});
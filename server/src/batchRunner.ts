@@ -0,0 +1,197 @@
+/**
+ * Batch Runner (POST /api/run/batch)
+ *
+ * Runs many independent jobs (e.g. graded submissions) in one request. Jobs are
+ * grouped by language and each group is worked off by a few lanes. A lane is
+ * one batch session, so its container and network are set up once and reused
+ * by every job the lane takes, with the delta file sync replacing one job's
+ * files by the next's. Lanes take the next job of their language as soon as
+ * they finish one, so a slow job doesn't hold up the rest.
+ *
+ * Batch jobs run through their own ExecutionQueue (batchQueue) with its own
+ * slots, so a large batch never takes execution slots from interactive runs.
+ * Results are reported in completion order.
+ */
+
+import { config } from './config';
+import { logger } from './logger';
+import { ExecutionQueue } from './executionQueue';
+import type { PipelineTimings } from './pipelineMetrics';
+
+export interface BatchRunOutput {
+  stdout: string;
+  stderr: string;
+  exitCode: number;
+  compileMs?: number;
+  runMs?: number;
+  /** Stage timings, for jobs that asked for them */
+  pipeline?: PipelineTimings;
+}
+
+export interface BatchJob {
+  /** Position in the request */
+  index: number;
+  /** Caller's id for the job, echoed in its result */
+  id?: string;
+  language: string;
+  /** Run the job in the lane's session; queueMs is the wait for a batch slot */
+  run: (sessionId: string, queueMs: number) => Promise<BatchRunOutput>;
+}
+
+export interface BatchResult extends Partial<BatchRunOutput> {
+  index: number;
+  id?: string;
+  language: string;
+  /** Wall time of the job, excluding its wait for a slot */
+  executionTime?: number;
+  queueMs?: number;
+  /** Set when the job could not run at all */
+  error?: string;
+}
+
+export interface BatchSummary {
+  done: true;
+  total: number;
+  succeeded: number;
+  failed: number;
+  /** Jobs never started because the client went away */
+  cancelled: number;
+  durationMs: number;
+}
+
+export interface BatchRunOptions {
+  /** Called with each result as soon as its job finishes */
+  onResult: (result: BatchResult) => void;
+  /** Remove a lane's containers and network once it has no jobs left */
+  releaseSession: (sessionId: string) => Promise<void>;
+  /** Checked before each job; true stops the lanes (client disconnected) */
+  isCancelled?: () => boolean;
+  lanesPerLanguage?: number;
+}
+
+export class BatchRunner {
+  private nextBatch = 0;
+  private stats = {
+    batches: 0,
+    activeBatches: 0,
+    jobs: 0,
+    succeeded: 0,
+    failed: 0,
+    cancelled: 0,
+  };
+
+  constructor(private readonly queue: ExecutionQueue) {}
+
+  /**
+   * Run all jobs, reporting each result through onResult.
+   * Resolves once every lane has finished and released its session.
+   */
+  async run(jobs: BatchJob[], options: BatchRunOptions): Promise<BatchSummary> {
+    const startTime = Date.now();
+    const batchId = `batch-${Date.now()}-${(this.nextBatch++).toString(36)}`;
+    const lanesPerLanguage = Math.max(1, options.lanesPerLanguage ?? config.batch.lanesPerLanguage);
+    const isCancelled = options.isCancelled ?? (() => false);
+    const summary: BatchSummary = { done: true, total: jobs.length, succeeded: 0, failed: 0, cancelled: 0, durationMs: 0 };
+
+    const report = (result: BatchResult) => {
+      if (result.exitCode === 0 && !result.error) {
+        summary.succeeded++;
+      } else {
+        summary.failed++;
+      }
+      try {
+        options.onResult(result);
+      } catch (error: any) {
+        logger.warn('Batch', `Result handler error: ${error.message}`);
+      }
+    };
+
+    const byLanguage = new Map<string, BatchJob[]>();
+    for (const job of jobs) {
+      const group = byLanguage.get(job.language) ?? [];
+      group.push(job);
+      byLanguage.set(job.language, group);
+    }
+
+    this.stats.batches++;
+    this.stats.activeBatches++;
+    this.stats.jobs += jobs.length;
+    logger.info('Batch', `${batchId}: ${jobs.length} jobs in ${byLanguage.size} languages`);
+
+    const lanes: Promise<void>[] = [];
+    for (const [language, group] of byLanguage) {
+      let next = 0;
+      const take = () => (next < group.length ? group[next++] : undefined);
+      const laneCount = Math.min(lanesPerLanguage, group.length);
+      const languageLanes: Promise<void>[] = [];
+      for (let lane = 0; lane < laneCount; lane++) {
+        const sessionId = `${batchId}-${language}-${lane}`;
+        languageLanes.push(this.runLane(sessionId, language, take, report, isCancelled)
+          .finally(() => options.releaseSession(sessionId).catch(err =>
+            logger.error('Batch', `Failed to release ${sessionId}: ${err}`)
+          )));
+      }
+      // Jobs left when the lanes stopped early were cancelled
+      lanes.push(Promise.all(languageLanes).then(() => {
+        summary.cancelled += group.length - next;
+      }));
+    }
+
+    await Promise.all(lanes);
+    summary.durationMs = Date.now() - startTime;
+    this.stats.activeBatches--;
+    this.stats.succeeded += summary.succeeded;
+    this.stats.failed += summary.failed;
+    this.stats.cancelled += summary.cancelled;
+    logger.info('Batch', `${batchId}: ${summary.succeeded} succeeded, ${summary.failed} failed, ${summary.cancelled} cancelled in ${summary.durationMs}ms`);
+    return summary;
+  }
+
+  getStats() {
+    return { ...this.stats, queue: this.queue.getStats() };
+  }
+
+  /** Work off jobs of one language one after another in the lane's session */
+  private async runLane(
+    sessionId: string,
+    language: string,
+    take: () => BatchJob | undefined,
+    report: (result: BatchResult) => void,
+    isCancelled: () => boolean,
+  ): Promise<void> {
+    for (;;) {
+      if (isCancelled()) return;
+      const job = take();
+      if (!job) return;
+
+      const enqueuedAt = Date.now();
+      try {
+        const result = await new Promise<BatchResult>((resolve, reject) => {
+          this.queue.enqueue(async () => {
+            const startedAt = Date.now();
+            const queueMs = startedAt - enqueuedAt;
+            try {
+              const output = await job.run(sessionId, queueMs);
+              resolve({ index: job.index, id: job.id, language, ...output, executionTime: Date.now() - startedAt, queueMs });
+            } catch (error) {
+              reject(error);
+            }
+          }, 0, language, () => reject(new Error('Timed out waiting for a batch execution slot')));
+        });
+        report(result);
+      } catch (error: any) {
+        report({ index: job.index, id: job.id, language, error: error.message });
+      }
+    }
+  }
+}
+
+/** Execution slots for batch jobs, separate from interactive runs */
+export const batchQueue = new ExecutionQueue(
+  config.batch.maxConcurrent,
+  config.executionQueue.maxQueueSize,
+  config.batch.queueTimeout,
+  { fairScheduling: config.executionQueue.fairScheduling, languages: Object.keys(config.runtimes) },
+);
+
+export const batchRunner = new BatchRunner(batchQueue);
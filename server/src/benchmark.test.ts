@@ -0,0 +1,78 @@
+/**
+ * Tests for the C++ benchmark mode
+ * Covers the cr-bench command, result parsing and the timing statistics.
+ */
+
+import {
+  benchmarkRunWrapper,
+  computeTimingStats,
+  formatBenchmarkSummary,
+  normalizeBenchmarkRuns,
+  parseBenchmarkResults,
+  summarizeBenchmark,
+  BENCHMARK_DIR,
+  BENCHMARK_RUNNER_PATH,
+} from './benchmark';
+import { config } from './config';
+
+describe('benchmarkRunWrapper', () => {
+  it('should exec the binary under cr-bench with the run count and budget', () => {
+    const command = benchmarkRunWrapper(5)('"$C/$K"', '.coderunner/cache/abc');
+    expect(command).toContain(`B=${BENCHMARK_DIR}`);
+    expect(command).toContain(
+      `exec ${BENCHMARK_RUNNER_PATH} 5 ${config.benchmark.timeBudgetMs} "$B/results" "$C/$K"`
+    );
+  });
+});
+
+describe('normalizeBenchmarkRuns', () => {
+  it('should default and clamp the run count', () => {
+    expect(normalizeBenchmarkRuns(undefined)).toBe(config.benchmark.defaultRuns);
+    expect(normalizeBenchmarkRuns(0)).toBe(1);
+    expect(normalizeBenchmarkRuns(3.7)).toBe(3);
+    expect(normalizeBenchmarkRuns(100000)).toBe(config.benchmark.maxRuns);
+  });
+});
+
+describe('parseBenchmarkResults', () => {
+  it('should convert wall ns and cpu us to milliseconds', () => {
+    const runs = parseBenchmarkResults('2000000 1500 500 0\ngarbage\n3000000 2000 0 1\n');
+    expect(runs).toEqual([
+      { wallMs: 2, cpuMs: 2, exitCode: 0 },
+      { wallMs: 3, cpuMs: 2, exitCode: 1 },
+    ]);
+  });
+});
+
+describe('computeTimingStats', () => {
+  it('should compute order statistics and sample stddev', () => {
+    const stats = computeTimingStats([4, 1, 3, 2, 5]);
+    expect(stats.min).toBe(1);
+    expect(stats.median).toBe(3);
+    expect(stats.p95).toBe(5);
+    expect(stats.mean).toBe(3);
+    expect(stats.stddev).toBeCloseTo(1.581, 3);
+  });
+
+  it('should return zeros for no samples', () => {
+    expect(computeTimingStats([])).toEqual({ min: 0, median: 0, p95: 0, mean: 0, stddev: 0 });
+  });
+});
+
+describe('summarizeBenchmark', () => {
+  it('should exclude the failing run from the stats', () => {
+    const summary = summarizeBenchmark([
+      { wallMs: 1, cpuMs: 1, exitCode: 0 },
+      { wallMs: 100, cpuMs: 100, exitCode: 139 },
+    ], 10);
+    expect(summary.completedRuns).toBe(1);
+    expect(summary.wallMs.p95).toBe(1);
+    expect(summary.failedExitCode).toBe(139);
+    expect(formatBenchmarkSummary(summary)).toContain('exited with code 139');
+  });
+
+  it('should mention the time budget when runs were cut short', () => {
+    const summary = summarizeBenchmark([{ wallMs: 1, cpuMs: 1, exitCode: 0 }], 10);
+    expect(formatBenchmarkSummary(summary)).toContain('time budget');
+  });
+});
@@ -0,0 +1,149 @@
+/**
+ * Benchmark Run Mode
+ *
+ * `benchmark` runs compile a cpp program once and then execute it repeatedly
+ * inside the same exec via cr-bench (runtimes/cpp/bench/cr-bench.c), which
+ * times every run in the container: wall time with CLOCK_MONOTONIC around
+ * fork/exec/wait, CPU time from the child's rusage. Server overhead (Docker exec
+ * round trip, compilation) is not part of the numbers.
+ *
+ * Only the first run's output is shown; every run reads stdin from /dev/null.
+ */
+
+import { config } from './config';
+import { readFile } from './dockerClient';
+import type { RunWrapper } from './cppBuild';
+
+/** Benchmark output directory inside the container, relative to /app */
+export const BENCHMARK_DIR = '.coderunner/bench';
+
+/** cr-bench binary baked into the cpp-runtime image */
+export const BENCHMARK_RUNNER_PATH = '/opt/coderunner/bin/cr-bench';
+
+export interface BenchmarkRun {
+  wallMs: number;
+  cpuMs: number;
+  exitCode: number;
+}
+
+export interface TimingStats {
+  min: number;
+  median: number;
+  p95: number;
+  mean: number;
+  stddev: number;
+}
+
+export interface BenchmarkSummary {
+  /** Runs requested and actually completed (the time budget may cut it short) */
+  requestedRuns: number;
+  completedRuns: number;
+  wallMs: TimingStats;
+  cpuMs: TimingStats;
+  /** Exit code of the failing run, if one failed */
+  failedExitCode: number | null;
+}
+
+/**
+ * Clamp a client-supplied run count to the configured bounds.
+ */
+export function normalizeBenchmarkRuns(runs: unknown): number {
+  const { defaultRuns, maxRuns } = config.benchmark;
+  const parsed = typeof runs === 'number' && Number.isFinite(runs) ? Math.floor(runs) : defaultRuns;
+  return Math.min(Math.max(parsed, 1), maxRuns);
+}
+
+/**
+ * Run wrapper for planCppBuild that executes the binary `runs` times under cr-bench.
+ */
+export function benchmarkRunWrapper(runs: number): RunWrapper {
+  return (binary) => [
+    `B=${BENCHMARK_DIR}`,
+    'mkdir -p "$B"',
+    `exec ${BENCHMARK_RUNNER_PATH} ${runs} ${config.benchmark.timeBudgetMs} "$B/results" ${binary}`,
+  ].join('; ');
+}
+
+/**
+ * Parse cr-bench result lines: "<wall_ns> <user_us> <sys_us> <exit_code>".
+ */
+export function parseBenchmarkResults(text: string): BenchmarkRun[] {
+  const runs: BenchmarkRun[] = [];
+  for (const line of text.split('\n')) {
+    const fields = line.trim().split(/\s+/).map(Number);
+    if (fields.length !== 4 || fields.some(f => !Number.isFinite(f))) continue;
+    const [wallNs, userUs, sysUs, exitCode] = fields;
+    runs.push({ wallMs: wallNs / 1e6, cpuMs: (userUs + sysUs) / 1e3, exitCode });
+  }
+  return runs;
+}
+
+function round(value: number): number {
+  return Math.round(value * 1000) / 1000;
+}
+
+/**
+ * min/median/p95/mean and sample standard deviation of a set of timings.
+ */
+export function computeTimingStats(values: number[]): TimingStats {
+  if (values.length === 0) {
+    return { min: 0, median: 0, p95: 0, mean: 0, stddev: 0 };
+  }
+  const sorted = [...values].sort((a, b) => a - b);
+  const mid = Math.floor(sorted.length / 2);
+  const median = sorted.length % 2 === 0 ? (sorted[mid - 1] + sorted[mid]) / 2 : sorted[mid];
+  const mean = sorted.reduce((a, b) => a + b, 0) / sorted.length;
+  const variance = sorted.length > 1
+    ? sorted.reduce((sum, v) => sum + (v - mean) ** 2, 0) / (sorted.length - 1)
+    : 0;
+
+  return {
+    min: round(sorted[0]),
+    median: round(median),
+    p95: round(sorted[Math.max(0, Math.ceil(0.95 * sorted.length) - 1)]),
+    mean: round(mean),
+    stddev: round(Math.sqrt(variance)),
+  };
+}
+
+/**
+ * Summarize the runs. A failed run is reported but not included in the stats.
+ */
+export function summarizeBenchmark(runs: BenchmarkRun[], requestedRuns: number): BenchmarkSummary {
+  const successful = runs.filter(r => r.exitCode === 0);
+  const failed = runs.find(r => r.exitCode !== 0);
+  return {
+    requestedRuns,
+    completedRuns: successful.length,
+    wallMs: computeTimingStats(successful.map(r => r.wallMs)),
+    cpuMs: computeTimingStats(successful.map(r => r.cpuMs)),
+    failedExitCode: failed ? failed.exitCode : null,
+  };
+}
+
+/**
+ * Read the results of the last benchmark run out of the container.
+ */
+export async function collectBenchmark(containerId: string, requestedRuns: number): Promise<BenchmarkSummary> {
+  const results = await readFile(containerId, `/app/${BENCHMARK_DIR}/results`);
+  return summarizeBenchmark(parseBenchmarkResults(results?.toString('utf-8') ?? ''), requestedRuns);
+}
+
+/**
+ * Human-readable rendering of a summary for the console.
+ */
+export function formatBenchmarkSummary(summary: BenchmarkSummary): string {
+  const row = (label: string, s: TimingStats) =>
+    `  ${label.padEnd(6)} min ${s.min}ms  median ${s.median}ms  p95 ${s.p95}ms  stddev ${s.stddev}ms`;
+  const lines = [
+    `[Benchmark] ${summary.completedRuns}/${summary.requestedRuns} runs`,
+    row('wall', summary.wallMs),
+    row('cpu', summary.cpuMs),
+  ];
+  if (summary.failedExitCode !== null) {
+    lines.push(`  stopped: a run exited with code ${summary.failedExitCode}`);
+  } else if (summary.completedRuns < summary.requestedRuns) {
+    lines.push(`  stopped early: time budget of ${config.benchmark.timeBudgetMs}ms reached`);
+  }
+  return lines.join('\n') + '\n';
+}
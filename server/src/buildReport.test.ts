@@ -0,0 +1,96 @@
+/**
+ * Tests for build report markers
+ * Verifies marker lines are stripped from stderr and parsed into a report.
+ */
+
+import {
+  BuildReportFilter,
+  extractBuildReport,
+  buildMarkerCommand,
+  parseBuildTimestamp,
+  getBuildPhases,
+  BUILD_MARKER,
+} from './buildReport';
+
+describe('BuildReportFilter', () => {
+  it('should strip marker lines and collect fields', () => {
+    const filter = new BuildReportFilter();
+    const out = filter.write(`${BUILD_MARKER}cache=miss\nmain.cpp:3: warning: unused\n${BUILD_MARKER}run\n`);
+    expect(out).toBe('main.cpp:3: warning: unused\n');
+    expect(filter.report).toEqual({ cache: 'miss', run: '' });
+  });
+
+  it('should pass program output through untouched after the run marker', () => {
+    const filter = new BuildReportFilter();
+    filter.write(`${BUILD_MARKER}cache=hit\n${BUILD_MARKER}run\n`);
+    expect(filter.write('partial line without newline')).toBe('partial line without newline');
+    expect(filter.write(`${BUILD_MARKER}cache=spoofed\n`)).toBe(`${BUILD_MARKER}cache=spoofed\n`);
+    expect(filter.report.cache).toBe('hit');
+  });
+
+  it('should handle markers split across chunks', () => {
+    const filter = new BuildReportFilter();
+    expect(filter.write('___BUI')).toBe('');
+    expect(filter.write('LD___cache=h')).toBe('');
+    expect(filter.write('it\n')).toBe('');
+    expect(filter.report.cache).toBe('hit');
+  });
+
+  it('should forward incomplete non-marker lines immediately', () => {
+    const filter = new BuildReportFilter();
+    expect(filter.write('error: expected')).toBe('error: expected');
+    expect(filter.end()).toBe('');
+  });
+
+  it('should flush a trailing marker on end', () => {
+    const filter = new BuildReportFilter();
+    filter.write(`${BUILD_MARKER}cache=miss`);
+    expect(filter.end()).toBe('');
+    expect(filter.report.cache).toBe('miss');
+  });
+});
+
+describe('extractBuildReport', () => {
+  it('should return cleaned stderr and the report', () => {
+    const { stderr, report } = extractBuildReport(`${BUILD_MARKER}cache=hit\n${BUILD_MARKER}run\nboom\n`);
+    expect(stderr).toBe('boom\n');
+    expect(report).toEqual({ cache: 'hit', run: '' });
+  });
+});
+
+describe('buildMarkerCommand', () => {
+  it('should echo the marker to stderr', () => {
+    expect(buildMarkerCommand('cache', 'hit')).toBe(`echo "${BUILD_MARKER}cache=hit" >&2`);
+    expect(buildMarkerCommand('run')).toBe(`echo "${BUILD_MARKER}run" >&2`);
+  });
+});
+
+describe('build phases', () => {
+  it('should parse nanosecond and second-precision timestamps', () => {
+    expect(parseBuildTimestamp('1700000000123456789')).toBe(1700000000123);
+    expect(parseBuildTimestamp('1700000000N')).toBe(1700000000000);
+    expect(parseBuildTimestamp('')).toBeNull();
+    expect(parseBuildTimestamp('garbage')).toBeNull();
+  });
+
+  it('should split compile and run at the run marker', () => {
+    const report = { start: '1700000000000000000', run: '1700000000400000000' };
+    expect(getBuildPhases(report, 900)).toEqual({ compileMs: 400, runMs: 500 });
+  });
+
+  it('should not depend on the server clock agreeing with the container', () => {
+    // Container clock an hour ahead of the server: phases only use durations
+    const report = { start: '1700003600000000000', run: '1700003600400000000' };
+    expect(getBuildPhases(report, 900)).toEqual({ compileMs: 400, runMs: 500 });
+    expect(getBuildPhases(report, 300)).toEqual({ compileMs: 400, runMs: 0 });
+  });
+
+  it('should count a failed build as compile time only', () => {
+    const report = { start: '1700000000000000000' };
+    expect(getBuildPhases(report, 250)).toEqual({ compileMs: 250, runMs: 0 });
+  });
+
+  it('should return null without a start marker', () => {
+    expect(getBuildPhases({ run: '1700000000400000000' }, 900)).toBeNull();
+  });
+});
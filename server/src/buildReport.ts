@@ -0,0 +1,160 @@
+/**
+ * Build Report Markers
+ *
+ * Compiled-language run commands print small marker lines on stderr describing
+ * what the build step did (cache hit/miss, artifact digest, ...) before the user
+ * program starts. The server strips those lines out of the stream the user sees
+ * and collects them into a key/value report.
+ *
+ * Marker format (one per line):
+ *   ___BUILD___start=<ns>          ← command started (container clock, `date +%s%N`)
+ *   ___BUILD___cache=hit
+ *   ___BUILD___digest=<sha256>
+ *   ___BUILD___run=<ns>            ← last marker; everything after it is program output
+ *
+ * The start/run timestamps are read from the same container clock, so their
+ * difference is the compile phase; the run phase is the rest of the exec's wall
+ * time. No container timestamp is ever compared with the server's clock, which
+ * may be skewed against a remote Docker host.
+ */
+
+export const BUILD_MARKER = '___BUILD___';
+
+/** Marker emitted right before the program is exec'd */
+export const BUILD_RUN_FIELD = 'run';
+
+/** Marker emitted when the command starts, before compiling */
+export const BUILD_START_FIELD = 'start';
+
+export type BuildReport = Record<string, string>;
+
+/**
+ * Shell snippet that emits a marker line on stderr.
+ * `value` is inserted unquoted so callers may use `$(...)` substitutions.
+ */
+export function buildMarkerCommand(field: string, value?: string): string {
+  const payload = value === undefined ? field : `${field}=${value}`;
+  return `echo "${BUILD_MARKER}${payload}" >&2`;
+}
+
+/**
+ * Languages whose run command has a compile phase and reports it through markers.
+ */
+export function usesBuildReport(language: string): boolean {
+  return language === 'cpp' || language === 'java';
+}
+
+/**
+ * Shell snippet that emits a marker carrying the current container time.
+ */
+export function buildTimestampCommand(field: string): string {
+  return buildMarkerCommand(field, '$(date +%s%N)');
+}
+
+/**
+ * Parse a `date +%s%N` marker value into epoch milliseconds. Falls back to
+ * second precision when the container's date has no %N support.
+ */
+export function parseBuildTimestamp(value: string | undefined): number | null {
+  if (!value) return null;
+  if (/^\d{16,}$/.test(value)) return Number(value.slice(0, -6));
+  const seconds = /^(\d{9,11})\D/.exec(value);
+  return seconds ? Number(seconds[1]) * 1000 : null;
+}
+
+/**
+ * Split a compiled-language exec into compile and run phases. `execMs` is the
+ * exec's wall time (measured by the agent, else by the server around the exec).
+ * Without a run marker the build failed and the whole exec counts as compile
+ * time. Returns null when no start marker was seen.
+ */
+export function getBuildPhases(report: BuildReport, execMs: number): { compileMs: number; runMs: number } | null {
+  const start = parseBuildTimestamp(report[BUILD_START_FIELD]);
+  if (start === null) return null;
+  const run = parseBuildTimestamp(report[BUILD_RUN_FIELD]);
+  if (run === null) {
+    return { compileMs: Math.max(0, execMs), runMs: 0 };
+  }
+  const compileMs = Math.max(0, run - start);
+  return { compileMs, runMs: Math.max(0, execMs - compileMs) };
+}
+
+/**
+ * Streaming stderr filter. Feed it chunks as they arrive; it returns the text that
+ * should be forwarded to the user with marker lines removed. Once the `run` marker
+ * has been seen the remaining stream is passed through untouched, so program
+ * output is never line-buffered.
+ */
+export class BuildReportFilter {
+  readonly report: BuildReport = {};
+  private pending = '';
+  private passThrough = false;
+
+  /** True once the run marker has been seen; further output needs no filtering */
+  get passingThrough(): boolean {
+    return this.passThrough;
+  }
+
+  write(chunk: string): string {
+    if (this.passThrough) return chunk;
+
+    const text = this.pending + chunk;
+    let forwarded = '';
+    let lineStart = 0;
+    let newline = text.indexOf('\n');
+
+    while (newline !== -1) {
+      const line = text.substring(lineStart, newline);
+      lineStart = newline + 1;
+
+      if (line.startsWith(BUILD_MARKER)) {
+        this.parseMarker(line);
+        if (this.passThrough) {
+          this.pending = '';
+          return forwarded + text.substring(lineStart);
+        }
+      } else {
+        forwarded += line + '\n';
+      }
+      newline = text.indexOf('\n', lineStart);
+    }
+
+    // Keep an incomplete trailing line until we know whether it is a marker
+    this.pending = text.substring(lineStart);
+    if (this.pending && !BUILD_MARKER.startsWith(this.pending.substring(0, BUILD_MARKER.length))) {
+      forwarded += this.pending;
+      this.pending = '';
+    }
+    return forwarded;
+  }
+
+  /** Flush whatever is still buffered once the stream has ended. */
+  end(): string {
+    const rest = this.pending;
+    this.pending = '';
+    if (rest.startsWith(BUILD_MARKER)) {
+      this.parseMarker(rest);
+      return '';
+    }
+    return rest;
+  }
+
+  private parseMarker(line: string): void {
+    const payload = line.substring(BUILD_MARKER.length).trim();
+    const eq = payload.indexOf('=');
+    const field = eq === -1 ? payload : payload.substring(0, eq);
+    this.report[field] = eq === -1 ? '' : payload.substring(eq + 1);
+    if (field === BUILD_RUN_FIELD) {
+      this.passThrough = true;
+    }
+  }
+}
+
+/**
+ * Non-streaming variant for buffered execs (REST API path).
+ */
+export function extractBuildReport(stderr: string): { stderr: string; report: BuildReport } {
+  const filter = new BuildReportFilter();
+  const cleaned = filter.write(stderr) + filter.end();
+  return { stderr: cleaned, report: filter.report };
+}
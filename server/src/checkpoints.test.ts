@@ -0,0 +1,104 @@
+/**
+ * Tests for checkpoint/restore warm starts
+ * Docker is mocked; assertions are on which start path each container takes.
+ */
+
+jest.mock('./dockerClient', () => ({
+  startContainer: jest.fn().mockResolvedValue(undefined),
+  createCheckpoint: jest.fn().mockResolvedValue(undefined),
+  removeContainers: jest.fn().mockResolvedValue(undefined),
+}));
+
+import { CheckpointManager } from './checkpoints';
+import { config } from './config';
+import * as dockerClient from './dockerClient';
+
+const mockDocker = dockerClient as jest.Mocked<typeof dockerClient>;
+
+const options = { ...config.checkpoint, enabled: true, languages: ['java'], dir: '/ckpt', retryInterval: 60_000 };
+
+function templateFactory() {
+  const release = jest.fn();
+  const factory = jest.fn(async (language: string) => ({ containerId: `template-${language}`, release }));
+  return { factory, release };
+}
+
+describe('CheckpointManager', () => {
+  beforeEach(() => {
+    jest.clearAllMocks();
+    mockDocker.startContainer.mockResolvedValue(undefined);
+    mockDocker.createCheckpoint.mockResolvedValue(undefined);
+  });
+
+  it('should checkpoint a template per language and remove it', async () => {
+    const manager = new CheckpointManager(options);
+    const { factory, release } = templateFactory();
+    manager.start(factory);
+    await manager.prepare('java');
+
+    expect(factory).toHaveBeenCalledTimes(1);
+    const [templateId, name, dir] = mockDocker.createCheckpoint.mock.calls[0];
+    expect(templateId).toBe('template-java');
+    expect(name).toMatch(/^java-/);
+    expect(dir).toBe('/ckpt/java');
+    expect(mockDocker.removeContainers).toHaveBeenCalledWith(['template-java']);
+    expect(release).toHaveBeenCalled();
+    expect(manager.getStats().java.state).toBe('ready');
+  });
+
+  it('should restore new containers from a ready checkpoint and time it', async () => {
+    const manager = new CheckpointManager(options);
+    manager.start(templateFactory().factory);
+    await manager.prepare('java');
+
+    const outcome = await manager.startContainer('java', 'session-container');
+
+    expect(outcome.restored).toBe(true);
+    expect(outcome.restoreMs).toBeGreaterThanOrEqual(0);
+    const [, checkpoint] = mockDocker.startContainer.mock.calls[0];
+    expect(checkpoint).toEqual({ name: mockDocker.createCheckpoint.mock.calls[0][1], dir: '/ckpt/java' });
+    expect(manager.getStats().java.restores).toBe(1);
+  });
+
+  it('should boot normally when the restore fails and stop restoring', async () => {
+    const manager = new CheckpointManager(options);
+    manager.start(templateFactory().factory);
+    await manager.prepare('java');
+    mockDocker.startContainer.mockRejectedValueOnce(new Error('criu failed'));
+
+    const outcome = await manager.startContainer('java', 'session-container');
+
+    expect(outcome.restored).toBe(false);
+    expect(mockDocker.startContainer).toHaveBeenLastCalledWith('session-container');
+    expect(manager.getStats().java).toMatchObject({ state: 'failed', restoreFailures: 1 });
+
+    await manager.startContainer('java', 'next-container');
+    expect(mockDocker.startContainer).toHaveBeenLastCalledWith('next-container');
+  });
+
+  it('should record checkpoint failures and keep booting normally', async () => {
+    const manager = new CheckpointManager(options);
+    mockDocker.createCheckpoint.mockRejectedValueOnce(new Error('checkpoint is only supported in experimental mode'));
+    manager.start(templateFactory().factory);
+    await manager.prepare('java').catch(() => undefined);
+
+    expect(manager.getStats().java.state).toBe('failed');
+    expect(manager.getStats().java.lastError).toContain('experimental');
+    expect(mockDocker.removeContainers).toHaveBeenCalledWith(['template-java']);
+    expect((await manager.startContainer('java', 'session-container')).restored).toBe(false);
+  });
+
+  it('should leave other languages and disabled mode alone', async () => {
+    const manager = new CheckpointManager(options);
+    const disabled = new CheckpointManager({ ...options, enabled: false });
+    const { factory } = templateFactory();
+    manager.start(factory);
+    disabled.start(factory);
+    await manager.prepare('java');
+    factory.mockClear();
+
+    expect((await manager.startContainer('python', 'py-container')).restored).toBe(false);
+    expect((await disabled.startContainer('java', 'java-container')).restored).toBe(false);
+    expect(factory).not.toHaveBeenCalled();
+  });
+});
@@ -0,0 +1,195 @@
+/**
+ * Checkpoint/Restore Warm Starts
+ *
+ * Heavy runtimes spend most of a cold start initializing: the JVM loading and
+ * warming the Java runner, Postgres running initdb and opening for connections.
+ * With CHECKPOINT_RESTORE, the pool does that once per language. It boots a
+ * template container, waits until the runtime is ready, and takes a CRIU
+ * checkpoint of it (`docker checkpoint create --checkpoint-dir`). New session
+ * containers of that language are then started from the checkpoint, so they
+ * begin life with the runtime already initialized.
+ *
+ * Needs a Docker daemon with experimental features and CRIU installed. Any
+ * failure, whether preparing the checkpoint or restoring from it, falls back
+ * to a normal boot; a failed checkpoint is rebuilt after CHECKPOINT_RETRY_INTERVAL.
+ * Restore times are recorded separately from the container stage (restoreMs
+ * in the pipeline metrics).
+ */
+
+import { config } from './config';
+import { logger } from './logger';
+import { LatencyHistogram, type StageStats } from './histogram';
+import { createCheckpoint, removeContainers, startContainer } from './dockerClient';
+
+export type CheckpointState = 'none' | 'preparing' | 'ready' | 'failed';
+
+interface CheckpointEntry {
+  state: CheckpointState;
+  /** Checkpoint names are never reused; each rebuild gets the next attempt number */
+  name: string;
+  attempts: number;
+  dir: string;
+  failedAt: number;
+  lastError?: string;
+  restores: number;
+  restoreFailures: number;
+  restoreMs: LatencyHistogram;
+}
+
+/** How a container was started */
+export interface StartOutcome {
+  restored: boolean;
+  /** Time taken by the restore (only when restored) */
+  restoreMs?: number;
+}
+
+/**
+ * Boots a template container and resolves once its runtime is initialized.
+ * `release` is called after the template was checkpointed and removed.
+ */
+export type TemplateFactory = (language: string) => Promise<{ containerId: string; release: () => void }>;
+
+export class CheckpointManager {
+  private readonly entries = new Map<string, CheckpointEntry>();
+  private readonly preparing = new Map<string, Promise<void>>();
+  private factory: TemplateFactory | null = null;
+  /** Checkpoints are named per server start, so a rebuilt image never meets an old snapshot */
+  private readonly generation = Date.now().toString(36);
+
+  constructor(private readonly options = config.checkpoint) {}
+
+  /** Whether new containers of the language should be restored from a checkpoint */
+  supports(language: string): boolean {
+    return this.options.enabled && this.options.languages.includes(language);
+  }
+
+  /** Register how template containers are created and start preparing checkpoints */
+  start(factory: TemplateFactory): void {
+    this.factory = factory;
+    if (!this.options.enabled) return;
+    logger.info('Checkpoint', `Preparing checkpoints for ${this.options.languages.join(', ')}`);
+    for (const language of this.options.languages) {
+      this.prepare(language).catch(() => { /* recorded in the entry */ });
+    }
+  }
+
+  /**
+   * Start a created container, from the language's checkpoint when one is
+   * ready. Falls back to a normal start when the restore fails.
+   */
+  async startContainer(language: string, containerId: string): Promise<StartOutcome> {
+    const entry = this.supports(language) ? this.entryFor(language) : undefined;
+    if (!entry || entry.state !== 'ready') {
+      if (entry) this.prepareIfDue(language, entry);
+      await startContainer(containerId);
+      return { restored: false };
+    }
+
+    const started = Date.now();
+    try {
+      await startContainer(containerId, { name: entry.name, dir: entry.dir });
+      const restoreMs = Date.now() - started;
+      entry.restores++;
+      entry.restoreMs.record(restoreMs);
+      logger.debug('Checkpoint', `Restored ${containerId.substring(0, 12)} from ${entry.name} in ${restoreMs}ms`);
+      return { restored: true, restoreMs };
+    } catch (error: any) {
+      entry.restoreFailures++;
+      this.markFailed(entry, `restore failed: ${error.message}`);
+      logger.warn('Checkpoint', `Restore of ${language} container failed, booting normally: ${error.message}`);
+      await startContainer(containerId);
+      return { restored: false };
+    }
+  }
+
+  /** Build the language's checkpoint (deduplicated while one is in progress) */
+  prepare(language: string): Promise<void> {
+    const pending = this.preparing.get(language);
+    if (pending) return pending;
+    if (!this.factory) return Promise.reject(new Error('Checkpoint manager not started'));
+
+    const entry = this.entryFor(language);
+    entry.state = 'preparing';
+    const task = this.buildCheckpoint(language, entry, this.factory)
+      .finally(() => this.preparing.delete(language));
+    this.preparing.set(language, task);
+    return task;
+  }
+
+  getStats(): Record<string, {
+    state: CheckpointState;
+    restores: number;
+    restoreFailures: number;
+    restoreMs: StageStats;
+    lastError?: string;
+  }> {
+    const stats: ReturnType<CheckpointManager['getStats']> = {};
+    for (const [language, entry] of this.entries) {
+      stats[language] = {
+        state: entry.state,
+        restores: entry.restores,
+        restoreFailures: entry.restoreFailures,
+        restoreMs: entry.restoreMs.stats(),
+        ...(entry.lastError ? { lastError: entry.lastError } : {}),
+      };
+    }
+    return stats;
+  }
+
+  private async buildCheckpoint(language: string, entry: CheckpointEntry, factory: TemplateFactory): Promise<void> {
+    const started = Date.now();
+    let template: { containerId: string; release: () => void } | null = null;
+    entry.name = `${language}-${this.generation}-${++entry.attempts}`;
+    try {
+      template = await factory(language);
+      // The template is stopped by the checkpoint; only the checkpoint files are kept
+      await createCheckpoint(template.containerId, entry.name, entry.dir);
+      entry.state = 'ready';
+      entry.lastError = undefined;
+      logger.info('Checkpoint', `${language} checkpoint ${entry.name} ready in ${Date.now() - started}ms`);
+    } catch (error: any) {
+      this.markFailed(entry, `checkpoint failed: ${error.message}`);
+      logger.warn('Checkpoint', `Could not checkpoint ${language} runtime: ${error.message}`);
+      throw error;
+    } finally {
+      if (template) {
+        await removeContainers([template.containerId]).catch(() => { /* best effort */ });
+        template.release();
+      }
+    }
+  }
+
+  private prepareIfDue(language: string, entry: CheckpointEntry): void {
+    const due = entry.state === 'none' ||
+      (entry.state === 'failed' && Date.now() - entry.failedAt >= this.options.retryInterval);
+    if (due && this.factory) {
+      this.prepare(language).catch(() => { /* recorded in the entry */ });
+    }
+  }
+
+  private markFailed(entry: CheckpointEntry, message: string): void {
+    entry.state = 'failed';
+    entry.failedAt = Date.now();
+    entry.lastError = message;
+  }
+
+  private entryFor(language: string): CheckpointEntry {
+    let entry = this.entries.get(language);
+    if (!entry) {
+      entry = {
+        state: 'none',
+        name: '',
+        attempts: 0,
+        dir: `${this.options.dir}/${language}`,
+        failedAt: 0,
+        restores: 0,
+        restoreFailures: 0,
+        restoreMs: new LatencyHistogram(),
+      };
+      this.entries.set(language, entry);
+    }
+    return entry;
+  }
+}
+
+export const checkpointManager = new CheckpointManager();
@@ -0,0 +1,74 @@
+/**
+ * Cluster Entry Point (npm start)
+ *
+ * Runs CLUSTER_WORKERS copies of the server on this machine. The primary only
+ * forks and supervises; every worker is a complete server (index.ts) with its
+ * own pools, queue share and Socket.IO connections, listening on the shared
+ * port. Worker i gets CLUSTER_SLOT=i of CLUSTER_SLOTS=N so the workers' session
+ * subnets never overlap on the shared Docker daemon. A worker that dies is
+ * replaced; its containers are reaped by the others (see clusterState.ts).
+ *
+ * With a single worker the server runs in this process.
+ */
+
+// Load environment variables FIRST before any other imports
+require('dotenv').config({ path: require('path').resolve(__dirname, '../.env') });
+
+import cluster, { type Worker } from 'cluster';
+import * as path from 'path';
+import { config } from './config';
+import { logger } from './logger';
+
+/** Pause before replacing a dead worker, so a crash loop doesn't spin */
+const RESTART_DELAY_MS = 1000;
+
+function startPrimary(workers: number): void {
+  // Workers run index.js as their main module
+  cluster.setupPrimary({ exec: path.join(__dirname, 'index.js') });
+
+  const slots = new Map<Worker, number>();
+  let shuttingDown = false;
+
+  const fork = (slot: number) => {
+    const worker = cluster.fork({ CLUSTER_SLOT: String(slot), CLUSTER_SLOTS: String(workers) });
+    slots.set(worker, slot);
+  };
+
+  cluster.on('exit', (worker, code, signal) => {
+    const slot = slots.get(worker)!;
+    slots.delete(worker);
+    if (shuttingDown) {
+      if (slots.size === 0) {
+        logger.info('Cluster', 'All workers stopped');
+        process.exit(0);
+      }
+      return;
+    }
+    logger.warn('Cluster', `Worker ${worker.process.pid} (slot ${slot}) exited (${signal ?? code}); restarting`);
+    setTimeout(() => fork(slot), RESTART_DELAY_MS);
+  });
+
+  // docker stop signals only PID 1; each worker runs its own graceful shutdown
+  const shutdown = (forward: boolean) => {
+    if (shuttingDown) return;
+    shuttingDown = true;
+    logger.info('Cluster', `Stopping ${slots.size} workers...`);
+    if (forward) {
+      for (const worker of slots.keys()) worker.process.kill('SIGTERM');
+    }
+  };
+  process.on('SIGTERM', () => shutdown(true));
+  // A terminal's Ctrl+C already reaches the whole process group
+  process.on('SIGINT', () => shutdown(false));
+
+  for (let slot = 0; slot < workers; slot++) {
+    fork(slot);
+  }
+  logger.info('Cluster', `Primary ${process.pid} started ${workers} workers`);
+}
+
+if (config.cluster.workers > 1) {
+  startPrimary(config.cluster.workers);
+} else {
+  require('./index').startServer();
+}
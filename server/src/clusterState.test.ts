@@ -0,0 +1,140 @@
+/**
+ * Tests for cluster state
+ * The store is a fake; assertions are on liveness, reaping rules and the queue share.
+ */
+
+import * as os from 'os';
+import { ClusterState, PostgresClusterStore, type ClusterStore, type InstanceRecord } from './clusterState';
+import { config } from './config';
+
+const load = () => ({ queued: 0, active: 1, sessions: 2, containers: 3 });
+const old = Date.now() - 60 * 60 * 1000;
+
+function instance(id: string): InstanceRecord {
+  return { id, startedAt: 0, heartbeatAt: Date.now(), ...load() };
+}
+
+function fakeStore(live: string[] = []): jest.Mocked<ClusterStore> {
+  return {
+    migrate: jest.fn().mockResolvedValue(undefined),
+    heartbeat: jest.fn().mockResolvedValue(undefined),
+    liveInstances: jest.fn().mockResolvedValue(live.map(instance)),
+    reap: jest.fn().mockResolvedValue([]),
+    removeInstance: jest.fn().mockResolvedValue(undefined),
+    claimSession: jest.fn().mockResolvedValue(undefined),
+    releaseSession: jest.fn().mockResolvedValue(undefined),
+    recordContainer: jest.fn().mockResolvedValue(undefined),
+    forgetContainers: jest.fn().mockResolvedValue(undefined),
+    close: jest.fn().mockResolvedValue(undefined),
+  };
+}
+
+describe('ClusterState without a store', () => {
+  const state = new ClusterState({ instanceId: 'me', store: null, instanceTimeout: 20000, slots: 1 });
+
+  it('should reap its own, unlabelled and long-dead instances\' objects only', () => {
+    expect(state.mayReap('me', Date.now())).toBe(true);
+    expect(state.mayReap(undefined, Date.now())).toBe(true);
+    expect(state.mayReap('gone-host-1', old)).toBe(true);
+    expect(state.mayReap('gone-host-1', Date.now() - 1000)).toBe(false);
+  });
+
+  it('should treat a running process of this machine as alive', () => {
+    const sibling = `${os.hostname()}-${process.ppid}`;
+    expect(state.isLive(sibling)).toBe(true);
+    expect(state.mayReap(sibling, old)).toBe(false);
+  });
+
+  it('should split the concurrency limit over the worker slots', async () => {
+    const onShare = jest.fn();
+    await new ClusterState({ instanceId: 'me', store: null, slots: 4 }).start(load, onShare);
+    expect(onShare).toHaveBeenCalledWith(Math.floor(config.sessionContainers.maxConcurrentSessions / 4));
+  });
+});
+
+describe('ClusterState with a store', () => {
+  let state: ClusterState | null = null;
+
+  afterEach(async () => {
+    await state?.stop();
+    state = null;
+  });
+
+  it('should spare siblings until the live set is known, then only live ones', async () => {
+    const store = fakeStore(['me', 'sibling']);
+    state = new ClusterState({ instanceId: 'me', store, instanceTimeout: 20000 });
+    expect(state.mayReap('stranger', old)).toBe(false);
+
+    await state.heartbeat();
+    expect(state.mayReap('sibling', old)).toBe(false);
+    expect(state.mayReap('stranger', old)).toBe(true);
+  });
+
+  it('should resize its share of the limit as instances join and leave', async () => {
+    const store = fakeStore(['me', 'sibling']);
+    state = new ClusterState({ instanceId: 'me', store });
+    const onShare = jest.fn();
+
+    await state.start(load, onShare);
+    expect(onShare).toHaveBeenLastCalledWith(Math.floor(config.sessionContainers.maxConcurrentSessions / 2));
+    expect(store.heartbeat).toHaveBeenCalledWith('me', expect.any(Number), load());
+
+    store.liveInstances.mockResolvedValue([instance('me')]);
+    await state.heartbeat();
+    expect(onShare).toHaveBeenLastCalledWith(config.sessionContainers.maxConcurrentSessions);
+    expect(state.getStats()).toMatchObject({ store: 'postgres', instances: [{ id: 'me' }] });
+  });
+
+  it('should keep the last live set when the store is unreachable', async () => {
+    const store = fakeStore(['me', 'sibling']);
+    state = new ClusterState({ instanceId: 'me', store });
+    await state.heartbeat();
+
+    store.heartbeat.mockRejectedValueOnce(new Error('connection refused'));
+    await expect(state.heartbeat()).rejects.toThrow('connection refused');
+    expect(state.isLive('sibling')).toBe(true);
+    expect(state.getStats().lastError).toBe('connection refused');
+  });
+
+  it('should record sessions and containers without waiting for the store', async () => {
+    const store = fakeStore();
+    state = new ClusterState({ instanceId: 'me', store });
+    store.claimSession.mockRejectedValueOnce(new Error('timeout'));
+
+    state.claimSession('s1');
+    state.recordContainer({ containerId: 'c1', sessionId: 's1', language: 'python', host: 'local' });
+    state.forgetContainers([]);
+    await new Promise(resolve => setImmediate(resolve));
+
+    expect(store.recordContainer).toHaveBeenCalledWith('me', expect.objectContaining({ containerId: 'c1' }));
+    expect(store.forgetContainers).not.toHaveBeenCalled();
+    expect(state.getStats().lastError).toBe('timeout');
+  });
+
+  it('should deregister on stop', async () => {
+    const store = fakeStore(['me']);
+    const leaving = new ClusterState({ instanceId: 'me', store });
+    await leaving.stop();
+    expect(store.removeInstance).toHaveBeenCalledWith('me');
+    expect(store.close).toHaveBeenCalled();
+  });
+});
+
+describe('PostgresClusterStore', () => {
+  it('should delete the sessions and containers of reaped instances', async () => {
+    const query = jest.fn()
+      .mockResolvedValueOnce({ rows: [{ id: 'dead-1' }] })
+      .mockResolvedValue({ rows: [] });
+    const store = new PostgresClusterStore({ query });
+
+    expect(await store.reap(20000)).toEqual(['dead-1']);
+    expect(query).toHaveBeenCalledWith(expect.stringContaining('DELETE FROM coderunner_sessions'), [['dead-1']]);
+    expect(query).toHaveBeenCalledWith(expect.stringContaining('DELETE FROM coderunner_containers'), [['dead-1']]);
+  });
+
+  it('should not touch other tables when no instance timed out', async () => {
+    const query = jest.fn().mockResolvedValue({ rows: [] });
+    await new PostgresClusterStore({ query }).reap(20000);
+    expect(query).toHaveBeenCalledTimes(1);
+  });
+});
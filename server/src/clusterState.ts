@@ -0,0 +1,372 @@
+/**
+ * Cluster State
+ *
+ * Several server processes can share the same Docker hosts: worker processes on
+ * one machine (CLUSTER_WORKERS, see cluster.ts) and replicas on other machines.
+ * Each process stamps the containers and networks it creates with its instance
+ * id. The orphan sweeps then only reap objects that belong to this process or
+ * to one that is gone, never those of a live sibling.
+ *
+ * Whether another instance is alive comes from the shared store when
+ * CLUSTER_STATE_URL is set: every process writes a heartbeat row to Postgres.
+ * Without the store, an instance id of this machine is checked by its pid,
+ * which is enough for workers. The store also records which instance owns each
+ * session, and registers every session container. MAX_CONCURRENT_SESSIONS is
+ * split between the live instances, so the cluster as a whole keeps the limit.
+ */
+
+import * as os from 'os';
+import { Pool } from 'pg';
+import { config } from './config';
+import { logger } from './logger';
+
+/** Container and network label naming the instance that created the object */
+export const INSTANCE_LABEL = 'instance';
+
+export interface InstanceLoad {
+  queued: number;
+  active: number;
+  sessions: number;
+  containers: number;
+}
+
+export interface InstanceRecord extends InstanceLoad {
+  id: string;
+  startedAt: number;
+  heartbeatAt: number;
+}
+
+export interface ContainerRecord {
+  containerId: string;
+  sessionId: string;
+  language: string;
+  host: string;
+}
+
+/** Shared state of all instances (see PostgresClusterStore) */
+export interface ClusterStore {
+  migrate(): Promise<void>;
+  heartbeat(instanceId: string, startedAt: number, load: InstanceLoad): Promise<void>;
+  /** Instances with a heartbeat within timeoutMs */
+  liveInstances(timeoutMs: number): Promise<InstanceRecord[]>;
+  /** Delete instances silent for longer than timeoutMs, with their sessions and containers */
+  reap(timeoutMs: number): Promise<string[]>;
+  removeInstance(instanceId: string): Promise<void>;
+  claimSession(sessionId: string, instanceId: string): Promise<void>;
+  releaseSession(sessionId: string): Promise<void>;
+  recordContainer(instanceId: string, container: ContainerRecord): Promise<void>;
+  forgetContainers(containerIds: string[]): Promise<void>;
+  close(): Promise<void>;
+}
+
+interface Queryable {
+  query(text: string, values?: unknown[]): Promise<{ rows: any[] }>;
+  end?(): Promise<void>;
+}
+
+/**
+ * Cluster store in a Postgres database. Times come from the database clock, so
+ * replicas with skewed clocks agree on who is alive.
+ */
+export class PostgresClusterStore implements ClusterStore {
+  constructor(private readonly db: Queryable) {}
+
+  async migrate(): Promise<void> {
+    await this.db.query(`
+      CREATE TABLE IF NOT EXISTS coderunner_instances (
+        id TEXT PRIMARY KEY,
+        started_at TIMESTAMPTZ NOT NULL,
+        heartbeat_at TIMESTAMPTZ NOT NULL,
+        queued INTEGER NOT NULL DEFAULT 0,
+        active INTEGER NOT NULL DEFAULT 0,
+        sessions INTEGER NOT NULL DEFAULT 0,
+        containers INTEGER NOT NULL DEFAULT 0
+      );
+      CREATE TABLE IF NOT EXISTS coderunner_sessions (
+        session_id TEXT PRIMARY KEY,
+        instance_id TEXT NOT NULL,
+        claimed_at TIMESTAMPTZ NOT NULL DEFAULT now()
+      );
+      CREATE TABLE IF NOT EXISTS coderunner_containers (
+        container_id TEXT PRIMARY KEY,
+        instance_id TEXT NOT NULL,
+        session_id TEXT NOT NULL,
+        language TEXT NOT NULL,
+        host TEXT NOT NULL,
+        created_at TIMESTAMPTZ NOT NULL DEFAULT now()
+      );
+      CREATE INDEX IF NOT EXISTS coderunner_containers_instance ON coderunner_containers (instance_id);
+    `);
+  }
+
+  async heartbeat(instanceId: string, startedAt: number, load: InstanceLoad): Promise<void> {
+    await this.db.query(
+      `INSERT INTO coderunner_instances (id, started_at, heartbeat_at, queued, active, sessions, containers)
+       VALUES ($1, to_timestamp($2 / 1000.0), now(), $3, $4, $5, $6)
+       ON CONFLICT (id) DO UPDATE SET heartbeat_at = now(), queued = $3, active = $4, sessions = $5, containers = $6`,
+      [instanceId, startedAt, load.queued, load.active, load.sessions, load.containers],
+    );
+  }
+
+  async liveInstances(timeoutMs: number): Promise<InstanceRecord[]> {
+    const { rows } = await this.db.query(
+      `SELECT id, queued, active, sessions, containers,
+              EXTRACT(EPOCH FROM started_at) * 1000 AS started_at,
+              EXTRACT(EPOCH FROM heartbeat_at) * 1000 AS heartbeat_at
+       FROM coderunner_instances
+       WHERE heartbeat_at >= now() - make_interval(secs => $1 / 1000.0)
+       ORDER BY id`,
+      [timeoutMs],
+    );
+    return rows.map(row => ({
+      id: row.id,
+      queued: row.queued,
+      active: row.active,
+      sessions: row.sessions,
+      containers: row.containers,
+      startedAt: Math.round(Number(row.started_at)),
+      heartbeatAt: Math.round(Number(row.heartbeat_at)),
+    }));
+  }
+
+  async reap(timeoutMs: number): Promise<string[]> {
+    const { rows } = await this.db.query(
+      `DELETE FROM coderunner_instances
+       WHERE heartbeat_at < now() - make_interval(secs => $1 / 1000.0)
+       RETURNING id`,
+      [timeoutMs],
+    );
+    const ids = rows.map(row => row.id as string);
+    if (ids.length > 0) {
+      await this.db.query('DELETE FROM coderunner_sessions WHERE instance_id = ANY($1)', [ids]);
+      await this.db.query('DELETE FROM coderunner_containers WHERE instance_id = ANY($1)', [ids]);
+    }
+    return ids;
+  }
+
+  async removeInstance(instanceId: string): Promise<void> {
+    await this.db.query('DELETE FROM coderunner_sessions WHERE instance_id = $1', [instanceId]);
+    await this.db.query('DELETE FROM coderunner_containers WHERE instance_id = $1', [instanceId]);
+    await this.db.query('DELETE FROM coderunner_instances WHERE id = $1', [instanceId]);
+  }
+
+  async claimSession(sessionId: string, instanceId: string): Promise<void> {
+    await this.db.query(
+      `INSERT INTO coderunner_sessions (session_id, instance_id) VALUES ($1, $2)
+       ON CONFLICT (session_id) DO UPDATE SET instance_id = $2, claimed_at = now()`,
+      [sessionId, instanceId],
+    );
+  }
+
+  async releaseSession(sessionId: string): Promise<void> {
+    await this.db.query('DELETE FROM coderunner_sessions WHERE session_id = $1', [sessionId]);
+  }
+
+  async recordContainer(instanceId: string, container: ContainerRecord): Promise<void> {
+    await this.db.query(
+      `INSERT INTO coderunner_containers (container_id, instance_id, session_id, language, host)
+       VALUES ($1, $2, $3, $4, $5)
+       ON CONFLICT (container_id) DO UPDATE SET instance_id = $2, session_id = $3`,
+      [container.containerId, instanceId, container.sessionId, container.language, container.host],
+    );
+  }
+
+  async forgetContainers(containerIds: string[]): Promise<void> {
+    await this.db.query('DELETE FROM coderunner_containers WHERE container_id = ANY($1)', [containerIds]);
+  }
+
+  async close(): Promise<void> {
+    await this.db.end?.();
+  }
+}
+
+export interface ClusterStateOptions {
+  instanceId?: string;
+  /** Default: a PostgresClusterStore on CLUSTER_STATE_URL, or none */
+  store?: ClusterStore | null;
+  instanceTimeout?: number;
+  /** Instances assumed alive without a store (workers of this machine) */
+  slots?: number;
+}
+
+export class ClusterState {
+  readonly instanceId: string;
+  private readonly startedAt = Date.now();
+  private readonly instanceTimeout: number;
+  private readonly slots: number;
+  private store: ClusterStore | null | undefined;
+  private live = new Map<string, InstanceRecord>();
+  /** Until the live set is first read from the store, every instance counts as alive */
+  private synced = false;
+  private timer: NodeJS.Timeout | null = null;
+  private load: () => InstanceLoad = () => ({ queued: 0, active: 0, sessions: 0, containers: 0 });
+  private onShare: (maxConcurrent: number) => void = () => undefined;
+  private concurrencyShare: number | null = null;
+  private reapedInstances = 0;
+  private lastError: string | null = null;
+
+  constructor(options: ClusterStateOptions = {}) {
+    this.instanceId = options.instanceId ?? config.cluster.instanceId;
+    this.store = options.store;
+    this.instanceTimeout = options.instanceTimeout ?? config.cluster.instanceTimeout;
+    this.slots = options.slots ?? config.cluster.slots;
+  }
+
+  /**
+   * Join the cluster: register in the store and heartbeat from now on.
+   * `onShare` receives this instance's part of MAX_CONCURRENT_SESSIONS
+   * whenever the number of live instances changes.
+   */
+  async start(load: () => InstanceLoad, onShare: (maxConcurrent: number) => void): Promise<void> {
+    this.load = load;
+    this.onShare = onShare;
+    const store = this.getStore();
+    if (!store) {
+      this.applyShare(this.slots);
+      return;
+    }
+    await store.migrate();
+    await this.heartbeat();
+    this.timer = setInterval(() => {
+      this.heartbeat().catch(e => logger.error('Cluster', `Heartbeat failed: ${e}`));
+    }, config.cluster.heartbeatInterval);
+    logger.info('Cluster', `Instance ${this.instanceId} joined (${this.live.size} live)`);
+  }
+
+  /** Leave the cluster; siblings stop counting this instance at once */
+  async stop(): Promise<void> {
+    if (this.timer) {
+      clearInterval(this.timer);
+      this.timer = null;
+    }
+    const store = this.store;
+    if (!store) return;
+    try {
+      await store.removeInstance(this.instanceId);
+    } catch (error: any) {
+      logger.warn('Cluster', `Failed to deregister ${this.instanceId}: ${error.message}`);
+    }
+    await store.close().catch(() => { /* best effort */ });
+  }
+
+  /** Write this instance's heartbeat, drop dead instances and refresh the live set */
+  async heartbeat(): Promise<void> {
+    const store = this.getStore();
+    if (!store) return;
+    try {
+      await store.heartbeat(this.instanceId, this.startedAt, this.load());
+      const reaped = await store.reap(this.instanceTimeout);
+      if (reaped.length > 0) {
+        this.reapedInstances += reaped.length;
+        logger.warn('Cluster', `Instances without heartbeat removed: ${reaped.join(', ')}`);
+      }
+      const live = await store.liveInstances(this.instanceTimeout);
+      this.live = new Map(live.map(instance => [instance.id, instance]));
+      this.synced = true;
+      this.lastError = null;
+      this.applyShare(Math.max(1, this.live.size));
+    } catch (error: any) {
+      // Keep the last known live set; siblings are not reaped on a store outage
+      this.lastError = error.message;
+      throw error;
+    }
+  }
+
+  isLive(instanceId: string): boolean {
+    if (instanceId === this.instanceId) return true;
+    if (this.getStore()) return !this.synced || this.live.has(instanceId);
+    return isLocalProcessAlive(instanceId);
+  }
+
+  /**
+   * Whether this instance may remove an object nothing here tracks: it was
+   * created by this instance, by nobody known, or by an instance that is gone.
+   * Objects younger than the instance timeout are spared, since their
+   * creator may not have sent its first heartbeat yet.
+   */
+  mayReap(owner: string | undefined, createdAt: number, now: number = Date.now()): boolean {
+    if (!owner || owner === this.instanceId) return true;
+    if (this.isLive(owner)) return false;
+    return now - createdAt > this.instanceTimeout;
+  }
+
+  claimSession(sessionId: string): void {
+    this.write('claim session', store => store.claimSession(sessionId, this.instanceId));
+  }
+
+  releaseSession(sessionId: string): void {
+    this.write('release session', store => store.releaseSession(sessionId));
+  }
+
+  recordContainer(container: ContainerRecord): void {
+    this.write('record container', store => store.recordContainer(this.instanceId, container));
+  }
+
+  forgetContainers(containerIds: string[]): void {
+    if (containerIds.length === 0) return;
+    this.write('forget containers', store => store.forgetContainers(containerIds));
+  }
+
+  getStats() {
+    const store = this.getStore();
+    const instances = store
+      ? Array.from(this.live.values())
+      : [{ id: this.instanceId, startedAt: this.startedAt, heartbeatAt: Date.now(), ...this.load() }];
+    return {
+      instanceId: this.instanceId,
+      store: store ? 'postgres' : 'none',
+      instances,
+      concurrencyShare: this.concurrencyShare,
+      reapedInstances: this.reapedInstances,
+      lastError: this.lastError,
+    };
+  }
+
+  private applyShare(instances: number): void {
+    const share = Math.max(1, Math.floor(config.sessionContainers.maxConcurrentSessions / instances));
+    if (share === this.concurrencyShare) return;
+    this.concurrencyShare = share;
+    this.onShare(share);
+    if (instances > 1) {
+      logger.info('Cluster', `${instances} instances: running up to ${share} executions here`);
+    }
+  }
+
+  /** Store writes are off the request path; a failed one only costs bookkeeping */
+  private write(what: string, operation: (store: ClusterStore) => Promise<void>): void {
+    const store = this.getStore();
+    if (!store) return;
+    operation(store).catch((error: any) => {
+      this.lastError = error.message;
+      logger.warn('Cluster', `Failed to ${what}: ${error.message}`);
+    });
+  }
+
+  private getStore(): ClusterStore | null {
+    if (this.store === undefined) {
+      this.store = config.cluster.stateUrl
+        ? new PostgresClusterStore(new Pool({ connectionString: config.cluster.stateUrl, max: 4 }))
+        : null;
+    }
+    return this.store;
+  }
+}
+
+/**
+ * Default instance ids are "<hostname>-<pid>"; one of this machine is alive
+ * while its process is. Ids of other machines can't be checked without a store.
+ */
+function isLocalProcessAlive(instanceId: string): boolean {
+  const prefix = `${os.hostname()}-`;
+  if (!instanceId.startsWith(prefix)) return false;
+  const pid = Number(instanceId.slice(prefix.length));
+  if (!Number.isInteger(pid) || pid <= 0) return false;
+  try {
+    process.kill(pid, 0);
+    return true;
+  } catch (error: any) {
+    return error.code === 'EPERM';
+  }
+}
+
+export const clusterState = new ClusterState();
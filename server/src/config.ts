@@ -4,8 +4,24 @@
  * Environment variables override defaults
  */
 
+import * as os from 'os';
 import { logger } from './logger';
 
+/**
+ * Parse "lang=count,lang=count" lists used by per-language settings.
+ */
+function parseLanguageCounts(value: string): Record<string, number> {
+  const counts: Record<string, number> = {};
+  for (const pair of value.split(',')) {
+    const [language, count] = pair.split('=').map(part => part.trim());
+    const parsed = parseInt(count, 10);
+    if (language && !isNaN(parsed)) {
+      counts[language] = parsed;
+    }
+  }
+  return counts;
+}
+
 export const config = {
   // === Server Configuration ===
   server: {
@@ -15,6 +31,25 @@ export const config = {
     logLevel: process.env.LOG_LEVEL || 'info',
   },
 
+  // === Cluster Configuration ===
+  cluster: {
+    // Worker processes started by dist/cluster.js (1 = a single process)
+    workers: parseInt(process.env.CLUSTER_WORKERS || '1', 10),
+    // Postgres connection string holding replica heartbeats, session ownership and
+    // the container registry. Needed for replicas on several machines; workers on
+    // one machine can run without it
+    stateUrl: process.env.CLUSTER_STATE_URL || '',
+    // Unique per process; stamped on its containers and networks
+    instanceId: process.env.CLUSTER_INSTANCE_ID || `${os.hostname()}-${process.pid}`,
+    // Replicas sharing a Docker daemon split the subnet pools into CLUSTER_SLOTS
+    // disjoint slices and each takes one (set automatically for workers)
+    slot: parseInt(process.env.CLUSTER_SLOT || '0', 10),
+    slots: parseInt(process.env.CLUSTER_SLOTS || '1', 10),
+    heartbeatInterval: parseInt(process.env.CLUSTER_HEARTBEAT_INTERVAL || '5000', 10), // ms
+    // A replica without a heartbeat for this long is dead and its containers are orphans
+    instanceTimeout: parseInt(process.env.CLUSTER_INSTANCE_TIMEOUT || '20000', 10), // ms
+  },
+
   // === Docker Configuration ===
   docker: {
     // Resource limits per container
@@ -28,6 +63,17 @@ export const config = {
     commandTimeout: parseInt(process.env.DOCKER_CMD_TIMEOUT || '15000', 10), // Docker command timeout (ms)
   },
 
+  dockerHosts: {
+    // Docker daemons to place sessions on, as comma-separated name=endpoint pairs,
+    // e.g. "local=unix:///var/run/docker.sock,b=https://10.0.0.5:2376".
+    // Empty = only the daemon of the active Docker CLI context
+    hosts: process.env.DOCKER_HOSTS || '',
+    // TLS client certificates for https:// endpoints: <certDir>/<name>/{ca,cert,key}.pem
+    certDir: process.env.DOCKER_HOSTS_CERT_DIR || './certs/docker',
+    healthInterval: parseInt(process.env.DOCKER_HOSTS_HEALTH_INTERVAL || '10000', 10), // ms
+    healthTimeout: parseInt(process.env.DOCKER_HOSTS_HEALTH_TIMEOUT || '3000', 10), // ms
+  },
+
   // === Network Configuration ===
   network: {
     // Session network naming and lifecycle
@@ -47,6 +93,14 @@ export const config = {
         { name: 'pool2', base: p2, cidr: `${p2}.0.0/16`, capacity: 4096 },
       ];
     })(),
+
+    // Pre-created network pool: sessions lease a ready network instead of
+    // creating one, and released networks are emptied and reused.
+    // NETWORK_POOL_SIZE=0 creates a network per session as before
+    poolSize: parseInt(process.env.NETWORK_POOL_SIZE || '4', 10),
+    // Free networks kept from ended sessions beyond which released ones are deleted
+    poolMax: parseInt(process.env.NETWORK_POOL_MAX || '16', 10),
+    poolRefillInterval: parseInt(process.env.NETWORK_POOL_REFILL_INTERVAL || '10000', 10), // ms
   },
 
   // === Session Container Management ===
@@ -54,6 +108,11 @@ export const config = {
     // TTL and cleanup
     ttl: parseInt(process.env.SESSION_TTL || '90000', 10), // 90 seconds (increased from 30s for better reuse)
     cleanupInterval: parseInt(process.env.CLEANUP_INTERVAL || '30000', 10), // 30 seconds
+    // Follow Docker die/destroy events to drop dead or removed containers right away;
+    // while every host's event stream is open, the listContainers orphan sweep only
+    // runs every ORPHAN_SWEEP_INTERVAL instead of on each cleanup pass
+    containerEvents: process.env.CONTAINER_EVENTS !== 'false',
+    orphanSweepInterval: parseInt(process.env.ORPHAN_SWEEP_INTERVAL || '300000', 10), // 5 minutes
     orphanedNetworkAge: parseInt(process.env.ORPHANED_NETWORK_AGE || '300000', 10), // 5 minutes
 
     // Concurrency control for parallel execution requests
@@ -62,11 +121,24 @@ export const config = {
     // Pooling configuration
     maxPerSession: parseInt(process.env.MAX_CONTAINERS_PER_SESSION || '10', 10),
     autoCleanup: process.env.AUTO_CLEANUP !== 'false',
+
+    // Standby pool: containers created, started and (for sql) health-checked ahead
+    // of demand, handed to a session on its first run of that language.
+    // PREWARM_TARGETS overrides the base size per language, e.g. "sql=2,java=1"
     preWarmPool: process.env.PREWARM_POOL === 'true',
+    preWarmSize: parseInt(process.env.PREWARM_SIZE || '1', 10),
+    preWarmTargets: parseLanguageCounts(process.env.PREWARM_TARGETS || ''),
+    preWarmMax: parseInt(process.env.PREWARM_MAX || '5', 10),
+    // The target grows to cover the first-run demand seen in this window
+    preWarmDemandWindow: parseInt(process.env.PREWARM_DEMAND_WINDOW || '60000', 10), // ms
+    preWarmRefillInterval: parseInt(process.env.PREWARM_REFILL_INTERVAL || '10000', 10), // ms
 
     // Performance: skip container cleanup for stateless languages (js, cpp, java)
     // Safe because putArchive overwrites files atomically each run
     skipStatelessCleanup: process.env.SKIP_STATELESS_CLEANUP !== 'false',
+    // Upload only files that changed since the container's last run and delete
+    // removed ones (only matters where /app survives between runs, see above)
+    deltaFileSync: process.env.DELTA_FILE_SYNC !== 'false',
   },
 
   // === Execution Queue Configuration ===
@@ -74,6 +146,188 @@ export const config = {
     maxQueueSize: parseInt(process.env.MAX_QUEUE_SIZE || '200', 10),
     queueTimeout: parseInt(process.env.QUEUE_TIMEOUT || '60000', 10), // ms
     enablePriorityQueue: process.env.ENABLE_PRIORITY_QUEUE !== 'false',
+    // Weighted fair sharing of execution slots across languages, by observed service time
+    fairScheduling: process.env.FAIR_SCHEDULING !== 'false',
+    // Per-language caps on concurrently running tasks, e.g. "cpp=20,java=20"
+    languageConcurrency: parseLanguageCounts(process.env.LANGUAGE_CONCURRENCY || ''),
+    // Adaptive concurrency: count running tasks in cost units (a language's run time
+    // in units of ADAPTIVE_COST_UNIT_MS) and move the limit AIMD-style between
+    // ADAPTIVE_CONCURRENCY_MIN and ADAPTIVE_CONCURRENCY_MAX from host CPU/memory and
+    // run latency. It starts at MAX_CONCURRENT_SESSIONS
+    adaptive: {
+      enabled: process.env.ADAPTIVE_CONCURRENCY !== 'false',
+      min: parseInt(process.env.ADAPTIVE_CONCURRENCY_MIN || '4', 10),
+      max: parseInt(process.env.ADAPTIVE_CONCURRENCY_MAX || '100', 10),
+      intervalMs: parseInt(process.env.ADAPTIVE_CONCURRENCY_INTERVAL || '2000', 10), // ms
+      targetCpu: parseFloat(process.env.ADAPTIVE_TARGET_CPU || '85'), // percent
+      targetMemory: parseFloat(process.env.ADAPTIVE_TARGET_MEMORY || '90'), // percent
+      // Cut the limit when runs take this many times their language's usual time
+      latencyRatio: parseFloat(process.env.ADAPTIVE_LATENCY_RATIO || '2'),
+      decreaseFactor: parseFloat(process.env.ADAPTIVE_DECREASE_FACTOR || '0.75'),
+      costUnitMs: parseInt(process.env.ADAPTIVE_COST_UNIT_MS || '1000', 10),
+      maxCostWeight: parseFloat(process.env.ADAPTIVE_MAX_COST_WEIGHT || '8'),
+    },
+  },
+
+  // === Batch Execution (POST /api/run/batch) ===
+  batch: {
+    // Max jobs in one batch request
+    maxJobs: parseInt(process.env.BATCH_MAX_JOBS || '500', 10),
+    // Request body limit for batch requests (other requests keep 10mb)
+    maxBodySize: process.env.BATCH_MAX_BODY_SIZE || '50mb',
+    // Execution slots for batch jobs, separate from MAX_CONCURRENT_SESSIONS
+    maxConcurrent: parseInt(process.env.BATCH_MAX_CONCURRENT || '8', 10),
+    // Reused sessions (containers) per language in one batch; each runs its jobs in turn
+    lanesPerLanguage: parseInt(process.env.BATCH_LANES_PER_LANGUAGE || '4', 10),
+    // How long a batch job may wait for a slot
+    queueTimeout: parseInt(process.env.BATCH_QUEUE_TIMEOUT || '600000', 10), // ms
+  },
+
+  // === C/C++ Build Configuration ===
+  cppBuild: {
+    // Content-addressed binary cache inside session containers: an unchanged
+    // rerun execs the cached binary instead of invoking g++ again
+    cacheEnabled: process.env.CPP_BUILD_CACHE !== 'false',
+    // Optional host directory shared across sessions (empty = disabled)
+    hostCacheDir: process.env.CPP_BUILD_CACHE_DIR || '',
+    hostCacheMaxEntries: parseInt(process.env.CPP_BUILD_CACHE_MAX_ENTRIES || '500', 10),
+    // Force-include a precompiled STL header from the cpp-runtime image when the
+    // program itself includes every header it contains
+    pchEnabled: process.env.CPP_PCH !== 'false',
+    // Compile multi-file projects to per-translation-unit objects and only
+    // rebuild the ones whose sources or included headers changed
+    incremental: process.env.CPP_INCREMENTAL_BUILD !== 'false',
+    // Concurrent translation-unit compiles (0 = derive from DOCKER_CPUS)
+    compileJobs: parseInt(process.env.CPP_COMPILE_JOBS || '0', 10),
+    // Build profile when a run doesn't ask for one (debug | release | native),
+    // and the one grading runs default to
+    defaultProfile: (process.env.CPP_BUILD_PROFILE || 'debug') as 'debug' | 'release' | 'native',
+    gradingProfile: (process.env.CPP_GRADING_BUILD_PROFILE || 'release') as 'debug' | 'release' | 'native',
+    // Linker passed via -fuse-ld (empty = GNU ld). The cpp-runtime image ships mold
+    linker: process.env.CPP_LINKER ?? 'mold',
+    // Run the toolchain page-cache warmer as the cpp container's main process; it
+    // re-reads the toolchain files so they stay cached between builds of a session
+    toolchainWarmer: process.env.CPP_TOOLCHAIN_WARMER === 'true',
+  },
+
+  // === Checkpoint/Restore ===
+  checkpoint: {
+    // Start new session containers from a CRIU checkpoint of an initialized
+    // runtime container (needs an experimental Docker daemon with CRIU)
+    enabled: process.env.CHECKPOINT_RESTORE === 'true',
+    languages: (process.env.CHECKPOINT_LANGUAGES || 'java,sql').split(',').map(l => l.trim()).filter(Boolean),
+    // Checkpoint directory on the Docker host
+    dir: process.env.CHECKPOINT_DIR || '/var/lib/coderunner/checkpoints',
+    // Wait before rebuilding a checkpoint that failed to create or restore (ms)
+    retryInterval: parseInt(process.env.CHECKPOINT_RETRY_INTERVAL || '300000', 10),
+  },
+
+  // === Execution Agent ===
+  agent: {
+    // Run cr-agent as the main process of session containers and send execs,
+    // uploads and file reads over one attached stream instead of Docker API calls
+    enabled: process.env.EXEC_AGENT !== 'false',
+    // How long a freshly started container gets to answer the agent hello (ms)
+    helloTimeout: parseInt(process.env.EXEC_AGENT_HELLO_TIMEOUT || '2000', 10),
+  },
+
+  // === Workspace tmpfs ===
+  workspace: {
+    // Mount /app and /tmp of agent-driven session containers (not sql) as tmpfs, so
+    // compile I/O and the wipe between runs stay in memory. Written files count
+    // against the container's memory limit. Needs the execution agent: Docker's
+    // archive API cannot see tmpfs mounts
+    tmpfs: process.env.WORKSPACE_TMPFS !== 'false',
+    appSize: process.env.WORKSPACE_TMPFS_SIZE || '256m',
+    tmpSize: process.env.WORKSPACE_TMPFS_TMP_SIZE || '256m',
+  },
+
+  // === Resource Telemetry ===
+  telemetry: {
+    // Capture each run's cgroup CPU time, peak memory, CPU throttling and block I/O
+    // from Docker stats: one-shot readings around the exec, plus a stats stream
+    // that is open only while the exec runs
+    execResources: process.env.EXEC_RESOURCE_TELEMETRY !== 'false',
+  },
+
+  // === Java Runner ===
+  javaRunner: {
+    // Keep a compile-and-run JVM resident in java session containers and send
+    // runs to it; the cold javac && java command stays as the fallback
+    daemon: process.env.JAVA_RUNNER_DAEMON !== 'false',
+    // Compile into a content-addressed class directory and skip javac when
+    // the sources are unchanged
+    classCache: process.env.JAVA_CLASS_CACHE !== 'false',
+  },
+
+  // === Speculative Builds ===
+  speculativeBuild: {
+    // Accept `build` socket events and compile cpp/java sources in the background
+    // at the lowest queue priority, so a following Run hits the build cache
+    enabled: process.env.SPECULATIVE_BUILD !== 'false',
+  },
+
+  // === SQL Backend ===
+  sqlBackend: {
+    // 'container': one postgres-runtime container per session (default)
+    // 'shared': a few long-lived Postgres servers; each session gets a database
+    // cloned from a template and its own login role
+    mode: (process.env.SQL_BACKEND || 'container') as 'container' | 'shared',
+    servers: parseInt(process.env.SQL_SHARED_SERVERS || '2', 10),
+    serverMemory: process.env.SQL_SHARED_MEMORY || '1024m',
+    serverCpus: process.env.SQL_SHARED_CPUS || '1',
+    maxConnections: parseInt(process.env.SQL_SHARED_MAX_CONNECTIONS || '100', 10),
+    // Concurrent connections allowed per session role
+    sessionConnectionLimit: parseInt(process.env.SQL_SESSION_CONNECTION_LIMIT || '4', 10),
+    // Optional .sql file on the server host loaded into the template database
+    templateSeed: process.env.SQL_TEMPLATE_SEED || '',
+  },
+
+  // === Interactive Output Streaming ===
+  output: {
+    // Per-run ceiling on streamed stdout+stderr; the run is stopped past it
+    maxBytes: parseInt(process.env.OUTPUT_MAX_BYTES || '1048576', 10), // 1MB
+    // Largest single output event sent to the client
+    frameBytes: parseInt(process.env.OUTPUT_FRAME_BYTES || '65536', 10),
+    // Flush delay after a quiet period, and the batching interval for sustained output (ms)
+    interactiveFlushMs: parseInt(process.env.OUTPUT_FLUSH_INTERACTIVE || '10', 10),
+    batchFlushMs: parseInt(process.env.OUTPUT_FLUSH_INTERVAL || '100', 10),
+    // Packets waiting in a client's send buffer before the exec stream is paused
+    socketBacklog: parseInt(process.env.OUTPUT_SOCKET_BACKLOG || '16', 10),
+    // WebSocket permessage-deflate for messages at least compressionThreshold bytes
+    compression: process.env.OUTPUT_COMPRESSION === 'true',
+    compressionThreshold: parseInt(process.env.OUTPUT_COMPRESSION_THRESHOLD || '16384', 10),
+  },
+
+  // === Benchmark Mode ===
+  benchmark: {
+    // Repeated runs of the compiled program per benchmark request
+    defaultRuns: parseInt(process.env.BENCHMARK_RUNS || '10', 10),
+    maxRuns: parseInt(process.env.BENCHMARK_MAX_RUNS || '50', 10),
+    // Stop starting new runs once this much wall time has been spent (ms)
+    timeBudgetMs: parseInt(process.env.BENCHMARK_TIME_BUDGET || '20000', 10),
+  },
+
+  // === Test-Case Run Mode (testCases on /api/run and batch jobs) ===
+  testCases: {
+    maxCases: parseInt(process.env.TEST_CASES_MAX || '100', 10),
+    // Per-case limits when a case doesn't set its own, and the largest allowed
+    defaultTimeLimitMs: parseInt(process.env.TEST_CASE_TIME_LIMIT || '2000', 10),
+    maxTimeLimitMs: parseInt(process.env.TEST_CASE_MAX_TIME_LIMIT || '10000', 10),
+    defaultMemoryLimit: process.env.TEST_CASE_MEMORY_LIMIT || '256m', // capped at DOCKER_MEMORY
+    // stdout of one case beyond this is an output_limit verdict
+    outputLimitBytes: parseInt(process.env.TEST_CASE_OUTPUT_LIMIT || String(16 * 1024 * 1024), 10),
+    // Exec timeout of a whole test-case run, compilation included
+    maxTotalMs: parseInt(process.env.TEST_CASE_MAX_TOTAL || '120000', 10),
+  },
+
+  // === Notebook Kernels ===
+  notebook: {
+    // C++ notebooks run on cling, an incremental C++ interpreter, in their own
+    // image (runtimes/cpp-kernel); each cell is JIT-compiled into the live process
+    cppKernel: process.env.NOTEBOOK_CPP_KERNEL !== 'false',
+    cppKernelImage: process.env.CPP_KERNEL_IMAGE || 'cpp-kernel-runtime',
+    cppStandard: process.env.CPP_KERNEL_STD || 'c++17',
   },
 
   // === Container Runtime Images ===
@@ -128,10 +382,38 @@ export function validateConfig(): void {
     throw new Error('No runtime images configured');
   }
 
+  const buildProfiles = ['debug', 'release', 'native'];
+  for (const profile of [config.cppBuild.defaultProfile, config.cppBuild.gradingProfile]) {
+    if (!buildProfiles.includes(profile)) {
+      throw new Error(`Invalid C/C++ build profile: ${profile}`);
+    }
+  }
+
+  if (!['container', 'shared'].includes(config.sqlBackend.mode)) {
+    throw new Error(`Invalid SQL backend: ${config.sqlBackend.mode}`);
+  }
+
+  for (const language of config.checkpoint.languages) {
+    if (!validRuntimes.includes(language)) {
+      throw new Error(`Invalid checkpoint language: ${language}`);
+    }
+  }
+
+  if (config.cluster.slots < 1 || config.cluster.slot < 0 || config.cluster.slot >= config.cluster.slots) {
+    throw new Error(`Invalid cluster slot: ${config.cluster.slot} of ${config.cluster.slots}`);
+  }
+
   const totalSubnetCapacity = config.network.subnetPools.reduce((sum, pool) => sum + pool.capacity, 0);
   logger.info('Config', `Network capacity: ${totalSubnetCapacity} concurrent sessions`);
 }
 
+/**
+ * Whether a client-supplied language names one of config.runtimes
+ */
+export function isSupportedLanguage(language: unknown): language is keyof typeof config.runtimes {
+  return typeof language === 'string' && Object.prototype.hasOwnProperty.call(config.runtimes, language);
+}
+
 /**
  * Get runtime configuration by language
  */
@@ -142,3 +424,12 @@ export function getRuntimeConfig(language: string) {
   }
   return runtime;
 }
+
+/**
+ * Whole CPUs in a session container's quota (DOCKER_CPUS), at least one.
+ * Fractional quotas round down so parallel work never over-subscribes the cgroup.
+ */
+export function containerCpuQuota(): number {
+  const cpus = parseFloat(config.docker.cpus);
+  return Number.isFinite(cpus) ? Math.max(1, Math.floor(cpus)) : 1;
+}
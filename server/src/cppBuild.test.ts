@@ -0,0 +1,347 @@
+/**
+ * Tests for C/C++ build planning
+ * Covers file filtering, cache key derivation, command generation and the host store.
+ */
+
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+import * as crypto from 'crypto';
+import {
+  filterCppFiles,
+  computeBuildKey,
+  compileJobs,
+  planCppBuild,
+  parseBuildProfile,
+  selectPrecompiledHeader,
+  resolveHeaderDependencies,
+  HostBuildStore,
+  hostStoreKey,
+  BUILD_CACHE_DIR,
+  BUILD_PROFILES,
+  OBJECT_DIR,
+  PCH_VARIANTS,
+  PCH_DIR,
+} from './cppBuild';
+import { profileRunWrapper } from './profiler';
+import { config } from './config';
+
+describe('filterCppFiles', () => {
+  const files = [
+    { path: 'main.cpp' },
+    { path: 'util.hpp' },
+    { path: 'legacy.c' },
+    { path: 'shared.h' },
+    { path: 'notes.txt' },
+  ];
+
+  it('should keep C++ sources and headers for a .cpp entry', () => {
+    expect(filterCppFiles(files, 'main.cpp').map(f => f.path)).toEqual(['main.cpp', 'util.hpp', 'shared.h']);
+  });
+
+  it('should keep C sources and headers for a .c entry', () => {
+    expect(filterCppFiles(files, 'legacy.c').map(f => f.path)).toEqual(['legacy.c', 'shared.h']);
+  });
+
+  it('should keep all files when there is no entry file', () => {
+    expect(filterCppFiles(files)).toHaveLength(files.length);
+  });
+});
+
+describe('computeBuildKey', () => {
+  it('should be independent of file order', () => {
+    const a = { path: 'a.cpp', content: 'int a;' };
+    const b = { path: 'b.cpp', content: 'int b;' };
+    expect(computeBuildKey([a, b], ['g++'])).toBe(computeBuildKey([b, a], ['g++']));
+  });
+
+  it('should change with content and toolchain', () => {
+    const files = [{ path: 'main.cpp', content: 'int main() {}' }];
+    const base = computeBuildKey(files, ['g++']);
+    expect(computeBuildKey([{ path: 'main.cpp', content: 'int main() { }' }], ['g++'])).not.toBe(base);
+    expect(computeBuildKey(files, ['g++', '-O2'])).not.toBe(base);
+  });
+});
+
+describe('planCppBuild', () => {
+  const files = [
+    { path: 'main.cpp', content: 'int main() {}' },
+    { path: 'list.cpp', content: 'void f() {}' },
+    { path: 'list.hpp', content: 'void f();' },
+    { path: 'lib/extra.cpp', content: '' },
+  ];
+
+  it('should compile only top-level translation units', () => {
+    const plan = planCppBuild(files, 'main.cpp', { cache: false, pch: false, profile: 'debug' });
+    expect(plan.compiler).toBe('g++');
+    expect(plan.sources).toEqual(['list.cpp', 'main.cpp']);
+    expect(plan.command).toContain("g++ -O0 -g -fuse-ld=mold 'list.cpp' 'main.cpp' -o app && ");
+    expect(plan.command).toContain('exec ./app');
+    expect(plan.key).toBe('');
+  });
+
+  it('should use gcc for C entry files', () => {
+    const plan = planCppBuild([{ path: 'main.c', content: '' }], 'main.c', { cache: false });
+    expect(plan.compiler).toBe('gcc');
+  });
+
+  it('should generate a cached command keyed by content', () => {
+    const plan = planCppBuild(files, 'main.cpp', { cache: true });
+    expect(plan.key).toMatch(/^[0-9a-f]{64}$/);
+    expect(plan.command).toContain(`C=${BUILD_CACHE_DIR}; K=${plan.key}`);
+    expect(plan.command).toContain('cache=hit');
+    expect(plan.command).toContain('cache=miss');
+    expect(plan.command).toContain('exec "$C/$K"');
+    expect(plan.command).toMatch(/^echo "___BUILD___start=\$\(date \+%s%N\)" >&2; /);
+    expect(plan.command).toContain('echo "___BUILD___run=$(date +%s%N)" >&2; exec "$C/$K"');
+    expect(plan.command).not.toContain('digest=');
+  });
+
+  it('should run the cached binary under perf in profiling mode', () => {
+    const plan = planCppBuild(files, 'main.cpp', { cache: true, runWrapper: profileRunWrapper });
+    expect(plan.command).not.toContain('exec "$C/$K"');
+    expect(plan.command).toContain(`sh "$C/$K" "$P"`);
+    expect(plan.command).toContain(`--comm '${plan.key.substring(0, 15)}'`);
+  });
+
+  it('should report a digest when requested', () => {
+    const plan = planCppBuild(files, 'main.cpp', { cache: true, reportDigest: true });
+    expect(plan.command).toContain('digest=$(sha256sum');
+  });
+});
+
+describe('build profiles', () => {
+  const files = [{ path: 'main.cpp', content: '#include <iostream>\nint main() {}' }];
+
+  it('should accept only known profiles', () => {
+    expect(parseBuildProfile('release')).toBe('release');
+    expect(parseBuildProfile('fast')).toBeNull();
+    expect(parseBuildProfile('toString')).toBeNull();
+    expect(parseBuildProfile(3)).toBeNull();
+  });
+
+  it('should pass the profile flags to the compiler', () => {
+    expect(planCppBuild(files, 'main.cpp', { cache: false, pch: false, profile: 'release' }).command)
+      .toContain("g++ -O2 -fuse-ld=mold 'main.cpp' -o app && ");
+    expect(planCppBuild(files, 'main.cpp', { cache: false, pch: false, profile: 'native' }).flags)
+      .toEqual(['-O3', '-march=native']);
+  });
+
+  it('should key the build on the profile', () => {
+    const debug = planCppBuild(files, 'main.cpp', { cache: true, profile: 'debug' });
+    const release = planCppBuild(files, 'main.cpp', { cache: true, profile: 'release' });
+    expect(debug.key).not.toBe(release.key);
+  });
+
+  it('should default grading runs to the grading profile', () => {
+    const grading = planCppBuild(files, 'main.cpp', { cache: true, pch: false, grading: true });
+    const explicit = planCppBuild(files, 'main.cpp', { cache: true, pch: false, profile: config.cppBuild.gradingProfile });
+    const interactive = planCppBuild(files, 'main.cpp', { cache: true, pch: false });
+    expect(grading.flags).toEqual([...BUILD_PROFILES[config.cppBuild.gradingProfile]]);
+    expect(grading.key).toBe(explicit.key);
+    expect(grading.key).not.toBe(interactive.key);
+    expect(planCppBuild(files, 'main.cpp', { cache: false, pch: false, grading: true, profile: 'debug' }).flags)
+      .toEqual(['-O0', '-g']);
+  });
+
+  it('should store native binaries per Docker host', () => {
+    const release = planCppBuild(files, 'main.cpp', { cache: true, profile: 'release' });
+    const native = planCppBuild(files, 'main.cpp', { cache: true, profile: 'native' });
+    expect(hostStoreKey(release, 'a')).toBe(release.key);
+    expect(hostStoreKey(release, 'b')).toBe(release.key);
+    expect(hostStoreKey(native, 'a')).toMatch(/^[0-9a-f]{64}$/);
+    expect(hostStoreKey(native, 'a')).not.toBe(native.key);
+    expect(hostStoreKey(native, 'a')).not.toBe(hostStoreKey(native, 'b'));
+  });
+
+  it('should skip the precompiled header for native builds', () => {
+    expect(planCppBuild(files, 'main.cpp', { cache: false, pch: true, profile: 'release' }).flags)
+      .toContain('-include');
+    expect(planCppBuild(files, 'main.cpp', { cache: false, pch: true, profile: 'native' }).flags)
+      .not.toContain('-include');
+  });
+});
+
+describe('incremental builds', () => {
+  const project = [
+    { path: 'main.cpp', content: '#include "list.hpp"\nint main() { f(); }' },
+    { path: 'list.cpp', content: '#include "list.hpp"\nvoid f() {}' },
+    { path: 'util.cpp', content: '#include "util/math.hpp"\nint g() { return 1; }' },
+    { path: 'list.hpp', content: 'void f();' },
+    { path: 'util/math.hpp', content: '#include "../list.hpp"\nint g();' },
+  ];
+  const objectKey = (files: typeof project, source: string) =>
+    planCppBuild(files, 'main.cpp', { cache: true, pch: false, incremental: true })
+      .objects.find(o => o.source === source)!.key;
+
+  it('should resolve quoted includes transitively and relative to the including file', () => {
+    const deps = resolveHeaderDependencies(project);
+    expect(deps.get('util.cpp')!.map(f => f.path).sort()).toEqual(['list.hpp', 'util.cpp', 'util/math.hpp']);
+    expect(deps.get('main.cpp')!.map(f => f.path).sort()).toEqual(['list.hpp', 'main.cpp']);
+  });
+
+  it('should depend on every header when an include cannot be resolved', () => {
+    const deps = resolveHeaderDependencies([
+      { path: 'main.cpp', content: '#include "missing.hpp"' },
+      { path: 'a.hpp', content: '' },
+    ]);
+    expect(deps.get('main.cpp')!.map(f => f.path)).toEqual(['main.cpp', 'a.hpp']);
+  });
+
+  it('should compile each translation unit to its own object', () => {
+    const plan = planCppBuild(project, 'main.cpp', { cache: true, pch: false, incremental: true });
+    expect(plan.objects.map(o => o.source)).toEqual(['list.cpp', 'main.cpp', 'util.cpp']);
+    expect(plan.command).toContain(`O=${OBJECT_DIR}`);
+    for (const object of plan.objects) {
+      expect(plan.command).toContain(`tu ${object.key} '${object.source}'`);
+    }
+  });
+
+  it('should pass the linker only to the link step', () => {
+    const plan = planCppBuild(project, 'main.cpp', { cache: true, pch: false, incremental: true });
+    expect(plan.command).toMatch(/g\+\+ -fuse-ld=mold "\$O\/[0-9a-f]{64}\.o"/);
+    expect(plan.command).not.toMatch(/-fuse-ld=mold -c/);
+  });
+
+  it('should compile translation units concurrently up to the job limit', () => {
+    const plan = planCppBuild(project, 'main.cpp', { cache: true, pch: false, incremental: true, jobs: 2 });
+    expect(plan.command).toContain('& P="$P $!"');
+    expect(plan.command).toContain('if [ $# -ge 2 ]; then wait $1');
+    expect(plan.command).toContain('for p in $P; do wait $p || R=1; done');
+  });
+
+  it('should not run more jobs than there are translation units', () => {
+    const plan = planCppBuild(project, 'main.cpp', { cache: true, pch: false, incremental: true, jobs: 16 });
+    expect(plan.command).toContain('if [ $# -ge 3 ]');
+  });
+
+  it('should default the job limit to the whole CPUs in the container quota', () => {
+    const docker = config.docker as { cpus: string };
+    const cppBuild = config.cppBuild as { compileJobs: number };
+    const saved = { cpus: docker.cpus, jobs: cppBuild.compileJobs };
+    try {
+      cppBuild.compileJobs = 0;
+      docker.cpus = '0.25';
+      expect(compileJobs()).toBe(1);
+      docker.cpus = '2.5';
+      expect(compileJobs()).toBe(2);
+      cppBuild.compileJobs = 6;
+      expect(compileJobs()).toBe(6);
+    } finally {
+      docker.cpus = saved.cpus;
+      cppBuild.compileJobs = saved.jobs;
+    }
+  });
+
+  it('should keep object keys of unchanged translation units', () => {
+    const edited = project.map(f => (f.path === 'main.cpp' ? { ...f, content: f.content + '\n' } : f));
+    expect(objectKey(edited, 'main.cpp')).not.toBe(objectKey(project, 'main.cpp'));
+    expect(objectKey(edited, 'list.cpp')).toBe(objectKey(project, 'list.cpp'));
+    expect(objectKey(edited, 'util.cpp')).toBe(objectKey(project, 'util.cpp'));
+  });
+
+  it('should invalidate only the units that include a changed header', () => {
+    const edited = project.map(f => (f.path === 'util/math.hpp' ? { ...f, content: 'long g();' } : f));
+    expect(objectKey(edited, 'util.cpp')).not.toBe(objectKey(project, 'util.cpp'));
+    expect(objectKey(edited, 'main.cpp')).toBe(objectKey(project, 'main.cpp'));
+  });
+
+  it('should not report a digest for binaries linked from reused objects', () => {
+    const plan = planCppBuild(project, 'main.cpp', { cache: true, pch: false, incremental: true, reportDigest: true });
+    expect(plan.command).toContain('else U=1; fi; }');
+    expect(plan.command).toMatch(/if \[ \$U -eq 0 \]; then echo "___BUILD___digest=/);
+  });
+
+  it('should build single-file programs in one step', () => {
+    const plan = planCppBuild([project[0], project[3]], 'main.cpp', { cache: true, incremental: true });
+    expect(plan.objects).toEqual([]);
+    expect(plan.command).not.toContain('O=');
+  });
+});
+
+describe('precompiled headers', () => {
+  const program = (...headers: string[]) => [{
+    path: 'main.cpp',
+    content: headers.map(h => `#include <${h}>`).join('\n') + '\n#include "local.hpp"\nint main() {}',
+  }];
+
+  it('should select the largest variant the program includes itself', () => {
+    expect(selectPrecompiledHeader(program('iostream'))).toBe('iostream');
+    expect(selectPrecompiledHeader(program('iostream', 'cmath', 'string'))).toBe('iostream');
+    expect(selectPrecompiledHeader(program('vector', 'iostream', 'algorithm', 'map'))).toBe('containers');
+  });
+
+  it('should select stdcxx for <bits/stdc++.h>', () => {
+    expect(selectPrecompiledHeader(program('bits/stdc++.h', 'unistd.h'))).toBe('stdcxx');
+  });
+
+  it('should never force-include a header the program does not include', () => {
+    // <algorithm> would make `int count;` ambiguous under `using namespace std`
+    expect(selectPrecompiledHeader(program('iostream', 'vector', 'string'))).toBe('iostream');
+    expect(selectPrecompiledHeader(program('cstdio', 'regex'))).toBeNull();
+    expect(selectPrecompiledHeader(program())).toBeNull();
+  });
+
+  it('should force-include the PCH and key the build on it', () => {
+    const files = program('iostream');
+    const withPch = planCppBuild(files, 'main.cpp', { cache: true, pch: true, profile: 'release' });
+    const withoutPch = planCppBuild(files, 'main.cpp', { cache: true, pch: false, profile: 'release' });
+    expect(withPch.flags).toEqual(['-O2', '-include', `${PCH_DIR}/iostream.h`]);
+    expect(withPch.key).not.toBe(withoutPch.key);
+  });
+
+  it('should never apply a C++ PCH to C programs', () => {
+    const plan = planCppBuild([{ path: 'main.c', content: '#include <cstdio>' }], 'main.c', { pch: true, profile: 'release' });
+    expect(plan.flags).toEqual(['-O2']);
+  });
+
+  it('should match the header lists baked into the cpp-runtime image', () => {
+    for (const variant of PCH_VARIANTS) {
+      const pchSource = fs.readFileSync(path.resolve(__dirname, `../../runtimes/cpp/pch/${variant.name}.h`), 'utf-8');
+      const baked = [...pchSource.matchAll(/^#include <([^>]+)>/gm)].map(m => m[1]);
+      expect(baked.sort()).toEqual([...variant.headers].sort());
+    }
+  });
+});
+
+describe('HostBuildStore', () => {
+  let dir: string;
+
+  beforeEach(() => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), 'build-store-'));
+  });
+
+  afterEach(() => {
+    fs.rmSync(dir, { recursive: true, force: true });
+  });
+
+  const sha = (b: Buffer) => crypto.createHash('sha256').update(b).digest('hex');
+
+  it('should be disabled without a directory', async () => {
+    const store = new HostBuildStore('', 10);
+    expect(store.enabled).toBe(false);
+    expect(await store.read('abc')).toBeNull();
+  });
+
+  it('should round-trip a verified binary', async () => {
+    const store = new HostBuildStore(dir, 10);
+    const binary = Buffer.from('ELF...');
+    expect(await store.save('k1', binary, sha(binary))).toBe(true);
+    expect(await store.read('k1')).toEqual(binary);
+  });
+
+  it('should refuse binaries that do not match the reported digest', async () => {
+    const store = new HostBuildStore(dir, 10);
+    expect(await store.save('k1', Buffer.from('tampered'), sha(Buffer.from('original')))).toBe(false);
+    expect(await store.read('k1')).toBeNull();
+  });
+
+  it('should evict entries beyond its capacity', async () => {
+    const store = new HostBuildStore(dir, 2);
+    for (const key of ['k1', 'k2', 'k3']) {
+      const binary = Buffer.from(key);
+      await store.save(key, binary, sha(binary));
+    }
+    expect(fs.readdirSync(dir)).toHaveLength(2);
+  });
+});
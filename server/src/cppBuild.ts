@@ -0,0 +1,478 @@
+/**
+ * C/C++ Build Planning
+ *
+ * Turns the files of a `cpp` run into the shell command executed inside the
+ * cpp-runtime container.
+ *
+ * Builds are content-addressed: the key is a SHA-256 over the filtered source
+ * set plus compiler, flags and runtime image. The binary for a key is kept under
+ * /app/.coderunner/cache/<key> (session containers keep /app between runs when
+ * SKIP_STATELESS_CLEANUP is on), so an unchanged rerun skips g++ entirely and
+ * execs the cached binary. Optionally, binaries are also published to a host
+ * directory (CPP_BUILD_CACHE_DIR) and seeded into fresh containers of other
+ * sessions that submit the same sources.
+ *
+ * C++ runs that include every header of one of the precompiled headers baked
+ * into the cpp-runtime image (runtimes/cpp/pch/) get that header force-included,
+ * so g++ loads the .gch instead of re-parsing <iostream>, <vector>, ... on every
+ * build.
+ *
+ * Multi-file projects are compiled per translation unit into content-addressed
+ * objects (/app/.coderunner/obj), so editing one file only recompiles that unit
+ * and the units including a changed header before relinking. Stale units are
+ * compiled concurrently, up to the container's CPU allowance.
+ * The user program can write those objects, so a binary linked from any reused
+ * one is never published to the host store.
+ *
+ * Every run is compiled with one of the BUILD_PROFILES flag sets, which is part
+ * of the cache key, and linked with the fast linker from the image (mold).
+ *
+ * The command reports what it did through stderr markers (see buildReport.ts).
+ */
+
+import * as crypto from 'crypto';
+import * as fs from 'fs';
+import * as path from 'path';
+import { config, containerCpuQuota } from './config';
+import { logger } from './logger';
+import { buildMarkerCommand, buildTimestampCommand, BUILD_RUN_FIELD, BUILD_START_FIELD } from './buildReport';
+import { shellEscape } from './shell';
+import type { FileEntry } from './dockerClient';
+
+const CPP_SOURCE_EXTENSIONS = ['cpp', 'cc', 'cxx', 'c++'];
+const CPP_HEADER_EXTENSIONS = ['hpp', 'h'];
+const C_SOURCE_EXTENSIONS = ['c'];
+const C_HEADER_EXTENSIONS = ['h'];
+
+/** Cache directory inside the container, relative to /app */
+export const BUILD_CACHE_DIR = '.coderunner/cache';
+
+/** Name a host-seeded binary is uploaded under before the command adopts it */
+export const SEED_PREFIX = '.cr-seed-';
+
+/** Directory of the precompiled headers inside the cpp-runtime image */
+export const PCH_DIR = '/opt/coderunner/pch';
+
+/** Toolchain page-cache warmer baked into the cpp-runtime image (CPP_TOOLCHAIN_WARMER) */
+export const CPP_TOOLCHAIN_WARMER_PATH = '/opt/coderunner/bin/cr-toolchain-warmer';
+
+/**
+ * Precompiled header variants baked into the cpp-runtime image, largest first,
+ * with the system headers each one includes. Keep in sync with runtimes/cpp/pch/.
+ */
+export const PCH_VARIANTS = [
+  { name: 'stdcxx', headers: ['bits/stdc++.h'] },
+  { name: 'containers', headers: ['algorithm', 'iostream', 'vector'] },
+  { name: 'iostream', headers: ['iostream'] },
+] as const;
+
+export type PchVariant = typeof PCH_VARIANTS[number]['name'];
+
+const SYSTEM_INCLUDE_REGEX = /^\s*#\s*include\s*<([^>]+)>/gm;
+const LOCAL_INCLUDE_REGEX = /^\s*#\s*include\s*"([^"]+)"/gm;
+
+/** Object directory for incremental multi-file builds, relative to /app */
+export const OBJECT_DIR = '.coderunner/obj';
+
+/** Objects kept per container across incremental builds */
+const MAX_CACHED_OBJECTS = 64;
+
+/**
+ * Build profiles selectable per run:
+ *   debug   → fastest compile, debuggable binary
+ *   release → optimized; the default for grading so timings reflect the algorithm
+ *   native  → aggressive optimization for the host CPU
+ */
+export const BUILD_PROFILES = {
+  debug: ['-O0', '-g'],
+  release: ['-O2'],
+  native: ['-O3', '-march=native'],
+} as const;
+
+export type BuildProfile = keyof typeof BUILD_PROFILES;
+
+/**
+ * Validate a client-supplied profile name. Returns null for unknown values.
+ */
+export function parseBuildProfile(value: unknown): BuildProfile | null {
+  return typeof value === 'string' && Object.prototype.hasOwnProperty.call(BUILD_PROFILES, value)
+    ? value as BuildProfile
+    : null;
+}
+
+/** Binaries kept per container; older entries are evicted on each miss */
+const MAX_CACHED_BINARIES = 8;
+
+export interface CppBuildPlan {
+  compiler: 'gcc' | 'g++';
+  profile: BuildProfile;
+  flags: string[];
+  /** Root-level translation units passed to the compiler */
+  sources: string[];
+  /** Content hash of sources + toolchain; empty when caching is disabled */
+  key: string;
+  /** Per-translation-unit objects for incremental builds (empty for single-step builds) */
+  objects: CppObject[];
+  command: string;
+}
+
+/**
+ * Builds the shell snippet that starts the compiled program. `binary` is the
+ * (quoted) shell expression for it, `executablePath` its path relative to /app.
+ */
+export type RunWrapper = (binary: string, executablePath: string) => string;
+
+export interface CppObject {
+  source: string;
+  /** Content hash of the unit, the project headers it includes and the toolchain */
+  key: string;
+}
+
+export interface CppBuildOptions {
+  /** Optimization profile (default: config.cppBuild.defaultProfile, or gradingProfile for grading runs) */
+  profile?: BuildProfile;
+  /** Test-case and batch runs: default to the grading profile so timings reflect optimized code */
+  grading?: boolean;
+  /** Use the content-addressed binary cache (default: config.cppBuild.cacheEnabled) */
+  cache?: boolean;
+  /** Force-include a matching precompiled header (default: config.cppBuild.pchEnabled) */
+  pch?: boolean;
+  /** Compile multi-file projects per translation unit (default: config.cppBuild.incremental) */
+  incremental?: boolean;
+  /** Concurrent translation-unit compiles (default: compileJobs()) */
+  jobs?: number;
+  /** Start the binary through a wrapper (profiling/benchmark modes) instead of exec'ing it */
+  runWrapper?: RunWrapper;
+  /** Emit a digest of fresh binaries so they can be published to the host store */
+  reportDigest?: boolean;
+}
+
+function extensionOf(filePath: string): string {
+  return filePath.split('.').pop()?.toLowerCase() || '';
+}
+
+function isCEntry(entryPath: string): boolean {
+  return extensionOf(entryPath) === 'c';
+}
+
+/**
+ * Number of translation units compiled concurrently: CPP_COMPILE_JOBS when set,
+ * otherwise the container's whole-CPU quota (see containerCpuQuota).
+ */
+export function compileJobs(): number {
+  if (config.cppBuild.compileJobs > 0) return config.cppBuild.compileJobs;
+  return containerCpuQuota();
+}
+
+/**
+ * For C/C++, keep only the files belonging to the entry file's language so that
+ * mixed workspaces don't feed .c files to g++ (or vice versa).
+ */
+export function filterCppFiles<T extends { path: string }>(files: T[], entryPath?: string): T[] {
+  if (!entryPath) return files;
+  const allowed = isCEntry(entryPath)
+    ? [...C_SOURCE_EXTENSIONS, ...C_HEADER_EXTENSIONS]
+    : [...CPP_SOURCE_EXTENSIONS, ...CPP_HEADER_EXTENSIONS];
+  return files.filter(f => allowed.includes(extensionOf(f.path)));
+}
+
+/**
+ * Collect the `#include <...>` headers referenced by a set of files.
+ */
+export function collectSystemIncludes(files: FileEntry[]): Set<string> {
+  const includes = new Set<string>();
+  for (const file of files) {
+    const content = typeof file.content === 'string' ? file.content : file.content.toString('utf-8');
+    for (const match of content.matchAll(SYSTEM_INCLUDE_REGEX)) {
+      includes.add(match[1].trim());
+    }
+  }
+  return includes;
+}
+
+/**
+ * Pick the precompiled header to force-include for a C++ program: the largest
+ * variant whose headers the program includes itself. Force-including it then
+ * only moves those includes to the top; a header the program doesn't include
+ * could add names that clash with its own (e.g. a global `count` next to
+ * std::count from <algorithm> under `using namespace std`). Returns null when
+ * no variant fits; the program is compiled without a PCH.
+ */
+export function selectPrecompiledHeader(files: FileEntry[]): PchVariant | null {
+  const includes = collectSystemIncludes(files);
+  const variant = PCH_VARIANTS.find(v => v.headers.every(header => includes.has(header)));
+  return variant ? variant.name : null;
+}
+
+/**
+ * Compute the content-addressed build key for a source set and toolchain.
+ * Files are hashed in path order so the key is independent of upload order.
+ */
+export function computeBuildKey(files: FileEntry[], toolchain: string[]): string {
+  const hash = crypto.createHash('sha256');
+  for (const part of toolchain) {
+    hash.update(part).update('\0');
+  }
+  const sorted = [...files].sort((a, b) => (a.path < b.path ? -1 : a.path > b.path ? 1 : 0));
+  for (const file of sorted) {
+    hash.update(file.path).update('\0');
+    hash.update(file.content).update('\0');
+  }
+  return hash.digest('hex');
+}
+
+/**
+ * Resolve the project headers each file depends on via `#include "..."`,
+ * transitively. Includes are looked up relative to the including file, then
+ * relative to /app. If any quoted include can't be resolved (e.g. it relies on
+ * an -I path), the file conservatively depends on every project header.
+ */
+export function resolveHeaderDependencies(files: FileEntry[]): Map<string, FileEntry[]> {
+  const byPath = new Map(files.map(f => [f.path, f]));
+  const isSource = (p: string) => [...CPP_SOURCE_EXTENSIONS, ...C_SOURCE_EXTENSIONS].includes(extensionOf(p));
+  const headers = files.filter(f => !isSource(f.path));
+
+  // Direct dependencies per file; null marks an unresolved include
+  const direct = new Map<string, string[] | null>();
+  for (const file of files) {
+    const content = typeof file.content === 'string' ? file.content : file.content.toString('utf-8');
+    const deps: string[] = [];
+    let unresolved = false;
+    for (const match of content.matchAll(LOCAL_INCLUDE_REGEX)) {
+      const name = match[1].trim();
+      const candidates = [
+        path.posix.normalize(path.posix.join(path.posix.dirname(file.path), name)),
+        path.posix.normalize(name),
+      ];
+      const found = candidates.find(c => byPath.has(c));
+      if (found) deps.push(found);
+      else unresolved = true;
+    }
+    direct.set(file.path, unresolved ? null : deps);
+  }
+
+  const result = new Map<string, FileEntry[]>();
+  for (const file of files) {
+    const seen = new Set<string>([file.path]);
+    const stack = [file.path];
+    let conservative = false;
+    while (stack.length > 0 && !conservative) {
+      const deps = direct.get(stack.pop()!);
+      if (deps === null) {
+        conservative = true;
+        break;
+      }
+      for (const dep of deps ?? []) {
+        if (!seen.has(dep)) {
+          seen.add(dep);
+          stack.push(dep);
+        }
+      }
+    }
+    result.set(file.path, conservative
+      ? [file, ...headers.filter(h => h.path !== file.path)]
+      : [...seen].map(p => byPath.get(p)!));
+  }
+  return result;
+}
+
+/**
+ * Plan the build for a cpp run: pick compiler and translation units, derive the
+ * cache key and generate the shell command. On a binary cache miss, multi-file
+ * projects only recompile the objects whose inputs changed before relinking.
+ */
+export function planCppBuild(files: FileEntry[], entryPath: string, options: CppBuildOptions = {}): CppBuildPlan {
+  const useCache = options.cache ?? config.cppBuild.cacheEnabled;
+  const isC = isCEntry(entryPath);
+  const compiler = isC ? 'gcc' : 'g++';
+  const sourceExtensions = isC ? C_SOURCE_EXTENSIONS : CPP_SOURCE_EXTENSIONS;
+  const profile = options.profile
+    ?? (options.grading ? config.cppBuild.gradingProfile : config.cppBuild.defaultProfile);
+  const flags: string[] = [...BUILD_PROFILES[profile]];
+
+  // The image only ships PCH variants for the portable profiles; a -march=native
+  // build would ignore them anyway
+  const usePch = !isC && profile !== 'native' && (options.pch ?? config.cppBuild.pchEnabled);
+  const pch = usePch ? selectPrecompiledHeader(files) : null;
+  if (pch) {
+    flags.push('-include', `${PCH_DIR}/${pch}.h`);
+  }
+
+  // Only top-level sources are compiled (files in subdirectories are still
+  // available to #include)
+  const sources = files
+    .map(f => f.path)
+    .filter(p => !p.includes('/') && sourceExtensions.includes(extensionOf(p)))
+    .sort();
+
+  // Linker selection only affects the link step, so it's kept out of the
+  // per-object keys
+  const linkFlags = config.cppBuild.linker ? [`-fuse-ld=${config.cppBuild.linker}`] : [];
+
+  // How the built binary is started: exec'd directly, or through a run-mode wrapper
+  const runStep: RunWrapper = options.runWrapper ?? ((binary) => `exec ${binary}`);
+
+  const flagArgs = flags.length > 0 ? flags.join(' ') + ' ' : '';
+  const linkArgs = linkFlags.length > 0 ? linkFlags.join(' ') + ' ' : '';
+  const sourceArgs = sources.length > 0 ? sources.map(shellEscape).join(' ') + ' ' : '';
+
+  if (!useCache) {
+    return {
+      compiler,
+      profile,
+      flags,
+      sources,
+      key: '',
+      objects: [],
+      command: `${buildTimestampCommand(BUILD_START_FIELD)}; ` +
+        `${compiler} ${flagArgs}${linkArgs}${sourceArgs}-o app && ` +
+        `{ ${buildTimestampCommand(BUILD_RUN_FIELD)}; ${runStep('./app', 'app')}; }`,
+    };
+  }
+
+  // -march=native binaries are only valid on the Docker host that built them;
+  // the container cache lives on that host, the shared store uses hostStoreKey()
+  const toolchain = [compiler, ...flags, config.runtimes.cpp.image];
+  const key = computeBuildKey(files, [...toolchain, ...linkFlags]);
+  const binary = `"$C/$K"`;
+
+  let objects: CppObject[] = [];
+  let buildSteps: string[];
+
+  if ((options.incremental ?? config.cppBuild.incremental) && sources.length > 1) {
+    const dependencies = resolveHeaderDependencies(files);
+    objects = sources.map(source => ({
+      source,
+      key: computeBuildKey(dependencies.get(source) ?? [], toolchain),
+    }));
+    const objectPaths = objects.map(o => `"$O/${o.key}.o"`).join(' ');
+    const jobs = Math.min(options.jobs ?? compileJobs(), objects.length);
+
+    // Stale objects are compiled by `tu <key> <source>` as background jobs,
+    // at most `jobs` at a time. Each job's diagnostics go to its own log,
+    // replayed in source order afterwards so parallel errors don't interleave.
+    // U marks a reused object: the user program can write $O, so such a
+    // binary stays in this container's cache and is never published.
+    buildSteps = [
+      `O=${OBJECT_DIR}; R=0; U=0; P=`,
+      'mkdir -p "$O"',
+      'tu() { if [ ! -f "$O/$1.o" ]; then ' +
+      `${compiler} ${flagArgs}-c "$2" -o "$O/$1.o.tmp" 2>"$O/$1.log" && mv -f "$O/$1.o.tmp" "$O/$1.o" & P="$P $!"; ` +
+      `set -- $P; if [ $# -ge ${jobs} ]; then wait $1 || R=1; shift; P="$*"; fi; else U=1; fi; }`,
+      ...objects.map(o => `tu ${o.key} ${shellEscape(o.source)}`),
+      'for p in $P; do wait $p || R=1; done',
+      ...objects.map(o => `if [ -f "$O/${o.key}.log" ]; then cat "$O/${o.key}.log" >&2; rm -f "$O/${o.key}.log"; fi`),
+      '[ $R -eq 0 ] || exit 1',
+      `${compiler} ${linkArgs}${objectPaths} -o "$C/$K.tmp" || exit $?`,
+      // Mark this build's objects as most recent before evicting old ones
+      `touch ${objectPaths}`,
+      `ls -t "$O" | sed '1,${MAX_CACHED_OBJECTS}d' | while read -r f; do rm -f "$O/$f"; done`,
+    ];
+  } else {
+    buildSteps = [`${compiler} ${flagArgs}${linkArgs}${sourceArgs}-o "$C/$K.tmp" || exit $?`];
+  }
+
+  const digestStep = buildMarkerCommand('digest', `$(sha256sum ${binary} | cut -d' ' -f1)`);
+  const steps = [
+    buildTimestampCommand(BUILD_START_FIELD),
+    `C=${BUILD_CACHE_DIR}; K=${key}`,
+    'mkdir -p "$C"',
+    // Adopt a binary seeded from the host-side store
+    `if [ ! -x ${binary} ] && [ -f "${SEED_PREFIX}$K" ]; then mv -f "${SEED_PREFIX}$K" ${binary}; fi`,
+    `if [ -x ${binary} ]; then ${buildMarkerCommand('cache', 'hit')}; else ` + [
+      buildMarkerCommand('cache', 'miss'),
+      ...buildSteps,
+      `mv -f "$C/$K.tmp" ${binary}`,
+      ...(options.reportDigest ? [objects.length > 0 ? `if [ $U -eq 0 ]; then ${digestStep}; fi` : digestStep] : []),
+      `ls -t "$C" | sed '1,${MAX_CACHED_BINARIES}d' | while read -r f; do rm -f "$C/$f"; done`,
+    ].join('; ') + '; fi',
+    buildTimestampCommand(BUILD_RUN_FIELD),
+    runStep(binary, `${BUILD_CACHE_DIR}/${key}`),
+  ];
+
+  return { compiler, profile, flags, sources, key, objects, command: steps.join('; ') };
+}
+
+/**
+ * Name of a plan's binary in the host store, which is shared by every Docker
+ * host. Portable profiles use the build key as is; native binaries are tied to
+ * the CPU of the Docker host that compiled them, so they are stored per host.
+ */
+export function hostStoreKey(plan: Pick<CppBuildPlan, 'key' | 'profile'>, dockerHost: string): string {
+  if (plan.profile !== 'native') return plan.key;
+  return crypto.createHash('sha256').update(`${plan.key}\0${dockerHost}`).digest('hex');
+}
+
+/**
+ * Host-side binary store shared across sessions.
+ * Entries are plain files named by build key; the least recently used ones
+ * are evicted once the store grows past its configured size.
+ */
+export class HostBuildStore {
+  constructor(
+    private readonly dir: string,
+    private readonly maxEntries: number,
+  ) { }
+
+  get enabled(): boolean {
+    return this.dir !== '';
+  }
+
+  /**
+   * Read a cached binary, refreshing its recency. Returns null on a miss.
+   */
+  async read(key: string): Promise<Buffer | null> {
+    if (!this.enabled) return null;
+    const file = path.join(this.dir, key);
+    try {
+      const binary = await fs.promises.readFile(file);
+      const now = new Date();
+      await fs.promises.utimes(file, now, now).catch(() => { /* best effort */ });
+      return binary;
+    } catch {
+      return null;
+    }
+  }
+
+  /**
+   * Store a binary after verifying it against the digest the container reported
+   * right after compiling (before the user program could touch it).
+   */
+  async save(key: string, binary: Buffer, expectedDigest: string): Promise<boolean> {
+    if (!this.enabled) return false;
+
+    const digest = crypto.createHash('sha256').update(binary).digest('hex');
+    if (digest !== expectedDigest) {
+      logger.warn('BuildCache', `Refusing to store ${key.substring(0, 12)}: digest mismatch`);
+      return false;
+    }
+
+    await fs.promises.mkdir(this.dir, { recursive: true });
+    const target = path.join(this.dir, key);
+    const tmp = `${target}.${process.pid}.tmp`;
+    await fs.promises.writeFile(tmp, binary, { mode: 0o755 });
+    await fs.promises.rename(tmp, target);
+    await this.evict();
+    return true;
+  }
+
+  private async evict(): Promise<void> {
+    const names = (await fs.promises.readdir(this.dir)).filter(n => !n.endsWith('.tmp'));
+    if (names.length <= this.maxEntries) return;
+
+    const entries = await Promise.all(names.map(async (name) => {
+      const stat = await fs.promises.stat(path.join(this.dir, name)).catch(() => null);
+      return { name, mtime: stat ? stat.mtimeMs : 0 };
+    }));
+    entries.sort((a, b) => a.mtime - b.mtime);
+
+    for (const entry of entries.slice(0, entries.length - this.maxEntries)) {
+      await fs.promises.rm(path.join(this.dir, entry.name), { force: true });
+    }
+  }
+}
+
+export const hostBuildStore = new HostBuildStore(
+  config.cppBuild.hostCacheDir,
+  config.cppBuild.hostCacheMaxEntries,
+);
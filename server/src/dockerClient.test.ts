@@ -20,8 +20,11 @@ const mockExec = jest.fn().mockResolvedValue({
   inspect: mockExecInspect,
 });
 
+const mockStats = jest.fn();
+
 const mockContainerInstance = {
   id: 'abc123container',
+  stats: mockStats,
   start: mockStart,
   remove: mockRemove,
   exec: mockExec,
@@ -56,6 +59,7 @@ const mockDockerInstance = {
     inspect: jest.fn().mockResolvedValue({}),
   }),
   ping: jest.fn().mockResolvedValue('OK'),
+  getEvents: jest.fn(),
   modem: {
     demuxStream: jest.fn(),
   },
@@ -98,7 +102,15 @@ import {
   pruneNetworks,
   pingDaemon,
   imageExists,
+  readCgroupCounters,
+  diffCgroupCounters,
+  sampleExecResources,
+  withProcessPeak,
+  requiresAgent,
+  parseContainerEvent,
+  watchContainerEvents,
 } from './dockerClient';
+import { clusterState } from './clusterState';
 
 // ─── Tests ───────────────────────────────────────────────────────────────────
 
@@ -147,7 +159,7 @@ describe('DockerClient', () => {
       expect(mockDockerInstance.createContainer).toHaveBeenCalledWith(
         expect.objectContaining({
           Image: 'python-runtime:latest',
-          Labels: { type: 'coderunner', sessionId: 'sess-1' },
+          Labels: { type: 'coderunner', sessionId: 'sess-1', instance: clusterState.instanceId },
           Env: ['HOME=/home/runner'],
           WorkingDir: '/app',
           HostConfig: expect.objectContaining({
@@ -188,6 +200,26 @@ describe('DockerClient', () => {
         }),
       );
     });
+
+    it('should mount tmpfs and keep the archive API away from it', async () => {
+      await createContainer({
+        image: 'cpp-runtime',
+        labels: {},
+        memory: '512m',
+        cpus: '1',
+        tmpfs: { '/app': 'rw,exec,size=256m' },
+      });
+
+      const callArg = mockDockerInstance.createContainer.mock.calls[0][0];
+      expect(callArg.HostConfig.Tmpfs).toEqual({ '/app': 'rw,exec,size=256m' });
+      expect(requiresAgent('abc123container')).toBe(true);
+      // Without an agent the upload would land beneath the mount
+      await expect(putFiles('abc123container', [{ path: 'main.cpp', content: '' }])).rejects.toThrow('tmpfs workspace');
+      expect(mockPutArchive).not.toHaveBeenCalled();
+
+      await removeContainers(['abc123container']);
+      expect(requiresAgent('abc123container')).toBe(false);
+    });
   });
 
   describe('removeContainers', () => {
@@ -217,6 +249,7 @@ describe('DockerClient', () => {
       expect(result).toHaveLength(1);
       expect(result[0].id).toBe('c1');
       expect(result[0].created).toBe(1700000000000); // converted to ms
+      expect(result[0].host).toBe('local');
     });
   });
 
@@ -302,6 +335,137 @@ describe('DockerClient', () => {
       const result = await pruneNetworks('type=coderunner');
       expect(result).toEqual(['net1']);
     });
+
+    it('pruneNetworks should require every given label', async () => {
+      await pruneNetworks('type=coderunner', 'instance=me');
+      expect(mockDockerInstance.pruneNetworks).toHaveBeenCalledWith({
+        filters: { label: ['type=coderunner', 'instance=me'] },
+      });
+    });
+  });
+
+  describe('Exec resource telemetry', () => {
+    const statsV2 = (cpuUserNs: number, usage: number, extra: any = {}) => ({
+      cpu_stats: {
+        cpu_usage: { usage_in_usermode: cpuUserNs, usage_in_kernelmode: 2_000_000 },
+        throttling_data: { throttled_periods: extra.throttled ?? 0, throttled_time: (extra.throttled ?? 0) * 1_000_000 },
+      },
+      memory_stats: { usage, stats: { inactive_file: 1000 } },
+      blkio_stats: { io_service_bytes_recursive: [{ op: 'read', value: extra.read ?? 0 }, { op: 'write', value: 0 }] },
+    });
+
+    it('readCgroupCounters should read cgroup v1 stats', () => {
+      const counters = readCgroupCounters({
+        cpu_stats: { cpu_usage: { usage_in_usermode: 5e6, usage_in_kernelmode: 1e6 } },
+        memory_stats: { usage: 10_000, max_usage: 50_000, stats: { total_inactive_file: 2000 } },
+        blkio_stats: { io_service_bytes_recursive: [{ op: 'Read', value: 512 }, { op: 'Write', value: 256 }, { op: 'Total', value: 768 }] },
+      });
+      expect(counters).toEqual({
+        cpuUserNs: 5e6, cpuSystemNs: 1e6, memoryBytes: 8000, memoryPeakBytes: 50_000,
+        throttledPeriods: 0, throttledNs: 0, blockReadBytes: 512, blockWriteBytes: 256,
+      });
+    });
+
+    it('diffCgroupCounters should only trust a lifetime peak that rose during the exec', () => {
+      const base = readCgroupCounters(statsV2(0, 0));
+      const before = { ...base, memoryPeakBytes: 90_000 };
+      expect(diffCgroupCounters(before, { ...base, memoryBytes: 100, memoryPeakBytes: 90_000 }, 5000).peakMemoryBytes).toBe(5000);
+      expect(diffCgroupCounters(before, { ...base, memoryBytes: 100, memoryPeakBytes: 120_000 }, 5000).peakMemoryBytes).toBe(120_000);
+    });
+
+    it('withProcessPeak should raise the peak to the process maxrss', () => {
+      const resources = diffCgroupCounters(readCgroupCounters(statsV2(0, 0)), { ...readCgroupCounters(statsV2(0, 0)), memoryBytes: 4096 });
+      const usage = { userMs: 1, systemMs: 0, maxRssKb: 32_000, wallMs: 5 };
+      expect(withProcessPeak(resources, usage).peakMemoryBytes).toBe(32_000 * 1024);
+      expect(withProcessPeak({ ...resources, peakMemoryBytes: 64_000_000 }, usage).peakMemoryBytes).toBe(64_000_000);
+      expect(withProcessPeak(resources, null)).toBe(resources);
+    });
+
+    it('sampleExecResources should diff one-shot readings and take the peak from the stream', async () => {
+      const stream = new PassThrough();
+      mockStats
+        .mockResolvedValueOnce(statsV2(10_000_000, 1000))
+        .mockResolvedValueOnce(stream)
+        .mockResolvedValueOnce(statsV2(310_000_000, 3000, { throttled: 4, read: 8192 }));
+
+      const sampler = await sampleExecResources('abc123container');
+      expect(mockStats).toHaveBeenNthCalledWith(1, { stream: false, 'one-shot': true });
+      expect(mockStats).toHaveBeenNthCalledWith(2, { stream: true });
+      await new Promise(setImmediate);
+      stream.write(JSON.stringify(statsV2(0, 64_001_000)) + '\n');
+
+      const resources = await sampler.stop();
+      expect(resources).toEqual({
+        cpuUserMs: 300, cpuSystemMs: 0, peakMemoryBytes: 64_000_000,
+        throttledPeriods: 4, throttledMs: 4, blockReadBytes: 8192, blockWriteBytes: 0,
+      });
+      expect(stream.destroyed).toBe(true);
+      // A second stop() doesn't read again
+      expect(await sampler.stop()).toBe(resources);
+      expect(mockStats).toHaveBeenCalledTimes(3);
+    });
+
+    it('sampleExecResources should give null when stats are unavailable', async () => {
+      mockStats.mockRejectedValueOnce(new Error('no such container'));
+      const sampler = await sampleExecResources('abc123container');
+      expect(await sampler.stop()).toBeNull();
+      expect(mockStats).toHaveBeenCalledTimes(1);
+    });
+  });
+
+  describe('Container events', () => {
+    const line = (action: string, id: string, extra: any = {}) => JSON.stringify({
+      Type: 'container',
+      Action: action,
+      Actor: { ID: id, Attributes: { type: 'coderunner-session', session: 's1', name: 'n', exitCode: '137' } },
+      time: 1700000000,
+      timeNano: 1700000000123456789,
+      ...extra,
+    }) + '\n';
+
+    it('parseContainerEvent should keep die/destroy events with their labels', () => {
+      expect(parseContainerEvent(line('die', 'c1'), 'local')).toEqual({
+        action: 'die', id: 'c1', labels: { type: 'coderunner-session', session: 's1' }, host: 'local', time: 1700000000123,
+      });
+      expect(parseContainerEvent(line('start', 'c1'), 'local')).toBeNull();
+      expect(parseContainerEvent(line('destroy', 'n1', { Type: 'network' }), 'local')).toBeNull();
+      expect(parseContainerEvent('{"partial', 'local')).toBeNull();
+    });
+
+    it('watchContainerEvents should filter, split lines and reconnect from the last event', async () => {
+      const flush = () => new Promise(setImmediate);
+      const eventSeconds = Math.floor(Date.now() / 1000) + 5;
+      const first = new PassThrough();
+      const second = new PassThrough();
+      mockDockerInstance.getEvents.mockResolvedValueOnce(first).mockResolvedValueOnce(second);
+      const events: any[] = [];
+
+      const watch = watchContainerEvents({ type: 'coderunner-session' }, (e) => events.push(e), 10);
+      await flush();
+      expect(mockDockerInstance.getEvents).toHaveBeenCalledWith({
+        filters: { type: ['container'], event: ['die', 'destroy'], label: ['type=coderunner-session'] },
+      });
+      expect(watch.connected()).toBe(true);
+
+      // Events split across chunks
+      const chunk = line('die', 'c1', { time: eventSeconds, timeNano: undefined }) + line('destroy', 'c1', { time: eventSeconds, timeNano: undefined });
+      first.write(chunk.slice(0, 20));
+      first.write(chunk.slice(20));
+      await flush();
+      expect(events.map(e => `${e.action}:${e.id}`)).toEqual(['die:c1', 'destroy:c1']);
+
+      first.end();
+      await flush();
+      expect(watch.connected()).toBe(false);
+      await new Promise(resolve => setTimeout(resolve, 20));
+      await flush();
+      expect(mockDockerInstance.getEvents).toHaveBeenLastCalledWith(expect.objectContaining({ since: eventSeconds }));
+      expect(watch.connected()).toBe(true);
+
+      watch.stop();
+      expect(second.destroyed).toBe(true);
+      expect(watch.connected()).toBe(false);
+    });
   });
 
   describe('Daemon operations', () => {
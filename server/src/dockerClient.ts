@@ -9,33 +9,17 @@
  * via `exec('docker ...')`, making migration straightforward.
  */
 
-import Docker from 'dockerode';
 import { logger } from './logger';
 import { Readable, PassThrough } from 'stream';
 import * as tar from 'tar-stream';
-import { execSync } from 'child_process';
+import { AgentConnection, type ResourceUsage } from './agent';
+import { dockerHosts } from './dockerHosts';
+import { clusterState, INSTANCE_LABEL } from './clusterState';
 
 /**
- * Resolve the Docker socket path from the active Docker CLI context,
- * falling back to the default `/var/run/docker.sock`.
+ * Objects live on the daemon of the host they were created on (see
+ * dockerHosts.ts); every call below goes to that daemon.
  */
-function resolveDockerSocket(): string {
-  try {
-    const host = execSync(
-      'docker context inspect --format "{{.Endpoints.docker.Host}}"',
-      { encoding: 'utf-8', timeout: 5000 },
-    ).trim();
-    if (host.startsWith('unix://')) {
-      return host.replace('unix://', '');
-    }
-  } catch {
-    // ignore – fall through to default
-  }
-  return '/var/run/docker.sock';
-}
-
-/** Singleton Docker client connected to the local daemon */
-const docker = new Docker({ socketPath: resolveDockerSocket() });
 
 // ─── Container Operations ────────────────────────────────────────────────────
 
@@ -47,8 +31,23 @@ export interface CreateContainerOptions {
   cpus: string;
   env?: string[];
   cmd?: string[];
+  /** Extra capabilities for the container's bounding set (e.g. PERFMON for profiling) */
+  capAdd?: string[];
+  /** Keep the main process's stdin open for attachAgent() */
+  openStdin?: boolean;
+  /** Docker host to create it on (default: the host of networkName, else the primary host) */
+  host?: string;
+  /**
+   * tmpfs mounts, path → mount options (e.g. `{ '/app': 'rw,exec,size=256m' }`).
+   * The archive API writes beneath them, so uploads and reads of such a container
+   * need its execution agent (see requiresAgent)
+   */
+  tmpfs?: Record<string, string>;
 }
 
+/** Containers with tmpfs mounts, whose files only their agent can reach */
+const agentOnlyContainers = new Set<string>();
+
 /**
  * Create and start a container, returning its full ID.
  * Equivalent to `docker run -d --label ... --network ... --memory ... --cpus ... <image> [cmd]`
@@ -57,31 +56,60 @@ export async function createContainer(opts: CreateContainerOptions): Promise<str
   const memoryBytes = parseMemoryString(opts.memory);
   const nanoCpus = parseCpuString(opts.cpus);
 
-  const container = await docker.createContainer({
+  const host = opts.host ?? (opts.networkName ? dockerHosts.networkHost(opts.networkName) : dockerHosts.primary());
+  const container = await dockerHosts.client(host).createContainer({
     Image: opts.image,
-    Labels: opts.labels,
+    // Every object names its creator so sibling instances leave it alone
+    Labels: { ...opts.labels, [INSTANCE_LABEL]: clusterState.instanceId },
     // For database containers (e.g., PostgreSQL), omit Cmd so the image's default
     // entrypoint starts the server. Other containers use 'tail -f /dev/null' to stay alive.
     ...(opts.cmd !== undefined ? { Cmd: opts.cmd } : {}),
     Env: opts.env,
+    ...(opts.openStdin ? { OpenStdin: true, StdinOnce: false } : {}),
     HostConfig: {
       Memory: memoryBytes,
       NanoCpus: nanoCpus,
+      ...(opts.capAdd && opts.capAdd.length > 0 ? { CapAdd: opts.capAdd } : {}),
+      ...(opts.tmpfs && Object.keys(opts.tmpfs).length > 0 ? { Tmpfs: opts.tmpfs } : {}),
       // If network is omitted, Docker puts it on the default bridge initially
       ...(opts.networkName ? { NetworkMode: opts.networkName } : {}),
     },
     WorkingDir: '/app',
   });
 
+  dockerHosts.trackContainer(container.id, host);
+  if (opts.tmpfs && Object.keys(opts.tmpfs).length > 0) agentOnlyContainers.add(container.id);
   return container.id;
 }
 
 /**
- * Start an existing container.
+ * Whether the container's files can only be uploaded and read through its
+ * execution agent: putArchive/getArchive don't see its tmpfs mounts.
+ */
+export function requiresAgent(containerId: string): boolean {
+  return agentOnlyContainers.has(containerId);
+}
+
+/**
+ * Start an existing container, optionally restoring it from a checkpoint.
+ * Equivalent to `docker start [--checkpoint <name> --checkpoint-dir <dir>] <id>`
  */
-export async function startContainer(containerId: string): Promise<void> {
-  const container = docker.getContainer(containerId);
-  await container.start();
+export async function startContainer(containerId: string, checkpoint?: { name: string; dir: string }): Promise<void> {
+  const container = dockerHosts.forContainer(containerId).getContainer(containerId);
+  if (checkpoint) {
+    await container.start({ checkpoint: checkpoint.name, 'checkpoint-dir': checkpoint.dir });
+  } else {
+    await container.start();
+  }
+}
+
+/**
+ * Checkpoint a running container with CRIU and stop it (experimental daemons only).
+ * Equivalent to `docker checkpoint create --checkpoint-dir <dir> <id> <name>`
+ */
+export async function createCheckpoint(containerId: string, name: string, dir: string): Promise<void> {
+  const container = dockerHosts.forContainer(containerId).getContainer(containerId);
+  await container.createCheckpoint({ CheckpointID: name, CheckpointDir: dir, Exit: true });
 }
 
 /**
@@ -91,14 +119,20 @@ export async function startContainer(containerId: string): Promise<void> {
 export async function execInContainer(
   containerId: string,
   command: string,
-  options: { workDir?: string; timeout?: number } = {},
-): Promise<{ stdout: string; stderr: string; exitCode: number }> {
-  const container = docker.getContainer(containerId);
+  options: { workDir?: string; timeout?: number; user?: string; env?: string[] } = {},
+): Promise<{ stdout: string; stderr: string; exitCode: number; usage?: ResourceUsage }> {
+  const agent = agentFor(containerId, options.user);
+  if (agent) return execViaAgent(agent, command, options);
+
+  const client = dockerHosts.forContainer(containerId);
+  const container = client.getContainer(containerId);
   const exec = await container.exec({
     Cmd: ['/bin/sh', '-c', command],
     AttachStdout: true,
     AttachStderr: true,
     WorkingDir: options.workDir ?? '/app',
+    ...(options.user ? { User: options.user } : {}),
+    ...(options.env ? { Env: options.env } : {}),
   });
 
   return new Promise((resolve, reject) => {
@@ -118,7 +152,7 @@ export async function execInContainer(
       const stdoutStream = new PassThrough();
       const stderrStream = new PassThrough();
 
-      docker.modem.demuxStream(stream, stdoutStream, stderrStream);
+      client.modem.demuxStream(stream, stdoutStream, stderrStream);
 
       stdoutStream.on('data', (chunk: Buffer) => stdoutChunks.push(chunk));
       stderrStream.on('data', (chunk: Buffer) => stderrChunks.push(chunk));
@@ -165,21 +199,46 @@ export async function execInContainer(
 export async function execInteractive(
   containerId: string,
   command: string,
-  options: { workDir?: string } = {},
+  options: { workDir?: string; user?: string; env?: string[] } = {},
 ): Promise<{
   stdout: PassThrough;
   stderr: PassThrough;
   stdin: NodeJS.WritableStream;
   getExitCode: () => Promise<number>;
+  /** CPU time and peak memory of the process (only known when run by the agent) */
+  getUsage: () => Promise<ResourceUsage | null>;
   kill: () => void;
+  /** Stop/start reading from the exec; a paused exec blocks on its own output */
+  pause: () => void;
+  resume: () => void;
 }> {
-  const container = docker.getContainer(containerId);
+  const agent = agentFor(containerId, options.user);
+  if (agent) {
+    const run = agent.exec(command, options);
+    agentStats.execs++;
+    return {
+      stdout: run.stdout,
+      stderr: run.stderr,
+      stdin: run.stdin,
+      getExitCode: async () => (await run.exited).exitCode,
+      getUsage: async () => (await run.exited).usage,
+      // Unlike a destroyed exec stream, this ends the program and its children
+      kill: () => run.kill(),
+      pause: run.pause,
+      resume: run.resume,
+    };
+  }
+
+  const client = dockerHosts.forContainer(containerId);
+  const container = client.getContainer(containerId);
   const exec = await container.exec({
     Cmd: ['/bin/sh', '-c', command],
     AttachStdout: true,
     AttachStderr: true,
     AttachStdin: true,
     WorkingDir: options.workDir ?? '/app',
+    ...(options.user ? { User: options.user } : {}),
+    ...(options.env ? { Env: options.env } : {}),
     Tty: false,
   });
 
@@ -191,7 +250,7 @@ export async function execInteractive(
 
       const stdoutStream = new PassThrough();
       const stderrStream = new PassThrough();
-      docker.modem.demuxStream(stream, stdoutStream, stderrStream);
+      client.modem.demuxStream(stream, stdoutStream, stderrStream);
 
       // Ensure PassThrough streams end when the raw Docker stream closes.
       // demuxStream only listens for 'end', but hijacked connections
@@ -211,6 +270,7 @@ export async function execInteractive(
           const inspectData = await exec.inspect();
           return inspectData.ExitCode ?? -1;
         },
+        getUsage: async () => null,
         kill: () => {
           try {
             stream.destroy();
@@ -218,6 +278,8 @@ export async function execInteractive(
             // Best-effort cleanup
           }
         },
+        pause: () => stream.pause(),
+        resume: () => stream.resume(),
       });
     });
   });
@@ -228,10 +290,11 @@ export async function execInteractive(
  * Equivalent to `docker rm -fv <ids...>`
  */
 export async function removeContainers(containerIds: string[]): Promise<void> {
+  containerIds.forEach(detachAgent);
   await Promise.allSettled(
     containerIds.map(async (id) => {
       try {
-        const container = docker.getContainer(id);
+        const container = dockerHosts.forContainer(id).getContainer(id);
         await container.remove({ force: true, v: true });
       } catch (err: any) {
         // Container may already be gone — ignore 404
@@ -241,26 +304,38 @@ export async function removeContainers(containerIds: string[]): Promise<void> {
       }
     }),
   );
+  containerIds.forEach(id => {
+    dockerHosts.untrackContainer(id);
+    agentOnlyContainers.delete(id);
+  });
 }
 
 /**
- * List containers matching a label filter.
+ * List containers matching a label filter on every healthy host.
  * Equivalent to `docker ps -a --filter "label=key=value" --format "{{.ID}}|{{.CreatedAt}}"`
  */
 export async function listContainers(
   labelFilter: Record<string, string>,
   all = true,
-): Promise<Array<{ id: string; created: number; labels: Record<string, string> }>> {
+): Promise<Array<{ id: string; created: number; labels: Record<string, string>; host: string }>> {
   const filters: Record<string, string[]> = {
     label: Object.entries(labelFilter).map(([k, v]) => (v ? `${k}=${v}` : k)),
   };
 
-  const containers = await docker.listContainers({ all, filters });
-  return containers.map((c) => ({
-    id: c.Id,
-    created: c.Created * 1000, // Docker returns seconds, we use ms
-    labels: c.Labels,
-  }));
+  const perHost = await onHealthyHosts(async (host) => {
+    const containers = await dockerHosts.client(host).listContainers({ all, filters });
+    return containers.map((c) => {
+      // Containers left by an earlier process are routed to where they were found
+      dockerHosts.trackContainer(c.Id, host);
+      return {
+        id: c.Id,
+        created: c.Created * 1000, // Docker returns seconds, we use ms
+        labels: c.Labels,
+        host,
+      };
+    });
+  });
+  return perHost.flat();
 }
 
 // ─── File Transfer ───────────────────────────────────────────────────────────
@@ -268,8 +343,10 @@ export async function listContainers(
 export interface FileEntry {
   /** Relative path inside the container (e.g. "main.py" or "src/app.java") */
   path: string;
-  /** UTF-8 file content */
-  content: string;
+  /** UTF-8 file content, or raw bytes (e.g. a compiled binary) */
+  content: string | Buffer;
+  /** Permission bits (defaults to 0644) */
+  mode?: number;
 }
 
 /**
@@ -280,24 +357,33 @@ export interface FileEntry {
  *   New: tar-stream → container.putArchive          (0 host I/O)
  *
  * This is the single biggest latency improvement for warm-reuse scenarios.
+ *
+ * Resolves to the size of the uploaded archive in bytes.
  */
-export async function putFiles(containerId: string, files: FileEntry[], destDir = '/app'): Promise<void> {
-  const container = docker.getContainer(containerId);
-  const archive = await createTarArchive(files);
+export async function putFiles(containerId: string, files: FileEntry[], destDir = '/app'): Promise<number> {
+  const agent = agentFor(containerId);
+  if (agent) {
+    agentStats.uploads++;
+    return agent.putFiles(destDir, files);
+  }
+  assertArchiveReachable(containerId);
+  const container = dockerHosts.forContainer(containerId).getContainer(containerId);
+  const { archive, size } = await createTarArchive(files);
   await container.putArchive(archive, { path: destDir });
+  return size;
 }
 
 /**
  * Create an in-memory tar archive from an array of file entries.
  * Uses tar-stream for zero-disk I/O streaming.
  */
-function createTarArchive(files: FileEntry[]): Promise<Readable> {
+function createTarArchive(files: FileEntry[]): Promise<{ archive: Readable; size: number }> {
   return new Promise((resolve, reject) => {
     const pack = tar.pack();
 
     for (const file of files) {
-      const content = Buffer.from(file.content, 'utf-8');
-      pack.entry({ name: file.path, size: content.length }, content);
+      const content = Buffer.isBuffer(file.content) ? file.content : Buffer.from(file.content, 'utf-8');
+      pack.entry({ name: file.path, size: content.length, mode: file.mode }, content);
     }
 
     pack.finalize();
@@ -313,12 +399,470 @@ function createTarArchive(files: FileEntry[]): Promise<Readable> {
           this.push(null);
         },
       });
-      resolve(readable);
+      resolve({ archive: readable, size: fullBuffer.length });
     });
     pack.on('error', reject);
   });
 }
 
+/**
+ * Fail instead of writing beneath (or reading from under) a tmpfs mount when
+ * the container's agent is gone.
+ */
+function assertArchiveReachable(containerId: string): void {
+  if (agentOnlyContainers.has(containerId)) {
+    throw new Error(`Container ${containerId.substring(0, 12)} has a tmpfs workspace and no execution agent`);
+  }
+}
+
+/**
+ * Read a single file out of a container via `getArchive`.
+ * Returns null if the path does not exist or is not a regular file.
+ */
+export async function readFile(containerId: string, filePath: string): Promise<Buffer | null> {
+  const agent = agentFor(containerId);
+  if (agent) return agent.readFile(filePath);
+  assertArchiveReachable(containerId);
+  const container = dockerHosts.forContainer(containerId).getContainer(containerId);
+  let archive: NodeJS.ReadableStream;
+  try {
+    archive = await container.getArchive({ path: filePath });
+  } catch (err: any) {
+    if (err.statusCode === 404) return null;
+    throw err;
+  }
+
+  return new Promise((resolve, reject) => {
+    const extract = tar.extract();
+    let result: Buffer | null = null;
+
+    extract.on('entry', (header, stream, next) => {
+      const chunks: Buffer[] = [];
+      stream.on('data', (chunk: Buffer) => chunks.push(chunk));
+      stream.on('end', () => {
+        if (result === null && header.type === 'file') {
+          result = Buffer.concat(chunks);
+        }
+        next();
+      });
+      stream.resume();
+    });
+    extract.on('finish', () => resolve(result));
+    extract.on('error', reject);
+
+    archive.pipe(extract);
+  });
+}
+
+// ─── Execution Agent ─────────────────────────────────────────────────────────
+
+/** Attached agents by container ID (see agent.ts) */
+const agents = new Map<string, AgentConnection>();
+
+/** Images whose containers didn't answer a hello; not probed again */
+const agentlessImages = new Set<string>();
+
+const agentStats = { attached: 0, failed: 0, execs: 0, uploads: 0 };
+
+/**
+ * Attach to a started container's main process and, if it is cr-agent, route
+ * its execs, uploads and reads through it from now on. Resolves false when the
+ * container has no agent; everything keeps using the Docker API then.
+ */
+export async function attachAgent(
+  containerId: string,
+  image: string,
+  helloTimeoutMs = 2000,
+  rememberFailure = true,
+): Promise<boolean> {
+  if (agents.has(containerId)) return true;
+  if (agentlessImages.has(image)) return false;
+
+  const client = dockerHosts.forContainer(containerId);
+  const container = client.getContainer(containerId);
+  const stream: any = await container.attach({ stream: true, stdin: true, stdout: true, stderr: true, hijack: true });
+
+  const agentOut = new PassThrough();
+  const agentLog = new PassThrough();
+  client.modem.demuxStream(stream, agentOut, agentLog);
+
+  const connection = new AgentConnection(
+    containerId,
+    (data) => {
+      if (!stream.destroyed) stream.write(data);
+    },
+    () => {
+      if (agents.get(containerId) === connection) agents.delete(containerId);
+      stream.destroy?.();
+    },
+  );
+  agentOut.on('data', (chunk: Buffer) => connection.receive(chunk));
+  // cr-agent and the command it supervises log to stderr
+  agentLog.on('data', (chunk: Buffer) => logger.debug('Agent', `${containerId.substring(0, 12)}: ${chunk.toString().trimEnd()}`));
+  stream.on('close', () => connection.close());
+  stream.on('error', () => connection.close());
+
+  if (!(await connection.hello(helloTimeoutMs))) {
+    connection.close();
+    if (rememberFailure) agentlessImages.add(image);
+    agentStats.failed++;
+    logger.info('Agent', `No execution agent in ${image}; using Docker exec for its containers`);
+    return false;
+  }
+
+  agents.set(containerId, connection);
+  agentStats.attached++;
+  return true;
+}
+
+/** Drop a container's agent connection (its running execs end with exit code -1) */
+export function detachAgent(containerId: string): void {
+  agents.get(containerId)?.close();
+  agents.delete(containerId);
+}
+
+export function hasAgent(containerId: string): boolean {
+  return agents.has(containerId);
+}
+
+/** Whether an earlier container of the image showed it has no agent */
+export function isAgentlessImage(image: string): boolean {
+  return agentlessImages.has(image);
+}
+
+/** The agent cannot switch users, so runs as another user go through Docker */
+function agentFor(containerId: string, user?: string): AgentConnection | undefined {
+  const agent = agents.get(containerId);
+  return agent?.isOpen && !user ? agent : undefined;
+}
+
+function execViaAgent(
+  agent: AgentConnection,
+  command: string,
+  options: { workDir?: string; timeout?: number; env?: string[] },
+): Promise<{ stdout: string; stderr: string; exitCode: number; usage?: ResourceUsage }> {
+  agentStats.execs++;
+  const run = agent.exec(command, options);
+  run.stdin.end();
+  const stdoutChunks: Buffer[] = [];
+  const stderrChunks: Buffer[] = [];
+  run.stdout.on('data', (chunk: Buffer) => stdoutChunks.push(chunk));
+  run.stderr.on('data', (chunk: Buffer) => stderrChunks.push(chunk));
+
+  return new Promise((resolve, reject) => {
+    const timeoutMs = options.timeout ?? 30_000;
+    const timer = timeoutMs > 0
+      ? setTimeout(() => {
+        run.kill();
+        reject(new Error(`Exec timed out after ${timeoutMs}ms`));
+      }, timeoutMs)
+      : undefined;
+
+    // Output is complete once both streams ended (the agent ends them after the exit frame)
+    const drained = (stream: PassThrough) => new Promise<void>(done => stream.once('end', done));
+    Promise.all([run.exited, drained(run.stdout), drained(run.stderr)]).then(([{ exitCode, usage }]) => {
+      if (timer) clearTimeout(timer);
+      resolve({
+        stdout: Buffer.concat(stdoutChunks).toString(),
+        stderr: Buffer.concat(stderrChunks).toString(),
+        exitCode,
+        ...(usage ? { usage } : {}),
+      });
+    });
+  });
+}
+
+export function getAgentStats(): { connected: number; attached: number; failed: number; execs: number; uploads: number } {
+  return { connected: agents.size, ...agentStats };
+}
+
+// ─── Exec Resource Telemetry ─────────────────────────────────────────────────
+
+/** Cgroup-level resource use of a container during one exec */
+export interface ExecResources {
+  /** CPU time in user and kernel mode (ms) */
+  cpuUserMs: number;
+  cpuSystemMs: number;
+  /** Highest memory use seen during the exec (bytes, page cache excluded) */
+  peakMemoryBytes: number;
+  /** CFS periods in which the container ran out of CPU quota, and how long it was held back (ms) */
+  throttledPeriods: number;
+  throttledMs: number;
+  /** Block device I/O (bytes) */
+  blockReadBytes: number;
+  blockWriteBytes: number;
+}
+
+/** Cumulative counters of one Docker stats reading */
+export interface CgroupCounters {
+  cpuUserNs: number;
+  cpuSystemNs: number;
+  /** Current memory use minus inactive page cache */
+  memoryBytes: number;
+  /** Lifetime peak of the container (cgroup v1 only) */
+  memoryPeakBytes?: number;
+  throttledPeriods: number;
+  throttledNs: number;
+  blockReadBytes: number;
+  blockWriteBytes: number;
+}
+
+/**
+ * Pull the cumulative counters out of a Docker stats object. Field names are the
+ * same on cgroup v1 and v2; v2 has no memory peak (see withProcessPeak) and
+ * lower-case blkio ops.
+ */
+export function readCgroupCounters(stats: any): CgroupCounters {
+  const cpu = stats?.cpu_stats ?? {};
+  const memory = stats?.memory_stats ?? {};
+  const inactiveFile = memory.stats?.total_inactive_file ?? memory.stats?.inactive_file ?? 0;
+  let blockReadBytes = 0;
+  let blockWriteBytes = 0;
+  for (const entry of stats?.blkio_stats?.io_service_bytes_recursive ?? []) {
+    const op = String(entry.op).toLowerCase();
+    if (op === 'read') blockReadBytes += entry.value;
+    else if (op === 'write') blockWriteBytes += entry.value;
+  }
+  return {
+    cpuUserNs: cpu.cpu_usage?.usage_in_usermode ?? 0,
+    cpuSystemNs: cpu.cpu_usage?.usage_in_kernelmode ?? 0,
+    memoryBytes: Math.max(0, (memory.usage ?? 0) - inactiveFile),
+    ...(memory.max_usage ? { memoryPeakBytes: memory.max_usage } : {}),
+    throttledPeriods: cpu.throttling_data?.throttled_periods ?? 0,
+    throttledNs: cpu.throttling_data?.throttled_time ?? 0,
+    blockReadBytes,
+    blockWriteBytes,
+  };
+}
+
+/**
+ * Resource use between two readings. `sampledPeakBytes` is the highest memory
+ * use streamed while the exec ran. A lifetime peak (v1) only counts when it
+ * rose during the exec, since an earlier run in the container may have set it.
+ */
+export function diffCgroupCounters(before: CgroupCounters, after: CgroupCounters, sampledPeakBytes = 0): ExecResources {
+  const delta = (a: number, b: number) => Math.max(0, a - b);
+  let peakMemoryBytes = Math.max(sampledPeakBytes, after.memoryBytes);
+  if (after.memoryPeakBytes !== undefined && after.memoryPeakBytes > (before.memoryPeakBytes ?? 0)) {
+    peakMemoryBytes = Math.max(peakMemoryBytes, after.memoryPeakBytes);
+  }
+  return {
+    cpuUserMs: Math.round(delta(after.cpuUserNs, before.cpuUserNs) / 1e6),
+    cpuSystemMs: Math.round(delta(after.cpuSystemNs, before.cpuSystemNs) / 1e6),
+    peakMemoryBytes,
+    throttledPeriods: delta(after.throttledPeriods, before.throttledPeriods),
+    throttledMs: Math.round(delta(after.throttledNs, before.throttledNs) / 1e6),
+    blockReadBytes: delta(after.blockReadBytes, before.blockReadBytes),
+    blockWriteBytes: delta(after.blockWriteBytes, before.blockWriteBytes),
+  };
+}
+
+/**
+ * Fold the exec'd process's own peak RSS (agent rusage) into the cgroup figures.
+ * cgroup v2 keeps no per-exec peak and the stats stream samples once a second,
+ * so for short runs this is the only real peak.
+ */
+export function withProcessPeak(resources: ExecResources, usage: ResourceUsage | null | undefined): ExecResources {
+  const processPeakBytes = (usage?.maxRssKb ?? 0) * 1024;
+  return processPeakBytes > resources.peakMemoryBytes ? { ...resources, peakMemoryBytes: processPeakBytes } : resources;
+}
+
+/** One stats reading without the ~1s wait for a second CPU sample (API 1.41+) */
+async function readStatsOnce(containerId: string): Promise<CgroupCounters> {
+  const container = dockerHosts.forContainer(containerId).getContainer(containerId);
+  const stats = await container.stats({ stream: false, 'one-shot': true } as any);
+  return readCgroupCounters(stats);
+}
+
+/**
+ * Start measuring a container's resource use for one exec. Takes a reading now
+ * and opens a stats stream (one sample per second, for the memory peak of longer
+ * runs) that `stop()` closes before taking the final reading. Nothing stays open
+ * between execs. `stop()` resolves to null if the figures could not be read;
+ * calling it again returns the same result.
+ * Equivalent to `docker stats --no-stream <id>` before and after the exec.
+ */
+export async function sampleExecResources(containerId: string): Promise<{ stop: () => Promise<ExecResources | null> }> {
+  let before: CgroupCounters;
+  try {
+    before = await readStatsOnce(containerId);
+  } catch (err: any) {
+    logger.debug('Docker', `Stats unavailable for ${containerId.substring(0, 12)}: ${err.message}`);
+    return { stop: async () => null };
+  }
+
+  let sampledPeakBytes = 0;
+  let stopped = false;
+  let statsStream: Readable | null = null;
+  const container = dockerHosts.forContainer(containerId).getContainer(containerId);
+  container.stats({ stream: true } as any).then((stream: any) => {
+    statsStream = stream as Readable;
+    if (stopped) {
+      statsStream.destroy();
+      return;
+    }
+    let pending = '';
+    statsStream.on('data', (chunk: Buffer) => {
+      pending += chunk.toString();
+      const lines = pending.split('\n');
+      pending = lines.pop() ?? '';
+      for (const line of lines) {
+        if (!line.trim()) continue;
+        try {
+          sampledPeakBytes = Math.max(sampledPeakBytes, readCgroupCounters(JSON.parse(line)).memoryBytes);
+        } catch {
+          // Partial or malformed sample; the final reading still counts
+        }
+      }
+    });
+    statsStream.on('error', () => { /* reported through the final reading */ });
+  }).catch(() => { /* stream is optional */ });
+
+  // Later calls get the same result
+  let result: Promise<ExecResources | null> | null = null;
+  const finish = async (): Promise<ExecResources | null> => {
+    stopped = true;
+    statsStream?.destroy();
+    try {
+      return diffCgroupCounters(before, await readStatsOnce(containerId), sampledPeakBytes);
+    } catch (err: any) {
+      logger.debug('Docker', `Stats unavailable for ${containerId.substring(0, 12)}: ${err.message}`);
+      return null;
+    }
+  };
+  return { stop: () => (result ??= finish()) };
+}
+
+// ─── Container Events ────────────────────────────────────────────────────────
+
+export interface ContainerEvent {
+  /** 'die' (main process exited) or 'destroy' (container removed) */
+  action: 'die' | 'destroy';
+  id: string;
+  labels: Record<string, string>;
+  host: string;
+  /** Unix time in ms */
+  time: number;
+}
+
+export interface ContainerEventWatch {
+  /** Whether every host's event stream is currently open */
+  connected: () => boolean;
+  stop: () => void;
+}
+
+/**
+ * Parse one line of the Docker events stream, or null if it is not a
+ * container die/destroy event.
+ */
+export function parseContainerEvent(line: string, host: string): ContainerEvent | null {
+  let event: any;
+  try {
+    event = JSON.parse(line);
+  } catch {
+    return null;
+  }
+  const action = event.Action ?? event.status;
+  if (event.Type !== 'container' || (action !== 'die' && action !== 'destroy')) return null;
+  const attributes: Record<string, string> = { ...(event.Actor?.Attributes ?? {}) };
+  // The name and the exit code are reported alongside the labels
+  delete attributes.name;
+  delete attributes.image;
+  delete attributes.exitCode;
+  return {
+    action,
+    id: event.Actor?.ID ?? event.id,
+    labels: attributes,
+    host,
+    time: event.timeNano ? Math.floor(event.timeNano / 1e6) : (event.time ?? 0) * 1000,
+  };
+}
+
+/**
+ * Follow die and destroy events of labelled containers on every host.
+ * A dropped stream is reopened after `reconnectMs` from the last event seen,
+ * so events in between are delivered (possibly twice).
+ * Equivalent to `docker events --filter type=container --filter event=die --filter event=destroy --filter label=...`
+ */
+export function watchContainerEvents(
+  labelFilter: Record<string, string>,
+  onEvent: (event: ContainerEvent) => void,
+  reconnectMs = 5000,
+): ContainerEventWatch {
+  const filters = {
+    type: ['container'],
+    event: ['die', 'destroy'],
+    label: Object.entries(labelFilter).map(([k, v]) => (v ? `${k}=${v}` : k)),
+  };
+  const open = new Map<string, Readable>();
+  const timers = new Set<NodeJS.Timeout>();
+  const hosts = dockerHosts.names();
+  let stopped = false;
+
+  const follow = (host: string, since?: number) => {
+    dockerHosts.client(host).getEvents({ filters, ...(since ? { since: Math.floor(since / 1000) } : {}) } as any)
+      .then((raw: any) => {
+        const stream = raw as Readable;
+        if (stopped) {
+          stream.destroy();
+          return;
+        }
+        open.set(host, stream);
+        let last = since ?? Date.now();
+        let pending = '';
+        stream.on('data', (chunk: Buffer) => {
+          pending += chunk.toString();
+          const lines = pending.split('\n');
+          pending = lines.pop() ?? '';
+          for (const line of lines) {
+            const event = line.trim() ? parseContainerEvent(line, host) : null;
+            if (!event) continue;
+            last = Math.max(last, event.time);
+            onEvent(event);
+          }
+        });
+        const reopen = () => {
+          if (open.get(host) !== stream) return;
+          open.delete(host);
+          stream.destroy();
+          if (stopped) return;
+          logger.warn('DockerClient', `Event stream of host ${host} closed, reconnecting`);
+          retry(host, last);
+        };
+        stream.on('end', reopen);
+        stream.on('close', reopen);
+        stream.on('error', reopen);
+      })
+      .catch((err: any) => {
+        if (stopped) return;
+        logger.warn('DockerClient', `Cannot follow events of host ${host}: ${err.message}`);
+        retry(host, since ?? Date.now());
+      });
+  };
+
+  const retry = (host: string, since: number) => {
+    const timer = setTimeout(() => {
+      timers.delete(timer);
+      follow(host, since);
+    }, reconnectMs);
+    timer.unref?.();
+    timers.add(timer);
+  };
+
+  hosts.forEach(host => follow(host));
+  return {
+    connected: () => !stopped && hosts.every(host => open.has(host)),
+    stop: () => {
+      stopped = true;
+      timers.forEach(clearTimeout);
+      timers.clear();
+      const streams = Array.from(open.values());
+      open.clear();
+      streams.forEach(stream => stream.destroy());
+    },
+  };
+}
+
 // ─── Network Operations ──────────────────────────────────────────────────────
 
 export interface CreateNetworkOptions {
@@ -326,6 +870,8 @@ export interface CreateNetworkOptions {
   driver: string;
   subnet: string;
   labels: Record<string, string>;
+  /** Docker host to create it on (default: the primary host) */
+  host?: string;
 }
 
 /**
@@ -333,16 +879,18 @@ export interface CreateNetworkOptions {
  * Equivalent to `docker network create --driver ... --subnet=... --label ... <name>`
  */
 export async function createNetwork(opts: CreateNetworkOptions): Promise<string> {
-  const network = await docker.createNetwork({
+  const host = opts.host ?? dockerHosts.primary();
+  const network = await dockerHosts.client(host).createNetwork({
     Name: opts.name,
     Driver: opts.driver,
     IPAM: {
       Driver: 'default',
       Config: [{ Subnet: opts.subnet }],
     },
-    Labels: opts.labels,
+    Labels: { ...opts.labels, [INSTANCE_LABEL]: clusterState.instanceId },
   });
 
+  dockerHosts.trackNetwork(opts.name, host);
   return network.id;
 }
 
@@ -352,7 +900,7 @@ export async function createNetwork(opts: CreateNetworkOptions): Promise<string>
  */
 export async function networkExists(name: string): Promise<boolean> {
   try {
-    const network = docker.getNetwork(name);
+    const network = dockerHosts.forNetwork(name).getNetwork(name);
     await network.inspect();
     return true;
   } catch {
@@ -368,7 +916,7 @@ export async function inspectNetwork(name: string): Promise<{
   subnet: string;
   containerCount: number;
 }> {
-  const network = docker.getNetwork(name);
+  const network = dockerHosts.forNetwork(name).getNetwork(name);
   const info = await network.inspect();
   const subnet = info.IPAM?.Config?.[0]?.Subnet ?? '';
   const containerCount = Object.keys(info.Containers ?? {}).length;
@@ -381,24 +929,58 @@ export async function inspectNetwork(name: string): Promise<{
  */
 export async function removeNetwork(name: string): Promise<void> {
   try {
-    const network = docker.getNetwork(name);
+    const network = dockerHosts.forNetwork(name).getNetwork(name);
     await network.remove();
   } catch (err: any) {
     if (err.statusCode !== 404) {
       throw err;
     }
   }
+  dockerHosts.untrackNetwork(name);
 }
 
 /**
- * List all networks matching a name prefix.
+ * List all networks matching a name prefix on every healthy host.
  * Equivalent to `docker network ls --filter name=<prefix>`
  */
 export async function listNetworks(namePrefix: string): Promise<string[]> {
-  const networks = await docker.listNetworks({
-    filters: { name: [namePrefix] },
+  const perHost = await onHealthyHosts(async (host) => {
+    const networks = await dockerHosts.client(host).listNetworks({
+      filters: { name: [namePrefix] },
+    });
+    return networks.map((n) => {
+      dockerHosts.trackNetwork(n.Name, host);
+      return n.Name;
+    });
   });
-  return networks.map((n) => n.Name);
+  return perHost.flat();
+}
+
+/**
+ * List networks matching a name prefix with their labels and creation time (ms).
+ * Equivalent to `docker network ls --filter name=<prefix> --format json`
+ */
+export async function listNetworkDetails(
+  namePrefix: string,
+): Promise<Array<{ name: string; created: number; labels: Record<string, string>; host: string }>> {
+  const perHost = await onHealthyHosts(async (host) => {
+    const networks = await dockerHosts.client(host).listNetworks({
+      filters: { name: [namePrefix] },
+    });
+    return networks.map((n) => {
+      dockerHosts.trackNetwork(n.Name, host);
+      return { name: n.Name, created: Date.parse(n.Created), labels: n.Labels ?? {}, host };
+    });
+  });
+  return perHost.flat();
+}
+
+/**
+ * Connect a container to a network on the same host.
+ * Equivalent to `docker network connect <name> <id>`
+ */
+export async function connectToNetwork(networkName: string, containerId: string): Promise<void> {
+  await dockerHosts.forNetwork(networkName).getNetwork(networkName).connect({ Container: containerId });
 }
 
 /**
@@ -406,7 +988,7 @@ export async function listNetworks(namePrefix: string): Promise<string[]> {
  */
 export async function disconnectAllFromNetwork(networkName: string): Promise<void> {
   try {
-    const network = docker.getNetwork(networkName);
+    const network = dockerHosts.forNetwork(networkName).getNetwork(networkName);
     const info = await network.inspect();
     const containerIds = Object.keys(info.Containers ?? {});
 
@@ -423,14 +1005,19 @@ export async function disconnectAllFromNetwork(networkName: string): Promise<voi
 }
 
 /**
- * Prune unused CodeRunner networks.
- * Equivalent to `docker network prune -f --filter label=type=coderunner`
+ * Prune unused CodeRunner networks carrying all the given labels.
+ * Equivalent to `docker network prune -f --filter label=type=coderunner [--filter label=...]`
  */
-export async function pruneNetworks(label: string): Promise<string[]> {
-  const result = await docker.pruneNetworks({
-    filters: { label: [label] },
+export async function pruneNetworks(...labels: string[]): Promise<string[]> {
+  const perHost = await onHealthyHosts(async (host) => {
+    const result = await dockerHosts.client(host).pruneNetworks({
+      filters: { label: labels },
+    });
+    const deleted = result.NetworksDeleted ?? [];
+    deleted.forEach(name => dockerHosts.untrackNetwork(name));
+    return deleted;
   });
-  return result.NetworksDeleted ?? [];
+  return perHost.flat();
 }
 
 /**
@@ -461,12 +1048,12 @@ export async function waitForHealthy(
 // ─── Image Operations ────────────────────────────────────────────────────────
 
 /**
- * Check if an image exists locally.
+ * Check if an image exists on a host (default: the primary host).
  * Equivalent to `docker image inspect <name>`
  */
-export async function imageExists(name: string): Promise<boolean> {
+export async function imageExists(name: string, host?: string): Promise<boolean> {
   try {
-    const image = docker.getImage(name);
+    const image = dockerHosts.client(host).getImage(name);
     await image.inspect();
     return true;
   } catch {
@@ -475,12 +1062,12 @@ export async function imageExists(name: string): Promise<boolean> {
 }
 
 /**
- * Check Docker daemon connectivity.
+ * Check connectivity of a host's daemon (default: the primary host).
  * Equivalent to `docker version`
  */
-export async function pingDaemon(): Promise<boolean> {
+export async function pingDaemon(host?: string): Promise<boolean> {
   try {
-    await docker.ping();
+    await dockerHosts.client(host).ping();
     return true;
   } catch {
     return false;
@@ -489,10 +1076,31 @@ export async function pingDaemon(): Promise<boolean> {
 
 // ─── Utility ─────────────────────────────────────────────────────────────────
 
+/**
+ * Run a per-host query on every healthy host. A host that fails is logged and
+ * left out, unless every host failed.
+ */
+async function onHealthyHosts<T>(query: (host: string) => Promise<T>): Promise<T[]> {
+  const hosts = dockerHosts.names(true);
+  const results = await Promise.allSettled(hosts.map(query));
+  const values: T[] = [];
+  let firstError: unknown = null;
+  results.forEach((result, i) => {
+    if (result.status === 'fulfilled') {
+      values.push(result.value);
+    } else {
+      firstError ??= result.reason;
+      logger.warn('DockerClient', `Query on host ${hosts[i]} failed: ${result.reason?.message ?? result.reason}`);
+    }
+  });
+  if (values.length === 0 && firstError !== null) throw firstError;
+  return values;
+}
+
 /**
  * Parse a memory string like "512m" or "1g" into bytes.
  */
-function parseMemoryString(mem: string): number {
+export function parseMemoryString(mem: string): number {
   const match = mem.match(/^(\d+)(b|k|m|g)?$/i);
   if (!match) return 512 * 1024 * 1024; // Default 512MB
 
@@ -513,6 +1121,3 @@ function parseMemoryString(mem: string): number {
 function parseCpuString(cpus: string): number {
   return Math.round(parseFloat(cpus) * 1e9);
 }
-
-/** Export the raw docker instance for edge cases */
-export { docker };
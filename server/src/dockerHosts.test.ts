@@ -0,0 +1,126 @@
+/**
+ * Tests for the Docker host registry
+ * Clients are fakes; assertions are on placement, pinning, draining and health.
+ */
+
+import type Docker from 'dockerode';
+import { DockerHostRegistry, dockerOptions, parseDockerHosts } from './dockerHosts';
+
+const specs = [
+  { name: 'a', endpoint: 'unix:///var/run/docker.sock' },
+  { name: 'b', endpoint: 'tcp://10.0.0.2:2375' },
+];
+
+function registry(ping: Record<string, jest.Mock> = {}) {
+  return new DockerHostRegistry({
+    specs,
+    healthTimeout: 50,
+    createClient: (spec) => ({ ping: ping[spec.name] ?? jest.fn().mockResolvedValue('OK') }) as unknown as Docker,
+  });
+}
+
+describe('parseDockerHosts', () => {
+  it('should parse named endpoints and default to the local daemon', () => {
+    expect(parseDockerHosts('a=unix:///var/run/docker.sock, b=https://10.0.0.2:2376')).toEqual([
+      { name: 'a', endpoint: 'unix:///var/run/docker.sock' },
+      { name: 'b', endpoint: 'https://10.0.0.2:2376' },
+    ]);
+    expect(parseDockerHosts('tcp://10.0.0.3:2375')).toEqual([{ name: 'host1', endpoint: 'tcp://10.0.0.3:2375' }]);
+    expect(parseDockerHosts('')).toEqual([{ name: 'local', endpoint: '' }]);
+  });
+
+  it('should reject duplicate names', () => {
+    expect(() => parseDockerHosts('a=/x.sock,a=/y.sock')).toThrow('Duplicate Docker host name: a');
+  });
+});
+
+describe('dockerOptions', () => {
+  it('should connect to sockets and plain TCP daemons', () => {
+    expect(dockerOptions(specs[0], '/certs')).toEqual({ socketPath: '/var/run/docker.sock' });
+    expect(dockerOptions(specs[1], '/certs')).toEqual({ protocol: 'http', host: '10.0.0.2', port: 2375 });
+  });
+
+  it('should reject unknown schemes', () => {
+    expect(() => dockerOptions({ name: 'x', endpoint: 'ssh://box' }, '/certs')).toThrow('Unsupported Docker endpoint');
+  });
+});
+
+describe('DockerHostRegistry', () => {
+  it('should place sessions on the least-loaded host and keep them there', () => {
+    const hosts = registry();
+    hosts.trackContainer('c1', 'a');
+
+    expect(hosts.placeSession('s1')).toBe('b');
+    hosts.trackContainer('c2', 'b');
+    hosts.trackContainer('c3', 'b');
+    expect(hosts.placeSession('s1')).toBe('b');
+    expect(hosts.placeSession('s2')).toBe('a');
+
+    expect(hosts.getStats().hosts.map(h => [h.name, h.sessions, h.placements])).toEqual([['a', 1, 1], ['b', 1, 1]]);
+  });
+
+  it('should route containers and networks to the host they were created on', () => {
+    const hosts = registry();
+    hosts.trackContainer('c1', 'b');
+    hosts.trackNetwork('n1', 'b');
+
+    expect(hosts.forContainer('c1')).toBe(hosts.client('b'));
+    expect(hosts.forNetwork('n1')).toBe(hosts.client('b'));
+    expect(hosts.containerHost('unknown')).toBe('a');
+
+    hosts.untrackContainer('c1');
+    expect(hosts.containerHost('c1')).toBe('a');
+  });
+
+  it('should keep sessions on a draining host but place new ones elsewhere', () => {
+    const hosts = registry();
+    expect(hosts.placeSession('s1')).toBe('a');
+
+    expect(hosts.drain('a')).toBe(true);
+    hosts.trackContainer('c1', 'b');
+    expect(hosts.placeSession('s1')).toBe('a');
+    expect(hosts.placeSession('s2')).toBe('b');
+    expect(hosts.getStats().hosts[0].state).toBe('draining');
+
+    hosts.undrain('a');
+    expect(hosts.placeSession('s3')).toBe('a');
+    expect(hosts.drain('missing')).toBe(false);
+  });
+
+  it('should move sessions off hosts that stop answering pings', async () => {
+    const ping = { a: jest.fn().mockRejectedValue(new Error('connect ECONNREFUSED')) };
+    const hosts = registry(ping);
+    expect(hosts.placeSession('s1')).toBe('a');
+
+    await hosts.checkHealth();
+    expect(hosts.getStats().hosts[0]).toMatchObject({ state: 'unhealthy', lastError: 'connect ECONNREFUSED' });
+    expect(hosts.placeSession('s1')).toBe('b');
+    expect(hosts.getStats().replacements).toBe(1);
+
+    ping.a.mockResolvedValue('OK');
+    await hosts.checkHealth();
+    expect(hosts.accepting('a')).toBe(true);
+  });
+
+  it('should treat a ping that hangs as unhealthy', async () => {
+    const hosts = registry({ b: jest.fn(() => new Promise(() => undefined)) });
+    await hosts.checkHealth();
+    expect(hosts.isHealthy('b')).toBe(false);
+    expect(hosts.getStats().hosts[1].lastError).toContain('timed out');
+  });
+
+  it('should fall back to the primary host when none accepts sessions', () => {
+    const hosts = registry();
+    hosts.drain('a');
+    hosts.drain('b');
+    expect(hosts.pickHost()).toBe('a');
+  });
+
+  it('should release a session so it can be placed again', () => {
+    const hosts = registry();
+    hosts.placeSession('s1');
+    hosts.releaseSession('s1');
+    expect(hosts.sessionHost('s1')).toBeUndefined();
+    expect(hosts.getStats().hosts[0].sessions).toBe(0);
+  });
+});
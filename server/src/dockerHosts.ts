@@ -0,0 +1,374 @@
+/**
+ * Docker Host Registry
+ *
+ * Sessions can be spread over several Docker daemons (DOCKER_HOSTS): the local
+ * socket and remote endpoints over TCP or TLS. A session is placed on the
+ * least-loaded healthy host the first time it needs a network or a container,
+ * and stays pinned there, so its containers share the session network and get
+ * reused. Every container and network is tracked by host, and dockerClient
+ * sends each Docker call to the daemon that owns the object.
+ *
+ * Hosts are pinged periodically. An unhealthy host gets no new sessions and its
+ * pinned sessions are placed again. A draining host also stops taking new
+ * sessions, but the ones on it keep running until they end, so a daemon can be
+ * taken out of rotation without interrupting anyone.
+ */
+
+import Docker from 'dockerode';
+import * as fs from 'fs';
+import * as path from 'path';
+import { execSync } from 'child_process';
+import { config } from './config';
+import { logger } from './logger';
+
+export interface DockerHostSpec {
+  name: string;
+  /** unix:///path, /path, tcp://host:port or https://host:port; empty = active CLI context */
+  endpoint: string;
+}
+
+export type DockerHostState = 'healthy' | 'unhealthy' | 'draining';
+
+interface DockerHost extends DockerHostSpec {
+  client: Docker | null; // created on first use
+  healthy: boolean;
+  draining: boolean;
+  containers: Set<string>;
+  networks: Set<string>;
+  sessions: Set<string>;
+  placements: number;
+  lastPingMs: number | null;
+  lastError: string | null;
+  lastCheckedAt: number;
+}
+
+export interface DockerHostStats {
+  name: string;
+  endpoint: string;
+  state: DockerHostState;
+  containers: number;
+  networks: number;
+  sessions: number;
+  /** Sessions placed on the host since startup */
+  placements: number;
+  lastPingMs: number | null;
+  lastError: string | null;
+  lastCheckedAt: number;
+}
+
+/**
+ * Resolve the Docker socket path from the active Docker CLI context,
+ * falling back to the default `/var/run/docker.sock`.
+ */
+function resolveDockerSocket(): string {
+  try {
+    const host = execSync(
+      'docker context inspect --format "{{.Endpoints.docker.Host}}"',
+      { encoding: 'utf-8', timeout: 5000 },
+    ).trim();
+    if (host.startsWith('unix://')) {
+      return host.replace('unix://', '');
+    }
+  } catch {
+    // ignore – fall through to default
+  }
+  return '/var/run/docker.sock';
+}
+
+/**
+ * Parse DOCKER_HOSTS ("name=endpoint,..."). Entries without a name are called
+ * host1, host2, ... An empty spec means the local daemon only.
+ */
+export function parseDockerHosts(spec: string): DockerHostSpec[] {
+  const hosts: DockerHostSpec[] = [];
+  for (const entry of spec.split(',').map(e => e.trim()).filter(Boolean)) {
+    const eq = entry.indexOf('=');
+    const name = eq > 0 ? entry.slice(0, eq).trim() : `host${hosts.length + 1}`;
+    const endpoint = eq > 0 ? entry.slice(eq + 1).trim() : entry;
+    if (hosts.some(h => h.name === name)) {
+      throw new Error(`Duplicate Docker host name: ${name}`);
+    }
+    hosts.push({ name, endpoint });
+  }
+  return hosts.length > 0 ? hosts : [{ name: 'local', endpoint: '' }];
+}
+
+/**
+ * dockerode connection options for a host. https:// endpoints use the client
+ * certificates in <certDir>/<name>/, laid out like DOCKER_CERT_PATH.
+ */
+export function dockerOptions(spec: DockerHostSpec, certDir: string): Docker.DockerOptions {
+  const { endpoint } = spec;
+  if (endpoint === '') return { socketPath: resolveDockerSocket() };
+  if (endpoint.startsWith('unix://')) return { socketPath: endpoint.slice('unix://'.length) };
+  if (endpoint.startsWith('/')) return { socketPath: endpoint };
+
+  const url = new URL(endpoint);
+  if (url.protocol === 'https:') {
+    const dir = path.join(certDir, spec.name);
+    return {
+      protocol: 'https',
+      host: url.hostname,
+      port: Number(url.port || 2376),
+      ca: fs.readFileSync(path.join(dir, 'ca.pem')),
+      cert: fs.readFileSync(path.join(dir, 'cert.pem')),
+      key: fs.readFileSync(path.join(dir, 'key.pem')),
+    };
+  }
+  if (url.protocol === 'tcp:' || url.protocol === 'http:') {
+    return { protocol: 'http', host: url.hostname, port: Number(url.port || 2375) };
+  }
+  throw new Error(`Unsupported Docker endpoint for host ${spec.name}: ${endpoint}`);
+}
+
+export interface DockerHostRegistryOptions {
+  specs?: DockerHostSpec[];
+  healthTimeout?: number;
+  createClient?: (spec: DockerHostSpec) => Docker;
+}
+
+export class DockerHostRegistry {
+  private hostList: DockerHost[] | null = null;
+  private readonly containerHosts = new Map<string, string>();
+  private readonly networkHosts = new Map<string, string>();
+  private readonly sessionHosts = new Map<string, string>();
+  private healthTimer: NodeJS.Timeout | null = null;
+  private replacements = 0;
+
+  constructor(private readonly options: DockerHostRegistryOptions = {}) {}
+
+  /** Name of the first configured host; unplaced work (standby, shared services) defaults to it */
+  primary(): string {
+    return this.hosts()[0].name;
+  }
+
+  /** All host names, optionally only those answering pings */
+  names(healthyOnly = false): string[] {
+    return this.hosts().filter(h => !healthyOnly || h.healthy).map(h => h.name);
+  }
+
+  client(name: string = this.primary()): Docker {
+    const host = this.host(name);
+    if (!host.client) {
+      host.client = this.options.createClient
+        ? this.options.createClient(host)
+        : new Docker(dockerOptions(host, config.dockerHosts.certDir));
+    }
+    return host.client;
+  }
+
+  /** Client of the daemon running the container (the primary one if unknown) */
+  forContainer(containerId: string): Docker {
+    return this.client(this.containerHost(containerId));
+  }
+
+  forNetwork(networkName: string): Docker {
+    return this.client(this.networkHost(networkName));
+  }
+
+  containerHost(containerId: string): string {
+    return this.containerHosts.get(containerId) ?? this.primary();
+  }
+
+  networkHost(networkName: string): string {
+    return this.networkHosts.get(networkName) ?? this.primary();
+  }
+
+  trackContainer(containerId: string, name: string): void {
+    this.untrackContainer(containerId);
+    this.containerHosts.set(containerId, name);
+    this.host(name).containers.add(containerId);
+  }
+
+  untrackContainer(containerId: string): void {
+    const name = this.containerHosts.get(containerId);
+    if (name === undefined) return;
+    this.containerHosts.delete(containerId);
+    this.host(name).containers.delete(containerId);
+  }
+
+  trackNetwork(networkName: string, name: string): void {
+    this.untrackNetwork(networkName);
+    this.networkHosts.set(networkName, name);
+    this.host(name).networks.add(networkName);
+  }
+
+  untrackNetwork(networkName: string): void {
+    const name = this.networkHosts.get(networkName);
+    if (name === undefined) return;
+    this.networkHosts.delete(networkName);
+    this.host(name).networks.delete(networkName);
+  }
+
+  /** Whether the host takes new sessions (healthy and not draining) */
+  accepting(name: string): boolean {
+    const host = this.hosts().find(h => h.name === name);
+    return host !== undefined && host.healthy && !host.draining;
+  }
+
+  isHealthy(name: string): boolean {
+    return this.hosts().some(h => h.name === name && h.healthy);
+  }
+
+  /**
+   * Host for new work: `preferred` when it accepts sessions, otherwise the
+   * accepting host with the fewest containers. When none accepts, the primary
+   * host is used so Docker reports the actual error.
+   */
+  pickHost(preferred?: string): string {
+    if (preferred !== undefined && this.accepting(preferred)) return preferred;
+    let best: DockerHost | null = null;
+    for (const host of this.hosts()) {
+      if (!host.healthy || host.draining) continue;
+      if (!best || host.containers.size < best.containers.size
+        || (host.containers.size === best.containers.size && host.sessions.size < best.sessions.size)) {
+        best = host;
+      }
+    }
+    return best ? best.name : this.primary();
+  }
+
+  /**
+   * Host of the session, placing it first if needed. A placed session stays on
+   * its host (also while that drains) until the host turns unhealthy.
+   */
+  placeSession(sessionId: string, preferred?: string): string {
+    const pinned = this.sessionHosts.get(sessionId);
+    if (pinned !== undefined && this.isHealthy(pinned)) return pinned;
+
+    const name = this.pickHost(preferred);
+    if (pinned !== undefined) {
+      this.host(pinned).sessions.delete(sessionId);
+      this.replacements++;
+      logger.warn('DockerHosts', `Host ${pinned} is unhealthy, moving session ${sessionId} to ${name}`);
+    }
+    this.sessionHosts.set(sessionId, name);
+    const host = this.host(name);
+    host.sessions.add(sessionId);
+    host.placements++;
+    return name;
+  }
+
+  /** Host the session is pinned to, if it was placed */
+  sessionHost(sessionId: string): string | undefined {
+    return this.sessionHosts.get(sessionId);
+  }
+
+  releaseSession(sessionId: string): void {
+    const name = this.sessionHosts.get(sessionId);
+    if (name === undefined) return;
+    this.sessionHosts.delete(sessionId);
+    this.host(name).sessions.delete(sessionId);
+  }
+
+  /** Stop placing sessions on the host; returns false for unknown hosts */
+  drain(name: string): boolean {
+    const host = this.hosts().find(h => h.name === name);
+    if (!host) return false;
+    if (!host.draining) {
+      host.draining = true;
+      logger.info('DockerHosts', `Draining host ${name} (${host.sessions.size} sessions, ${host.containers.size} containers left)`);
+    }
+    return true;
+  }
+
+  undrain(name: string): boolean {
+    const host = this.hosts().find(h => h.name === name);
+    if (!host) return false;
+    if (host.draining) {
+      host.draining = false;
+      logger.info('DockerHosts', `Host ${name} accepts sessions again`);
+    }
+    return true;
+  }
+
+  /** Ping every host and update its health */
+  async checkHealth(): Promise<void> {
+    const timeoutMs = this.options.healthTimeout ?? config.dockerHosts.healthTimeout;
+    await Promise.all(this.hosts().map(async (host) => {
+      const start = Date.now();
+      let timer: NodeJS.Timeout | undefined;
+      try {
+        await Promise.race([
+          this.client(host.name).ping(),
+          new Promise((_, reject) => {
+            timer = setTimeout(() => reject(new Error(`ping timed out after ${timeoutMs}ms`)), timeoutMs);
+          }),
+        ]);
+        if (!host.healthy) logger.info('DockerHosts', `Host ${host.name} is healthy again`);
+        host.healthy = true;
+        host.lastPingMs = Date.now() - start;
+        host.lastError = null;
+      } catch (error: any) {
+        if (host.healthy) logger.warn('DockerHosts', `Host ${host.name} is unhealthy: ${error.message}`);
+        host.healthy = false;
+        host.lastPingMs = null;
+        host.lastError = error.message;
+      } finally {
+        if (timer) clearTimeout(timer);
+        host.lastCheckedAt = Date.now();
+      }
+    }));
+  }
+
+  /** Ping the hosts periodically (call checkHealth() first for an immediate result) */
+  startHealthChecks(intervalMs: number = config.dockerHosts.healthInterval): void {
+    if (this.healthTimer) return;
+    logger.info('DockerHosts', `Scheduling on ${this.names().join(', ')}`);
+    this.healthTimer = setInterval(() => {
+      this.checkHealth().catch(e => logger.error('DockerHosts', `Health check failed: ${e}`));
+    }, intervalMs);
+  }
+
+  stopHealthChecks(): void {
+    if (this.healthTimer) {
+      clearInterval(this.healthTimer);
+      this.healthTimer = null;
+    }
+  }
+
+  getStats(): { hosts: DockerHostStats[]; replacements: number } {
+    const hosts = this.hosts().map((host): DockerHostStats => ({
+      name: host.name,
+      endpoint: host.endpoint || 'local',
+      state: host.draining ? 'draining' : host.healthy ? 'healthy' : 'unhealthy',
+      containers: host.containers.size,
+      networks: host.networks.size,
+      sessions: host.sessions.size,
+      placements: host.placements,
+      lastPingMs: host.lastPingMs,
+      lastError: host.lastError,
+      lastCheckedAt: host.lastCheckedAt,
+    }));
+    return { hosts, replacements: this.replacements };
+  }
+
+  private host(name: string): DockerHost {
+    const host = this.hosts().find(h => h.name === name);
+    if (!host) throw new Error(`Unknown Docker host: ${name}`);
+    return host;
+  }
+
+  /** Hosts are read from config on first use, so importing this module touches no daemon */
+  private hosts(): DockerHost[] {
+    if (!this.hostList) {
+      const specs = this.options.specs ?? parseDockerHosts(config.dockerHosts.hosts);
+      this.hostList = specs.map(spec => ({
+        ...spec,
+        client: null,
+        healthy: true,
+        draining: false,
+        containers: new Set(),
+        networks: new Set(),
+        sessions: new Set(),
+        placements: 0,
+        lastPingMs: null,
+        lastError: null,
+        lastCheckedAt: 0,
+      }));
+    }
+    return this.hostList;
+  }
+}
+
+export const dockerHosts = new DockerHostRegistry();
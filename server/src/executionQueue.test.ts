@@ -0,0 +1,275 @@
+/**
+ * Tests for the Execution Queue
+ * Covers priority ordering, per-language fair sharing, concurrency caps,
+ * timer-driven expiry of queued tasks and adaptive concurrency, including
+ * tasks whose wall time is spent waiting on input.
+ */
+
+import { ExecutionQueue, nextConcurrencyLimit, type AdaptiveConcurrencyOptions } from './executionQueue';
+
+/** A task the test completes by hand, recording the order tasks start in */
+function controlledTask(order: string[], label: string) {
+  let finish: () => void = () => {};
+  const task = () => new Promise<void>(resolve => {
+    order.push(label);
+    finish = resolve;
+  });
+  return { task, finish: () => finish() };
+}
+
+/** Let the queue's then/finally chain run */
+async function settle(): Promise<void> {
+  for (let i = 0; i < 5; i++) await Promise.resolve();
+}
+
+/** Run every queued task to completion, one at a time */
+async function drain(tasks: Array<{ finish: () => void }>): Promise<void> {
+  for (const t of tasks) {
+    t.finish();
+    await settle();
+  }
+}
+
+describe('ExecutionQueue', () => {
+  it('should run higher priority tasks first, FIFO within a priority', async () => {
+    const order: string[] = [];
+    const queue = new ExecutionQueue(1, 10, 60000, { fairScheduling: false });
+    const tasks = [
+      controlledTask(order, 'blocker'),
+      controlledTask(order, 'rest-1'),
+      controlledTask(order, 'rest-2'),
+      controlledTask(order, 'ws'),
+    ];
+
+    queue.enqueue(tasks[0].task, 2, 'python');
+    queue.enqueue(tasks[1].task, 1, 'python');
+    queue.enqueue(tasks[2].task, 1, 'cpp');
+    queue.enqueue(tasks[3].task, 2, 'java');
+    await drain([tasks[0], tasks[3], tasks[1], tasks[2]]);
+
+    expect(order).toEqual(['blocker', 'ws', 'rest-1', 'rest-2']);
+  });
+
+  it('should interleave languages instead of serving a burst in arrival order', async () => {
+    const order: string[] = [];
+    const queue = new ExecutionQueue(1, 10, 60000);
+    const cpp = [1, 2, 3].map(i => controlledTask(order, `cpp-${i}`));
+    const python = [1, 2, 3].map(i => controlledTask(order, `python-${i}`));
+
+    cpp.forEach(t => queue.enqueue(t.task, 1, 'cpp'));
+    python.forEach(t => queue.enqueue(t.task, 1, 'python'));
+    await drain([cpp[0], python[0], cpp[1], python[1], cpp[2], python[2]]);
+
+    expect(order).toEqual(['cpp-1', 'python-1', 'cpp-2', 'python-2', 'cpp-3', 'python-3']);
+  });
+
+  it('should not exceed per-language concurrency caps', () => {
+    const order: string[] = [];
+    const queue = new ExecutionQueue(3, 10, 60000, { languageConcurrency: { cpp: 1 } });
+
+    queue.enqueue(controlledTask(order, 'cpp-1').task, 1, 'cpp');
+    queue.enqueue(controlledTask(order, 'cpp-2').task, 1, 'cpp');
+    queue.enqueue(controlledTask(order, 'python-1').task, 1, 'python');
+
+    expect(order).toEqual(['cpp-1', 'python-1']);
+    const stats = queue.getDetailedStats();
+    expect(stats.active).toBe(2);
+    expect(stats.queuedByLanguage.cpp).toBe(1);
+  });
+
+  it('should start waiting tasks when the concurrency limit is raised', () => {
+    const order: string[] = [];
+    const queue = new ExecutionQueue(1, 10, 60000);
+    ['a', 'b', 'c'].forEach(label => queue.enqueue(controlledTask(order, label).task, 1, 'python'));
+    expect(order).toEqual(['a']);
+
+    queue.setMaxConcurrent(3);
+    expect(order).toEqual(['a', 'b', 'c']);
+    queue.setMaxConcurrent(0);
+    expect(queue.getStats().maxConcurrent).toBe(1);
+  });
+
+  it('should reject tasks once the queue is full', () => {
+    const queue = new ExecutionQueue(1, 1, 60000);
+    const order: string[] = [];
+    queue.enqueue(controlledTask(order, 'running').task);
+    queue.enqueue(controlledTask(order, 'queued').task);
+    expect(() => queue.enqueue(controlledTask(order, 'rejected').task)).toThrow('Queue full');
+  });
+
+  it('should drop lanes that have nothing queued or running', async () => {
+    const queue = new ExecutionQueue(2, 10, 60000);
+    const order: string[] = [];
+    const tasks = ['lang-a', 'lang-b'].map(label => controlledTask(order, label));
+    queue.enqueue(tasks[0].task, 1, 'lang-a');
+    queue.enqueue(tasks[1].task, 1, 'lang-b');
+    expect(Object.keys(queue.getDetailedStats().activeByLanguage)).toEqual(['lang-a', 'lang-b']);
+
+    await drain(tasks);
+    expect(queue.getDetailedStats().activeByLanguage).toEqual({});
+  });
+
+  it('should keep known languages and put others in the default lane', async () => {
+    const queue = new ExecutionQueue(2, 10, 60000, { languages: ['python'] });
+    const order: string[] = [];
+    const tasks = ['python', 'unknown'].map(label => controlledTask(order, label));
+    queue.enqueue(tasks[0].task, 1, 'python');
+    queue.enqueue(tasks[1].task, 1, 'not-a-language');
+    expect(order).toEqual(['python', 'unknown']);
+
+    await drain(tasks);
+    expect(queue.getDetailedStats().activeByLanguage).toEqual({ python: 0 });
+  });
+
+  describe('expiry', () => {
+    beforeEach(() => jest.useFakeTimers());
+    afterEach(() => jest.useRealTimers());
+
+    it('should drop a task that waits longer than the queue timeout', () => {
+      const order: string[] = [];
+      const queue = new ExecutionQueue(1, 10, 1000);
+      const onExpired = jest.fn();
+
+      queue.enqueue(controlledTask(order, 'running').task, 1, 'cpp');
+      queue.enqueue(controlledTask(order, 'waiting').task, 1, 'cpp', onExpired);
+      jest.advanceTimersByTime(1001);
+
+      expect(onExpired).toHaveBeenCalledTimes(1);
+      const stats = queue.getStats();
+      expect(stats.queued).toBe(0);
+      expect(stats.expiredTasks).toBe(1);
+      expect(stats.failedTasks).toBe(1);
+    });
+
+    it('should not expire a task once it has started', async () => {
+      const order: string[] = [];
+      const queue = new ExecutionQueue(1, 10, 1000);
+      const onExpired = jest.fn();
+      const first = controlledTask(order, 'first');
+
+      queue.enqueue(first.task, 1, 'cpp');
+      queue.enqueue(controlledTask(order, 'second').task, 1, 'cpp', onExpired);
+      first.finish();
+      await settle();
+      jest.advanceTimersByTime(5000);
+
+      expect(order).toEqual(['first', 'second']);
+      expect(onExpired).not.toHaveBeenCalled();
+    });
+  });
+
+  describe('adaptive concurrency', () => {
+    const options: AdaptiveConcurrencyOptions = {
+      min: 1,
+      max: 8,
+      intervalMs: 2000,
+      targetCpu: 85,
+      targetMemory: 90,
+      latencyRatio: 2,
+      decreaseFactor: 0.75,
+      costUnitMs: 250,
+      maxCostWeight: 8,
+    };
+    const calm = { cpu: 40, memory: 50, latencyRatio: 1, saturated: false };
+
+    it('nextConcurrencyLimit should cut on pressure and add one while saturated', () => {
+      expect(nextConcurrencyLimit(8, { ...calm, memory: 95 }, options)).toEqual({ limit: 6, reason: 'memory 95% > 90%' });
+      expect(nextConcurrencyLimit(8, { ...calm, cpu: 97 }, options)).toEqual({ limit: 6, reason: 'cpu 97% > 85%' });
+      expect(nextConcurrencyLimit(4, { ...calm, latencyRatio: 2.5, saturated: true }, options).limit).toBe(3);
+      expect(nextConcurrencyLimit(4, { ...calm, saturated: true }, options)).toEqual({
+        limit: 5, reason: 'tasks waiting at cpu 40%, memory 50%',
+      });
+      // Nothing waiting, or no room to move
+      expect(nextConcurrencyLimit(4, calm, options).reason).toBeNull();
+      expect(nextConcurrencyLimit(8, { ...calm, saturated: true }, options).reason).toBeNull();
+      expect(nextConcurrencyLimit(1, { ...calm, cpu: 99 }, options).reason).toBeNull();
+      // Too few completions to judge latency
+      expect(nextConcurrencyLimit(4, { ...calm, latencyRatio: null }, options).reason).toBeNull();
+    });
+
+    it('should count running tasks by their learned cost weight', async () => {
+      const queue = new ExecutionQueue(4, 50, 60000, { adaptive: options, languages: ['python', 'cpp'] });
+      // Quick python runs bring its estimate from the 1000ms default to one unit
+      for (let i = 0; i < 12; i++) queue.enqueue(async () => {}, 1, 'python');
+      for (let i = 0; i < 30; i++) await settle();
+      expect(queue.getStats().completedTasks).toBe(12);
+
+      const order: string[] = [];
+      const python = [1, 2, 3, 4, 5].map(i => controlledTask(order, `python-${i}`));
+      python.forEach(t => queue.enqueue(t.task, 1, 'python'));
+      expect(order).toEqual(['python-1', 'python-2', 'python-3', 'python-4']);
+
+      // Not measured yet, so cpp costs 1000ms / 250ms = 4 units. It is next by
+      // fair share and waits for room; python-5 doesn't get past it
+      queue.enqueue(controlledTask(order, 'cpp-1').task, 1, 'cpp');
+      python[0].finish();
+      await settle();
+      expect(order).toHaveLength(4);
+      await drain(python.slice(1, 4));
+      expect(order).toEqual(['python-1', 'python-2', 'python-3', 'python-4', 'cpp-1']);
+
+      const stats = queue.getDetailedStats();
+      expect(stats.adaptiveConcurrency).toMatchObject({
+        enabled: true, limit: 4, activeCost: 4, costWeightByLanguage: { python: 1, cpp: 4 },
+      });
+    });
+
+    it('should record each adjustment with its reason', () => {
+      const queue = new ExecutionQueue(2, 50, 60000, { adaptive: options });
+      const order: string[] = [];
+      ['a', 'b', 'c'].forEach(label => queue.enqueue(controlledTask(order, label).task, 1, 'python'));
+      expect(order).toEqual(['a']);
+
+      queue.adjustConcurrency({ cpu: 30, memory: 40 }, 1000);
+      expect(order).toEqual(['a']);
+      queue.adjustConcurrency({ cpu: 30, memory: 40 }, 2000);
+      queue.adjustConcurrency({ cpu: 95, memory: 40 }, 3000);
+
+      const { adaptiveConcurrency } = queue.getDetailedStats();
+      expect(adaptiveConcurrency.limit).toBe(3);
+      expect((adaptiveConcurrency as any).adjustments).toEqual([
+        { time: 1000, from: 2, to: 3, reason: 'tasks waiting at cpu 30%, memory 40%' },
+        { time: 2000, from: 3, to: 4, reason: 'tasks waiting at cpu 30%, memory 40%' },
+        { time: 3000, from: 4, to: 3, reason: 'cpu 95% > 85%' },
+      ]);
+      expect(queue.getStats().concurrencyLimit).toBe(3);
+    });
+
+    describe('input-bound tasks', () => {
+      beforeEach(() => jest.useFakeTimers());
+      afterEach(() => jest.useRealTimers());
+
+      it('should learn cost from the reported service time and skip their latency', async () => {
+        const queue = new ExecutionQueue(4, 50, 60000, { adaptive: options, languages: ['python'] });
+        for (let i = 0; i < 12; i++) queue.enqueue(async () => {}, 1, 'python');
+        for (let i = 0; i < 30; i++) await settle();
+        queue.adjustConcurrency({ cpu: 30, memory: 40 }, 1000);
+
+        // Sessions that sit on input() for 30s each, using 100ms of CPU
+        for (let i = 0; i < 4; i++) {
+          queue.enqueue(() => new Promise(resolve => {
+            setTimeout(() => resolve({ serviceMs: 100, interactive: true }), 30000);
+          }), 2, 'python');
+        }
+        jest.advanceTimersByTime(30000);
+        for (let i = 0; i < 30; i++) await settle();
+        expect(queue.getStats().completedTasks).toBe(16);
+
+        queue.adjustConcurrency({ cpu: 30, memory: 40 }, 2000);
+        const stats = queue.getDetailedStats();
+        expect(stats.serviceTimeByLanguage.python).toBeLessThan(options.costUnitMs);
+        expect(stats.adaptiveConcurrency).toMatchObject({
+          costWeightByLanguage: { python: 1 },
+          lastSignals: { latencyRatio: null },
+        });
+      });
+    });
+
+    it('should scale its bounds with the cluster share', () => {
+      const queue = new ExecutionQueue(8, 50, 60000, { adaptive: options });
+      queue.setMaxConcurrent(4);
+      const { adaptiveConcurrency } = queue.getDetailedStats();
+      expect(adaptiveConcurrency).toMatchObject({ limit: 4, min: 1, max: 4 });
+    });
+  });
+});
@@ -0,0 +1,641 @@
+/**
+ * Execution Queue
+ *
+ * Bounds concurrent 'run' requests to maxConcurrentSessions. Files within a
+ * single request execute sequentially to support dependencies (e.g., server→client).
+ *
+ * Waiting tasks sit in one binary heap per language (priority desc, then FIFO),
+ * so enqueue and dispatch are O(log n). Each task has its own expiry timer that
+ * removes it from its heap when queueTimeout passes.
+ *
+ * Dispatch order:
+ *   1. Higher priority first, across all languages (WebSocket = 2, REST = 1)
+ *   2. Among equal priorities, the language with the least virtual time. Every
+ *      dispatch advances its language's virtual time by that language's observed
+ *      service time (EWMA), so slow compiles get fewer slots per second than quick
+ *      runs and each language ends up with a comparable share of slot-time.
+ *   3. Optional per-language concurrency caps (LANGUAGE_CONCURRENCY) are never exceeded
+ *
+ * Adaptive concurrency (ADAPTIVE_CONCURRENCY): running tasks are counted in cost
+ * units instead of one slot each. A language's weight is its service time EWMA
+ * in units of costUnitMs (at least 1), so a cpp compile holds more of the limit
+ * than a python one-liner. Every interval the limit moves AIMD-style between its
+ * bounds: cut by decreaseFactor when host CPU, host memory or run latency
+ * (against each language's long-term baseline) is over target, raised by one
+ * when tasks had to wait and nothing was. The last adjustments and their reasons
+ * are kept for getDetailedStats().
+ *
+ * A task may resolve to a TaskReport. Its serviceMs replaces the task's wall time
+ * as the service time sample, so time spent idle (e.g. a program waiting on
+ * input()) doesn't count as load. Interactive tasks never feed the latency
+ * signal, and an interactive task without a serviceMs teaches nothing.
+ */
+
+import { logger } from './logger';
+import { RingBuffer } from './ringBuffer';
+
+/** Service time assumed for a language before any of its tasks have finished */
+const DEFAULT_SERVICE_ESTIMATE_MS = 1000;
+
+/** Weight of the newest sample in the per-language service time EWMA */
+const SERVICE_EWMA_ALPHA = 0.2;
+
+/** Lane used for tasks enqueued without a language */
+const DEFAULT_LANE = 'default';
+
+/** Weight of the newest sample in the per-language latency baseline (slow on purpose) */
+const BASELINE_EWMA_ALPHA = 0.02;
+
+/** Completions an interval needs before its latency counts as a signal */
+const MIN_LATENCY_SAMPLES = 3;
+
+/** Adjustments kept for getDetailedStats() */
+const ADJUSTMENT_HISTORY = 20;
+
+/** What a finished task reports about the load it caused */
+export interface TaskReport {
+  /** Time the task kept the host busy, in ms (default: its wall time) */
+  serviceMs?: number;
+  /** The task's duration depended on user input, so it says nothing about latency */
+  interactive?: boolean;
+}
+
+export type QueueTask = () => Promise<void | TaskReport>;
+
+interface QueuedTask {
+  task: QueueTask;
+  priority: number;
+  timestamp: number;
+  language?: string;
+  /** Enqueue order, breaks priority ties */
+  seq: number;
+  /** Position in the lane heap, -1 once removed */
+  heapIndex: number;
+  expiryTimer: ReturnType<typeof setTimeout> | null;
+  onExpired?: () => void;
+}
+
+/**
+ * Binary heap of queued tasks that tracks each task's index, so an expired task
+ * can be removed from the middle in O(log n).
+ */
+class TaskHeap {
+  private items: QueuedTask[] = [];
+
+  get size(): number {
+    return this.items.length;
+  }
+
+  peek(): QueuedTask | undefined {
+    return this.items[0];
+  }
+
+  push(item: QueuedTask): void {
+    item.heapIndex = this.items.length;
+    this.items.push(item);
+    this.siftUp(item.heapIndex);
+  }
+
+  pop(): QueuedTask | undefined {
+    const top = this.items[0];
+    if (top) this.remove(top);
+    return top;
+  }
+
+  remove(item: QueuedTask): boolean {
+    const index = item.heapIndex;
+    if (index < 0 || this.items[index] !== item) return false;
+
+    const last = this.items.pop()!;
+    item.heapIndex = -1;
+    if (last !== item) {
+      this.items[index] = last;
+      last.heapIndex = index;
+      this.siftDown(index);
+      this.siftUp(last.heapIndex);
+    }
+    return true;
+  }
+
+  private before(a: QueuedTask, b: QueuedTask): boolean {
+    return a.priority !== b.priority ? a.priority > b.priority : a.seq < b.seq;
+  }
+
+  private swap(i: number, j: number): void {
+    const a = this.items[i];
+    const b = this.items[j];
+    this.items[i] = b;
+    this.items[j] = a;
+    a.heapIndex = j;
+    b.heapIndex = i;
+  }
+
+  private siftUp(index: number): void {
+    while (index > 0) {
+      const parent = (index - 1) >>> 1;
+      if (!this.before(this.items[index], this.items[parent])) break;
+      this.swap(index, parent);
+      index = parent;
+    }
+  }
+
+  private siftDown(index: number): void {
+    const n = this.items.length;
+    for (;;) {
+      const left = 2 * index + 1;
+      const right = left + 1;
+      let first = index;
+      if (left < n && this.before(this.items[left], this.items[first])) first = left;
+      if (right < n && this.before(this.items[right], this.items[first])) first = right;
+      if (first === index) break;
+      this.swap(index, first);
+      index = first;
+    }
+  }
+}
+
+interface LanguageLane {
+  language: string;
+  heap: TaskHeap;
+  active: number;
+  /** Accumulated service time handed out, in ms (fair-share clock) */
+  virtualTime: number;
+  /** EWMA of completed task durations, in ms */
+  serviceEstimateMs: number;
+  /** Slow EWMA of task durations, the lane's latency under normal load (0 = no sample yet) */
+  baselineMs: number;
+}
+
+/** Host load in percent, as sampled by adminMetrics */
+export interface HostLoad {
+  cpu: number;
+  memory: number;
+}
+
+export interface AdaptiveConcurrencyOptions {
+  /** Bounds of the limit, in cost units */
+  min: number;
+  max: number;
+  /** How often the limit is adjusted (ms) */
+  intervalMs: number;
+  /** Decrease above these host CPU / memory percentages */
+  targetCpu: number;
+  targetMemory: number;
+  /** Decrease when runs take this many times their language's baseline */
+  latencyRatio: number;
+  /** Multiplier applied to the limit on a decrease */
+  decreaseFactor: number;
+  /** Run duration that costs one unit; longer runs cost proportionally more */
+  costUnitMs: number;
+  /** Upper bound of a language's weight */
+  maxCostWeight: number;
+}
+
+/** Signals of one adjustment interval */
+export interface ConcurrencySignals extends HostLoad {
+  /** Mean run time / language baseline, null with too few completions */
+  latencyRatio: number | null;
+  /** Whether a queued task waited for the limit during the interval */
+  saturated: boolean;
+}
+
+export interface ConcurrencyAdjustment {
+  time: number;
+  from: number;
+  to: number;
+  reason: string;
+}
+
+/**
+ * One AIMD step. Over-target memory, CPU or latency (checked in that order)
+ * cuts the limit multiplicatively; a saturated interval with no pressure adds
+ * one unit. `reason` is null when the limit stays.
+ */
+export function nextConcurrencyLimit(
+  limit: number,
+  signals: ConcurrencySignals,
+  options: Pick<AdaptiveConcurrencyOptions, 'min' | 'max' | 'targetCpu' | 'targetMemory' | 'latencyRatio' | 'decreaseFactor'>,
+): { limit: number; reason: string | null } {
+  const { min, max } = options;
+  if (limit > max) return { limit: max, reason: `above the maximum of ${max}` };
+  if (limit < min) return { limit: min, reason: `below the minimum of ${min}` };
+
+  let pressure: string | null = null;
+  if (signals.memory > options.targetMemory) {
+    pressure = `memory ${signals.memory}% > ${options.targetMemory}%`;
+  } else if (signals.cpu > options.targetCpu) {
+    pressure = `cpu ${signals.cpu}% > ${options.targetCpu}%`;
+  } else if (signals.latencyRatio !== null && signals.latencyRatio > options.latencyRatio) {
+    pressure = `latency ${signals.latencyRatio.toFixed(2)}x baseline > ${options.latencyRatio}x`;
+  }
+
+  if (pressure) {
+    const decreased = Math.max(min, Math.floor(limit * options.decreaseFactor));
+    return decreased < limit ? { limit: decreased, reason: pressure } : { limit, reason: null };
+  }
+  if (signals.saturated && limit < max) {
+    return { limit: limit + 1, reason: `tasks waiting at cpu ${signals.cpu}%, memory ${signals.memory}%` };
+  }
+  return { limit, reason: null };
+}
+
+export interface ExecutionQueueOptions {
+  /** Weighted fair sharing across languages (default: true) */
+  fairScheduling?: boolean;
+  /** Max concurrently running tasks per language; missing = no cap beyond maxConcurrent */
+  languageConcurrency?: Record<string, number>;
+  /**
+   * Languages whose lanes (and learned service times) are kept while idle. Tasks
+   * of other languages share the default lane. Without it every language gets a
+   * lane, dropped again once it has nothing queued or running.
+   */
+  languages?: string[];
+  /** Adjust the limit from host load and latency (see startAdaptiveConcurrency) */
+  adaptive?: AdaptiveConcurrencyOptions;
+}
+
+export class ExecutionQueue {
+  private lanes = new Map<string, LanguageLane>();
+  private queuedCount: number = 0;
+  private activeCount: number = 0;
+  private maxConcurrent: number;
+  private completedTasks: number = 0;
+  private failedTasks: number = 0;
+  private expiredTasks: number = 0;
+  private taskTimes: number[] = [];
+  private maxTaskTimeHistory: number = 100;
+  private maxQueueSize: number;
+  private queueTimeout: number;
+  private fairScheduling: boolean;
+  private languageConcurrency: Record<string, number>;
+  private knownLanguages: Set<string> | null;
+  private nextSeq: number = 0;
+  /** Virtual time of the most recent dispatch; lanes waking from idle start here */
+  private virtualClock: number = 0;
+
+  // Adaptive concurrency: the limit is in cost units while it is enabled
+  private adaptive: AdaptiveConcurrencyOptions | null;
+  private readonly initialMaxConcurrent: number;
+  private limit: number;
+  private activeCost: number = 0;
+  private saturated: boolean = false;
+  private latencyRatioSum: number = 0;
+  private latencySamples: number = 0;
+  private lastSignals: ConcurrencySignals | null = null;
+  private adjustments = new RingBuffer<ConcurrencyAdjustment>(ADJUSTMENT_HISTORY);
+  private adaptiveTimer: NodeJS.Timeout | null = null;
+
+  constructor(maxConcurrent: number, maxQueueSize?: number, queueTimeout?: number, options: ExecutionQueueOptions = {}) {
+    this.maxConcurrent = maxConcurrent;
+    this.maxQueueSize = maxQueueSize || parseInt(process.env.MAX_QUEUE_SIZE || '200', 10);
+    this.queueTimeout = queueTimeout || parseInt(process.env.QUEUE_TIMEOUT || '60000', 10);
+    this.fairScheduling = options.fairScheduling ?? true;
+    this.languageConcurrency = options.languageConcurrency ?? {};
+    this.knownLanguages = options.languages ? new Set(options.languages) : null;
+    this.adaptive = options.adaptive ?? null;
+    this.initialMaxConcurrent = Math.max(1, maxConcurrent);
+    this.limit = this.adaptive ? this.clampToBounds(maxConcurrent) : maxConcurrent;
+  }
+
+  /**
+   * Change the concurrency limit; running tasks above a lowered limit finish
+   * normally. Used to split MAX_CONCURRENT_SESSIONS between cluster instances.
+   * With adaptive concurrency its bounds are scaled by the same share.
+   */
+  setMaxConcurrent(maxConcurrent: number): void {
+    this.maxConcurrent = Math.max(1, maxConcurrent);
+    this.limit = this.adaptive ? this.clampToBounds(this.limit) : this.maxConcurrent;
+    this.processQueue();
+  }
+
+  /**
+   * Adjust the concurrency limit every intervalMs from the sampled host load.
+   * No-op unless the queue was created with adaptive options.
+   */
+  startAdaptiveConcurrency(load: () => HostLoad): void {
+    if (!this.adaptive || this.adaptiveTimer) return;
+    this.adaptiveTimer = setInterval(() => this.adjustConcurrency(load()), this.adaptive.intervalMs);
+    this.adaptiveTimer.unref?.();
+  }
+
+  stopAdaptiveConcurrency(): void {
+    if (this.adaptiveTimer) clearInterval(this.adaptiveTimer);
+    this.adaptiveTimer = null;
+  }
+
+  /**
+   * Take one AIMD step with the host load and the latency and saturation seen
+   * since the previous step.
+   */
+  adjustConcurrency(load: HostLoad, now: number = Date.now()): void {
+    if (!this.adaptive) return;
+    const signals: ConcurrencySignals = {
+      cpu: load.cpu,
+      memory: load.memory,
+      latencyRatio: this.latencySamples >= MIN_LATENCY_SAMPLES
+        ? this.latencyRatioSum / this.latencySamples
+        : null,
+      // A task still waiting counts too: nothing may have finished all interval
+      saturated: this.saturated || this.blockedByLimit(),
+    };
+    this.saturated = false;
+    this.latencyRatioSum = 0;
+    this.latencySamples = 0;
+    this.lastSignals = signals;
+
+    const next = nextConcurrencyLimit(this.limit, signals, { ...this.adaptive, ...this.bounds() });
+    if (!next.reason) return;
+
+    const adjustment = { time: now, from: this.limit, to: next.limit, reason: next.reason };
+    this.adjustments.push(adjustment);
+    const message = `Concurrency limit ${adjustment.from} → ${adjustment.to}: ${adjustment.reason}`;
+    if (next.limit < this.limit) {
+      logger.info('ExecutionQueue', message);
+    } else {
+      logger.debug('ExecutionQueue', message);
+    }
+    this.limit = next.limit;
+    this.processQueue();
+  }
+
+  /** Whether the next task to dispatch is held back by the limit (not by a language cap) */
+  private blockedByLimit(): boolean {
+    const lane = this.selectLane();
+    return lane !== null && this.exceedsLimit(this.costWeight(lane));
+  }
+
+  /** Whether starting a task of this weight would go over the limit */
+  private exceedsLimit(weight: number): boolean {
+    // Tolerance for the float sum of fractional weights
+    return this.activeCount > 0 && this.activeCost + weight > this.limit + 1e-9;
+  }
+
+  /** Adaptive bounds, scaled by this instance's share of the configured maximum */
+  private bounds(): { min: number; max: number } {
+    const { min, max } = this.adaptive!;
+    const scaledMax = Math.max(1, Math.round((max * this.maxConcurrent) / this.initialMaxConcurrent));
+    return { min: Math.min(min, scaledMax), max: scaledMax };
+  }
+
+  private clampToBounds(limit: number): number {
+    const { min, max } = this.bounds();
+    return Math.min(max, Math.max(min, limit));
+  }
+
+  /**
+   * Slots a task of the language holds: its service time in cost units with
+   * adaptive concurrency, else one.
+   */
+  private costWeight(lane: LanguageLane): number {
+    if (!this.adaptive) return 1;
+    const { costUnitMs, maxCostWeight } = this.adaptive;
+    return Math.min(maxCostWeight, Math.max(1, lane.serviceEstimateMs / costUnitMs));
+  }
+
+  /**
+   * Queue a task. `onExpired` is called if the task is dropped after waiting
+   * longer than queueTimeout, so the caller can fail the request.
+   */
+  enqueue(task: QueueTask, priority: number = 0, language?: string, onExpired?: () => void): void {
+    // Check queue size limit
+    if (this.queuedCount >= this.maxQueueSize) {
+      throw new Error(`Queue full: ${this.queuedCount} tasks queued (max: ${this.maxQueueSize})`);
+    }
+
+    const queuedTask: QueuedTask = {
+      task,
+      priority,
+      timestamp: Date.now(),
+      language,
+      seq: this.nextSeq++,
+      heapIndex: -1,
+      expiryTimer: null,
+      onExpired,
+    };
+
+    const lane = this.getLane(this.laneName(language));
+    if (lane.heap.size === 0 && lane.active === 0) {
+      // An idle language doesn't bank credit: it rejoins at the current clock
+      lane.virtualTime = Math.max(lane.virtualTime, this.virtualClock);
+    }
+    lane.heap.push(queuedTask);
+    this.queuedCount++;
+
+    queuedTask.expiryTimer = setTimeout(() => this.expire(lane, queuedTask), this.queueTimeout);
+    queuedTask.expiryTimer.unref?.();
+
+    this.processQueue();
+  }
+
+  private laneName(language: string | undefined): string {
+    if (language === undefined) return DEFAULT_LANE;
+    return this.knownLanguages && !this.knownLanguages.has(language) ? DEFAULT_LANE : language;
+  }
+
+  private getLane(language: string): LanguageLane {
+    let lane = this.lanes.get(language);
+    if (!lane) {
+      lane = {
+        language,
+        heap: new TaskHeap(),
+        active: 0,
+        virtualTime: this.virtualClock,
+        serviceEstimateMs: DEFAULT_SERVICE_ESTIMATE_MS,
+        baselineMs: 0,
+      };
+      this.lanes.set(language, lane);
+    }
+    return lane;
+  }
+
+  /**
+   * Drop a lane that has nothing queued or running, unless it belongs to a known
+   * language. A language that comes back starts at the current virtual clock, as
+   * an idle lane would.
+   */
+  private releaseLane(lane: LanguageLane): void {
+    if (lane.heap.size > 0 || lane.active > 0) return;
+    if (lane.language === DEFAULT_LANE || this.knownLanguages?.has(lane.language)) return;
+    this.lanes.delete(lane.language);
+  }
+
+  private expire(lane: LanguageLane, queuedTask: QueuedTask): void {
+    queuedTask.expiryTimer = null;
+    if (!lane.heap.remove(queuedTask)) return;
+
+    this.queuedCount--;
+    this.expiredTasks++;
+    this.failedTasks++;
+    logger.warn('ExecutionQueue', `Task timed out after ${this.queueTimeout}ms in queue (${lane.language})`);
+    this.releaseLane(lane);
+    try {
+      queuedTask.onExpired?.();
+    } catch (error: any) {
+      logger.error('ExecutionQueue', `Expiry handler error: ${error?.message || error}`);
+    }
+  }
+
+  /**
+   * Lane whose head task should run next, or null when nothing is eligible.
+   */
+  private selectLane(): LanguageLane | null {
+    let best: LanguageLane | null = null;
+    let bestHead: QueuedTask | undefined;
+
+    for (const lane of this.lanes.values()) {
+      const head = lane.heap.peek();
+      if (!head) continue;
+      const cap = this.languageConcurrency[lane.language];
+      if (cap > 0 && lane.active >= cap) continue;
+
+      if (!best || !bestHead) {
+        best = lane;
+        bestHead = head;
+        continue;
+      }
+      if (head.priority !== bestHead.priority) {
+        if (head.priority > bestHead.priority) {
+          best = lane;
+          bestHead = head;
+        }
+        continue;
+      }
+      const earlier = this.fairScheduling && lane.virtualTime !== best.virtualTime
+        ? lane.virtualTime < best.virtualTime
+        : head.seq < bestHead.seq;
+      if (earlier) {
+        best = lane;
+        bestHead = head;
+      }
+    }
+    return best;
+  }
+
+  private processQueue(): void {
+    // Process tasks without blocking - key fix for concurrency
+    for (;;) {
+      const lane = this.selectLane();
+      if (!lane) break;
+      // The chosen task waits for room rather than letting lighter ones pass it,
+      // so heavy languages aren't starved. An idle queue always runs one task.
+      const weight = this.costWeight(lane);
+      if (this.exceedsLimit(weight)) {
+        this.saturated = true;
+        break;
+      }
+      const queuedTask = lane.heap.pop()!;
+      if (queuedTask.expiryTimer) {
+        clearTimeout(queuedTask.expiryTimer);
+        queuedTask.expiryTimer = null;
+      }
+
+      this.queuedCount--;
+      this.activeCount++;
+      this.activeCost += weight;
+      lane.active++;
+      this.virtualClock = lane.virtualTime;
+      lane.virtualTime += lane.serviceEstimateMs;
+      const startTime = Date.now();
+
+      // Execute task asynchronously WITHOUT await - this enables true parallelism
+      queuedTask.task()
+        .then((report) => {
+          const taskTime = Date.now() - startTime;
+          this.taskTimes.push(taskTime);
+          if (this.taskTimes.length > this.maxTaskTimeHistory) {
+            this.taskTimes.shift();
+          }
+          this.learn(lane, taskTime, report || {});
+          this.completedTasks++;
+        })
+        .catch((error) => {
+          logger.error('ExecutionQueue', `Task error: ${error?.message || error}`);
+          this.failedTasks++;
+        })
+        .finally(() => {
+          this.activeCount--;
+          this.activeCost = this.activeCount > 0 ? this.activeCost - weight : 0;
+          lane.active--;
+          this.releaseLane(lane);
+          // Continue processing remaining tasks
+          if (this.queuedCount > 0) {
+            this.processQueue();
+          }
+        });
+    }
+  }
+
+  /** Update a lane's service time and latency baseline from a finished task */
+  private learn(lane: LanguageLane, taskTime: number, report: TaskReport): void {
+    const serviceMs = report.serviceMs ?? (report.interactive ? null : taskTime);
+    if (serviceMs !== null) {
+      lane.serviceEstimateMs += SERVICE_EWMA_ALPHA * (serviceMs - lane.serviceEstimateMs);
+    }
+    if (report.interactive) return;
+    if (lane.baselineMs > 0) {
+      this.latencyRatioSum += taskTime / lane.baselineMs;
+      this.latencySamples++;
+      lane.baselineMs += BASELINE_EWMA_ALPHA * (taskTime - lane.baselineMs);
+    } else {
+      lane.baselineMs = Math.max(1, taskTime);
+    }
+  }
+
+  getStats() {
+    const averageTaskTime = this.taskTimes.length > 0
+      ? this.taskTimes.reduce((a, b) => a + b, 0) / this.taskTimes.length
+      : 0;
+
+    return {
+      queued: this.queuedCount,
+      active: this.activeCount,
+      maxConcurrent: this.maxConcurrent,
+      concurrencyLimit: this.limit,
+      completedTasks: this.completedTasks,
+      failedTasks: this.failedTasks,
+      expiredTasks: this.expiredTasks,
+      averageTaskTime: Math.round(averageTaskTime),
+      maxQueueSize: this.maxQueueSize,
+    };
+  }
+
+  getDetailedStats() {
+    const stats = this.getStats();
+    const queuedByLanguage: { [key: string]: number } = {};
+    const activeByLanguage: { [key: string]: number } = {};
+    const serviceTimeByLanguage: { [key: string]: number } = {};
+    const costWeightByLanguage: { [key: string]: number } = {};
+
+    for (const lane of this.lanes.values()) {
+      if (lane.language === DEFAULT_LANE) continue;
+      queuedByLanguage[lane.language] = lane.heap.size;
+      activeByLanguage[lane.language] = lane.active;
+      serviceTimeByLanguage[lane.language] = Math.round(lane.serviceEstimateMs);
+      costWeightByLanguage[lane.language] = Math.round(this.costWeight(lane) * 100) / 100;
+    }
+
+    return {
+      ...stats,
+      queuedByLanguage,
+      activeByLanguage,
+      serviceTimeByLanguage,
+      fairScheduling: this.fairScheduling,
+      languageConcurrency: this.languageConcurrency,
+      queueUtilization: this.limit > 0
+        ? Math.round((this.activeCost / this.limit) * 100)
+        : 0,
+      adaptiveConcurrency: this.adaptive
+        ? {
+          enabled: true,
+          limit: this.limit,
+          ...this.bounds(),
+          activeCost: Math.round(this.activeCost * 100) / 100,
+          costWeightByLanguage,
+          lastSignals: this.lastSignals,
+          // Newest last
+          adjustments: this.adjustments.toArray(),
+        }
+        : { enabled: false, limit: this.limit },
+    };
+  }
+}
@@ -0,0 +1,152 @@
+/**
+ * Tests for delta file sync
+ * Uses the real pool bookkeeping with a mocked Docker layer.
+ */
+
+jest.mock('./dockerClient', () => ({
+  putFiles: jest.fn(),
+  execInContainer: jest.fn(),
+}));
+
+jest.mock('./pool', () => ({
+  sessionPool: {
+    getSyncedFiles: jest.fn(),
+    recordSyncedFiles: jest.fn(),
+  },
+}));
+
+import { createHash } from 'crypto';
+import { hashFileEntry, parseChecksums, planFileSync, syncFiles } from './fileSync';
+import * as dockerClient from './dockerClient';
+import { sessionPool } from './pool';
+
+const sha256 = (content: string) => createHash('sha256').update(content).digest('hex');
+
+describe('planFileSync', () => {
+  const a = { path: 'main.cpp', content: 'int main() {}' };
+  const b = { path: 'util.h', content: '#pragma once' };
+
+  it('should upload everything without a previous record', () => {
+    const plan = planFileSync(null, [a, b]);
+    expect(plan.upload).toEqual([a, b]);
+    expect(plan.remove).toEqual([]);
+    expect(plan.hashes.get('main.cpp')).toBe(hashFileEntry(a));
+  });
+
+  it('should upload only changed files and remove deleted ones', () => {
+    const previous = planFileSync(null, [a, b]).hashes;
+    const changed = { path: 'main.cpp', content: 'int main() { return 1; }' };
+    const added = { path: 'extra.cpp', content: '' };
+
+    const plan = planFileSync(previous, [changed, added]);
+    expect(plan.upload.map(f => f.path)).toEqual(['main.cpp', 'extra.cpp']);
+    expect(plan.remove).toEqual(['util.h']);
+  });
+
+  it('should treat a mode change as a change', () => {
+    const previous = planFileSync(null, [a]).hashes;
+    expect(planFileSync(previous, [{ ...a, mode: 0o755 }]).upload).toHaveLength(1);
+  });
+
+  it('should hash string and Buffer content identically', () => {
+    expect(hashFileEntry({ path: 'x', content: 'abc' })).toBe(hashFileEntry({ path: 'x', content: Buffer.from('abc') }));
+  });
+});
+
+describe('parseChecksums', () => {
+  it('should map paths to hashes and skip escaped names', () => {
+    const hash = sha256('x');
+    const checksums = parseChecksums(`${hash}  src/a b.js\n\\${hash}  odd\\nname\n${hash} *bin.dat\n`);
+    expect([...checksums]).toEqual([['src/a b.js', hash], ['bin.dat', hash]]);
+  });
+});
+
+describe('syncFiles', () => {
+  // Container /app contents by container id, as the mocked exec sees them
+  let disk: Map<string, Map<string, string>>;
+  let records: Map<string, Map<string, string>>;
+
+  beforeEach(() => {
+    disk = new Map();
+    records = new Map();
+    (sessionPool.getSyncedFiles as jest.Mock).mockImplementation((containerId: string) => records.get(containerId) ?? null);
+    (sessionPool.recordSyncedFiles as jest.Mock).mockImplementation(
+      (containerId: string, _sessionId: string, hashes: Map<string, string>) => { records.set(containerId, hashes); },
+    );
+    (dockerClient.putFiles as jest.Mock).mockImplementation(async (containerId: string, entries: { path: string; content: string | Buffer }[]) => {
+      const files = disk.get(containerId) ?? new Map();
+      for (const entry of entries) files.set(entry.path, entry.content.toString());
+      disk.set(containerId, files);
+      return 512;
+    });
+    (dockerClient.execInContainer as jest.Mock).mockImplementation(async (containerId: string, command: string) => {
+      const files = disk.get(containerId) ?? new Map<string, string>();
+      const checked = /sha256sum -- (.*) 2>/.exec(command)?.[1].split(' ').map(p => p.replace(/^'|'$/g, '')) ?? [];
+      const stdout = checked.filter(p => files.has(p)).map(p => `${sha256(files.get(p)!)}  ${p}\n`).join('');
+      return { stdout, stderr: '', exitCode: 0 };
+    });
+  });
+
+  it('should skip the upload entirely for an unchanged rerun', async () => {
+    const files = [{ path: 'app.js', content: 'console.log(1)' }];
+    const first = await syncFiles('c-unchanged', 's1', files);
+    expect(first).toEqual({ bytesSent: 512, uploaded: 1, removed: 0, unchanged: 0 });
+
+    const second = await syncFiles('c-unchanged', 's1', files);
+    expect(second).toEqual({ bytesSent: 0, uploaded: 0, removed: 0, unchanged: 1 });
+    expect(dockerClient.putFiles).toHaveBeenCalledTimes(1);
+  });
+
+  it('should delete files removed from the project', async () => {
+    await syncFiles('c-removed', 's1', [
+      { path: 'Main.java', content: 'class Main {}' },
+      { path: "it's.java", content: 'class Old {}' },
+    ]);
+    const result = await syncFiles('c-removed', 's1', [{ path: 'Main.java', content: 'class Main {}' }]);
+
+    expect(result.removed).toBe(1);
+    expect(dockerClient.execInContainer).toHaveBeenCalledWith(
+      'c-removed', expect.stringMatching(/^rm -f -- 'it'\\''s\.java'; sha256sum -- 'Main\.java'/), expect.anything());
+  });
+
+  it('should always upload transient entries without recording them', async () => {
+    const files = [{ path: 'main.cpp', content: 'int main() {}' }];
+    await syncFiles('c-seed', 's1', files);
+    await syncFiles('c-seed', 's1', files, [{ path: '.cr-seed-abc', content: Buffer.from([1]), mode: 0o755 }]);
+
+    expect(dockerClient.putFiles).toHaveBeenLastCalledWith('c-seed', [expect.objectContaining({ path: '.cr-seed-abc' })]);
+    const third = await syncFiles('c-seed', 's1', files);
+    expect(third.removed).toBe(0);
+  });
+
+  it('should re-upload files the program modified or deleted', async () => {
+    const files = [
+      { path: 'main.js', content: 'console.log(1)' },
+      { path: 'data.txt', content: 'input' },
+      { path: 'lib.js', content: 'module.exports = 1' },
+    ];
+    await syncFiles('c-stale', 's1', files);
+    disk.get('c-stale')!.set('main.js', 'tampered');
+    disk.get('c-stale')!.delete('data.txt');
+
+    const result = await syncFiles('c-stale', 's1', files);
+    expect(result).toEqual({ bytesSent: 512, uploaded: 2, removed: 0, unchanged: 1 });
+    expect(dockerClient.putFiles).toHaveBeenLastCalledWith('c-stale', [files[0], files[1]]);
+    expect(disk.get('c-stale')!.get('main.js')).toBe('console.log(1)');
+  });
+
+  it('should not check the container on a first sync', async () => {
+    await syncFiles('c-first', 's1', [{ path: 'app.py', content: 'print(1)' }]);
+    expect(dockerClient.execInContainer).not.toHaveBeenCalled();
+  });
+
+  it('should forget the record when the upload fails', async () => {
+    const files = [{ path: 'app.js', content: 'x' }];
+    await syncFiles('c-fail', 's1', files);
+    (dockerClient.putFiles as jest.Mock).mockRejectedValueOnce(new Error('boom'));
+    await expect(syncFiles('c-fail', 's1', [{ path: 'app.js', content: 'y' }])).rejects.toThrow('boom');
+
+    const retry = await syncFiles('c-fail', 's1', files);
+    expect(retry.uploaded).toBe(1);
+  });
+});
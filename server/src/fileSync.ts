@@ -0,0 +1,139 @@
+/**
+ * Delta file sync into session containers
+ *
+ * Containers of stateless languages keep /app between runs (see
+ * skipStatelessCleanup), so most files of a rerun are already in place. The
+ * pool remembers a content hash per synced path; each run uploads only added or
+ * changed files and deletes files that were removed from the project.
+ *
+ * The user program runs with write access to /app and may have edited or deleted
+ * project files since, so files the record calls unchanged are checked against
+ * the container (sha256sum, in the same exec as the deletions) and re-uploaded
+ * when they differ or are gone.
+ *
+ * Containers whose /app is wiped after every run have an empty record and get
+ * a full upload, exactly as before.
+ */
+
+import { createHash } from 'crypto';
+import { config } from './config';
+import { execInContainer, putFiles, type FileEntry } from './dockerClient';
+import { sessionPool } from './pool';
+import { shellEscape } from './shell';
+
+export interface FileSyncPlan {
+  /** Files to upload (new or changed) */
+  upload: FileEntry[];
+  /** Previously synced paths that are no longer part of the project */
+  remove: string[];
+  /** Record to keep once the sync has succeeded */
+  hashes: Map<string, string>;
+}
+
+export interface FileSyncResult {
+  /** Size of the uploaded archive (0 when nothing changed) */
+  bytesSent: number;
+  uploaded: number;
+  removed: number;
+  unchanged: number;
+}
+
+/**
+ * Hash of everything that ends up on disk for a file: content and mode.
+ */
+export function hashFileEntry(file: FileEntry): string {
+  return createHash('sha256')
+    .update(String(file.mode ?? 0o644))
+    .update('\0')
+    .update(file.content)
+    .digest('hex');
+}
+
+/**
+ * Content hash as printed by sha256sum in the container.
+ */
+function contentHash(file: FileEntry): string {
+  return createHash('sha256').update(file.content).digest('hex');
+}
+
+/**
+ * Parse `sha256sum` output into path → hash. Escaped names (backslash-prefixed
+ * lines) are skipped, which makes those files count as changed.
+ */
+export function parseChecksums(output: string): Map<string, string> {
+  const checksums = new Map<string, string>();
+  for (const line of output.split('\n')) {
+    const match = /^([0-9a-f]{64}) [ *](.+)$/.exec(line);
+    if (match) checksums.set(match[2], match[1]);
+  }
+  return checksums;
+}
+
+/**
+ * Work out what has to change in the container to match `files`.
+ */
+export function planFileSync(previous: Map<string, string> | null, files: FileEntry[]): FileSyncPlan {
+  const hashes = new Map<string, string>();
+  const upload: FileEntry[] = [];
+
+  for (const file of files) {
+    const hash = hashFileEntry(file);
+    hashes.set(file.path, hash);
+    if (previous?.get(file.path) !== hash) {
+      upload.push(file);
+    }
+  }
+
+  const remove = previous ? [...previous.keys()].filter(path => !hashes.has(path)) : [];
+  return { upload, remove, hashes };
+}
+
+/**
+ * Bring the container's /app in line with the project files. `transient`
+ * entries (e.g. build cache seeds, which the run consumes) are always uploaded
+ * and never recorded.
+ */
+export async function syncFiles(
+  containerId: string,
+  sessionId: string,
+  files: FileEntry[],
+  transient: FileEntry[] = [],
+): Promise<FileSyncResult> {
+  const previous = config.sessionContainers.deltaFileSync
+    ? sessionPool.getSyncedFiles(containerId, sessionId)
+    : null;
+  const plan = planFileSync(previous, files);
+
+  try {
+    const uploading = new Set(plan.upload);
+    const kept = previous ? files.filter(file => !uploading.has(file)) : [];
+    const steps: string[] = [];
+    if (plan.remove.length > 0) steps.push(`rm -f -- ${plan.remove.map(shellEscape).join(' ')}`);
+    if (kept.length > 0) steps.push(`sha256sum -- ${kept.map(file => shellEscape(file.path)).join(' ')} 2>/dev/null`);
+
+    if (steps.length > 0) {
+      const result = await execInContainer(containerId, steps.join('; '), {
+        timeout: config.docker.commandTimeout,
+      });
+      const checksums = parseChecksums(result.stdout);
+      for (const file of kept) {
+        if (checksums.get(file.path) !== contentHash(file)) plan.upload.push(file);
+      }
+    }
+
+    const toUpload = [...plan.upload, ...transient];
+    const bytesSent = toUpload.length > 0 ? await putFiles(containerId, toUpload) : 0;
+    sessionPool.recordSyncedFiles(containerId, sessionId, plan.hashes);
+
+    return {
+      bytesSent,
+      uploaded: plan.upload.length,
+      removed: plan.remove.length,
+      unchanged: files.length - plan.upload.length,
+    };
+  } catch (error) {
+    // The container's state is unknown now; the next run uploads everything
+    sessionPool.recordSyncedFiles(containerId, sessionId, new Map());
+    throw error;
+  }
+}
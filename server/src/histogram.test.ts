@@ -0,0 +1,71 @@
+/**
+ * Tests for the fixed-memory latency histogram
+ */
+
+import { LatencyHistogram, PROMETHEUS_BUCKETS_MS } from './histogram';
+
+describe('LatencyHistogram', () => {
+  it('should be exact for small values', () => {
+    const histogram = new LatencyHistogram();
+    for (let i = 1; i <= 50; i++) histogram.record(i);
+    expect(histogram.percentile(50)).toBe(25);
+    expect(histogram.percentile(90)).toBe(45);
+    expect(histogram.percentile(100)).toBe(50);
+  });
+
+  it('should stay within the bucket error for large values', () => {
+    const histogram = new LatencyHistogram();
+    for (let i = 1; i <= 1000; i++) histogram.record(i * 37);
+    const p99 = histogram.percentile(99);
+    expect(p99).toBeGreaterThanOrEqual(990 * 37);
+    expect(p99).toBeLessThanOrEqual(990 * 37 * 1.04);
+  });
+
+  it('should never report more than the largest sample', () => {
+    const histogram = new LatencyHistogram();
+    histogram.record(400);
+    expect(histogram.percentile(99)).toBe(400);
+  });
+
+  it('should clamp out-of-range values', () => {
+    const histogram = new LatencyHistogram();
+    histogram.record(-5);
+    histogram.record(Number.MAX_SAFE_INTEGER);
+    expect(histogram.count).toBe(2);
+    expect(histogram.percentile(1)).toBe(0);
+  });
+
+  it('should track the exact smallest and largest samples', () => {
+    const histogram = new LatencyHistogram();
+    expect(histogram.minMs).toBe(0);
+    [100, 1234, 300].forEach(v => histogram.record(v));
+    expect(histogram.minMs).toBe(100);
+    expect(histogram.maxMs).toBe(1234);
+    expect(histogram.percentile(1)).toBe(100);
+  });
+
+  it('should compute the average from the exact sum', () => {
+    const histogram = new LatencyHistogram();
+    [100, 200, 600].forEach(v => histogram.record(v));
+    expect(histogram.stats().avg).toBe(300);
+  });
+
+  it('should produce cumulative Prometheus buckets ending with +Inf', () => {
+    const histogram = new LatencyHistogram();
+    [3, 7, 7, 120000].forEach(v => histogram.record(v));
+    const buckets = histogram.cumulativeBuckets();
+    expect(buckets).toHaveLength(PROMETHEUS_BUCKETS_MS.length + 1);
+    expect(buckets[0]).toEqual([5, 1]);
+    expect(buckets[1]).toEqual([10, 3]);
+    expect(buckets[buckets.length - 2]).toEqual([60000, 3]);
+    expect(buckets[buckets.length - 1]).toEqual([Infinity, 4]);
+  });
+
+  it('should clear everything on reset', () => {
+    const histogram = new LatencyHistogram();
+    histogram.record(10);
+    histogram.reset();
+    expect(histogram.count).toBe(0);
+    expect(histogram.stats()).toEqual({ p50: 0, p90: 0, p95: 0, p99: 0, avg: 0 });
+  });
+});
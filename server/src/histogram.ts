@@ -0,0 +1,145 @@
+/**
+ * Fixed-memory latency histogram
+ *
+ * Log-linear buckets over integer milliseconds: exact below 64ms, then 32
+ * sub-buckets per power of two (≤3% relative error) up to ~18.6 hours. Memory is
+ * a constant ~3KB per histogram regardless of how many samples are recorded, and
+ * percentiles are read in O(buckets).
+ *
+ * Each histogram also keeps counts for the coarse PROMETHEUS_BUCKETS_MS bounds
+ * so it can be exported as a Prometheus histogram without re-bucketing.
+ */
+
+/** Values below this are recorded exactly */
+const LINEAR_LIMIT = 64;
+const LINEAR_BITS = 6;
+/** Sub-buckets per power of two above LINEAR_LIMIT */
+const SUB_BUCKET_BITS = 5;
+const SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+/** Largest recordable value is 2^MAX_EXPONENT - 1 ms; larger values are clamped */
+const MAX_EXPONENT = 26;
+const MAX_VALUE = 2 ** MAX_EXPONENT - 1;
+const BUCKET_COUNT = LINEAR_LIMIT + (MAX_EXPONENT - LINEAR_BITS) * SUB_BUCKETS;
+
+/** Upper bounds (ms) of the buckets exported to Prometheus; +Inf is implied */
+export const PROMETHEUS_BUCKETS_MS = [5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000, 60000] as const;
+
+export interface StageStats {
+  p50: number;
+  p90: number;
+  p95: number;
+  p99: number;
+  avg: number;
+}
+
+function bucketIndex(value: number): number {
+  if (value < LINEAR_LIMIT) return value;
+  const exponent = 31 - Math.clz32(value);
+  const sub = (value >>> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+  return LINEAR_LIMIT + (exponent - LINEAR_BITS) * SUB_BUCKETS + sub;
+}
+
+/**
+ * Index of the PROMETHEUS_BUCKETS_MS bound a value falls under; the last index
+ * (PROMETHEUS_BUCKETS_MS.length) is +Inf.
+ */
+export function exportBucketIndex(ms: number): number {
+  let bound = 0;
+  while (bound < PROMETHEUS_BUCKETS_MS.length && ms > PROMETHEUS_BUCKETS_MS[bound]) bound++;
+  return bound;
+}
+
+/** Highest value that lands in bucket `index` */
+function bucketUpperBound(index: number): number {
+  if (index < LINEAR_LIMIT) return index;
+  const exponent = LINEAR_BITS + Math.floor((index - LINEAR_LIMIT) / SUB_BUCKETS);
+  const sub = (index - LINEAR_LIMIT) % SUB_BUCKETS;
+  const shift = exponent - SUB_BUCKET_BITS;
+  return ((SUB_BUCKETS + sub) << shift) + (1 << shift) - 1;
+}
+
+export class LatencyHistogram {
+  private counts = new Uint32Array(BUCKET_COUNT);
+  /** Non-cumulative counts per PROMETHEUS_BUCKETS_MS bound, plus one for +Inf */
+  private exportCounts = new Uint32Array(PROMETHEUS_BUCKETS_MS.length + 1);
+  private total = 0;
+  private sum = 0;
+  private min = Infinity;
+  private max = 0;
+
+  get count(): number {
+    return this.total;
+  }
+
+  get sumMs(): number {
+    return this.sum;
+  }
+
+  /** Smallest and largest samples (exact), 0 when empty */
+  get minMs(): number {
+    return this.total > 0 ? this.min : 0;
+  }
+
+  get maxMs(): number {
+    return this.max;
+  }
+
+  record(ms: number): void {
+    const value = Math.min(Math.max(0, Math.round(ms)), MAX_VALUE);
+    this.counts[bucketIndex(value)]++;
+    this.exportCounts[exportBucketIndex(value)]++;
+
+    this.total++;
+    this.sum += value;
+    if (value < this.min) this.min = value;
+    if (value > this.max) this.max = value;
+  }
+
+  /**
+   * Smallest recorded value v such that at least p% of samples are ≤ v, rounded
+   * up to its bucket's upper bound (and kept within the smallest and largest sample).
+   */
+  percentile(p: number): number {
+    if (this.total === 0) return 0;
+    const rank = Math.max(1, Math.ceil((p / 100) * this.total));
+    let seen = 0;
+    for (let i = 0; i < BUCKET_COUNT; i++) {
+      seen += this.counts[i];
+      if (seen >= rank) return Math.max(Math.min(bucketUpperBound(i), this.max), this.min);
+    }
+    return this.max;
+  }
+
+  stats(): StageStats {
+    return {
+      p50: this.percentile(50),
+      p90: this.percentile(90),
+      p95: this.percentile(95),
+      p99: this.percentile(99),
+      avg: this.total > 0 ? Math.round(this.sum / this.total) : 0,
+    };
+  }
+
+  /**
+   * Cumulative [upper bound ms, count] pairs for Prometheus, ending with +Inf.
+   */
+  cumulativeBuckets(): Array<[number, number]> {
+    const buckets: Array<[number, number]> = [];
+    let cumulative = 0;
+    PROMETHEUS_BUCKETS_MS.forEach((bound, i) => {
+      cumulative += this.exportCounts[i];
+      buckets.push([bound, cumulative]);
+    });
+    buckets.push([Infinity, this.total]);
+    return buckets;
+  }
+
+  reset(): void {
+    this.counts.fill(0);
+    this.exportCounts.fill(0);
+    this.total = 0;
+    this.sum = 0;
+    this.min = Infinity;
+    this.max = 0;
+  }
+}
@@ -11,13 +11,49 @@ import { promisify } from 'util';
 import * as fs from 'fs';
 import * as path from 'path';
 import { createServer } from 'http';
-import { Server } from 'socket.io';
-import { sessionPool } from './pool';
-import { config, validateConfig } from './config';
-import { getOrCreateSessionNetwork, deleteSessionNetwork, getNetworkName, cleanupOrphanedNetworks, aggressiveBulkNetworkCleanup, getNetworkStats, getSubnetStats, getNetworkMetrics } from './networkManager';
+import { Server, type Socket } from 'socket.io';
+import { sessionPool, type ContainerStart } from './pool';
+import { config, isSupportedLanguage, validateConfig } from './config';
+import { getOrCreateSessionNetwork, deleteSessionNetwork, getNetworkName, cleanupOrphanedNetworks, aggressiveBulkNetworkCleanup, getNetworkStats, getSubnetStats, getNetworkMetrics, startNetworkPool, stopNetworkPool } from './networkManager';
 import { kernelManager } from './kernelManager';
-import { putFiles, execInteractive, execInContainer, pingDaemon, imageExists, type FileEntry } from './dockerClient';
+import { execInteractive, execInContainer, readFile, pingDaemon, imageExists, sampleExecResources, withProcessPeak, type ExecResources, type FileEntry } from './dockerClient';
+import { dockerHosts } from './dockerHosts';
+import { clusterState } from './clusterState';
+import { batchRunner, type BatchJob } from './batchRunner';
+import cluster from 'cluster';
+import type { ResourceUsage } from './agent';
 import { pipelineMetrics, createStopwatch, type PipelineTimings } from './pipelineMetrics';
+import { filterCppFiles, planCppBuild, parseBuildProfile, hostBuildStore, hostStoreKey, BUILD_CACHE_DIR, SEED_PREFIX, type CppBuildPlan, type BuildProfile } from './cppBuild';
+import { javaBuildKey, javaRunCommand } from './javaRunner';
+import {
+  speculativeBuildCommand,
+  speculativeBuilds,
+  MAX_DIAGNOSTIC_BYTES,
+  SPECULATIVE_BUILD_LANGUAGES,
+  SPECULATIVE_BUILD_PRIORITY,
+  type SpeculativeBuild,
+  type SpeculativeBuildCommand,
+  type SpeculativeBuildOutcome,
+} from './speculativeBuild';
+import {
+  BuildReportFilter,
+  extractBuildReport,
+  getBuildPhases,
+  usesBuildReport,
+  BUILD_RUN_FIELD,
+  type BuildReport,
+} from './buildReport';
+import { shellEscape } from './shell';
+import { collectProfile, formatProfileSummary, profileRunWrapper, type ProfileSummary } from './profiler';
+import { ExecutionQueue, type TaskReport } from './executionQueue';
+import { OutputStream } from './outputStream';
+import { syncFiles } from './fileSync';
+import { sharedPostgres, type SqlRunTarget } from './sharedPostgres';
+import { benchmarkRunWrapper, collectBenchmark, formatBenchmarkSummary, normalizeBenchmarkRuns, type BenchmarkSummary } from './benchmark';
+import {
+  TEST_CASE_LANGUAGES, collectTestCases, compileErrorSummary, parseTestCases, testCaseCommand, testCaseFiles,
+  testCaseRunWrapper, testCaseTimeoutMs, withTestCaseReset, type TestCase, type TestCaseSummary,
+} from './testCases';
 import { logger } from './logger';
 
 import { adminMetrics } from './adminMetrics';
@@ -119,7 +155,15 @@ const io = new Server(httpServer, {
   cors: {
     origin: allowedOrigins,
     methods: ["GET", "POST"]
-  }
+  },
+  // Optional compression of large frames (e.g. bulk program output)
+  perMessageDeflate: config.output.compression
+    ? { threshold: config.output.compressionThreshold }
+    : false,
+  // Cluster workers share the port and connections are spread without
+  // stickiness, so a polling session's requests could reach different workers.
+  // A WebSocket stays on the worker that accepted it, with all of its state.
+  ...(cluster.isWorker ? { transports: ['websocket' as const] } : {}),
 });
 
 const PORT = config.server.port;
@@ -128,6 +172,8 @@ const PORT = config.server.port;
 app.use(compression());  // Gzip/deflate compression for all responses
 app.use(helmet());  // Security headers (X-Content-Type-Options, X-Frame-Options, etc.)
 app.use(cors({ origin: allowedOrigins }));
+// Batches carry many submissions; parsed here, the general parser below skips them
+app.use('/api/run/batch', express.json({ limit: config.batch.maxBodySize }));
 app.use(express.json({ limit: '10mb' }));
 
 // --- Rate Limiting: /api/run endpoint ---
@@ -160,6 +206,24 @@ export interface RunResult {
   stdout: string;
   stderr: string;
   exitCode: number;
+  /** Compile and run phases of cpp/java executions (from build markers) */
+  compileMs?: number;
+  runMs?: number;
+  /** Per-case verdicts of a test-case run (testCases.ts) */
+  testCases?: TestCaseSummary;
+  /** Stage timings of the run; only sent to clients that ask with `timings: true` */
+  pipeline?: PipelineTimings;
+}
+
+/**
+ * Drop the pipeline timings from a result unless the request asked for them
+ * (the performance regression suite does, see server/tests/run-regression.js).
+ */
+function withRequestedTimings<T extends { pipeline?: PipelineTimings }>(result: T, timings?: boolean): T {
+  if (timings) return result;
+  const rest = { ...result };
+  delete rest.pipeline;
+  return rest;
 }
 
 // --- File Validation & Sanitization ---
@@ -216,38 +280,19 @@ function validateAndSanitizeFiles(files: File[]): { valid: boolean; error?: stri
   return { valid: true };
 }
 
-/**
- * Shell-escape a filename for safe use in shell commands.
- * Uses single quotes which prevent all shell interpretation.
- */
-function shellEscape(arg: string): string {
-  // Replace single quotes with '\'' (end quote, escaped quote, start quote)
-  return "'" + arg.replace(/'/g, "'\\''") + "'";
-}
-
-function getRunCommand(language: string, entryFile: string): string {
+function getRunCommand(language: string, entryFile: string, cppPlan?: CppBuildPlan | null, javaKey = ''): string {
   switch (language) {
     case 'python': return `python -u ${shellEscape(entryFile)}`; // -u for unbuffered output
     case 'javascript': return `node ${shellEscape(entryFile)}`;
     case 'cpp': {
-      // Determine compiler and file extension pattern based on entry file
-      const ext = entryFile.split('.').pop()?.toLowerCase();
-      if (ext === 'c') {
-        // Pure C files - use gcc and only compile .c files
-        return 'find . -maxdepth 1 -name "*.c" -print0 | xargs -0 gcc -o app && ./app';
-      } else {
-        // C++ files (.cpp, .cc, .cxx, .c++) - use g++ and compile C++ files only
-        return 'find . -maxdepth 1 \\( -name "*.cpp" -o -name "*.cc" -o -name "*.cxx" -o -name "*.c++" \\) -print0 | xargs -0 g++ -o app && ./app';
-      }
+      // Compiler, translation units and the build cache are planned in cppBuild.ts
+      if (!cppPlan) throw new Error('Missing build plan for cpp run');
+      return cppPlan.command;
     }
     case 'java': {
-      const className = entryFile.split('/').pop()?.replace('.java', '') || entryFile.replace('.java', '');
-      // -XX:TieredStopAtLevel=1  → only C1 compiler (fast startup, skip C2 optimiser)
-      // -XX:+UseSerialGC         → minimal GC overhead for short-lived processes
-      // -Xshare:auto             → use CDS archive baked into the image
-      // -Xms8m -Xmx256m         → small heap to reduce GC pauses and startup cost
-      const jvmFlags = '-XX:TieredStopAtLevel=1 -XX:+UseSerialGC -Xshare:auto -Xms8m -Xmx256m';
-      return `javac -d . $(find . -name "*.java") && java ${jvmFlags} ${shellEscape(className)}`;
+      // Warm in-container daemon with the cold javac && java path as fallback,
+      // compiled into the class cache entry for javaKey (javaRunner.ts)
+      return javaRunCommand(entryFile, { key: javaKey });
     }
     case 'sql': {
       return `PGPASSWORD=root psql -U root -d devdb -f ${shellEscape(entryFile)}`;
@@ -257,151 +302,17 @@ function getRunCommand(language: string, entryFile: string): string {
 }
 
 // --- Request Queue Manager ---
-// Manages concurrent execution of 'run' requests with configurable parallelism
-// Files within a single request execute sequentially to support dependencies (e.g., server→client)
-
-interface QueuedTask {
-  task: () => Promise<void>;
-  priority: number;
-  timestamp: number;
-  language?: string;
-}
-
-class ExecutionQueue {
-  private queue: Array<QueuedTask> = [];
-  private activeCount: number = 0;
-  private maxConcurrent: number;
-  private completedTasks: number = 0;
-  private failedTasks: number = 0;
-  private taskTimes: number[] = [];
-  private maxTaskTimeHistory: number = 100;
-  private maxQueueSize: number;
-  private queueTimeout: number;
-
-  constructor(maxConcurrent: number, maxQueueSize?: number, queueTimeout?: number) {
-    this.maxConcurrent = maxConcurrent;
-    this.maxQueueSize = maxQueueSize || parseInt(process.env.MAX_QUEUE_SIZE || '200', 10);
-    this.queueTimeout = queueTimeout || parseInt(process.env.QUEUE_TIMEOUT || '60000', 10);
-  }
-
-  enqueue(task: () => Promise<void>, priority: number = 0, language?: string): void {
-    // Check queue size limit
-    if (this.queue.length >= this.maxQueueSize) {
-      throw new Error(`Queue full: ${this.queue.length} tasks queued (max: ${this.maxQueueSize})`);
-    }
-
-    const queuedTask: QueuedTask = {
-      task,
-      priority,
-      timestamp: Date.now(),
-      language,
-    };
-
-    // Binary search for correct insertion index (sorted by priority desc, then timestamp asc)
-    let lo = 0, hi = this.queue.length;
-    while (lo < hi) {
-      const mid = (lo + hi) >>> 1;
-      const cmp = this.queue[mid];
-      if (cmp.priority > queuedTask.priority ||
-        (cmp.priority === queuedTask.priority && cmp.timestamp <= queuedTask.timestamp)) {
-        lo = mid + 1;
-      } else {
-        hi = mid;
-      }
-    }
-    this.queue.splice(lo, 0, queuedTask);
-
-    this.processQueue();
-  }
-
-  private processQueue(): void {
-    // Remove expired tasks from queue
-    const now = Date.now();
-    const initialQueueLength = this.queue.length;
-    this.queue = this.queue.filter(qt => {
-      if (now - qt.timestamp > this.queueTimeout) {
-        logger.warn('ExecutionQueue', `Task timed out after ${this.queueTimeout}ms in queue`);
-        this.failedTasks++;
-        return false;
-      }
-      return true;
-    });
-    if (this.queue.length < initialQueueLength) {
-      logger.info('ExecutionQueue', `Removed ${initialQueueLength - this.queue.length} expired tasks from queue`);
-    }
-
-    // Process tasks without blocking - key fix for concurrency
-    while (this.queue.length > 0 && this.activeCount < this.maxConcurrent) {
-      const queuedTask = this.queue.shift();
-      if (!queuedTask) break;
-
-      this.activeCount++;
-      const startTime = Date.now();
-
-      // Execute task asynchronously WITHOUT await - this enables true parallelism
-      queuedTask.task()
-        .then(() => {
-          const taskTime = Date.now() - startTime;
-          this.taskTimes.push(taskTime);
-          if (this.taskTimes.length > this.maxTaskTimeHistory) {
-            this.taskTimes.shift();
-          }
-          this.completedTasks++;
-        })
-        .catch((error) => {
-          logger.error('ExecutionQueue', `Task error: ${error?.message || error}`);
-          this.failedTasks++;
-        })
-        .finally(() => {
-          this.activeCount--;
-          // Continue processing remaining tasks
-          if (this.queue.length > 0) {
-            this.processQueue();
-          }
-        });
-    }
-  }
-
-  getStats() {
-    const averageTaskTime = this.taskTimes.length > 0
-      ? this.taskTimes.reduce((a, b) => a + b, 0) / this.taskTimes.length
-      : 0;
-
-    return {
-      queued: this.queue.length,
-      active: this.activeCount,
-      maxConcurrent: this.maxConcurrent,
-      completedTasks: this.completedTasks,
-      failedTasks: this.failedTasks,
-      averageTaskTime: Math.round(averageTaskTime),
-      maxQueueSize: this.maxQueueSize,
-    };
-  }
-
-  getDetailedStats() {
-    const stats = this.getStats();
-    const queuedByLanguage: { [key: string]: number } = {};
-
-    this.queue.forEach(qt => {
-      if (qt.language) {
-        queuedByLanguage[qt.language] = (queuedByLanguage[qt.language] || 0) + 1;
-      }
-    });
-
-    return {
-      ...stats,
-      queuedByLanguage,
-      queueUtilization: this.maxConcurrent > 0
-        ? Math.round((this.activeCount / this.maxConcurrent) * 100)
-        : 0,
-    };
-  }
-}
-
+// Concurrency-bounded, per-language fair queue for 'run' requests (see executionQueue.ts)
 const executionQueue = new ExecutionQueue(
   config.sessionContainers.maxConcurrentSessions,
   config.executionQueue.maxQueueSize,
-  config.executionQueue.queueTimeout
+  config.executionQueue.queueTimeout,
+  {
+    fairScheduling: config.executionQueue.fairScheduling,
+    languageConcurrency: config.executionQueue.languageConcurrency,
+    languages: Object.keys(config.runtimes),
+    adaptive: config.executionQueue.adaptive.enabled ? config.executionQueue.adaptive : undefined,
+  }
 );
 
 // Export for admin routes
@@ -434,9 +345,15 @@ io.on('connection', (socket) => {
 
   let currentProcess: any = null;
   let containerId: string | null = null;
+  // containerId is a shared Postgres server rather than a pooled session container
+  let containerShared = false;
   let currentLanguage: string | null = null;
   let currentSessionId: string | null = null;
   let manuallyStopped: boolean = false;
+  // The user sent stdin to the current run
+  let inputReceived = false;
+  // The current run is registered with the speculative build tracker
+  let speculativeRunActive = false;
 
   // --- Per-socket rate limiting for code execution ---
   const socketRateLimit = { count: 0, windowStart: Date.now() };
@@ -453,42 +370,16 @@ io.on('connection', (socket) => {
     return socketRateLimit.count <= SOCKET_RATE_MAX;
   }
 
-  // Output buffering - batch chunks to reduce socket traffic and memory overhead
-  // Instead of emitting every stdout/stderr chunk immediately, we buffer them and
-  // emit in batches every 100ms. This reduces:
-  // - Socket.io message overhead (fewer emit calls)
-  // - Network traffic (combined chunks are more efficient)
-  // - Client-side memory pressure (reduces processing overhead)
-  // - Server console logging (only critical logs kept after refactoring)
-  let outputBuffer: { sessionId: string; type: 'stdout' | 'stderr'; data: string }[] = [];
-  let flushBufferTimer: NodeJS.Timeout | null = null;
-
-  const flushOutputBuffer = () => {
-    if (outputBuffer.length > 0) {
-      // Combine consecutive same-type chunks to further reduce overhead
-      // e.g., [stdout:"a", stdout:"b", stderr:"c"] → [stdout:"ab", stderr:"c"]
-      const combined: { sessionId: string; type: 'stdout' | 'stderr'; data: string }[] = [];
-      for (const item of outputBuffer) {
-        if (combined.length > 0 && combined[combined.length - 1].type === item.type && combined[combined.length - 1].sessionId === item.sessionId) {
-          combined[combined.length - 1].data += item.data;
-        } else {
-          combined.push(item);
-        }
-      }
-      // Emit combined chunks
-      combined.forEach(item => socket.emit('output', item));
-      outputBuffer = [];
-    }
-    flushBufferTimer = null;
-  };
-
-  const scheduleFlush = () => {
-    if (!flushBufferTimer) {
-      flushBufferTimer = setTimeout(flushOutputBuffer, 100); // Flush every 100ms
-    }
+  // Output of the current run. Chunks stay Buffers until sent, are flushed
+  // adaptively in capped frames and pause the exec while this client's send
+  // buffer is backed up (see outputStream.ts)
+  let outputStream: OutputStream | null = null;
+  const isSocketCongested = () => {
+    const writeBuffer = (socket.conn as unknown as { writeBuffer?: unknown[] }).writeBuffer;
+    return (writeBuffer?.length ?? 0) > config.output.socketBacklog;
   };
 
-  socket.on('run', async (data: { sessionId: string; language: string, files: File[] }) => {
+  socket.on('run', async (data: { sessionId: string; language: string, files: File[], buildProfile?: string, mode?: string, benchmarkRuns?: number }) => {
     const { sessionId, language, files } = data;
 
     // Per-socket rate limiting
@@ -498,12 +389,22 @@ io.on('connection', (socket) => {
       return;
     }
 
+    // Unknown languages never reach the queue, which keeps a lane per language
+    if (!isSupportedLanguage(language)) {
+      socket.emit('output', { sessionId, type: 'stderr', data: `Error: Unsupported language '${language}'\n` });
+      socket.emit('exit', { sessionId, code: 1 });
+      return;
+    }
+
     // Enqueue the execution task with configurable concurrency
     // Priority: WebSocket interactive requests get priority 2 (higher than API)
+    const enqueuedAt = Date.now();
     executionQueue.enqueue(async () => {
+      const queueMs = Date.now() - enqueuedAt;
       currentLanguage = language;
       currentSessionId = sessionId;
       manuallyStopped = false; // Reset flag for new execution
+      inputReceived = false;
       const startTime = Date.now(); // Track execution start time
       const executionId = `ws-${sessionId}-${startTime}`;
 
@@ -518,13 +419,6 @@ io.on('connection', (socket) => {
         return;
       }
 
-      const runtimeConfig = config.runtimes[language as keyof typeof config.runtimes];
-      if (!runtimeConfig) {
-        socket.emit('output', { sessionId, type: 'stderr', data: `Error: Unsupported language '${language}'\n` });
-        socket.emit('exit', { sessionId, code: 1 });
-        return;
-      }
-
       // Find entry file
       const entryFile = files.find(f => f.toBeExec);
       if (!entryFile && language !== 'cpp' && language !== 'sql') {
@@ -544,9 +438,38 @@ io.on('connection', (socket) => {
         }
       }
 
+      const buildProfile = data.buildProfile === undefined ? undefined : parseBuildProfile(data.buildProfile);
+      if (buildProfile === null) {
+        socket.emit('output', { sessionId, type: 'stderr', data: `Error: Unknown build profile '${data.buildProfile}'\n` });
+        socket.emit('exit', { sessionId, code: 1 });
+        return;
+      }
+
+      // Run modes: 'run' (default), 'profile' (cpp only, hardware counters via perf)
+      // or 'benchmark' (cpp only, repeated timed runs via cr-bench)
+      const mode = data.mode ?? 'run';
+      if (mode !== 'run' && !((mode === 'profile' || mode === 'benchmark') && language === 'cpp')) {
+        socket.emit('output', { sessionId, type: 'stderr', data: `Error: Run mode '${mode}' is not supported for ${language}\n` });
+        socket.emit('exit', { sessionId, code: 1 });
+        return;
+      }
+      const profiling = mode === 'profile';
+      const benchmarkRuns = mode === 'benchmark' ? normalizeBenchmarkRuns(data.benchmarkRuns) : 0;
+
+      // For C/C++, filter files based on entry file extension to avoid conflicts
+      const filesToWrite = language === 'cpp' ? filterCppFiles(files, execFile?.path) : files;
+      const cppPlan = language === 'cpp'
+        ? planCppBuild(filesToWrite, execFile ? execFile.path : '', {
+          profile: buildProfile,
+          runWrapper: profiling ? profileRunWrapper : benchmarkRuns > 0 ? benchmarkRunWrapper(benchmarkRuns) : undefined,
+          reportDigest: hostBuildStore.enabled,
+        })
+        : null;
+      const javaKey = language === 'java' ? javaBuildKey(filesToWrite) : '';
+
       let command = '';
       try {
-        command = getRunCommand(language, execFile ? execFile.path : '');
+        command = getRunCommand(language, execFile ? execFile.path : '', cppPlan, javaKey);
       } catch (e: any) {
         socket.emit('output', { sessionId, type: 'stderr', data: e.message + '\n' });
         socket.emit('exit', { sessionId, code: 1 });
@@ -558,33 +481,70 @@ io.on('connection', (socket) => {
       const maxRetries = 2;
       let lastError: any = null;
       let containerReused = false;
+      let containerStart: ContainerStart | null = null;
+      let networkMs = 0;
+      let containerMs = 0;
+      let fileTransferMs = 0;
+      let fileTransferBytes = 0;
       const sw = createStopwatch();
 
-      for (let attempt = 1; attempt <= maxRetries; attempt++) {
+      // SQL on the shared backend runs against a per-session database on a
+      // long-lived server instead of its own container (see sharedPostgres.ts)
+      let sqlTarget: SqlRunTarget | null = null;
+      if (language === 'sql' && sharedPostgres.enabled) {
+        try {
+          sqlTarget = await sharedPostgres.acquire(socket.id);
+          containerId = sqlTarget.containerId;
+          containerShared = true;
+          containerReused = sqlTarget.reused;
+          command = sharedPostgres.runCommand(sqlTarget, execFile!.path);
+          containerMs += sw.lap();
+        } catch (e: any) {
+          socket.emit('output', { sessionId, type: 'stderr', data: `System Error: Failed to prepare SQL database - ${e.message}\n` });
+          socket.emit('exit', { sessionId, code: 1 });
+          return;
+        }
+      }
+
+      // A speculative build of these sources may still hold the container: wait
+      // for it (or stop a build of older sources) so the run reuses its output
+      if (SPECULATIVE_BUILD_LANGUAGES.includes(language)) {
+        speculativeRunActive = true;
+        if (await speculativeBuilds.beforeRun(socket.id, cppPlan?.key || javaKey)) {
+          logger.debug('Execution', `Session ${socket.id.substring(0, 8)}: artifact prebuilt by a speculative build`);
+        }
+        containerMs += sw.lap();
+      }
+
+      for (let attempt = 1; !sqlTarget && attempt <= maxRetries; attempt++) {
         try {
           logger.info('Execution', `Creating container for session ${socket.id.substring(0, 8)}, language ${language} (attempt ${attempt}/${maxRetries})`);
           const networkName = await getOrCreateSessionNetwork(socket.id);
-          const networkMs = sw.lap();
-          logger.info('Execution', `Network ready: ${networkName} (${networkMs}ms)`);
+          const attemptNetworkMs = sw.lap();
+          networkMs += attemptNetworkMs;
+          logger.info('Execution', `Network ready: ${networkName} (${attemptNetworkMs}ms)`);
 
           // Check if container will be reused (before getOrCreate changes the state)
           const poolStats = sessionPool.getMetrics();
-          containerId = await sessionPool.getOrCreateContainer(language, socket.id, networkName);
-          const containerMs = sw.lap();
+          containerId = await sessionPool.getOrCreateContainer(language, socket.id, networkName, profiling ? 'profile' : undefined);
+          const attemptContainerMs = sw.lap();
+          containerMs += attemptContainerMs;
           containerReused = poolStats.containersReused < sessionPool.getMetrics().containersReused;
-          logger.info('Execution', `Container ready: ${containerId.substring(0, 12)} (${containerMs}ms, reused=${containerReused})`);
+          containerStart = sessionPool.takeContainerStart(containerId);
+          logger.info('Execution', `Container ready: ${containerId.substring(0, 12)} (${attemptContainerMs}ms, reused=${containerReused})`);
           break; // Success - exit retry loop
         } catch (e: any) {
           lastError = e;
           logger.error('Execution', `Failed to acquire container (attempt ${attempt}/${maxRetries}): ${e.message}`);
 
           // Clean up the failed network before retrying
-          await deleteSessionNetwork(socket.id).catch(cleanupErr =>
+          await deleteSessionNetwork(socket.id, false).catch(cleanupErr =>
             logger.error('Execution', `Failed to cleanup network after error: ${cleanupErr}`)
           );
 
           // If this was the last attempt, fail
           if (attempt === maxRetries) {
+            releaseSpeculativeRun();
             socket.emit('output', { sessionId, type: 'stderr', data: `System Error: Failed to acquire container after ${maxRetries} attempts - ${e.message}\n` });
             socket.emit('exit', { sessionId, code: 1 });
             return;
@@ -592,43 +552,37 @@ io.on('connection', (socket) => {
 
           // Wait a bit before retrying to avoid hammering Docker
           await new Promise(resolve => setTimeout(resolve, 500));
+          // Failed attempts count towards container acquisition
+          containerMs += sw.lap();
         }
       }
 
       // At this point, containerId must be set (we returned early if all retries failed)
       if (!containerId) {
+        releaseSpeculativeRun();
         socket.emit('output', { sessionId, type: 'stderr', data: 'System Error: Container acquisition failed\n' });
         socket.emit('exit', { sessionId, code: 1 });
         return;
       }
 
-      // 2. Stream files directly into container (zero host I/O)
+      // 2. Stream changed files directly into container (zero host I/O)
+      let buildSeeded = false;
       try {
-        // For C/C++, filter files based on entry file extension to avoid conflicts
-        let filesToWrite = files;
-        if (language === 'cpp' && execFile) {
-          const entryExt = execFile.path.split('.').pop()?.toLowerCase();
-          if (entryExt === 'c') {
-            filesToWrite = files.filter(f => {
-              const ext = f.path.split('.').pop()?.toLowerCase();
-              return ext === 'c' || ext === 'h';
-            });
-          } else {
-            filesToWrite = files.filter(f => {
-              const ext = f.path.split('.').pop()?.toLowerCase();
-              return ext === 'cpp' || ext === 'cc' || ext === 'cxx' || ext === 'c++' || ext === 'hpp' || ext === 'h';
-            });
-          }
-        }
-
         const fileEntries: FileEntry[] = filesToWrite.map(f => ({
           path: f.path,
           content: f.content,
         }));
 
-        await putFiles(containerId, fileEntries);
-        const fileTransferMs = sw.lap();
-        logger.info('Execution', `Files streamed to container (${fileTransferMs}ms, ${fileEntries.length} files)`);
+        const seed = cppPlan ? await getBuildSeed(containerId, socket.id, cppPlan) : null;
+        buildSeeded = seed !== null;
+
+        const sync = sqlTarget
+          ? await sharedPostgres.syncFiles(sqlTarget, fileEntries)
+          : await syncFiles(containerId, socket.id, fileEntries, seed ? [seed] : []);
+        fileTransferMs = sw.lap();
+        fileTransferBytes = sync.bytesSent;
+        logger.info('Execution', `Files synced to container (${fileTransferMs}ms, ${sync.uploaded} uploaded, ` +
+          `${sync.unchanged} unchanged, ${sync.removed} removed, ${sync.bytesSent} bytes)`);
       } catch (err: any) {
         cleanup().catch(e => logger.error('Cleanup', `Error: ${e}`));
         socket.emit('output', { sessionId, type: 'stderr', data: `System Error: ${err.message}\n` });
@@ -637,18 +591,34 @@ io.on('connection', (socket) => {
       }
 
       // 3. Execute via Docker SDK interactive exec (streaming output)
+      const resourceSampler = await startResourceSampling(containerId, sqlTarget);
+      let taskReport: TaskReport | undefined;
       try {
-        const execSession = await execInteractive(containerId, command);
+        const execSession = await execInteractive(containerId, command, sqlTarget?.options);
         currentProcess = execSession;
 
-        execSession.stdout.on('data', (chunk: Buffer) => {
-          outputBuffer.push({ sessionId, type: 'stdout', data: chunk.toString() });
-          scheduleFlush();
+        // Compiled runs report their build step via stderr markers; strip them from the output
+        const buildFilter = usesBuildReport(language) ? new BuildReportFilter() : null;
+
+        const output = new OutputStream({
+          sessionId,
+          emit: payload => socket.emit('output', payload),
+          isCongested: isSocketCongested,
+          // Runaway output: stop the program once the ceiling is reached
+          onLimit: () => execSession.kill(),
         });
+        output.attach(execSession);
+        outputStream = output;
+
+        execSession.stdout.on('data', (chunk: Buffer) => output.write('stdout', chunk));
 
         execSession.stderr.on('data', (chunk: Buffer) => {
-          outputBuffer.push({ sessionId, type: 'stderr', data: chunk.toString() });
-          scheduleFlush();
+          if (!buildFilter || buildFilter.passingThrough) {
+            output.write('stderr', chunk);
+            return;
+          }
+          const data = buildFilter.write(chunk.toString());
+          if (data) output.write('stderr', Buffer.from(data));
         });
 
         // Wait for the exec to finish
@@ -658,22 +628,42 @@ io.on('connection', (socket) => {
             if (ended) return;
             ended = true;
 
-            // Flush any remaining buffered output before exit
-            if (flushBufferTimer) {
-              clearTimeout(flushBufferTimer);
-              flushOutputBuffer();
+            const buildTail = buildFilter?.end();
+            if (buildTail) {
+              output.write('stderr', Buffer.from(buildTail));
             }
 
+            // Flush any remaining buffered output before exit
+            output.end();
+            if (outputStream === output) outputStream = null;
+
             const executionMs = sw.lap();
             const executionTime = sw.total();
+            const sampled = await resourceSampler?.stop() ?? null;
 
-            // Get exit code
+            // Get exit code (and, for agent runs, the process's resource usage)
             let code = 0;
+            let usage: ResourceUsage | null = null;
             try {
               code = await execSession.getExitCode();
+              usage = await execSession.getUsage();
             } catch {
               code = -1;
             }
+            const resources = sampled ? withProcessPeak(sampled, usage) : null;
+            const phases = buildFilter ? getBuildPhases(buildFilter.report, usage?.wallMs ?? executionMs) : null;
+
+            // The run's wall time includes waiting on the user, so the queue learns
+            // its cost from the setup stages plus the agent's CPU time. Without the
+            // agent only the build counts once input arrived, and nothing at all
+            // for an interpreted run.
+            const execCostMs = usage
+              ? usage.userMs + usage.systemMs
+              : inputReceived ? phases?.compileMs : executionMs;
+            taskReport = {
+              interactive: true,
+              ...(execCostMs !== undefined ? { serviceMs: networkMs + containerMs + fileTransferMs + execCostMs } : {}),
+            };
 
             // Track execution completion
             adminMetrics.trackExecutionEnded(executionId);
@@ -686,24 +676,67 @@ io.on('connection', (socket) => {
               clientId: socket.id,
             });
 
-            // Record pipeline metrics
-            pipelineMetrics.record({
-              queueMs: 0, // Would need queue-level timing
-              networkMs: 0,
-              containerMs: 0,
-              fileTransferMs: 0,
+            // Profiling results are read back from the container and sent with the exit event
+            let profile: ProfileSummary | undefined;
+            if (profiling && containerId && !manuallyStopped) {
+              try {
+                profile = await collectProfile(containerId);
+                socket.emit('output', { sessionId, type: 'system', data: formatProfileSummary(profile) });
+              } catch (e: any) {
+                logger.error('Profiler', `Failed to collect profile: ${e.message}`);
+              }
+            }
+
+            // Benchmark results only exist once the build succeeded and the runs started
+            let benchmark: BenchmarkSummary | undefined;
+            if (benchmarkRuns > 0 && buildFilter?.report[BUILD_RUN_FIELD] && containerId && !manuallyStopped) {
+              try {
+                benchmark = await collectBenchmark(containerId, benchmarkRuns);
+                socket.emit('output', { sessionId, type: 'system', data: formatBenchmarkSummary(benchmark) });
+              } catch (e: any) {
+                logger.error('Benchmark', `Failed to collect results: ${e.message}`);
+              }
+            }
+
+            // Only emit exit if not manually stopped
+            if (!manuallyStopped) {
+              socket.emit('exit', {
+                sessionId, code, executionTime,
+                ...(usage ? { usage } : {}),
+                ...(resources ? { resources } : {}),
+                ...(profile ? { profile } : {}),
+                ...(benchmark ? { benchmark } : {}),
+              });
+            }
+
+            // Post-run work (profile/benchmark collection, build bookkeeping, returning
+            // the container) is the cleanup stage; it is recorded once it finishes
+            const recordPipeline = () => pipelineMetrics.record({
+              queueMs,
+              networkMs,
+              containerMs,
+              ...(containerStart ? { containerSource: containerStart.source, restoreMs: containerStart.restoreMs } : {}),
+              fileTransferMs,
+              fileTransferBytes,
               executionMs,
-              cleanupMs: 0,
-              totalMs: executionTime,
+              ...(phases ?? {}),
+              ...(resources ? { resources } : {}),
+              cleanupMs: sw.lap(),
+              totalMs: queueMs + sw.total(),
               containerReused,
               language,
             });
 
-            // Only emit exit if not manually stopped
-            if (!manuallyStopped) {
-              socket.emit('exit', { sessionId, code, executionTime });
+            if (cppPlan && buildFilter && containerId) {
+              await completeCppBuild(containerId, socket.id, cppPlan, buildFilter.report, buildSeeded)
+                .catch(e => logger.error('BuildCache', `Error: ${e}`));
+            }
+            if (javaKey && buildFilter && containerId) {
+              completeJavaBuild(containerId, socket.id, javaKey, buildFilter.report);
             }
-            cleanup().catch(e => logger.error('Cleanup', `Error: ${e}`));
+            cleanup()
+              .catch(e => logger.error('Cleanup', `Error: ${e}`))
+              .finally(recordPipeline);
             resolve();
           };
 
@@ -721,16 +754,49 @@ io.on('connection', (socket) => {
           }, timeoutMs);
         });
       } catch (err: any) {
+        resourceSampler?.stop();
         logger.error('Execution', `Process error: ${err.message}`);
         socket.emit('output', { sessionId, type: 'stderr', data: `Process Error: ${err.message}\n` });
         socket.emit('exit', { sessionId, code: 1 });
         cleanup().catch(e => logger.error('Cleanup', `Error: ${e}`));
       }
-    }, 2, language); // Priority 2 for interactive WebSocket requests
+      return taskReport;
+    }, 2, language, () => { // Priority 2 for interactive WebSocket requests
+      socket.emit('output', { sessionId, type: 'stderr', data: 'Error: Timed out waiting for an execution slot\n' });
+      socket.emit('exit', { sessionId, code: 1 });
+    });
+  });
+
+  // Background compile of cpp/java sources on save or idle (speculativeBuild.ts).
+  // Only uses idle capacity: dropped while runs are waiting for a slot
+  socket.on('build', (data: { sessionId?: string; language: string; files: File[]; buildProfile?: string }) => {
+    if (!config.speculativeBuild.enabled || !config.sessionContainers.skipStatelessCleanup) return;
+    if (!data || !SPECULATIVE_BUILD_LANGUAGES.includes(data.language) || !Array.isArray(data.files)) return;
+    if (!validateAndSanitizeFiles(data.files).valid) return;
+    const buildProfile = data.buildProfile === undefined ? undefined : parseBuildProfile(data.buildProfile);
+    if (buildProfile === null || executionQueue.getStats().queued > 0) return;
+
+    const entryFile = data.files.find(f => f.toBeExec);
+    const plan = speculativeBuildCommand(
+      data.language,
+      data.files.map(f => ({ path: f.path, content: f.content })),
+      entryFile ? entryFile.path : '',
+      { profile: buildProfile, reportDigest: hostBuildStore.enabled },
+    );
+    const build = plan ? speculativeBuilds.request(socket.id, plan.key) : null;
+    if (!plan || !build) return;
+
+    executionQueue.enqueue(
+      () => runSpeculativeBuild(socket, build, data.language, plan, data.sessionId),
+      SPECULATIVE_BUILD_PRIORITY,
+      data.language,
+      () => speculativeBuilds.finish(build, 'cancelled'),
+    );
   });
 
   socket.on('input', (data: string) => {
     if (currentProcess && currentProcess.stdin) {
+      inputReceived = true;
       try {
         currentProcess.stdin.write(data);
       } catch {
@@ -913,35 +979,47 @@ io.on('connection', (socket) => {
       activeLoadTestId = null;
     }
 
-    if (flushBufferTimer) {
-      clearTimeout(flushBufferTimer);
-    }
+    outputStream?.dispose();
     if (currentProcess) {
       currentProcess.kill();
     }
     await cleanup().catch(e => logger.error('Cleanup', `Error: ${e}`));
 
+    // Stop a speculative build still holding one of the session's containers
+    speculativeBuilds.forget(socket.id);
+
     // Clean up all session containers for this socket
     await sessionPool.cleanupSession(socket.id);
 
     // Clean up all kernels for this socket
     await kernelManager.shutdownSocketKernels(socket.id);
 
+    // Drop the session's database on the shared SQL backend
+    await sharedPostgres.releaseSession(socket.id);
+
     // Clean up session network
     await deleteSessionNetwork(socket.id).catch(err =>
       logger.error('Disconnect', `Failed to cleanup session network: ${err}`)
     );
   });
 
+  function releaseSpeculativeRun() {
+    if (!speculativeRunActive) return;
+    speculativeRunActive = false;
+    speculativeBuilds.runFinished(socket.id);
+  }
+
   async function cleanup() {
-    if (containerId) {
+    if (containerId && !containerShared) {
       // Return container to pool (cleaned and TTL refreshed)
       await sessionPool.returnContainer(containerId, socket.id).catch(err =>
         logger.error('Cleanup', `Failed to return container to pool: ${err}`)
       );
-      containerId = null;
     }
+    containerId = null;
+    containerShared = false;
     currentProcess = null;
+    releaseSpeculativeRun();
   }
 });
 
@@ -959,26 +1037,68 @@ app.get('/health', (req, res) => {
 // NOTE: Legacy endpoints (/api/network-stats, /api/cleanup-stats, /api/queue-stats) have been
 // removed. Use the authenticated /admin/stats endpoint instead: /admin/stats with X-Admin-Key header.
 
-// API endpoint for code execution - networking always enabled
-app.post('/api/run', async (req, res) => {
-  const { language, files } = req.body;
+/**
+ * Validate the body of a REST run (also each job of a batch)
+ */
+interface RunRequest {
+  language: string;
+  files: File[];
+  buildProfile?: BuildProfile;
+  testCases?: TestCase[];
+  /** Include the run's pipeline stage timings in the result */
+  timings?: boolean;
+}
+
+function parseRunRequest(body: any): RunRequest | { error: string } {
+  const { language, files } = body ?? {};
 
   if (!language || !files || !Array.isArray(files)) {
-    res.status(400).json({ error: "Invalid request body. 'language' and 'files' are required." });
-    return;
+    return { error: "Invalid request body. 'language' and 'files' are required." };
+  }
+
+  if (!isSupportedLanguage(language)) {
+    return { error: `Unsupported language '${language}'.` };
+  }
+
+  const buildProfile = body.buildProfile === undefined ? undefined : parseBuildProfile(body.buildProfile);
+  if (buildProfile === null) {
+    return { error: "Invalid buildProfile. Expected one of: debug, release, native." };
   }
 
   if (files.length === 0) {
-    res.status(400).json({ error: "No files provided." });
-    return;
+    return { error: "No files provided." };
   }
 
   // Validate and sanitize files
   const validation = validateAndSanitizeFiles(files);
   if (!validation.valid) {
-    res.status(400).json({ error: `Validation Error: ${validation.error}` });
+    return { error: `Validation Error: ${validation.error}` };
+  }
+
+  const timings = body.timings === true;
+
+  // Compile once, then judge every case in the same container (testCases.ts)
+  if (body.testCases === undefined) {
+    return { language, files, buildProfile, timings };
+  }
+  if (!TEST_CASE_LANGUAGES.includes(language)) {
+    return { error: `Test cases are not supported for ${language}.` };
+  }
+  const testCases = parseTestCases(body.testCases);
+  if (typeof testCases === 'string') {
+    return { error: testCases };
+  }
+  return { language, files, buildProfile, testCases, timings };
+}
+
+// API endpoint for code execution - networking always enabled
+app.post('/api/run', async (req, res) => {
+  const parsed = parseRunRequest(req.body);
+  if ('error' in parsed) {
+    res.status(400).json({ error: parsed.error });
     return;
   }
+  const { language, files, buildProfile, testCases, timings } = parsed;
 
   const startTime = Date.now();
   const sessionId = `api-${Date.now()}-${Math.random().toString(36).substring(7)}`;
@@ -1000,15 +1120,16 @@ app.post('/api/run', async (req, res) => {
     }
 
     // Execute via queue with priority 1 (lower than WebSocket requests)
+    const enqueuedAt = Date.now();
     const result = await new Promise<RunResult>((resolve, reject) => {
       executionQueue.enqueue(async () => {
         try {
-          const execResult = await executeWithSessionContainer(language, files, sessionId);
+          const execResult = await executeWithSessionContainer(language, files, sessionId, buildProfile, Date.now() - enqueuedAt, testCases);
           resolve(execResult);
         } catch (error) {
           reject(error);
         }
-      }, 1, language);
+      }, 1, language, () => reject(new Error('Timed out waiting for an execution slot')));
     });
 
     const executionTime = Date.now() - startTime;
@@ -1025,7 +1146,7 @@ app.post('/api/run', async (req, res) => {
     });
 
     res.json({
-      ...result,
+      ...withRequestedTimings(result, timings),
       executionTime
     });
   } catch (error: any) {
@@ -1049,14 +1170,106 @@ app.post('/api/run', async (req, res) => {
   }
 });
 
+// Batch execution for bulk workloads such as grading (see batchRunner.ts).
+// One request against the rate limit; results stream back as NDJSON, one line
+// per job in completion order, then a summary line with `done: true`.
+app.post('/api/run/batch', async (req, res) => {
+  const jobs = req.body?.jobs;
+  if (!Array.isArray(jobs) || jobs.length === 0) {
+    res.status(400).json({ error: "Invalid request body. 'jobs' must be a non-empty array." });
+    return;
+  }
+  if (jobs.length > config.batch.maxJobs) {
+    res.status(400).json({ error: `Too many jobs: ${jobs.length} (max: ${config.batch.maxJobs})` });
+    return;
+  }
+
+  // Callers may ask for fewer lanes, e.g. 1 to run every job in one warm container
+  const lanes = req.body.lanes;
+  const lanesPerLanguage = Number.isInteger(lanes) && lanes > 0
+    ? Math.min(lanes, config.batch.lanesPerLanguage)
+    : undefined;
+
+  const clientId = req.ip || req.socket.remoteAddress || 'unknown';
+  let disconnected = false;
+  res.on('close', () => { disconnected = true; });
+
+  res.status(200);
+  res.setHeader('Content-Type', 'application/x-ndjson');
+  res.setHeader('Cache-Control', 'no-cache');
+  const writeLine = (line: object) => {
+    if (res.writableEnded) return;
+    res.write(JSON.stringify(line) + '\n');
+    // Push each line through the compression middleware right away
+    (res as any).flush?.();
+  };
+
+  // Invalid jobs are reported up front; the rest of the batch still runs
+  let invalid = 0;
+  const runnable: BatchJob[] = [];
+  jobs.forEach((job: any, index: number) => {
+    const id = job?.id === undefined ? undefined : String(job.id);
+    const parsed = parseRunRequest(job);
+    if ('error' in parsed) {
+      invalid++;
+      writeLine({ index, id, language: job?.language, error: parsed.error });
+      return;
+    }
+    // Batches are grading workloads: build with the grading profile unless the job asks otherwise
+    const buildProfile = parsed.buildProfile ?? config.cppBuild.gradingProfile;
+    runnable.push({
+      index,
+      id,
+      language: parsed.language,
+      run: async (sessionId, queueMs) => withRequestedTimings(await executeWithSessionContainer(
+        parsed.language, parsed.files, sessionId, buildProfile, queueMs, parsed.testCases,
+      ), parsed.timings),
+    });
+  });
+
+  const summary = await batchRunner.run(runnable, {
+    onResult: (result) => {
+      writeLine(result);
+      adminMetrics.trackRequest({
+        type: 'api',
+        language: result.language,
+        executionTime: result.executionTime ?? 0,
+        success: result.exitCode === 0 && !result.error,
+        sessionId: 'batch',
+        clientId,
+      });
+    },
+    releaseSession: releaseBatchSession,
+    isCancelled: () => disconnected,
+    lanesPerLanguage,
+  });
+
+  writeLine({ ...summary, total: jobs.length, failed: summary.failed + invalid });
+  res.end();
+});
+
+/**
+ * Remove the containers, SQL database and network of a batch lane
+ */
+async function releaseBatchSession(sessionId: string): Promise<void> {
+  await sessionPool.cleanupSession(sessionId);
+  await sharedPostgres.releaseSession(sessionId);
+  await deleteSessionNetwork(sessionId);
+}
+
 /**
  * Execute code with session container (for API endpoint).
  * Uses Docker SDK streaming: zero host filesystem I/O.
+ * `queueMs` is the time the request waited in the execution queue, for pipeline metrics.
+ * With `testCases` the program is compiled once and judged against each case.
  */
 async function executeWithSessionContainer(
   language: string,
   files: File[],
-  sessionId: string
+  sessionId: string,
+  buildProfile?: BuildProfile,
+  queueMs: number = 0,
+  testCases?: TestCase[]
 ): Promise<RunResult> {
   const runtimeConfig = config.runtimes[language as keyof typeof config.runtimes];
   if (!runtimeConfig) {
@@ -1077,30 +1290,69 @@ async function executeWithSessionContainer(
     }
   }
 
+  // Filter files for C/C++
+  const filesToWrite = language === 'cpp' ? filterCppFiles(files, execFile?.path) : files;
+  const cppPlan = language === 'cpp'
+    ? planCppBuild(filesToWrite, execFile ? execFile.path : '', {
+      profile: buildProfile,
+      grading: testCases !== undefined,
+      reportDigest: hostBuildStore.enabled,
+      runWrapper: testCases ? testCaseRunWrapper : undefined,
+    })
+    : null;
+  const javaKey = language === 'java' ? javaBuildKey(filesToWrite) : '';
+
   let command = '';
   try {
-    command = getRunCommand(language, execFile ? execFile.path : '');
+    command = testCases && language !== 'cpp'
+      ? testCaseCommand(language, execFile ? execFile.path : '', javaKey)
+      : getRunCommand(language, execFile ? execFile.path : '', cppPlan, javaKey);
+    if (testCases) command = withTestCaseReset(command);
   } catch (e: any) {
     return { stdout: '', stderr: e.message, exitCode: 1 };
   }
 
   let containerId: string | null = null;
+  let containerReused = false;
+  let containerStart: ContainerStart | null = null;
+  let networkMs = 0;
+  let containerMs = 0;
+  const sw = createStopwatch();
+
+  // SQL on the shared backend: a per-session database instead of a container
+  let sqlTarget: SqlRunTarget | null = null;
+  if (language === 'sql' && sharedPostgres.enabled) {
+    try {
+      sqlTarget = await sharedPostgres.acquire(sessionId);
+      containerId = sqlTarget.containerId;
+      containerReused = sqlTarget.reused;
+      command = sharedPostgres.runCommand(sqlTarget, execFile!.path);
+      containerMs += sw.lap();
+    } catch (error: any) {
+      return { stdout: '', stderr: `System Error: Failed to prepare SQL database - ${error.message}`, exitCode: 1 };
+    }
+  }
 
   // Retry logic for network/container acquisition
   const maxRetries = 2;
   let networkCreated = false;
 
-  for (let attempt = 1; attempt <= maxRetries; attempt++) {
+  for (let attempt = 1; !sqlTarget && attempt <= maxRetries; attempt++) {
     try {
       const networkName = await getOrCreateSessionNetwork(sessionId);
       networkCreated = true;
+      networkMs += sw.lap();
+      const reusedBefore = sessionPool.getMetrics().containersReused;
       containerId = await sessionPool.getOrCreateContainer(language, sessionId, networkName);
+      containerMs += sw.lap();
+      containerReused = reusedBefore < sessionPool.getMetrics().containersReused;
+      containerStart = sessionPool.takeContainerStart(containerId);
       break;
     } catch (error: any) {
       logger.error('API', `Failed to acquire container (attempt ${attempt}/${maxRetries}): ${error.message}`);
 
       if (networkCreated) {
-        await deleteSessionNetwork(sessionId).catch(cleanupErr =>
+        await deleteSessionNetwork(sessionId, false).catch(cleanupErr =>
           logger.error('API', `Failed to cleanup network after error: ${cleanupErr}`)
         );
         networkCreated = false;
@@ -1111,6 +1363,7 @@ async function executeWithSessionContainer(
       }
 
       await new Promise(r => setTimeout(r, 500));
+      containerMs += sw.lap();
     }
   }
 
@@ -1119,36 +1372,89 @@ async function executeWithSessionContainer(
   }
 
   try {
-    // Filter files for C/C++
-    let filesToWrite = files;
-    if (language === 'cpp' && execFile) {
-      const entryExt = execFile.path.split('.').pop()?.toLowerCase();
-      if (entryExt === 'c') {
-        filesToWrite = files.filter(f => {
-          const ext = f.path.split('.').pop()?.toLowerCase();
-          return ext === 'c' || ext === 'h';
-        });
-      } else {
-        filesToWrite = files.filter(f => {
-          const ext = f.path.split('.').pop()?.toLowerCase();
-          return ext === 'cpp' || ext === 'cc' || ext === 'cxx' || ext === 'c++' || ext === 'hpp' || ext === 'h';
-        });
-      }
-    }
-
-    // Stream files directly into container (no temp dir)
+    // Stream changed files directly into container (no temp dir)
     const fileEntries: FileEntry[] = filesToWrite.map(f => ({ path: f.path, content: f.content }));
-    await putFiles(containerId, fileEntries);
+    const seed = cppPlan ? await getBuildSeed(containerId, sessionId, cppPlan) : null;
+    // Case inputs change on every run, so they are uploaded without delta tracking
+    const transient = [...(seed ? [seed] : []), ...(testCases ? testCaseFiles(testCases) : [])];
+    const sync = sqlTarget
+      ? await sharedPostgres.syncFiles(sqlTarget, fileEntries)
+      : await syncFiles(containerId, sessionId, fileEntries, transient);
+    const fileTransferMs = sw.lap();
 
     // Execute command via SDK
-    const result = await execInContainer(containerId, command, { timeout: 30_000 });
+    const timeout = testCases ? testCaseTimeoutMs(testCases) : 30_000;
+    const resourceSampler = await startResourceSampling(containerId, sqlTarget);
+    const result = await execInContainer(containerId, command, { timeout, ...sqlTarget?.options })
+      .catch((error) => {
+        resourceSampler?.stop();
+        throw error;
+      });
+    const extracted = usesBuildReport(language) ? extractBuildReport(result.stderr) : null;
+    const executionMs = sw.lap();
+    const phases = extracted ? getBuildPhases(extracted.report, result.usage?.wallMs ?? executionMs) : null;
+    const sampled = await resourceSampler?.stop() ?? null;
+    const resources = sampled ? withProcessPeak(sampled, result.usage) : null;
+    const stderr = extracted ? extracted.stderr : result.stderr;
+
+    if (extracted && cppPlan) {
+      await completeCppBuild(containerId, sessionId, cppPlan, extracted.report, seed !== null)
+        .catch(e => logger.error('BuildCache', `Error: ${e}`));
+    }
+    if (extracted && javaKey) {
+      completeJavaBuild(containerId, sessionId, javaKey, extracted.report);
+    }
+
+    // Verdicts are read before the container goes back to the pool. No results
+    // after a failed build means the cases never ran.
+    let testCaseSummary: TestCaseSummary | undefined;
+    if (testCases) {
+      const collected = await collectTestCases(containerId, testCases.length).catch((e: any) => {
+        logger.error('TestCases', `Failed to collect results: ${e.message}`);
+        return null;
+      });
+      if (collected) {
+        testCaseSummary = collected;
+      } else if (extracted && !extracted.report[BUILD_RUN_FIELD]) {
+        testCaseSummary = compileErrorSummary(testCases);
+      }
+    }
 
     // Return container to pool
-    await sessionPool.returnContainer(containerId, sessionId).catch(err =>
-      logger.error('API', `Failed to return container to pool: ${err}`)
-    );
+    if (!sqlTarget) {
+      await sessionPool.returnContainer(containerId, sessionId).catch(err =>
+        logger.error('API', `Failed to return container to pool: ${err}`)
+      );
+    }
+
+    const timing: PipelineTimings = {
+      queueMs,
+      networkMs,
+      containerMs,
+      ...(containerStart ? { containerSource: containerStart.source, restoreMs: containerStart.restoreMs } : {}),
+      fileTransferMs,
+      fileTransferBytes: sync.bytesSent,
+      executionMs,
+      ...(phases ?? {}),
+      ...(extracted?.report.cache !== undefined
+        ? { buildCache: extracted.report.cache === 'hit' ? (seed ? 'host' : 'hit') : 'miss' }
+        : {}),
+      ...(resources ? { resources } : {}),
+      cleanupMs: sw.lap(),
+      totalMs: queueMs + sw.total(),
+      containerReused,
+      language,
+    };
+    pipelineMetrics.record(timing);
 
-    return { stdout: result.stdout, stderr: result.stderr, exitCode: result.exitCode };
+    return {
+      stdout: result.stdout,
+      stderr,
+      exitCode: result.exitCode,
+      ...(phases ?? {}),
+      ...(testCaseSummary ? { testCases: testCaseSummary } : {}),
+      pipeline: timing,
+    };
   } catch (error: any) {
     // Clean up network if execution failed
     await deleteSessionNetwork(sessionId).catch(cleanupErr =>
@@ -1159,8 +1465,159 @@ async function executeWithSessionContainer(
   }
 }
 
-// Start Server
-if (require.main === module) {
+/**
+ * Start cgroup telemetry for one exec in a session container. Runs on the shared
+ * SQL container are not sampled, since other sessions' queries would be counted.
+ */
+async function startResourceSampling(
+  containerId: string,
+  sqlTarget: SqlRunTarget | null
+): Promise<{ stop: () => Promise<ExecResources | null> } | null> {
+  if (!config.telemetry.execResources || sqlTarget) return null;
+  return sampleExecResources(containerId);
+}
+
+/**
+ * If the host-side build store has a binary for this plan and the container
+ * doesn't already hold it, return a file entry that seeds it into the container.
+ */
+async function getBuildSeed(containerId: string, sessionId: string, plan: CppBuildPlan): Promise<FileEntry | null> {
+  if (!plan.key || !hostBuildStore.enabled || sessionPool.hasBuildArtifact(containerId, sessionId, plan.key)) {
+    return null;
+  }
+  const binary = await hostBuildStore.read(hostStoreKey(plan, dockerHosts.containerHost(containerId)));
+  return binary ? { path: `${SEED_PREFIX}${plan.key}`, content: binary, mode: 0o755 } : null;
+}
+
+/**
+ * Account for a finished cpp build: count the cache outcome, remember the artifact
+ * for this container and publish freshly compiled binaries to the host-side store.
+ */
+async function completeCppBuild(
+  containerId: string,
+  sessionId: string,
+  plan: CppBuildPlan,
+  report: BuildReport,
+  seeded: boolean
+): Promise<void> {
+  if (!plan.key || report.cache === undefined) return;
+
+  const outcome = report.cache === 'hit' ? (seeded ? 'host' : 'hit') : 'miss';
+  pipelineMetrics.recordBuildCache(outcome);
+
+  // No run marker means compilation failed — nothing was cached
+  if (report[BUILD_RUN_FIELD] === undefined) return;
+  sessionPool.recordBuildArtifact(containerId, sessionId, plan.key);
+
+  if (outcome === 'miss' && report.digest && hostBuildStore.enabled) {
+    const binary = await readFile(containerId, `/app/${BUILD_CACHE_DIR}/${plan.key}`);
+    if (binary) {
+      await hostBuildStore.save(hostStoreKey(plan, dockerHosts.containerHost(containerId)), binary, report.digest);
+    }
+  }
+}
+
+/**
+ * Account for a java run's class cache lookup and remember the cached classes
+ * for this container.
+ */
+function completeJavaBuild(containerId: string, sessionId: string, key: string, report: BuildReport): void {
+  if (report.cache === undefined) return;
+  pipelineMetrics.recordBuildCache(report.cache === 'hit' ? 'hit' : 'miss');
+  // No run marker means compilation failed — nothing was cached
+  if (report[BUILD_RUN_FIELD] !== undefined) {
+    sessionPool.recordBuildArtifact(containerId, sessionId, key);
+  }
+}
+
+/**
+ * Compile a session's sources ahead of its next run (speculativeBuild.ts) and
+ * send the outcome and compiler diagnostics to the client as `build:result`.
+ */
+async function runSpeculativeBuild(
+  socket: Socket,
+  build: SpeculativeBuild,
+  language: string,
+  plan: SpeculativeBuildCommand,
+  sessionId?: string,
+): Promise<void> {
+  if (!speculativeBuilds.start(build)) return;
+
+  let containerId: string | null = null;
+  let outcome: SpeculativeBuildOutcome = 'failed';
+  try {
+    const networkName = await getOrCreateSessionNetwork(socket.id);
+    containerId = await sessionPool.getOrCreateContainer(language, socket.id, networkName);
+    const seed = plan.cppPlan ? await getBuildSeed(containerId, socket.id, plan.cppPlan) : null;
+    await syncFiles(containerId, socket.id, plan.files, seed ? [seed] : []);
+    if (build.cancelled) {
+      outcome = 'cancelled';
+      return;
+    }
+
+    const execStartedAt = Date.now();
+    const execSession = await execInteractive(containerId, plan.command);
+    speculativeBuilds.onKill(build, () => execSession.kill());
+
+    // Only stderr matters (diagnostics and build markers); keep a bounded prefix
+    const stderrChunks: Buffer[] = [];
+    let stderrBytes = 0;
+    execSession.stdout.resume();
+    execSession.stderr.on('data', (chunk: Buffer) => {
+      if (stderrBytes >= MAX_DIAGNOSTIC_BYTES) return;
+      stderrChunks.push(chunk);
+      stderrBytes += chunk.length;
+    });
+    const timeoutSec = parseInt(config.docker.timeout.replace(/[^0-9]/g, ''), 10);
+    await new Promise<void>((resolve) => {
+      const timer = setTimeout(() => {
+        execSession.kill();
+        resolve();
+      }, (timeoutSec > 0 ? timeoutSec : 30) * 1000);
+      execSession.stderr.on('end', () => {
+        clearTimeout(timer);
+        resolve();
+      });
+    });
+    const execMs = Date.now() - execStartedAt;
+    const code = await execSession.getExitCode().catch(() => -1);
+    const usage = await execSession.getUsage().catch(() => null);
+
+    const { stderr, report } = extractBuildReport(Buffer.concat(stderrChunks).toString('utf-8'));
+    if (plan.cppPlan) {
+      await completeCppBuild(containerId, socket.id, plan.cppPlan, report, seed !== null)
+        .catch(e => logger.error('BuildCache', `Error: ${e}`));
+    } else {
+      completeJavaBuild(containerId, socket.id, plan.key, report);
+    }
+
+    outcome = build.cancelled ? 'cancelled' : code === 0 && report[BUILD_RUN_FIELD] !== undefined ? 'built' : 'failed';
+    if (outcome !== 'cancelled') {
+      const phases = getBuildPhases(report, usage?.wallMs ?? execMs);
+      socket.emit('build:result', {
+        sessionId,
+        language,
+        status: outcome === 'built' ? 'ok' : 'error',
+        diagnostics: stderr.substring(0, MAX_DIAGNOSTIC_BYTES),
+        cached: report.cache === 'hit',
+        ...(phases ? { compileMs: phases.compileMs } : {}),
+      });
+    }
+    logger.debug('SpeculativeBuild', `Session ${socket.id.substring(0, 8)} ${language}: ${outcome} (key ${plan.key.substring(0, 12)})`);
+  } catch (error: any) {
+    logger.warn('SpeculativeBuild', `Build for session ${socket.id.substring(0, 8)} failed: ${error.message}`);
+  } finally {
+    if (containerId) {
+      await sessionPool.returnContainer(containerId, socket.id).catch(err =>
+        logger.error('SpeculativeBuild', `Failed to return container to pool: ${err}`)
+      );
+    }
+    speculativeBuilds.finish(build, outcome);
+  }
+}
+
+// Start Server (directly, or from cluster.ts in each worker)
+export function startServer(): void {
   // Global error handlers to prevent silent exits
   process.on('uncaughtException', (err) => {
     logger.error('Server', `Uncaught Exception: ${err}`);
@@ -1183,19 +1640,40 @@ if (require.main === module) {
     }
     logger.info('Preflight', 'Docker daemon is running');
 
+    // Instances sharing the daemon leave the builds to the one in slot 0
+    const buildsImages = config.cluster.slot === 0;
+
+    // The language images copy cr-agent from agent-runtime, so it is built first
+    const agentImageExists = await imageExists('agent-runtime');
+    if (!agentImageExists && !buildsImages) {
+      logger.warn('Preflight', 'agent-runtime image not found; the instance in cluster slot 0 builds it');
+    } else if (!agentImageExists) {
+      logger.info('Preflight', 'agent-runtime image not found. Building...');
+      try {
+        await execAsync('docker build -t agent-runtime /app/server/runtimes/agent/');
+        logger.info('Preflight', 'Successfully built agent-runtime');
+      } catch (error: any) {
+        logger.error('Preflight', `Failed to build agent-runtime: ${error.message}`);
+      }
+    }
+
     // Check if required runtime images exist via SDK
     const requiredImages = [
       'python-runtime',
       'javascript-runtime',
       'java-runtime',
       'cpp-runtime',
-      'postgres-runtime'
+      'postgres-runtime',
+      // cling for C++ notebooks (kernelManager.ts)
+      ...(config.notebook.cppKernel ? [config.notebook.cppKernelImage] : []),
     ];
 
     for (const imageName of requiredImages) {
       const exists = await imageExists(imageName);
       if (exists) {
         logger.info('Preflight', `${imageName} image found`);
+      } else if (!buildsImages) {
+        logger.warn('Preflight', `${imageName} image not found; the instance in cluster slot 0 builds it`);
       } else {
         logger.info('Preflight', `${imageName} image not found. Building in background...`);
         // Use non-blocking exec so the event loop stays free for health checks
@@ -1212,13 +1690,45 @@ if (require.main === module) {
       }
     }
 
+    // Images are only built on the local daemon; other hosts need them pulled or built there
+    for (const host of dockerHosts.names().slice(1)) {
+      if (!(await pingDaemon(host))) {
+        logger.warn('Preflight', `Docker host ${host} is not reachable; no sessions go there until it answers`);
+        continue;
+      }
+      for (const imageName of ['agent-runtime', ...requiredImages]) {
+        if (!(await imageExists(imageName, host))) {
+          logger.warn('Preflight', `${imageName} image missing on Docker host ${host}`);
+        }
+      }
+    }
+
     logger.info('Preflight', 'Pre-flight checks complete');
   }
 
-  // Session pool uses on-demand containers - no initialization needed
-  logger.info('Server', 'Starting with session-based container pool (on-demand + TTL)');
+  // Session pool creates containers on demand; PREWARM_POOL adds a standby pool
+  logger.info('Server', `Starting with session-based container pool (on-demand + TTL${config.sessionContainers.preWarmPool ? ' + standby' : ''})`);
 
   preflightChecks().then(async () => {
+    // Unreachable Docker hosts are skipped by the cleanup and the pools below
+    await dockerHosts.checkHealth();
+
+    // Join the cluster before any cleanup, so siblings' objects are recognised
+    await clusterState.start(
+      () => {
+        const queue = executionQueue.getStats();
+        return {
+          queued: queue.queued,
+          active: queue.active,
+          sessions: sessionPool.getSessionCount(),
+          containers: sessionPool.getStats().totalContainers,
+        };
+      },
+      (maxConcurrent) => executionQueue.setMaxConcurrent(maxConcurrent),
+    ).catch(err =>
+      logger.error('Server', `Cluster state unavailable, sparing other instances' containers: ${err.message}`)
+    );
+
     // Clean up any orphaned networks from previous runs on startup
     logger.info('Server', 'Cleaning up orphaned networks from previous runs...');
     await cleanupOrphanedNetworks(0).catch(err =>
@@ -1235,6 +1745,23 @@ if (require.main === module) {
       process.exit(1);
     });
 
+    dockerHosts.startHealthChecks();
+    sessionPool.startEventWatch();
+    executionQueue.startAdaptiveConcurrency(() => {
+      const { cpu, memory } = adminMetrics.getSystemMetrics();
+      return { cpu, memory: memory.usagePercentage };
+    });
+    if (config.sessionContainers.preWarmPool) {
+      sessionPool.startStandbyPool();
+    }
+    startNetworkPool();
+    sessionPool.startCheckpoints();
+
+    // Shared SQL backend; SQL runs use per-session containers until it is up
+    sharedPostgres.start().catch(err =>
+      logger.error('Server', `Shared Postgres backend unavailable, using per-session containers: ${err.message}`)
+    );
+
     // Adaptive cleanup intervals based on load
     let containerCleanupInterval = config.sessionContainers.cleanupInterval; // Default 30s
     let networkCleanupInterval = 120000; // Default 2 minutes
@@ -1361,15 +1888,17 @@ if (require.main === module) {
         clearInterval(networkCleanupTimer);
         clearInterval(networkStatsInterval);
         clearInterval(snapshotInterval);
+        dockerHosts.stopHealthChecks();
 
         // Cleanup with timeout
         await Promise.race([
-          sessionPool.cleanupAll(),
+          Promise.all([sessionPool.cleanupAll(), sharedPostgres.stop()]),
           new Promise(resolve => setTimeout(resolve, 3000))
         ]);
+        await clusterState.stop();
 
         await Promise.race([
-          cleanupOrphanedNetworks(0),
+          cleanupOrphanedNetworks(0).then(() => stopNetworkPool()),
           new Promise(resolve => setTimeout(resolve, 2000))
         ]);
 
@@ -1401,4 +1930,8 @@ if (require.main === module) {
   });
 }
 
+if (require.main === module) {
+  startServer();
+}
+
 export default app;
@@ -0,0 +1,98 @@
+/**
+ * Tests for the warm Java runner commands
+ * Covers the daemon run command, its cold fallback and the container command.
+ */
+
+import {
+  javaClassName,
+  javaContainerCommand,
+  javaRunCommand,
+  javaRunTimeoutSeconds,
+  javaBuildKey,
+  COLD_JVM_FLAGS,
+  JAVA_CLASS_CACHE_DIR,
+  JAVA_RUNNER_CLIENT_PATH,
+  JAVA_RUNNER_DAEMON_PATH,
+} from './javaRunner';
+import { buildTimestampCommand, BUILD_RUN_FIELD, BUILD_START_FIELD } from './buildReport';
+
+describe('javaClassName', () => {
+  it('should strip directories and the extension', () => {
+    expect(javaClassName('Main.java')).toBe('Main');
+    expect(javaClassName('src/app/Hello.java')).toBe('Hello');
+  });
+});
+
+describe('javaRunCommand', () => {
+  it('should hand the run to the daemon client with the cold command as fallback', () => {
+    const command = javaRunCommand('Main.java', { daemon: true });
+
+    expect(command.startsWith(`${buildTimestampCommand(BUILD_START_FIELD)}; `)).toBe(true);
+    expect(command).toContain(`if [ -x ${JAVA_RUNNER_CLIENT_PATH} ]; then`);
+    expect(command).toContain(`CR_JAVA_FALLBACK='javac -d . $(find . -name "*.java") && `);
+    expect(command).toContain(`CR_JAVA_TIMEOUT=${javaRunTimeoutSeconds()} exec ${JAVA_RUNNER_CLIENT_PATH} 'Main'`);
+  });
+
+  it('should run the cold command directly when the image has no client', () => {
+    const command = javaRunCommand('Main.java', { daemon: true });
+    expect(command.endsWith(`fi; javac -d . $(find . -name "*.java") && ` +
+      `{ ${buildTimestampCommand(BUILD_RUN_FIELD)}; java ${COLD_JVM_FLAGS} 'Main'; }`)).toBe(true);
+  });
+
+  it('should only use javac and java when the daemon is disabled', () => {
+    const command = javaRunCommand('Main.java', { daemon: false });
+
+    expect(command).not.toContain(JAVA_RUNNER_CLIENT_PATH);
+    expect(command).toContain('javac -d . $(find . -name "*.java") && ');
+    expect(command).toContain(`java ${COLD_JVM_FLAGS} 'Main'`);
+  });
+
+  it('should escape class names in both paths', () => {
+    const command = javaRunCommand("it's.java", { daemon: true });
+    expect(command).toContain(`exec ${JAVA_RUNNER_CLIENT_PATH} 'it'\\''s'`);
+  });
+});
+
+describe('class cache', () => {
+  const files = [
+    { path: 'Main.java', content: 'class Main {}' },
+    { path: 'input.txt', content: '1 2 3' },
+  ];
+
+  it('should key only on the java sources', () => {
+    const key = javaBuildKey(files);
+    expect(key).toMatch(/^[0-9a-f]{64}$/);
+    expect(javaBuildKey([files[0], { path: 'input.txt', content: 'changed' }])).toBe(key);
+    expect(javaBuildKey([{ path: 'Main.java', content: 'class Main { }' }])).not.toBe(key);
+  });
+
+  it('should compile into the cache entry and run from it', () => {
+    const key = javaBuildKey(files);
+    const command = javaRunCommand('Main.java', { daemon: true, key });
+
+    expect(command).toContain(`CR_JAVA_CLASSES=${JAVA_CLASS_CACHE_DIR}/${key} exec ${JAVA_RUNNER_CLIENT_PATH} 'Main'`);
+    expect(command).toContain(`D=${JAVA_CLASS_CACHE_DIR}/${key}; if [ -d "$D" ]; then`);
+    expect(command).toContain('javac -d "$D.tmp" $(find . -name "*.java") && mv "$D.tmp" "$D"');
+    expect(command).toContain(`java ${COLD_JVM_FLAGS} -cp "$D:." 'Main'`);
+  });
+
+  it('should stop after compiling for build-only commands', () => {
+    const command = javaRunCommand('Main.java', { daemon: true, key: 'k', buildOnly: true });
+
+    expect(command).toContain(`exec ${JAVA_RUNNER_CLIENT_PATH} ''`);
+    expect(command).not.toContain(`java ${COLD_JVM_FLAGS}`);
+    expect(command.endsWith(`fi; ${buildTimestampCommand(BUILD_RUN_FIELD)}`)).toBe(true);
+  });
+});
+
+describe('javaContainerCommand', () => {
+  it('should start the daemon when the image has it and idle otherwise', () => {
+    const [shell, flag, script] = javaContainerCommand(true);
+    expect([shell, flag]).toEqual(['/bin/sh', '-c']);
+    expect(script).toBe(`[ -x ${JAVA_RUNNER_DAEMON_PATH} ] && exec ${JAVA_RUNNER_DAEMON_PATH}; exec tail -f /dev/null`);
+  });
+
+  it('should keep the plain idle process when the daemon is disabled', () => {
+    expect(javaContainerCommand(false)).toEqual(['tail', '-f', '/dev/null']);
+  });
+});
@@ -0,0 +1,118 @@
+/**
+ * Warm Java Runner
+ *
+ * Java session containers run cr-java-daemon (runtimes/java/bin) as their main
+ * process. It keeps one JVM resident that compiles with javax.tools in-process
+ * and executes each program in a throwaway class loader with stdio routed to
+ * the run (runtimes/java/runner/CrRunner.java), so a run no longer pays for two
+ * JVM start-ups (javac, then java) and always hits a warmed-up compiler.
+ *
+ * Runs go through the cr-java-run client. The cold `javac && java` command is
+ * passed along as its fallback and used whenever the daemon is not ready (still
+ * starting, restarting after a crash, older image without it) or busy with a
+ * run another exec of the session started.
+ *
+ * Both paths report build phases through the same stderr markers (see
+ * buildReport.ts).
+ *
+ * With JAVA_CLASS_CACHE, classes are compiled into a content-addressed directory
+ * (/app/.coderunner/classes/<key>, like the cpp binary cache) and reruns of
+ * unchanged sources skip javac. Build-only commands fill that cache ahead of a
+ * run (speculativeBuild.ts).
+ */
+
+import { config } from './config';
+import { buildMarkerCommand, buildTimestampCommand, BUILD_RUN_FIELD, BUILD_START_FIELD } from './buildReport';
+import { computeBuildKey } from './cppBuild';
+import { shellEscape } from './shell';
+import type { FileEntry } from './dockerClient';
+
+/** Supervisor baked into the java-runtime image, run as the container's main process */
+export const JAVA_RUNNER_DAEMON_PATH = '/opt/coderunner/bin/cr-java-daemon';
+
+/** Spool directory shared by the daemon and its client; `ready` exists while the daemon accepts runs */
+export const JAVA_RUNNER_SPOOL = '/home/runner/.cr-java';
+
+/** Per-run client of the daemon */
+export const JAVA_RUNNER_CLIENT_PATH = '/opt/coderunner/bin/cr-java-run';
+
+/** Class cache directory inside the container, relative to /app */
+export const JAVA_CLASS_CACHE_DIR = '.coderunner/classes';
+
+/** Class cache entries kept per container; older ones are evicted on each miss */
+const MAX_CACHED_CLASSES = 8;
+
+export interface JavaRunOptions {
+  /** Send the run to the warm daemon (default: config.javaRunner.daemon) */
+  daemon?: boolean;
+  /** Class cache key of the sources (javaBuildKey); empty compiles into /app */
+  key?: string;
+  /** Compile into the class cache without running anything */
+  buildOnly?: boolean;
+}
+
+// -XX:TieredStopAtLevel=1  → only C1 compiler (fast startup, skip C2 optimiser)
+// -XX:+UseSerialGC         → minimal GC overhead for short-lived processes
+// -Xshare:auto             → use CDS archive baked into the image
+// -Xms8m -Xmx256m         → small heap to reduce GC pauses and startup cost
+export const COLD_JVM_FLAGS = '-XX:TieredStopAtLevel=1 -XX:+UseSerialGC -Xshare:auto -Xms8m -Xmx256m';
+
+/** Main class of an entry file: "src/Main.java" → "Main" */
+export function javaClassName(entryFile: string): string {
+  return entryFile.split('/').pop()?.replace('.java', '') || entryFile.replace('.java', '');
+}
+
+/** Seconds a daemon run may take before the daemon gives up on it (DOCKER_TIMEOUT) */
+export function javaRunTimeoutSeconds(): number {
+  const seconds = parseInt(config.docker.timeout.replace(/[^0-9]/g, ''), 10);
+  return seconds > 0 ? seconds : 30;
+}
+
+/**
+ * Class cache key: a content hash over the .java sources plus the runtime
+ * image. Empty when the class cache is disabled.
+ */
+export function javaBuildKey(files: FileEntry[]): string {
+  if (!config.javaRunner.classCache) return '';
+  const sources = files.filter(f => f.path.endsWith('.java'));
+  return computeBuildKey(sources, ['javac', config.runtimes.java.image]);
+}
+
+/** Separate javac and java processes; the start marker is printed by the caller */
+function coldCommand(className: string, key: string, buildOnly: boolean): string {
+  const classPath = key ? '-cp "$D:." ' : '';
+  const run = buildOnly
+    ? buildTimestampCommand(BUILD_RUN_FIELD)
+    : `{ ${buildTimestampCommand(BUILD_RUN_FIELD)}; java ${COLD_JVM_FLAGS} ${classPath}${shellEscape(className)}; }`;
+  if (!key) {
+    return `javac -d . $(find . -name "*.java") && ${run}`;
+  }
+  // Compiled next to the entry and renamed into place, so an entry is always complete
+  return `D=${JAVA_CLASS_CACHE_DIR}/${key}; if [ -d "$D" ]; then ${buildMarkerCommand('cache', 'hit')}; else ` +
+    `${buildMarkerCommand('cache', 'miss')}; rm -rf "$D.tmp"; ` +
+    `mkdir -p "$D.tmp" && javac -d "$D.tmp" $(find . -name "*.java") && mv "$D.tmp" "$D" || { rm -rf "$D.tmp"; exit 1; }; ` +
+    `ls -t ${JAVA_CLASS_CACHE_DIR} | sed '1,${MAX_CACHED_CLASSES}d' | while read -r f; do rm -rf "${JAVA_CLASS_CACHE_DIR}/$f"; done; fi; ${run}`;
+}
+
+/** Shell command for a java run (or, with buildOnly, just its compile step), executed in /app */
+export function javaRunCommand(entryFile: string, options: JavaRunOptions = {}): string {
+  const { daemon = config.javaRunner.daemon, key = '', buildOnly = false } = options;
+  // The daemon stops after compiling when given no main class
+  const className = buildOnly ? '' : javaClassName(entryFile);
+  const start = buildTimestampCommand(BUILD_START_FIELD);
+  const cold = coldCommand(className, key, buildOnly);
+  if (!daemon) {
+    return `${start}; ${cold}`;
+  }
+  // The daemon prints the cache and run markers itself
+  const classes = key ? `CR_JAVA_CLASSES=${JAVA_CLASS_CACHE_DIR}/${key} ` : '';
+  return `${start}; if [ -x ${JAVA_RUNNER_CLIENT_PATH} ]; then ` +
+    `CR_JAVA_FALLBACK=${shellEscape(cold)} CR_JAVA_TIMEOUT=${javaRunTimeoutSeconds()} ${classes}` +
+    `exec ${JAVA_RUNNER_CLIENT_PATH} ${shellEscape(className)}; fi; ${cold}`;
+}
+
+/** Main process of java containers: the daemon if the image has it, else idle */
+export function javaContainerCommand(daemon = config.javaRunner.daemon): string[] {
+  if (!daemon) return ['tail', '-f', '/dev/null'];
+  return ['/bin/sh', '-c', `[ -x ${JAVA_RUNNER_DAEMON_PATH} ] && exec ${JAVA_RUNNER_DAEMON_PATH}; exec tail -f /dev/null`];
+}
@@ -0,0 +1,60 @@
+/**
+ * Tests for notebook kernel languages
+ * Covers language names from notebook metadata and the C++ (cling) kernel driver.
+ */
+
+jest.mock('./networkManager', () => ({
+  getOrCreateSessionNetwork: jest.fn().mockResolvedValue('net-1'),
+}));
+
+jest.mock('./dockerClient', () => ({
+  createContainer: jest.fn().mockResolvedValue('container-1'),
+  startContainer: jest.fn().mockResolvedValue(undefined),
+  execInteractive: jest.fn(),
+  putFiles: jest.fn().mockResolvedValue(0),
+  removeContainers: jest.fn().mockResolvedValue(undefined),
+}));
+
+import { config } from './config';
+import * as dockerClient from './dockerClient';
+import { cppKernelScript, kernelManager, normalizeKernelLanguage } from './kernelManager';
+
+describe('normalizeKernelLanguage', () => {
+  it('should map Jupyter language names to kernels', () => {
+    expect(normalizeKernelLanguage('python')).toBe('python');
+    expect(normalizeKernelLanguage('Python3')).toBe('python');
+    expect(normalizeKernelLanguage('c++')).toBe('cpp');
+    expect(normalizeKernelLanguage('C++17')).toBe('cpp');
+    expect(normalizeKernelLanguage('xcpp17')).toBe('cpp');
+    expect(normalizeKernelLanguage('java')).toBeNull();
+  });
+
+  it('should have no C++ kernel when it is disabled', () => {
+    const enabled = config.notebook.cppKernel;
+    config.notebook.cppKernel = false;
+    try {
+      expect(normalizeKernelLanguage('cpp')).toBeNull();
+    } finally {
+      config.notebook.cppKernel = enabled;
+    }
+  });
+});
+
+describe('cppKernelScript', () => {
+  it('should feed cells to one cling process between cell markers', () => {
+    const script = cppKernelScript('c++20');
+    expect(script).toContain('exec cling --nologo -std=c++20');
+    expect(script).toContain("marker '___CELL_START___' \"$id\"");
+    expect(script).toContain("marker '___CELL_END___' \"$id\"");
+    expect(script).toContain('base64 -d');
+    // Unfinished multi-line input is dropped before the end marker
+    expect(script.indexOf('.@')).toBeLessThan(script.indexOf("marker '___CELL_END___'"));
+  });
+});
+
+describe('KernelManager.startKernel', () => {
+  it('should reject languages without a kernel before creating anything', async () => {
+    await expect(kernelManager.startKernel('nb-1', 'socket-1', 'java')).rejects.toThrow('Unsupported language');
+    expect(dockerClient.createContainer).not.toHaveBeenCalled();
+  });
+});
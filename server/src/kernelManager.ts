@@ -14,8 +14,11 @@ import {
 /**
  * Kernel Manager for Jupyter-like Notebook Execution
  * 
- * Manages persistent Python kernel processes for notebooks.
+ * Manages persistent Python and C++ kernel processes for notebooks.
  * Each notebook gets its own kernel that maintains state between cell executions.
+ * C++ kernels drive cling, an incremental interpreter: a cell is JIT-compiled
+ * into the running process on top of the earlier cells, so it costs tens of
+ * milliseconds rather than a rebuild of the whole notebook.
  * 
  * SECURITY: All Docker operations use the dockerode SDK (via dockerClient.ts).
  * No shell commands are spawned, eliminating command injection risks.
@@ -152,6 +155,92 @@ while True:
         print(f'Kernel error: {e}', file=sys.stderr, flush=True)
 `;
 
+/**
+ * C++ kernel driver: turns the kernel protocol on stdin into cling input.
+ * The markers are printed by cling itself (std::puts + fflush), so they stay in
+ * order with the cell's own output. `.@` after each cell drops unfinished
+ * multi-line input (unbalanced braces), so the end marker always runs.
+ */
+export function cppKernelScript(standard: string = config.notebook.cppStandard): string {
+  return `
+marker() { printf 'std::puts("%s%s"); std::fflush(stdout);\\n' "$1" "$2"; }
+{
+  printf '#include <cstdio>\\n#include <iostream>\\n#include <string>\\n#include <vector>\\n'
+  printf '#include <map>\\n#include <algorithm>\\n#include <cmath>\\n'
+  marker __KERNEL_READY__ ''
+  while IFS= read -r line; do
+    case "$line" in
+      __EXEC__:*)
+        rest=\${line#__EXEC__:}
+        id=$(printf '%s' "\${rest%%:*}" | tr -cd 'A-Za-z0-9_.-')
+        marker '${CELL_START_MARKER}' "$id"
+        printf '%s' "\${rest#*:}" | base64 -d
+        printf '\\n.@\\n'
+        marker '${CELL_END_MARKER}' "$id"
+        ;;
+      __SHUTDOWN__) break ;;
+    esac
+  done
+  printf '.q\\n'
+} | exec cling --nologo -std=${standard}
+`;
+}
+
+/**
+ * How each notebook language's kernel is run
+ */
+interface KernelSpec {
+  image: () => string;
+  /** Driver written to /app, then started with `command` */
+  scriptPath: string;
+  script: () => string;
+  command: string;
+  /** Sends SIGINT to the running cell */
+  interruptCommand: string;
+  /** Drops interpreter noise from an output line */
+  cleanLine: (line: string) => string;
+  /** Whether a stderr chunk reports a failed cell */
+  isError: (text: string) => boolean;
+}
+
+// Prompts cling may print even without a terminal
+const CLING_PROMPT = /^(\[cling\][$?] ?)+/;
+
+const KERNEL_SPECS: Record<string, KernelSpec> = {
+  python: {
+    image: () => config.runtimes.python.image,
+    scriptPath: 'kernel.py',
+    script: () => PYTHON_KERNEL_SCRIPT,
+    command: 'python -u /app/kernel.py',
+    interruptCommand: 'pkill -SIGINT -f kernel.py',
+    cleanLine: line => line,
+    isError: text => text.includes(CELL_ERROR_MARKER),
+  },
+  cpp: {
+    image: () => config.notebook.cppKernelImage,
+    scriptPath: 'kernel.sh',
+    script: () => cppKernelScript(),
+    command: 'sh /app/kernel.sh',
+    interruptCommand: 'pkill -SIGINT -x cling',
+    cleanLine: line => line.replace(CLING_PROMPT, ''),
+    // Compiler diagnostics ("input_line_7:2:3: error: ...")
+    isError: text => /(^|\s)(fatal )?error: /.test(text),
+  },
+};
+
+/**
+ * Kernel language for a notebook's language name (Jupyter metadata uses e.g.
+ * "c++" or "C++17"), or null when there is no kernel for it.
+ */
+export function normalizeKernelLanguage(language: string): string | null {
+  const name = language.toLowerCase();
+  if (name === 'python' || name === 'python3') return 'python';
+  if (/^(cpp|c\+\+|cxx|xcpp)(\d+)?$/.test(name)) {
+    return config.notebook.cppKernel ? 'cpp' : null;
+  }
+  return null;
+}
+
 class KernelManager {
   // Map: kernelId -> KernelSession
   private kernels: Map<string, KernelSession> = new Map();
@@ -209,8 +298,13 @@ class KernelManager {
   async startKernel(
     notebookId: string,
     socketId: string,
-    language: string = 'python'
+    requestedLanguage: string = 'python'
   ): Promise<string> {
+    const language = normalizeKernelLanguage(requestedLanguage);
+    if (!language) {
+      throw new Error(`Unsupported language for kernel: ${requestedLanguage}`);
+    }
+
     // Check if kernel already exists for this notebook
     const existingKernelId = this.notebookKernels.get(notebookId);
     if (existingKernelId) {
@@ -247,7 +341,7 @@ class KernelManager {
       this.kernels.set(kernelId, session);
       this.notebookKernels.set(notebookId, kernelId);
 
-      // Start the Python kernel process
+      // Start the kernel process
       await this.startKernelProcess(session);
 
       session.status = 'idle';
@@ -271,13 +365,13 @@ class KernelManager {
     networkName: string,
     language: string
   ): Promise<string> {
-    const runtimeConfig = config.runtimes[language as keyof typeof config.runtimes];
-    if (!runtimeConfig) {
+    const spec = KERNEL_SPECS[language];
+    if (!spec) {
       throw new Error(`Unsupported language for kernel: ${language}`);
     }
 
     const containerId = await dockerCreateContainer({
-      image: runtimeConfig.image,
+      image: spec.image(),
       labels: {
         'type': 'coderunner-kernel',
         'kernel': kernelId,
@@ -296,21 +390,23 @@ class KernelManager {
   }
 
   /**
-   * Start the Python kernel process inside the container via SDK.
+   * Start the kernel process inside the container via SDK.
    * SECURITY: Uses putFiles() + execInteractive() instead of docker cp + docker exec CLI.
    */
   private async startKernelProcess(session: KernelSession): Promise<void> {
+    const spec = KERNEL_SPECS[session.language];
+
     // Stream kernel script directly into container via SDK (zero host I/O for docker cp)
     const kernelFile: FileEntry = {
-      path: 'kernel.py',
-      content: PYTHON_KERNEL_SCRIPT,
+      path: spec.scriptPath,
+      content: spec.script(),
     };
     await putFiles(session.containerId, [kernelFile]);
 
     // Start the kernel process via SDK interactive exec (replaces spawn('docker', ['exec', ...]))
     const execSession = await execInteractive(
       session.containerId,
-      'python -u /app/kernel.py',
+      spec.command,
     );
 
     session.process = execSession;
@@ -325,18 +421,16 @@ class KernelManager {
         reject(new Error('Kernel startup timeout'));
       }, 30000);
 
-      const checkReady = (text: string) => {
-        if (text.includes('__KERNEL_READY__')) {
+      // Check stdout for ready signal (an interpreter may print before it)
+      const checkReady = (data: Buffer) => {
+        if (data.toString().includes('__KERNEL_READY__')) {
           isReady = true;
           clearTimeout(timeout);
+          execSession.stdout.removeListener('data', checkReady);
           resolve();
         }
       };
-
-      // Check stdout for ready signal
-      execSession.stdout.once('data', (data: Buffer) => {
-        checkReady(data.toString());
-      });
+      execSession.stdout.on('data', checkReady);
 
       execSession.stdout.on('error', (err: Error) => {
         clearTimeout(timeout);
@@ -368,7 +462,8 @@ class KernelManager {
       const lines = currentOutput.split('\n');
       currentOutput = lines.pop() || '';  // Keep incomplete line
 
-      for (const line of lines) {
+      for (const rawLine of lines) {
+        const line = spec.cleanLine(rawLine);
         if (line.startsWith(CELL_START_MARKER)) {
           currentCellId = line.substring(CELL_START_MARKER.length);
         } else if (line.startsWith(CELL_END_MARKER)) {
@@ -404,9 +499,8 @@ class KernelManager {
       const text = data.toString();
       logger.debug('KernelManager', `stderr: ${text}`);
       if (currentCellId) {
-        const isErrorMarker = text.includes(CELL_ERROR_MARKER);
         this.emitOutput(session.kernelId, {
-          type: isErrorMarker ? 'error' : 'stderr',
+          type: spec.isError(text) ? 'error' : 'stderr',
           content: text.replace(CELL_ERROR_MARKER, ''),
           cellId: currentCellId,
         });
@@ -475,7 +569,7 @@ class KernelManager {
       try {
         // Use SDK to execute pkill inside the container (no shell interpolation)
         const { execInContainer } = await import('./dockerClient');
-        await execInContainer(session.containerId, 'pkill -SIGINT -f kernel.py', { timeout: 5000 });
+        await execInContainer(session.containerId, KERNEL_SPECS[session.language].interruptCommand, { timeout: 5000 });
         logger.info('KernelManager', `Interrupted kernel ${kernelId}`);
       } catch (error) {
         logger.error('KernelManager', `Failed to interrupt kernel: ${error}`);
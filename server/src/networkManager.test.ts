@@ -1,5 +1,36 @@
-import { getNetworkName, getNetworkMetrics, resetNetworkMetrics, getSubnetStats } from './networkManager';
+import {
+    getNetworkName,
+    getNetworkMetrics,
+    resetNetworkMetrics,
+    getSubnetStats,
+    getOrCreateSessionNetwork,
+    deleteSessionNetwork,
+    startNetworkPool,
+    stopNetworkPool,
+    getNetworkPoolStats,
+    listReapableSessionNetworks,
+} from './networkManager';
 import { config } from './config';
+import { clusterState } from './clusterState';
+import * as dockerClient from './dockerClient';
+
+jest.mock('./dockerClient', () => ({
+    createNetwork: jest.fn().mockResolvedValue('mock-network-id'),
+    networkExists: jest.fn().mockResolvedValue(false),
+    inspectNetwork: jest.fn().mockResolvedValue({ created: new Date().toISOString(), subnet: '', containerCount: 0 }),
+    removeNetwork: jest.fn().mockResolvedValue(undefined),
+    listNetworks: jest.fn().mockResolvedValue([]),
+    listNetworkDetails: jest.fn().mockResolvedValue([]),
+    disconnectAllFromNetwork: jest.fn().mockResolvedValue(undefined),
+    pruneNetworks: jest.fn().mockResolvedValue([]),
+}));
+
+const mockDocker = dockerClient as jest.Mocked<typeof dockerClient>;
+
+/** Let background pool refills finish */
+async function flush(): Promise<void> {
+    for (let i = 0; i < 5; i++) await new Promise(resolve => setImmediate(resolve));
+}
 
 describe('networkManager', () => {
     describe('getNetworkName', () => {
@@ -80,4 +111,73 @@ describe('networkManager', () => {
             expect(stats.poolStats.pool2.utilization).toContain('%');
         });
     });
+
+    describe('network pool', () => {
+        afterEach(async () => {
+            await stopNetworkPool();
+            await flush();
+            jest.clearAllMocks();
+        });
+
+        it('should create networks on the configured subnet pools', async () => {
+            const name = await getOrCreateSessionNetwork('no-pool');
+            expect(name).toBe(`${config.network.sessionNetworkPrefix}no-pool`);
+            const opts = mockDocker.createNetwork.mock.calls[0][0];
+            expect(opts.subnet.startsWith(`${config.network.subnetPools[0].base}.`)).toBe(true);
+            expect(opts.labels).toEqual({ type: 'coderunner', session: 'no-pool' });
+        });
+
+        it('should lease a pre-created network and recycle it when the session ends', async () => {
+            startNetworkPool();
+            await flush();
+            expect(mockDocker.createNetwork).toHaveBeenCalledTimes(config.network.poolSize);
+
+            const name = await getOrCreateSessionNetwork('s1');
+            expect(name).toContain(`${config.network.sessionNetworkPrefix}pool-`);
+            expect(getNetworkName('s1')).toBe(name);
+
+            mockDocker.networkExists.mockResolvedValueOnce(true);
+            expect(await getOrCreateSessionNetwork('s1')).toBe(name);
+
+            await deleteSessionNetwork('s1');
+            expect(mockDocker.disconnectAllFromNetwork).toHaveBeenCalledWith(name);
+            expect(mockDocker.removeNetwork).not.toHaveBeenCalled();
+            expect(getNetworkName('s1')).toBe(`${config.network.sessionNetworkPrefix}s1`);
+            expect(getNetworkPoolStats().recycled).toBeGreaterThanOrEqual(1);
+        });
+
+        it('should give concurrent first calls of a session the same network', async () => {
+            startNetworkPool();
+            await flush();
+            mockDocker.networkExists.mockResolvedValue(true);
+
+            const [a, b] = await Promise.all([getOrCreateSessionNetwork('s2'), getOrCreateSessionNetwork('s2')]);
+            expect(a).toBe(b);
+            expect(getNetworkPoolStats().leased).toBe(1);
+            mockDocker.networkExists.mockResolvedValue(false);
+        });
+
+        it('should delete a leased network instead of recycling it after a failed setup', async () => {
+            startNetworkPool();
+            await flush();
+
+            const name = await getOrCreateSessionNetwork('s3');
+            await deleteSessionNetwork('s3', false);
+            expect(mockDocker.removeNetwork).toHaveBeenCalledWith(name);
+        });
+    });
+
+    describe('listReapableSessionNetworks', () => {
+        it('should leave out fresh networks of other instances', async () => {
+            const old = Date.now() - 60 * 60 * 1000;
+            (mockDocker.listNetworkDetails as jest.Mock).mockResolvedValueOnce([
+                { name: 'mine', created: Date.now(), labels: { instance: clusterState.instanceId }, host: 'local' },
+                { name: 'unlabelled', created: old, labels: {}, host: 'local' },
+                { name: 'dead', created: old, labels: { instance: 'gone-host-1' }, host: 'local' },
+                { name: 'fresh', created: Date.now(), labels: { instance: 'gone-host-2' }, host: 'local' },
+            ]);
+
+            expect(await listReapableSessionNetworks()).toEqual(['mine', 'unlabelled', 'dead']);
+        });
+    });
 });
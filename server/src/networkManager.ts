@@ -6,9 +6,12 @@ import {
   inspectNetwork as dockerInspectNetwork,
   removeNetwork as dockerRemoveNetwork,
   listNetworks as dockerListNetworks,
+  listNetworkDetails,
   disconnectAllFromNetwork,
   pruneNetworks,
 } from './dockerClient';
+import { dockerHosts } from './dockerHosts';
+import { clusterState, INSTANCE_LABEL } from './clusterState';
 
 /**
  * Network Manager for Session-based Docker Networks
@@ -66,28 +69,32 @@ export function resetNetworkMetrics(): void {
 
 /**
  * Subnet Allocator - Manages IP subnet allocation from custom pools
- * Uses explicit subnet assignment to avoid Docker IPAM race conditions
+ * Uses explicit subnet assignment to avoid Docker IPAM race conditions.
+ * Instances sharing a Docker daemon each take every CLUSTER_SLOTS-th /28,
+ * starting at their CLUSTER_SLOT, so their subnets never overlap.
  */
 class SubnetAllocator {
   private usedSubnets: Set<string> = new Set();
   private poolCounters: Map<string, number> = new Map();
+  private readonly slot = config.cluster.slot;
+  private readonly slots = config.cluster.slots;
 
   constructor() {
     // Initialize counters for each pool
     for (const pool of config.network.subnetPools) {
-      this.poolCounters.set(pool.name, 0);
+      this.poolCounters.set(pool.name, this.slot);
     }
   }
 
   allocateSubnet(): string | null {
     // Try each pool in order
     for (const pool of config.network.subnetPools) {
-      const counter = this.poolCounters.get(pool.name) || 0;
+      const counter = this.poolCounters.get(pool.name) ?? this.slot;
 
       if (counter < pool.capacity) {
         const subnet = this.generateSubnet(pool, counter);
         if (subnet) {
-          this.poolCounters.set(pool.name, counter + 1);
+          this.poolCounters.set(pool.name, counter + this.slots);
           this.usedSubnets.add(subnet);
           return subnet;
         }
@@ -106,12 +113,10 @@ class SubnetAllocator {
     // counter 16  → 10.x.1.0/28   etc.
     const third = Math.floor(counter / 16);   // 0..255
     const fourth = (counter % 16) * 16;       // 0,16,32..240
-    if (pool.name === 'pool1') {
-      return `10.201.${third}.${fourth}/28`;
-    } else if (pool.name === 'pool2') {
-      return `10.202.${third}.${fourth}/28`;
+    if (!pool.base) {
+      return null;
     }
-    return null;
+    return `${pool.base}.${third}.${fourth}/28`;
   }
 
   releaseSubnet(subnet: string): void {
@@ -127,14 +132,17 @@ class SubnetAllocator {
     };
 
     for (const pool of config.network.subnetPools) {
-      const used = this.poolCounters.get(pool.name) || 0;
+      // Counted within this instance's slice of the pool
+      const counter = this.poolCounters.get(pool.name) ?? this.slot;
+      const used = Math.ceil(Math.max(0, counter - this.slot) / this.slots);
+      const available = Math.ceil(Math.max(0, pool.capacity - this.slot) / this.slots);
       stats.poolStats[pool.name] = {
         used,
-        available: pool.capacity,
-        utilization: ((used / pool.capacity) * 100).toFixed(2) + '%',
+        available,
+        utilization: available > 0 ? ((used / available) * 100).toFixed(2) + '%' : '0.00%',
       };
       stats.totalUsed += used;
-      stats.totalAvailable += pool.capacity;
+      stats.totalAvailable += available;
     }
 
     return stats;
@@ -156,6 +164,38 @@ let emergencyCleanupRunning = false;
 let lastEmergencyCleanup = 0;
 const EMERGENCY_CLEANUP_COOLDOWN = 5000; // 5 seconds minimum between emergency cleanups
 
+/**
+ * Pre-created network pool (NETWORK_POOL_SIZE > 0)
+ *
+ * Creating a bridge network is a daemon round trip plus bridge/iptables setup
+ * and dominates a session's first run. Pool networks are created ahead of
+ * demand under neutral names (`<prefix>pool-…`), leased to a session on its
+ * first getOrCreateSessionNetwork call and refilled in the background. When the
+ * session ends the network is emptied and goes back to the free list instead of
+ * being removed, up to NETWORK_POOL_MAX free networks. With several Docker
+ * hosts, each host accepting sessions keeps its own NETWORK_POOL_SIZE networks.
+ */
+interface PoolNetwork {
+  sessionId: string | null; // null while free
+  leasedAt: number;
+}
+
+const poolNetworks: Map<string, PoolNetwork> = new Map();
+/** Free pool networks (of all hosts), oldest first */
+const freeNetworks: string[] = [];
+/** sessionId -> leased pool network */
+const leasedNetworks: Map<string, string> = new Map();
+let poolNetworkSeq = 0;
+/** host -> pool networks being created there */
+const poolNetworksCreating: Map<string, number> = new Map();
+let networkPoolTimer: NodeJS.Timeout | null = null;
+/** Bumped on stop/discard so in-flight creations don't land in a stale pool */
+let networkPoolGeneration = 0;
+const networkPoolCounters = { hits: 0, misses: 0, recycled: 0 };
+
+/** Orphan cleanup leaves a leased network alone for at least this long */
+const LEASE_GRACE_MS = 30000;
+
 /**
  * Check if a Docker network exists (via SDK, no process spawn)
  */
@@ -169,8 +209,35 @@ export async function networkExists(networkName: string): Promise<boolean> {
  * try to create the same network simultaneously
  */
 export async function getOrCreateSessionNetwork(sessionId: string): Promise<string> {
+  // The session's containers are created on the same host (see pool.ts)
+  const host = dockerHosts.placeSession(sessionId);
+
+  const leased = leasedNetworks.get(sessionId);
+  if (leased) {
+    if (await networkExists(leased)) {
+      return leased;
+    }
+    // Removed behind our back (e.g. pruned); lease another one below
+    logger.warn('NetworkManager', `Leased network ${leased} disappeared, replacing it`);
+    leasedNetworks.delete(sessionId);
+    poolNetworks.delete(leased);
+  }
+
   const networkName = `${config.network.sessionNetworkPrefix}${sessionId}`;
 
+  // Check if another request is already creating this network
+  const pendingCreation = pendingNetworkCreations.get(networkName);
+  if (pendingCreation) {
+    logger.debug('NetworkManager', `Waiting for pending network creation: ${networkName}`);
+    return await pendingCreation;
+  }
+
+  // Pool path: synchronous, so a concurrent call for the same session sees the lease
+  const pooled = leasePoolNetwork(sessionId, host);
+  if (pooled) {
+    return pooled;
+  }
+
   // Fast path: if network exists, return immediately
   const exists = await networkExists(networkName);
   if (exists) {
@@ -178,15 +245,14 @@ export async function getOrCreateSessionNetwork(sessionId: string): Promise<stri
     return networkName;
   }
 
-  // Check if another request is already creating this network
-  const pendingCreation = pendingNetworkCreations.get(networkName);
-  if (pendingCreation) {
-    logger.debug('NetworkManager', `Waiting for pending network creation: ${networkName}`);
-    return await pendingCreation;
+  // The existence check yielded; another request may have started creating it
+  const raced = pendingNetworkCreations.get(networkName);
+  if (raced) {
+    return await raced;
   }
 
   // Create the network with mutex protection
-  const creationPromise = createSessionNetworkWithRetry(sessionId);
+  const creationPromise = createSessionNetworkWithRetry(sessionId, host);
   pendingNetworkCreations.set(networkName, creationPromise);
 
   try {
@@ -209,11 +275,28 @@ export async function listSessionNetworks(): Promise<string[]> {
   }
 }
 
+/**
+ * Session networks the cleanups may remove: this instance's, and those of
+ * instances that are gone. A live sibling's networks are its own business.
+ */
+export async function listReapableSessionNetworks(): Promise<string[]> {
+  try {
+    const now = Date.now();
+    const networks = await listNetworkDetails(config.network.sessionNetworkPrefix);
+    return networks
+      .filter(n => clusterState.mayReap(n.labels[INSTANCE_LABEL], n.created, now))
+      .map(n => n.name);
+  } catch (error) {
+    logger.error('NetworkManager', `Failed to list session networks: ${error}`);
+    return [];
+  }
+}
+
 /**
  * Get network name from session ID
  */
 export function getNetworkName(sessionId: string): string {
-  return `${config.network.sessionNetworkPrefix}${sessionId}`;
+  return leasedNetworks.get(sessionId) ?? `${config.network.sessionNetworkPrefix}${sessionId}`;
 }
 
 /**
@@ -226,12 +309,12 @@ export function getSubnetStats() {
 /**
  * Create session network with retry logic and exponential backoff
  */
-async function createSessionNetworkWithRetry(sessionId: string, maxRetries: number = 3): Promise<string> {
+async function createSessionNetworkWithRetry(sessionId: string, host: string, maxRetries: number = 3): Promise<string> {
   const networkName = `${config.network.sessionNetworkPrefix}${sessionId}`;
 
   for (let attempt = 1; attempt <= maxRetries; attempt++) {
     try {
-      return await createSessionNetwork(sessionId);
+      return await createSessionNetwork(sessionId, host);
     } catch (error: any) {
       // If network already exists (race condition), verify and return
       if (error.message.includes('already exists')) {
@@ -261,7 +344,10 @@ async function createSessionNetworkWithRetry(sessionId: string, maxRetries: numb
  * Create a session network with explicit subnet allocation via Docker SDK.
  * Eliminates shell process spawning overhead.
  */
-export async function createSessionNetwork(sessionId: string): Promise<string> {
+export async function createSessionNetwork(
+  sessionId: string,
+  host: string = dockerHosts.placeSession(sessionId),
+): Promise<string> {
   const networkName = `${config.network.sessionNetworkPrefix}${sessionId}`;
 
   // Double-check if network already exists (could have been created concurrently)
@@ -271,6 +357,13 @@ export async function createSessionNetwork(sessionId: string): Promise<string> {
     return networkName;
   }
 
+  return createNetworkWithSubnet(networkName, { 'session': sessionId }, host);
+}
+
+/**
+ * Allocate a subnet and create a labelled CodeRunner network on it.
+ */
+async function createNetworkWithSubnet(networkName: string, labels: Record<string, string>, host: string): Promise<string> {
   // Allocate a subnet from configured pools
   const subnet = subnetAllocator.allocateSubnet();
   if (!subnet) {
@@ -278,15 +371,16 @@ export async function createSessionNetwork(sessionId: string): Promise<string> {
   }
 
   try {
-    logger.info('NetworkManager', `Creating network: ${networkName} with subnet ${subnet}`);
+    logger.info('NetworkManager', `Creating network: ${networkName} with subnet ${subnet} on ${host}`);
     await dockerCreateNetwork({
       name: networkName,
       driver: config.network.networkDriver,
       subnet,
       labels: {
         'type': 'coderunner',
-        'session': sessionId,
+        ...labels,
       },
+      host,
     });
     networkMetrics.networksCreated++;
     logger.info('NetworkManager', `Network created: ${networkName}`);
@@ -322,11 +416,36 @@ export async function createSessionNetwork(sessionId: string): Promise<string> {
 }
 
 /**
- * Delete a Docker network and release its subnet (via SDK)
+ * Release a session's network. A leased pool network is emptied and returned to
+ * the pool unless `recycle` is false (e.g. after a failed setup) or the pool is
+ * full; anything else is deleted.
  */
-export async function deleteSessionNetwork(sessionId: string): Promise<void> {
-  const networkName = `${config.network.sessionNetworkPrefix}${sessionId}`;
+export async function deleteSessionNetwork(sessionId: string, recycle: boolean = true): Promise<void> {
+  // Without its network the session can be placed on any host again
+  dockerHosts.releaseSession(sessionId);
+
+  const leased = leasedNetworks.get(sessionId);
+  if (leased) {
+    leasedNetworks.delete(sessionId);
+    const entry = poolNetworks.get(leased);
+    if (entry) {
+      entry.sessionId = null;
+      if (recycle && await recyclePoolNetwork(leased)) {
+        return;
+      }
+      poolNetworks.delete(leased);
+    }
+    await removeSessionNetwork(leased);
+    return;
+  }
+
+  await removeSessionNetwork(`${config.network.sessionNetworkPrefix}${sessionId}`);
+}
 
+/**
+ * Delete a Docker network and release its subnet (via SDK)
+ */
+async function removeSessionNetwork(networkName: string): Promise<void> {
   try {
     // Get subnet before deleting so we can release it
     let subnet = '';
@@ -352,13 +471,181 @@ export async function deleteSessionNetwork(sessionId: string): Promise<void> {
   }
 }
 
+/**
+ * Hand a free pool network on the session's host to the session, or null when
+ * the pool is off or has none there.
+ */
+function leasePoolNetwork(sessionId: string, host: string): string | null {
+  if (!networkPoolTimer) return null;
+
+  const index = freeNetworks.findIndex(name => dockerHosts.networkHost(name) === host);
+  const networkName = index >= 0 ? freeNetworks.splice(index, 1)[0] : undefined;
+  // Refill in the background while this one is handed out
+  replenishNetworkPool().catch(e => logger.error('NetworkManager', `Network pool refill failed: ${e}`));
+  if (!networkName) {
+    networkPoolCounters.misses++;
+    return null;
+  }
+
+  poolNetworks.set(networkName, { sessionId, leasedAt: Date.now() });
+  leasedNetworks.set(sessionId, networkName);
+  networkPoolCounters.hits++;
+  logger.debug('NetworkManager', `Leased pool network ${networkName} to ${sessionId}`);
+  return networkName;
+}
+
+/**
+ * Empty a released pool network and put it back on the free list.
+ * Returns false when it should be deleted instead.
+ */
+async function recyclePoolNetwork(networkName: string): Promise<boolean> {
+  const host = dockerHosts.networkHost(networkName);
+  if (!networkPoolTimer || !dockerHosts.accepting(host) || freeOn(host).length >= config.network.poolMax) {
+    return false;
+  }
+  const generation = networkPoolGeneration;
+
+  try {
+    await disconnectAllFromNetwork(networkName);
+    const info = await dockerInspectNetwork(networkName);
+    if (info.containerCount > 0) {
+      return false;
+    }
+  } catch {
+    return false;
+  }
+
+  // Stopped or discarded meanwhile, or leased again by a racing cleanup
+  if (generation !== networkPoolGeneration || poolNetworks.get(networkName)?.sessionId !== null) {
+    return false;
+  }
+  freeNetworks.push(networkName);
+  networkPoolCounters.recycled++;
+  logger.debug('NetworkManager', `Recycled pool network ${networkName}`);
+  return true;
+}
+
+/**
+ * Create pool networks until NETWORK_POOL_SIZE are free on every host that
+ * accepts sessions (counting ones in flight). Free networks of hosts that
+ * stopped accepting sessions are deleted.
+ */
+export async function replenishNetworkPool(): Promise<void> {
+  if (!networkPoolTimer) return;
+  const generation = networkPoolGeneration;
+  const work: Promise<void>[] = [];
+
+  const stranded = freeNetworks.filter(name => !dockerHosts.accepting(dockerHosts.networkHost(name)));
+  for (const networkName of stranded) {
+    freeNetworks.splice(freeNetworks.indexOf(networkName), 1);
+    poolNetworks.delete(networkName);
+    work.push(removeSessionNetwork(networkName));
+  }
+
+  for (const host of dockerHosts.names()) {
+    if (!dockerHosts.accepting(host)) continue;
+    const creating = poolNetworksCreating.get(host) ?? 0;
+    const missing = config.network.poolSize - freeOn(host).length - creating;
+    if (missing <= 0) continue;
+    poolNetworksCreating.set(host, creating + missing);
+
+    for (let i = 0; i < missing; i++) {
+      work.push((async () => {
+        const networkName = `${config.network.sessionNetworkPrefix}pool-${Date.now().toString(36)}-${++poolNetworkSeq}`;
+        try {
+          await createNetworkWithSubnet(networkName, { 'pool': 'true' }, host);
+          if (generation !== networkPoolGeneration) {
+            await removeSessionNetwork(networkName);
+            return;
+          }
+          poolNetworks.set(networkName, { sessionId: null, leasedAt: 0 });
+          freeNetworks.push(networkName);
+        } catch (error: any) {
+          logger.warn('NetworkManager', `Failed to pre-create pool network on ${host}: ${error.message}`);
+        } finally {
+          poolNetworksCreating.set(host, (poolNetworksCreating.get(host) ?? 1) - 1);
+        }
+      })());
+    }
+  }
+
+  await Promise.all(work);
+}
+
+/** Free pool networks on a host */
+function freeOn(host: string): string[] {
+  return freeNetworks.filter(name => dockerHosts.networkHost(name) === host);
+}
+
+/**
+ * Start keeping pre-created networks (NETWORK_POOL_SIZE > 0).
+ * Fills the pool right away, then tops it up periodically.
+ */
+export function startNetworkPool(): void {
+  if (networkPoolTimer || config.network.poolSize <= 0) return;
+  logger.info('NetworkManager', `Starting network pool (size: ${config.network.poolSize}, max free: ${config.network.poolMax})`);
+  networkPoolTimer = setInterval(() => {
+    replenishNetworkPool().catch(e => logger.error('NetworkManager', `Network pool refill failed: ${e}`));
+  }, config.network.poolRefillInterval);
+  replenishNetworkPool().catch(e => logger.error('NetworkManager', `Network pool refill failed: ${e}`));
+}
+
+/**
+ * Stop refilling and delete every pool network, leased ones included.
+ * Call after the containers on them have been removed.
+ */
+export async function stopNetworkPool(): Promise<void> {
+  if (networkPoolTimer) {
+    clearInterval(networkPoolTimer);
+    networkPoolTimer = null;
+  }
+  const networks = forgetPoolNetworks();
+  await Promise.allSettled(networks.map(async (networkName) => {
+    await disconnectAllFromNetwork(networkName);
+    await removeSessionNetwork(networkName);
+  }));
+}
+
+/**
+ * Drop all pool bookkeeping without touching Docker; returns the networks that
+ * were tracked. Used when networks are about to be (or were) removed in bulk.
+ */
+function forgetPoolNetworks(): string[] {
+  networkPoolGeneration++;
+  const networks = Array.from(poolNetworks.keys());
+  poolNetworks.clear();
+  freeNetworks.length = 0;
+  leasedNetworks.clear();
+  return networks;
+}
+
+function isFreePoolNetwork(networkName: string): boolean {
+  const entry = poolNetworks.get(networkName);
+  return entry !== undefined && entry.sessionId === null;
+}
+
+/**
+ * Network pool statistics for monitoring
+ */
+export function getNetworkPoolStats() {
+  return {
+    enabled: networkPoolTimer !== null,
+    target: config.network.poolSize,
+    maxFree: config.network.poolMax,
+    free: freeNetworks.length,
+    leased: leasedNetworks.size,
+    creating: Array.from(poolNetworksCreating.values()).reduce((sum, n) => sum + n, 0),
+    ...networkPoolCounters,
+  };
+}
+
 /**
  * Cleanup orphaned networks (networks older than maxAge with no containers)
  */
 export async function cleanupOrphanedNetworks(maxAgeMs: number = 300000): Promise<void> {
   try {
     const startTime = Date.now();
-    const networks = await listSessionNetworks();
+    const networks = await listReapableSessionNetworks();
     const now = Date.now();
     let cleanedCount = 0;
     const orphanedCount = networks.length;
@@ -387,15 +674,24 @@ export async function cleanupOrphanedNetworks(maxAgeMs: number = 300000): Promis
     for (const networkName of networks) {
       const cleanupTask = (async () => {
         try {
+          // Free pool networks are empty by design
+          if (isFreePoolNetwork(networkName)) {
+            return;
+          }
+
           const info = await dockerInspectNetwork(networkName);
           const createdAt = new Date(info.created).getTime();
-          const ageMs = now - createdAt;
           const containerCount = info.containerCount;
 
+          // A leased pool network is as old as its lease, not the network
+          const pooled = poolNetworks.get(networkName);
+          const ageMs = now - (pooled ? pooled.leasedAt : createdAt);
+          const maxAge = pooled ? Math.max(effectiveMaxAge, LEASE_GRACE_MS) : effectiveMaxAge;
+
           // Check if network should be cleaned up
-          if (ageMs > effectiveMaxAge && containerCount === 0) {
+          if (ageMs > maxAge && containerCount === 0) {
             logger.info('NetworkManager', `Cleaning up orphaned network: ${networkName} (age: ${Math.floor(ageMs / 1000)}s)`);
-            const sessionId = networkName.replace(config.network.sessionNetworkPrefix, '');
+            const sessionId = pooled?.sessionId ?? networkName.replace(config.network.sessionNetworkPrefix, '');
             await deleteSessionNetwork(sessionId);
             cleanedCount++;
           }
@@ -457,8 +753,19 @@ export async function emergencyNetworkCleanup(): Promise<void> {
 
     // Use SDK prune — no process spawn
     try {
-      const deleted = await pruneNetworks(config.network.networkLabel);
+      // Only this instance's: a sibling's fresh network is empty until its container joins
+      const deleted = await pruneNetworks(
+        config.network.networkLabel,
+        `${INSTANCE_LABEL}=${clusterState.instanceId}`,
+      );
       logger.info('NetworkManager', `Emergency prune removed ${deleted.length} networks`);
+      // Free pool networks have no containers, so the prune took them
+      for (const networkName of deleted) {
+        if (isFreePoolNetwork(networkName)) {
+          poolNetworks.delete(networkName);
+        }
+      }
+      freeNetworks.splice(0, freeNetworks.length, ...freeNetworks.filter(name => poolNetworks.has(name)));
     } catch (pruneError: any) {
       if (pruneError.message?.includes('already running')) {
         logger.warn('NetworkManager', 'EMERGENCY: Prune already running in another process');
@@ -468,13 +775,17 @@ export async function emergencyNetworkCleanup(): Promise<void> {
     }
 
     // Additional manual cleanup of session networks with no containers
-    const networks = await listSessionNetworks();
+    const networks = await listReapableSessionNetworks();
     let manualCleanupCount = 0;
 
     const batchSize = 10;
     for (let i = 0; i < networks.length; i += batchSize) {
       const batch = networks.slice(i, i + batchSize);
       const cleanupPromises = batch.map(async (networkName) => {
+        // Pool networks are reclaimed through deleteSessionNetwork / orphan cleanup
+        if (poolNetworks.has(networkName)) {
+          return;
+        }
         try {
           const info = await dockerInspectNetwork(networkName);
           if (info.containerCount === 0) {
@@ -569,14 +880,17 @@ export async function aggressiveBulkNetworkCleanup(): Promise<number> {
     const startTime = Date.now();
     let removedCount = 0;
 
-    // Step 1: Get all CodeRunner session networks
-    const networks = await listSessionNetworks();
+    // Step 1: Get all CodeRunner session networks this instance may remove
+    const networks = await listReapableSessionNetworks();
     if (networks.length === 0) {
       logger.info('NetworkManager', 'No networks found for bulk cleanup');
       return 0;
     }
     logger.info('NetworkManager', `Found ${networks.length} networks for bulk removal`);
 
+    // Pool networks go too; the pool refills with fresh ones
+    forgetPoolNetworks();
+
     // Step 2: Force-disconnect all containers from these networks
     logger.info('NetworkManager', 'Disconnecting containers from networks...');
     await Promise.allSettled(
@@ -0,0 +1,108 @@
+/**
+ * Tests for bounded, backpressure-aware output streaming
+ */
+
+import { OutputStream, type OutputPayload, type OutputStreamOptions } from './outputStream';
+
+function createStream(overrides: Partial<OutputStreamOptions> = {}) {
+  const emitted: OutputPayload[] = [];
+  let congested = false;
+  const source = { pause: jest.fn(), resume: jest.fn() };
+  const stream = new OutputStream({
+    sessionId: 's1',
+    emit: payload => emitted.push(payload),
+    isCongested: () => congested,
+    maxBytes: 1024,
+    frameBytes: 64,
+    interactiveFlushMs: 10,
+    batchFlushMs: 100,
+    ...overrides,
+  });
+  stream.attach(source);
+  return { stream, emitted, source, setCongested: (value: boolean) => { congested = value; } };
+}
+
+const text = (emitted: OutputPayload[], type = 'stdout') =>
+  emitted.filter(p => p.type === type).map(p => p.data).join('');
+
+describe('OutputStream', () => {
+  beforeEach(() => jest.useFakeTimers());
+  afterEach(() => jest.useRealTimers());
+
+  it('should flush small output quickly after a quiet period', () => {
+    const { stream, emitted } = createStream();
+    stream.write('stdout', Buffer.from('hello\n'));
+    expect(emitted).toHaveLength(0);
+
+    jest.advanceTimersByTime(10);
+    expect(emitted).toEqual([{ sessionId: 's1', type: 'stdout', data: 'hello\n' }]);
+  });
+
+  it('should batch sustained output and merge same-type chunks', () => {
+    const { stream, emitted } = createStream();
+    stream.write('stdout', Buffer.from('a'));
+    jest.advanceTimersByTime(10);
+
+    stream.write('stdout', Buffer.from('b'));
+    stream.write('stdout', Buffer.from('c'));
+    jest.advanceTimersByTime(10);
+    expect(emitted).toHaveLength(1);
+
+    jest.advanceTimersByTime(90);
+    expect(emitted.map(p => p.data)).toEqual(['a', 'bc']);
+  });
+
+  it('should send large volumes right away in capped frames', () => {
+    const { stream, emitted } = createStream();
+    stream.write('stdout', Buffer.alloc(150, 'x'));
+    expect(emitted.map(p => p.data.length)).toEqual([64, 64, 22]);
+  });
+
+  it('should keep multi-byte characters intact across frames', () => {
+    const { stream, emitted } = createStream({ frameBytes: 4 });
+    stream.write('stdout', Buffer.from('aé€'));
+    stream.end();
+    expect(text(emitted)).toBe('aé€');
+    expect(emitted.every(p => !p.data.includes('�'))).toBe(true);
+  });
+
+  it('should pause the source while the client is backed up', () => {
+    const { stream, emitted, source, setCongested } = createStream();
+    setCongested(true);
+    stream.write('stdout', Buffer.alloc(100, 'x'));
+    expect(emitted).toHaveLength(0);
+    expect(source.pause).toHaveBeenCalledTimes(1);
+
+    setCongested(false);
+    jest.advanceTimersByTime(25);
+    expect(text(emitted)).toHaveLength(100);
+    expect(source.resume).toHaveBeenCalledTimes(1);
+  });
+
+  it('should cut output off at the ceiling with a notice', () => {
+    const onLimit = jest.fn();
+    const { stream, emitted } = createStream({ maxBytes: 10, onLimit });
+    stream.write('stdout', Buffer.from('12345678'));
+    stream.write('stderr', Buffer.from('abcdefgh'));
+    stream.write('stdout', Buffer.from('ignored'));
+
+    expect(onLimit).toHaveBeenCalledTimes(1);
+    expect(stream.isTruncated).toBe(true);
+    expect(text(emitted)).toBe('12345678');
+    expect(text(emitted, 'stderr')).toBe('ab');
+    expect(emitted[emitted.length - 1]).toMatchObject({ type: 'system', data: expect.stringContaining('truncated') });
+  });
+
+  it('should drain everything on end, even when backed up', () => {
+    const { stream, emitted, setCongested } = createStream();
+    setCongested(true);
+    stream.write('stdout', Buffer.from('out'));
+    stream.write('stderr', Buffer.from('err'));
+    stream.end();
+    expect(emitted.map(p => [p.type, p.data])).toEqual([['stdout', 'out'], ['stderr', 'err']]);
+
+    stream.write('stdout', Buffer.from('late'));
+    jest.advanceTimersByTime(1000);
+    expect(emitted).toHaveLength(2);
+  });
+});
@@ -0,0 +1,236 @@
+/**
+ * Bounded, backpressure-aware output streaming
+ *
+ * Output of an interactive run is kept as Buffers until it is sent and is
+ * decoded once per frame (StringDecoder keeps multi-byte characters that
+ * straddle a frame boundary intact). Flushing adapts to the volume:
+ *
+ *   - output after a quiet period goes out after interactiveFlushMs
+ *   - sustained output is batched every batchFlushMs
+ *   - once frameBytes are pending they are sent right away, in frames of at
+ *     most frameBytes
+ *
+ * While the client connection has a send backlog nothing is emitted and the
+ * exec stream is paused, so a program printing in a tight loop blocks on its
+ * own stdout instead of growing server memory. Past maxBytes the output is cut
+ * off with a notice and onLimit is called.
+ */
+
+import { StringDecoder } from 'string_decoder';
+import { config } from './config';
+
+export type OutputType = 'stdout' | 'stderr';
+
+export interface OutputPayload {
+  sessionId: string;
+  type: OutputType | 'system';
+  data: string;
+}
+
+/** Stream the output is read from; paused while the client is backed up */
+export interface OutputSource {
+  pause(): void;
+  resume(): void;
+}
+
+export interface OutputStreamOptions {
+  sessionId: string;
+  emit: (payload: OutputPayload) => void;
+  /** True while the client connection has a send backlog */
+  isCongested: () => boolean;
+  /** Called once when the output ceiling is hit, e.g. to stop the program */
+  onLimit?: () => void;
+  maxBytes?: number;
+  frameBytes?: number;
+  interactiveFlushMs?: number;
+  batchFlushMs?: number;
+}
+
+/** How often a congested connection is re-checked (ms) */
+const BACKLOG_POLL_MS = 25;
+
+interface PendingGroup {
+  type: OutputType;
+  chunks: Buffer[];
+  bytes: number;
+}
+
+export class OutputStream {
+  private readonly sessionId: string;
+  private readonly emit: (payload: OutputPayload) => void;
+  private readonly isCongested: () => boolean;
+  private readonly onLimit?: () => void;
+  private readonly maxBytes: number;
+  private readonly frameBytes: number;
+  private readonly interactiveFlushMs: number;
+  private readonly batchFlushMs: number;
+
+  private pending: PendingGroup[] = [];
+  private pendingBytes = 0;
+  private totalBytes = 0;
+  private truncated = false;
+  private noticeSent = false;
+  private decoders: Record<OutputType, StringDecoder> = {
+    stdout: new StringDecoder('utf8'),
+    stderr: new StringDecoder('utf8'),
+  };
+  private timer: NodeJS.Timeout | null = null;
+  private lastFlush = 0;
+  private source: OutputSource | null = null;
+  private paused = false;
+  private closed = false;
+
+  constructor(options: OutputStreamOptions) {
+    this.sessionId = options.sessionId;
+    this.emit = options.emit;
+    this.isCongested = options.isCongested;
+    this.onLimit = options.onLimit;
+    this.maxBytes = options.maxBytes ?? config.output.maxBytes;
+    this.frameBytes = options.frameBytes ?? config.output.frameBytes;
+    this.interactiveFlushMs = options.interactiveFlushMs ?? config.output.interactiveFlushMs;
+    this.batchFlushMs = options.batchFlushMs ?? config.output.batchFlushMs;
+  }
+
+  /** Stream to pause while the client is backed up */
+  attach(source: OutputSource): void {
+    this.source = source;
+  }
+
+  /** True once output has been cut off at maxBytes */
+  get isTruncated(): boolean {
+    return this.truncated;
+  }
+
+  write(type: OutputType, chunk: Buffer): void {
+    if (this.closed || this.truncated || chunk.length === 0) return;
+
+    const remaining = this.maxBytes - this.totalBytes;
+    if (chunk.length > remaining) {
+      chunk = chunk.subarray(0, remaining);
+      this.truncated = true;
+    }
+    this.totalBytes += chunk.length;
+
+    if (chunk.length > 0) {
+      const last = this.pending[this.pending.length - 1];
+      if (last && last.type === type) {
+        last.chunks.push(chunk);
+        last.bytes += chunk.length;
+      } else {
+        this.pending.push({ type, chunks: [chunk], bytes: chunk.length });
+      }
+      this.pendingBytes += chunk.length;
+    }
+
+    if (this.truncated) {
+      this.flush();
+      this.onLimit?.();
+    } else if (this.pendingBytes >= this.frameBytes) {
+      this.flush();
+    } else {
+      this.schedule();
+    }
+  }
+
+  /**
+   * Send everything still pending, regardless of backlog, and stop. Called when
+   * the run ends so the output precedes the exit event.
+   */
+  end(): void {
+    if (this.closed) return;
+    this.clearTimer();
+    while (this.pending.length > 0) this.emitFrame();
+    for (const type of ['stdout', 'stderr'] as const) {
+      const tail = this.decoders[type].end();
+      if (tail) this.emit({ sessionId: this.sessionId, type, data: tail });
+    }
+    this.emitNoticeIfDue();
+    this.resumeSource();
+    this.closed = true;
+  }
+
+  /** Drop pending output without sending it (client went away) */
+  dispose(): void {
+    this.clearTimer();
+    this.pending = [];
+    this.pendingBytes = 0;
+    this.closed = true;
+  }
+
+  private schedule(): void {
+    if (this.timer) return;
+    const quiet = Date.now() - this.lastFlush >= this.batchFlushMs;
+    this.timer = setTimeout(() => this.flush(), quiet ? this.interactiveFlushMs : this.batchFlushMs);
+  }
+
+  private flush(): void {
+    this.clearTimer();
+    if (this.closed) return;
+
+    while (this.pending.length > 0) {
+      if (this.isCongested()) {
+        this.pauseSource();
+        this.timer = setTimeout(() => this.flush(), BACKLOG_POLL_MS);
+        return;
+      }
+      this.emitFrame();
+    }
+    this.emitNoticeIfDue();
+    this.resumeSource();
+  }
+
+  /** Emit up to frameBytes of the oldest pending output */
+  private emitFrame(): void {
+    const group = this.pending[0];
+    const parts: Buffer[] = [];
+    let size = 0;
+    while (group.chunks.length > 0 && size < this.frameBytes) {
+      const chunk = group.chunks[0];
+      const take = Math.min(chunk.length, this.frameBytes - size);
+      if (take === chunk.length) {
+        parts.push(chunk);
+        group.chunks.shift();
+      } else {
+        parts.push(chunk.subarray(0, take));
+        group.chunks[0] = chunk.subarray(take);
+      }
+      size += take;
+    }
+    group.bytes -= size;
+    this.pendingBytes -= size;
+    if (group.chunks.length === 0) this.pending.shift();
+
+    const data = this.decoders[group.type].write(parts.length === 1 ? parts[0] : Buffer.concat(parts, size));
+    if (data) this.emit({ sessionId: this.sessionId, type: group.type, data });
+    this.lastFlush = Date.now();
+  }
+
+  private emitNoticeIfDue(): void {
+    if (!this.truncated || this.noticeSent || this.pending.length > 0) return;
+    this.noticeSent = true;
+    this.emit({
+      sessionId: this.sessionId,
+      type: 'system',
+      data: `\n[Output truncated: exceeded ${this.maxBytes} bytes]\n`,
+    });
+  }
+
+  private pauseSource(): void {
+    if (this.paused || !this.source) return;
+    this.paused = true;
+    this.source.pause();
+  }
+
+  private resumeSource(): void {
+    if (!this.paused || !this.source) return;
+    this.paused = false;
+    this.source.resume();
+  }
+
+  private clearTimer(): void {
+    if (this.timer) {
+      clearTimeout(this.timer);
+      this.timer = null;
+    }
+  }
+}
@@ -3,7 +3,7 @@
  * Unit tests for the latency tracking and percentile calculation.
  */
 
-import { pipelineMetrics, createStopwatch, type PipelineTimings } from './pipelineMetrics';
+import { pipelineMetrics, createStopwatch, getDominantPhase, type PipelineTimings } from './pipelineMetrics';
 
 describe('PipelineMetrics', () => {
   beforeEach(() => {
@@ -88,6 +88,118 @@ describe('PipelineMetrics', () => {
     });
   });
 
+  describe('compile/run phases', () => {
+    it('should report per-language compile and run percentiles', () => {
+      pipelineMetrics.record(makeTiming({ language: 'cpp', executionMs: 500, compileMs: 400, runMs: 100 }));
+      pipelineMetrics.record(makeTiming({ language: 'cpp', executionMs: 300, compileMs: 200, runMs: 100 }));
+      pipelineMetrics.record(makeTiming({ language: 'python', executionMs: 100 }));
+
+      const stats = pipelineMetrics.getStats();
+      expect(Object.keys(stats.byLanguagePhases)).toEqual(['cpp']);
+      expect(stats.byLanguagePhases['cpp'].count).toBe(2);
+      expect(stats.byLanguagePhases['cpp'].compileMs.p99).toBe(400);
+      expect(stats.byLanguagePhases['cpp'].compileMs.avg).toBe(300);
+      expect(stats.byLanguagePhases['cpp'].runMs.p50).toBe(100);
+    });
+
+    it('should record the dominant phase of slow executions', () => {
+      pipelineMetrics.record(makeTiming({
+        language: 'java', totalMs: 2000, executionMs: 1900, compileMs: 1500, runMs: 400,
+      }));
+
+      const stats = pipelineMetrics.getStats();
+      expect(stats.slowExecutions[0].dominantPhase).toBe('compile');
+    });
+
+    it('should fall back to the execution stage for interpreted languages', () => {
+      expect(getDominantPhase(makeTiming({ executionMs: 900, containerMs: 10 }))).toBe('execution');
+      expect(getDominantPhase(makeTiming({ executionMs: 100, containerMs: 800 }))).toBe('container');
+    });
+  });
+
+  describe('per-language stages', () => {
+    it('should keep stage percentiles per language', () => {
+      pipelineMetrics.record(makeTiming({ language: 'python', queueMs: 10, containerMs: 40 }));
+      pipelineMetrics.record(makeTiming({ language: 'java', queueMs: 300, containerMs: 5 }));
+
+      const stats = pipelineMetrics.getStats();
+      expect(stats.byLanguageStages['python'].queueMs.p90).toBe(10);
+      expect(stats.byLanguageStages['java'].queueMs.p50).toBe(300);
+      expect(stats.byStage['containerMs'].p99).toBe(40);
+      expect(stats.byLanguageStages['python'].compileMs).toBeUndefined();
+    });
+  });
+
+  describe('container sources', () => {
+    it('should split the container stage by source and time restores separately', () => {
+      pipelineMetrics.record(makeTiming({ language: 'java', containerMs: 900, containerSource: 'created' }));
+      pipelineMetrics.record(makeTiming({ language: 'java', containerMs: 250, containerSource: 'restored', restoreMs: 180 }));
+      pipelineMetrics.record(makeTiming({ language: 'java', containerMs: 40, containerSource: 'standby' }));
+
+      const stats = pipelineMetrics.getStats();
+      expect(stats.containerBySource['restored'].p50).toBe(250);
+      expect(stats.containerBySource['created'].p50).toBe(900);
+      expect(stats.byStage['restoreMs'].count).toBe(1);
+      expect(stats.byLanguageStages['java'].restoreMs.p50).toBe(180);
+      expect(pipelineMetrics.renderPrometheus()).toContain('coderunner_container_acquire_duration_seconds_count{source="standby"} 1');
+    });
+  });
+
+  describe('resource telemetry', () => {
+    it('should aggregate cgroup resource use per language', () => {
+      const resources = (cpuUserMs: number, peakMb: number, throttledPeriods = 0) => ({
+        cpuUserMs,
+        cpuSystemMs: 10,
+        peakMemoryBytes: peakMb * 1024 * 1024,
+        throttledPeriods,
+        throttledMs: throttledPeriods * 5,
+        blockReadBytes: 4096,
+        blockWriteBytes: 0,
+      });
+      pipelineMetrics.record(makeTiming({ language: 'cpp', resources: resources(40, 40) }));
+      pipelineMetrics.record(makeTiming({ language: 'cpp', resources: resources(490, 200, 3) }));
+      pipelineMetrics.record(makeTiming({ language: 'cpp' }));
+
+      const stats = pipelineMetrics.getStats().byLanguageResources['cpp'];
+      expect(stats.count).toBe(2);
+      expect(stats.cpuMs.p50).toBe(50);
+      expect(stats.peakMemoryMb.p99).toBeGreaterThanOrEqual(200);
+      expect(stats.throttledRuns).toBe(1);
+      expect(stats.blockReadBytes).toBe(8192);
+
+      const text = pipelineMetrics.renderPrometheus();
+      expect(text).toContain('coderunner_exec_cpu_seconds_total{language="cpp",mode="user"} 0.53');
+      expect(text).toContain('coderunner_exec_throttled_total{language="cpp"} 1');
+    });
+  });
+
+  describe('renderPrometheus', () => {
+    it('should export stage histograms in seconds with language labels', () => {
+      pipelineMetrics.record(makeTiming({ language: 'cpp', queueMs: 20, compileMs: 700, runMs: 50 }));
+      pipelineMetrics.recordBuildCache('miss');
+
+      const text = pipelineMetrics.renderPrometheus();
+      expect(text).toContain('# TYPE coderunner_pipeline_stage_duration_seconds histogram');
+      expect(text).toContain('coderunner_pipeline_stage_duration_seconds_bucket{stage="queue",language="cpp",le="0.025"} 1');
+      expect(text).toContain('coderunner_pipeline_stage_duration_seconds_bucket{stage="compile",language="cpp",le="0.5"} 0');
+      expect(text).toContain('coderunner_pipeline_stage_duration_seconds_sum{stage="compile",language="cpp"} 0.7');
+      expect(text).toContain('coderunner_pipeline_executions_total 1');
+      expect(text).toContain('coderunner_build_cache_lookups_total{outcome="miss"} 1');
+    });
+  });
+
+  describe('build cache', () => {
+    it('should count hits, host hits and misses', () => {
+      pipelineMetrics.recordBuildCache('hit');
+      pipelineMetrics.recordBuildCache('hit');
+      pipelineMetrics.recordBuildCache('host');
+      pipelineMetrics.recordBuildCache('miss');
+
+      const stats = pipelineMetrics.getStats();
+      expect(stats.buildCache).toEqual({ hits: 2, hostHits: 1, misses: 1, hitRate: 75 });
+    });
+  });
+
   describe('reset', () => {
     it('should clear all data', () => {
       pipelineMetrics.record(makeTiming({ totalMs: 2000 }));
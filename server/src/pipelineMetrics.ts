@@ -6,11 +6,23 @@
  *
  *   queue → network → container → fileTransfer → execution → cleanup
  *
- * Exposes percentile calculations (p50, p95, p99) for each stage
- * and flags slow executions for investigation.
+ * For compiled languages (cpp, java) execution is further split into its
+ * compile and run phases. The container stage is also broken down by where
+ * the container came from (reused, standby pool, checkpoint restore, fresh
+ * boot), with checkpoint restores timed on their own.
+ *
+ * Every stage is recorded into fixed-memory histograms (overall and per
+ * language), so percentiles (p50, p90, p95, p99) cover all executions since
+ * the last reset at constant memory. Slow executions are flagged for
+ * investigation, and the histograms can be rendered in Prometheus text format.
  */
 
 import { logger } from './logger';
+import { LatencyHistogram, type StageStats } from './histogram';
+import type { ContainerSource } from './pool';
+import type { ExecResources } from './dockerClient';
+
+export type { StageStats } from './histogram';
 
 export interface PipelineTimings {
   /** Time spent in the execution queue before processing began */
@@ -19,10 +31,24 @@ export interface PipelineTimings {
   networkMs: number;
   /** Time to acquire (create or reuse) a container */
   containerMs: number;
+  /** How the container was obtained */
+  containerSource?: ContainerSource;
+  /** Checkpoint restore part of containerMs (restored containers only) */
+  restoreMs?: number;
   /** Time to transfer files into the container */
   fileTransferMs: number;
+  /** Bytes actually uploaded for the run (only changed files are sent) */
+  fileTransferBytes?: number;
   /** Time for the actual code execution */
   executionMs: number;
+  /** Compiler part of executionMs (cpp/java only) */
+  compileMs?: number;
+  /** Program part of executionMs (cpp/java only) */
+  runMs?: number;
+  /** Build cache lookup of the run (cpp/java only) */
+  buildCache?: BuildCacheOutcome;
+  /** Cgroup CPU, memory, throttling and block I/O of the container during the exec */
+  resources?: ExecResources;
   /** Time to return container to pool and clean up */
   cleanupMs: number;
   /** Total wall-clock time from enqueue to completion */
@@ -33,31 +59,110 @@ export interface PipelineTimings {
   language: string;
 }
 
+/** Resource use of one language's executions, for capacity planning */
+export interface LanguageResourceStats {
+  count: number;
+  /** CPU time (user + system) per execution */
+  cpuMs: StageStats;
+  /** Peak memory per execution, in MiB */
+  peakMemoryMb: StageStats;
+  /** Executions that were CPU-throttled at least once */
+  throttledRuns: number;
+  blockReadBytes: number;
+  blockWriteBytes: number;
+}
+
+interface ResourceTotals {
+  cpu: LatencyHistogram;
+  memoryMb: LatencyHistogram;
+  cpuUserMs: number;
+  cpuSystemMs: number;
+  throttledRuns: number;
+  blockReadBytes: number;
+  blockWriteBytes: number;
+}
+
+/** A slow execution together with the stage that took the longest */
+export interface SlowExecution extends PipelineTimings {
+  dominantPhase: string;
+}
+
+/**
+ * Outcome of a compiled-language build lookup:
+ *   hit  → binary found in the session container
+ *   host → binary seeded from the host-side store
+ *   miss → compiled from scratch
+ */
+export type BuildCacheOutcome = 'hit' | 'host' | 'miss';
+
 /** Threshold above which an execution is considered "slow" */
 const SLOW_EXECUTION_THRESHOLD_MS = 1000;
 
-/** Maximum number of timing records to keep per stage */
-const MAX_HISTORY = 500;
+/** Stages recorded for every execution */
+export const PIPELINE_STAGES = [
+  'queueMs', 'networkMs', 'containerMs', 'fileTransferMs', 'executionMs', 'cleanupMs', 'totalMs',
+] as const;
+
+/** Phases recorded for compiled languages only */
+export const COMPILE_PHASES = ['compileMs', 'runMs'] as const;
+
+/** Recorded for containers restored from a checkpoint only */
+export const RESTORE_PHASES = ['restoreMs'] as const;
+
+export type PipelineStage =
+  | typeof PIPELINE_STAGES[number]
+  | typeof COMPILE_PHASES[number]
+  | typeof RESTORE_PHASES[number];
 
 class PipelineMetricsService {
-  private timings: PipelineTimings[] = [];
-  private slowExecutions: PipelineTimings[] = [];
+  /** Stage histograms across all languages */
+  private stages = new Map<PipelineStage, LatencyHistogram>();
+  /** Stage histograms per language */
+  private languageStages = new Map<string, Map<PipelineStage, LatencyHistogram>>();
+  private count = 0;
+  private reusedCount = 0;
+  private fileTransfer = { bytes: 0, runs: 0 };
+  private slowExecutions: SlowExecution[] = [];
   private readonly maxSlowExecutions = 50;
+  private buildCache: Record<BuildCacheOutcome, number> = { hit: 0, host: 0, miss: 0 };
+  /** Cgroup resource use per language (executions with telemetry only) */
+  private languageResources = new Map<string, ResourceTotals>();
+  /** Container stage by container source, to compare restores with the standby pool */
+  private containerBySource = new Map<ContainerSource, LatencyHistogram>();
 
   /**
    * Record a complete pipeline execution's timings.
    */
   record(timing: PipelineTimings): void {
-    this.timings.push(timing);
+    this.count++;
+    if (timing.containerReused) this.reusedCount++;
+    if (timing.fileTransferBytes !== undefined) {
+      this.fileTransfer.bytes += timing.fileTransferBytes;
+      this.fileTransfer.runs++;
+    }
 
-    // Trim history to prevent unbounded growth
-    if (this.timings.length > MAX_HISTORY) {
-      this.timings = this.timings.slice(-MAX_HISTORY);
+    let perLanguage = this.languageStages.get(timing.language);
+    if (!perLanguage) {
+      perLanguage = new Map();
+      this.languageStages.set(timing.language, perLanguage);
+    }
+    for (const stage of [...PIPELINE_STAGES, ...COMPILE_PHASES, ...RESTORE_PHASES]) {
+      const value = timing[stage];
+      if (value === undefined) continue;
+      histogramFor(this.stages, stage).record(value);
+      histogramFor(perLanguage, stage).record(value);
+    }
+    if (timing.containerSource) {
+      histogramFor(this.containerBySource, timing.containerSource).record(timing.containerMs);
+    }
+    if (timing.resources) {
+      this.recordResources(timing.language, timing.resources);
     }
 
     // Track slow executions separately
     if (timing.totalMs > SLOW_EXECUTION_THRESHOLD_MS) {
-      this.slowExecutions.push(timing);
+      const dominantPhase = getDominantPhase(timing);
+      this.slowExecutions.push({ ...timing, dominantPhase });
       if (this.slowExecutions.length > this.maxSlowExecutions) {
         this.slowExecutions.shift();
       }
@@ -65,89 +170,247 @@ class PipelineMetricsService {
         'PipelineMetrics',
         `Slow execution detected (${timing.totalMs}ms): ` +
         `queue=${timing.queueMs}ms network=${timing.networkMs}ms ` +
-        `container=${timing.containerMs}ms files=${timing.fileTransferMs}ms ` +
-        `exec=${timing.executionMs}ms cleanup=${timing.cleanupMs}ms ` +
-        `language=${timing.language} reused=${timing.containerReused}`,
+        `container=${timing.containerMs}ms files=${timing.fileTransferMs}ms` +
+        (timing.fileTransferBytes !== undefined ? ` (${timing.fileTransferBytes}B)` : '') + ' ' +
+        `exec=${timing.executionMs}ms` +
+        (timing.compileMs !== undefined ? ` (compile=${timing.compileMs}ms run=${timing.runMs ?? 0}ms)` : '') +
+        ` cleanup=${timing.cleanupMs}ms ` +
+        `language=${timing.language} reused=${timing.containerReused} dominant=${dominantPhase}`,
       );
     }
   }
 
+  private recordResources(language: string, resources: ExecResources): void {
+    let totals = this.languageResources.get(language);
+    if (!totals) {
+      totals = {
+        cpu: new LatencyHistogram(),
+        memoryMb: new LatencyHistogram(),
+        cpuUserMs: 0,
+        cpuSystemMs: 0,
+        throttledRuns: 0,
+        blockReadBytes: 0,
+        blockWriteBytes: 0,
+      };
+      this.languageResources.set(language, totals);
+    }
+    totals.cpu.record(resources.cpuUserMs + resources.cpuSystemMs);
+    totals.memoryMb.record(Math.round(resources.peakMemoryBytes / (1024 * 1024)));
+    totals.cpuUserMs += resources.cpuUserMs;
+    totals.cpuSystemMs += resources.cpuSystemMs;
+    if (resources.throttledPeriods > 0) totals.throttledRuns++;
+    totals.blockReadBytes += resources.blockReadBytes;
+    totals.blockWriteBytes += resources.blockWriteBytes;
+  }
+
+  /**
+   * Count a build cache lookup (cpp binary cache, java class cache).
+   */
+  recordBuildCache(outcome: BuildCacheOutcome): void {
+    this.buildCache[outcome]++;
+  }
+
+  /**
+   * Build cache counters with the overall hit rate (container + host hits).
+   */
+  getBuildCacheStats(): { hits: number; hostHits: number; misses: number; hitRate: number } {
+    const { hit, host, miss } = this.buildCache;
+    const total = hit + host + miss;
+    return {
+      hits: hit,
+      hostHits: host,
+      misses: miss,
+      hitRate: total > 0 ? Math.round(((hit + host) / total) * 100) : 0,
+    };
+  }
+
   /**
    * Get percentile statistics for each pipeline stage.
    */
   getStats(): {
     count: number;
     reuseRate: number;
-    byStage: Record<string, { p50: number; p95: number; p99: number; avg: number }>;
+    byStage: Record<string, StageStats>;
     byLanguage: Record<string, { count: number; avgTotal: number }>;
-    slowExecutions: PipelineTimings[];
+    byLanguageStages: Record<string, Record<string, StageStats>>;
+    byLanguagePhases: Record<string, { count: number; compileMs: StageStats; runMs: StageStats }>;
+    byLanguageResources: Record<string, LanguageResourceStats>;
+    fileTransfer: { totalBytes: number; avgBytes: number };
+    slowExecutions: SlowExecution[];
+    buildCache: ReturnType<PipelineMetricsService['getBuildCacheStats']>;
+    containerBySource: Record<string, StageStats>;
   } {
-    if (this.timings.length === 0) {
-      return {
-        count: 0,
-        reuseRate: 0,
-        byStage: {},
-        byLanguage: {},
-        slowExecutions: [],
-      };
+    const byStage: Record<string, StageStats> = {};
+    for (const stage of [...PIPELINE_STAGES, ...RESTORE_PHASES]) {
+      const histogram = this.stages.get(stage);
+      if (histogram) byStage[stage] = histogram.stats();
     }
 
-    const stages: (keyof Pick<PipelineTimings, 'queueMs' | 'networkMs' | 'containerMs' | 'fileTransferMs' | 'executionMs' | 'cleanupMs' | 'totalMs'>)[] = [
-      'queueMs', 'networkMs', 'containerMs', 'fileTransferMs', 'executionMs', 'cleanupMs', 'totalMs',
-    ];
+    const byLanguage: Record<string, { count: number; avgTotal: number }> = {};
+    const byLanguageStages: Record<string, Record<string, StageStats>> = {};
+    const byLanguagePhases: Record<string, { count: number; compileMs: StageStats; runMs: StageStats }> = {};
+    for (const [lang, stages] of this.languageStages) {
+      const total = stages.get('totalMs')!;
+      byLanguage[lang] = { count: total.count, avgTotal: total.stats().avg };
 
-    const byStage: Record<string, { p50: number; p95: number; p99: number; avg: number }> = {};
-    for (const stage of stages) {
-      const values = this.timings.map((t) => t[stage]).sort((a, b) => a - b);
-      byStage[stage] = {
-        p50: percentile(values, 50),
-        p95: percentile(values, 95),
-        p99: percentile(values, 99),
-        avg: Math.round(values.reduce((a, b) => a + b, 0) / values.length),
-      };
-    }
+      byLanguageStages[lang] = {};
+      for (const [stage, histogram] of stages) {
+        byLanguageStages[lang][stage] = histogram.stats();
+      }
 
-    // Aggregate by language
-    const byLanguage: Record<string, { count: number; avgTotal: number }> = {};
-    for (const t of this.timings) {
-      if (!byLanguage[t.language]) {
-        byLanguage[t.language] = { count: 0, avgTotal: 0 };
+      // Compile/run split for compiled languages
+      const compile = stages.get('compileMs');
+      if (compile) {
+        byLanguagePhases[lang] = {
+          count: compile.count,
+          compileMs: compile.stats(),
+          runMs: (stages.get('runMs') ?? new LatencyHistogram()).stats(),
+        };
       }
-      byLanguage[t.language].count++;
-      byLanguage[t.language].avgTotal += t.totalMs;
-    }
-    for (const lang of Object.keys(byLanguage)) {
-      byLanguage[lang].avgTotal = Math.round(byLanguage[lang].avgTotal / byLanguage[lang].count);
     }
 
-    const reusedCount = this.timings.filter((t) => t.containerReused).length;
+    const byLanguageResources: Record<string, LanguageResourceStats> = {};
+    for (const [lang, totals] of this.languageResources) {
+      byLanguageResources[lang] = {
+        count: totals.cpu.count,
+        cpuMs: totals.cpu.stats(),
+        peakMemoryMb: totals.memoryMb.stats(),
+        throttledRuns: totals.throttledRuns,
+        blockReadBytes: totals.blockReadBytes,
+        blockWriteBytes: totals.blockWriteBytes,
+      };
+    }
 
     return {
-      count: this.timings.length,
-      reuseRate: Math.round((reusedCount / this.timings.length) * 100),
+      count: this.count,
+      reuseRate: this.count > 0 ? Math.round((this.reusedCount / this.count) * 100) : 0,
       byStage,
       byLanguage,
+      byLanguageStages,
+      byLanguagePhases,
+      byLanguageResources,
+      fileTransfer: {
+        totalBytes: this.fileTransfer.bytes,
+        avgBytes: this.fileTransfer.runs > 0 ? Math.round(this.fileTransfer.bytes / this.fileTransfer.runs) : 0,
+      },
       slowExecutions: [...this.slowExecutions],
+      buildCache: this.getBuildCacheStats(),
+      containerBySource: Object.fromEntries(
+        [...this.containerBySource].map(([source, histogram]) => [source, histogram.stats()]),
+      ),
     };
   }
 
+  /**
+   * Render the stage histograms and counters in Prometheus text exposition format.
+   * Durations are exported in seconds, per Prometheus convention.
+   */
+  renderPrometheus(): string {
+    const lines: string[] = [
+      '# HELP coderunner_pipeline_stage_duration_seconds Duration of each execution pipeline stage.',
+      '# TYPE coderunner_pipeline_stage_duration_seconds histogram',
+    ];
+    for (const [lang, stages] of this.languageStages) {
+      for (const [stage, histogram] of stages) {
+        const labels = `stage="${stage.replace(/Ms$/, '')}",language="${lang}"`;
+        for (const [bound, cumulative] of histogram.cumulativeBuckets()) {
+          const le = bound === Infinity ? '+Inf' : String(bound / 1000);
+          lines.push(`coderunner_pipeline_stage_duration_seconds_bucket{${labels},le="${le}"} ${cumulative}`);
+        }
+        lines.push(`coderunner_pipeline_stage_duration_seconds_sum{${labels}} ${histogram.sumMs / 1000}`);
+        lines.push(`coderunner_pipeline_stage_duration_seconds_count{${labels}} ${histogram.count}`);
+      }
+    }
+
+    lines.push(
+      '# HELP coderunner_container_acquire_duration_seconds Container stage duration by container source.',
+      '# TYPE coderunner_container_acquire_duration_seconds histogram',
+    );
+    for (const [source, histogram] of this.containerBySource) {
+      const labels = `source="${source}"`;
+      for (const [bound, cumulative] of histogram.cumulativeBuckets()) {
+        const le = bound === Infinity ? '+Inf' : String(bound / 1000);
+        lines.push(`coderunner_container_acquire_duration_seconds_bucket{${labels},le="${le}"} ${cumulative}`);
+      }
+      lines.push(`coderunner_container_acquire_duration_seconds_sum{${labels}} ${histogram.sumMs / 1000}`);
+      lines.push(`coderunner_container_acquire_duration_seconds_count{${labels}} ${histogram.count}`);
+    }
+
+    lines.push(
+      '# HELP coderunner_pipeline_executions_total Executions recorded by the pipeline metrics.',
+      '# TYPE coderunner_pipeline_executions_total counter',
+      `coderunner_pipeline_executions_total ${this.count}`,
+      '# HELP coderunner_pipeline_container_reuse_total Executions that reused a session container.',
+      '# TYPE coderunner_pipeline_container_reuse_total counter',
+      `coderunner_pipeline_container_reuse_total ${this.reusedCount}`,
+      '# HELP coderunner_file_transfer_bytes_total Bytes uploaded into session containers.',
+      '# TYPE coderunner_file_transfer_bytes_total counter',
+      `coderunner_file_transfer_bytes_total ${this.fileTransfer.bytes}`,
+      '# HELP coderunner_build_cache_lookups_total C/C++ build cache lookups by outcome.',
+      '# TYPE coderunner_build_cache_lookups_total counter',
+      ...(Object.keys(this.buildCache) as BuildCacheOutcome[]).map(outcome =>
+        `coderunner_build_cache_lookups_total{outcome="${outcome}"} ${this.buildCache[outcome]}`),
+    );
+
+    lines.push(
+      '# HELP coderunner_exec_cpu_seconds_total Container CPU time used by executions.',
+      '# TYPE coderunner_exec_cpu_seconds_total counter',
+    );
+    for (const [lang, totals] of this.languageResources) {
+      lines.push(`coderunner_exec_cpu_seconds_total{language="${lang}",mode="user"} ${totals.cpuUserMs / 1000}`);
+      lines.push(`coderunner_exec_cpu_seconds_total{language="${lang}",mode="system"} ${totals.cpuSystemMs / 1000}`);
+    }
+    lines.push(
+      '# HELP coderunner_exec_throttled_total Executions that hit the container CPU quota.',
+      '# TYPE coderunner_exec_throttled_total counter',
+      ...[...this.languageResources].map(([lang, totals]) =>
+        `coderunner_exec_throttled_total{language="${lang}"} ${totals.throttledRuns}`),
+    );
+    return lines.join('\n') + '\n';
+  }
+
   /**
    * Reset all collected metrics.
    */
   reset(): void {
-    this.timings = [];
+    this.stages.clear();
+    this.languageStages.clear();
+    this.count = 0;
+    this.reusedCount = 0;
+    this.fileTransfer = { bytes: 0, runs: 0 };
     this.slowExecutions = [];
+    this.buildCache = { hit: 0, host: 0, miss: 0 };
+    this.containerBySource.clear();
+    this.languageResources.clear();
     logger.info('PipelineMetrics', 'Metrics reset');
   }
 }
 
+function histogramFor<K>(map: Map<K, LatencyHistogram>, stage: K): LatencyHistogram {
+  let histogram = map.get(stage);
+  if (!histogram) {
+    histogram = new LatencyHistogram();
+    map.set(stage, histogram);
+  }
+  return histogram;
+}
+
 /**
- * Calculate the p-th percentile from a sorted array of numbers.
+ * Name of the longest stage of an execution. Compiled executions are split
+ * into their compile and run phases instead of a single execution stage.
  */
-function percentile(sorted: number[], p: number): number {
-  if (sorted.length === 0) return 0;
-  const index = Math.ceil((p / 100) * sorted.length) - 1;
-  return sorted[Math.max(0, index)];
+export function getDominantPhase(timing: PipelineTimings): string {
+  const phases: [string, number][] = [
+    ['queue', timing.queueMs],
+    ['network', timing.networkMs],
+    ['container', timing.containerMs],
+    ['fileTransfer', timing.fileTransferMs],
+    ...(timing.compileMs !== undefined
+      ? [['compile', timing.compileMs], ['run', timing.runMs ?? 0]] as [string, number][]
+      : [['execution', timing.executionMs]] as [string, number][]),
+    ['cleanup', timing.cleanupMs],
+  ];
+  return phases.reduce((max, phase) => (phase[1] > max[1] ? phase : max))[0];
 }
 
 /**
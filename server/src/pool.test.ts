@@ -11,9 +11,24 @@ jest.mock('./dockerClient', () => ({
     removeContainers: jest.fn().mockResolvedValue(undefined),
     listContainers: jest.fn().mockResolvedValue([]),
     waitForHealthy: jest.fn().mockResolvedValue(undefined),
+    startContainer: jest.fn().mockResolvedValue(undefined),
+    attachAgent: jest.fn().mockResolvedValue(true),
+    hasAgent: jest.fn().mockReturnValue(true),
+    requiresAgent: jest.fn().mockReturnValue(false),
+    isAgentlessImage: jest.fn().mockReturnValue(false),
+    watchContainerEvents: jest.fn().mockReturnValue({ connected: () => true, stop: jest.fn() }),
+    connectToNetwork: jest.fn().mockResolvedValue(undefined),
 }));
 
-import { sessionPool } from './pool';
+jest.mock('./networkManager', () => ({
+    getOrCreateSessionNetwork: jest.fn().mockResolvedValue('mock-network'),
+}));
+
+import { sessionPool, computeStandbyTarget } from './pool';
+import * as dockerClient from './dockerClient';
+import { AGENT_PATH } from './agent';
+import { clusterState } from './clusterState';
+import * as os from 'os';
 
 describe('SessionContainerPool', () => {
     beforeEach(() => {
@@ -70,9 +85,162 @@ describe('SessionContainerPool', () => {
         });
     });
 
+    describe('standby pool', () => {
+        it('should expose standby metrics', () => {
+            const metrics = sessionPool.getMetrics();
+            expect(metrics.standbyHits).toBe(0);
+            expect(metrics.standbyMisses).toBe(0);
+            expect(metrics.standbyHitRate).toBe(0);
+            expect(metrics.standbyByLanguage).toHaveProperty('python', 0);
+        });
+
+        it('should scale the target with recent demand within the bounds', () => {
+            expect(computeStandbyTarget(1, 5, 0)).toBe(1);
+            expect(computeStandbyTarget(1, 5, 3)).toBe(3);
+            expect(computeStandbyTarget(1, 5, 12)).toBe(5);
+            expect(computeStandbyTarget(3, 2, 0)).toBe(3);
+        });
+
+        it('should hand a ready standby container to a session on first demand', async () => {
+            (dockerClient.createContainer as jest.Mock).mockResolvedValue('standby-container-id');
+            await sessionPool.replenishStandby();
+            expect(sessionPool.getMetrics().standbyByLanguage.python).toBe(1);
+
+            (dockerClient.createContainer as jest.Mock).mockResolvedValue('mock-container-id');
+            const containerId = await sessionPool.getOrCreateContainer('python', 'standby-test', 'mock-network');
+
+            expect(containerId).toBe('standby-container-id');
+            const metrics = sessionPool.getMetrics();
+            expect(metrics.standbyHits).toBe(1);
+            expect(metrics.standbyByLanguage.python).toBe(0);
+
+            await sessionPool.cleanupSession('standby-test');
+            await sessionPool.stopStandbyPool();
+        });
+
+        it('should start containers under the execution agent and attach to it', async () => {
+            (dockerClient.createContainer as jest.Mock).mockClear();
+            (dockerClient.createContainer as jest.Mock).mockResolvedValue('agent-container-id');
+            await sessionPool.replenishStandby();
+
+            const options = (dockerClient.createContainer as jest.Mock).mock.calls
+                .map(([opts]) => opts)
+                .find(opts => opts.labels.language === 'python');
+            expect(options.openStdin).toBe(true);
+            expect(options.cmd[2]).toContain(AGENT_PATH);
+            expect(dockerClient.attachAgent).toHaveBeenCalledWith('agent-container-id', expect.any(String), expect.any(Number), true);
+
+            await sessionPool.stopStandbyPool();
+        });
+    });
+
+    describe('tmpfs workspace', () => {
+        const createdOptions = (language: string) => (dockerClient.createContainer as jest.Mock).mock.calls
+            .map(([opts]) => opts)
+            .filter(opts => opts.labels.language === language);
+
+        beforeEach(() => {
+            (dockerClient.hasAgent as jest.Mock).mockReturnValue(true);
+        });
+
+        it('should mount /app and /tmp as exec tmpfs except for sql', async () => {
+            (dockerClient.createContainer as jest.Mock).mockResolvedValue('tmpfs-container-id');
+            await sessionPool.getOrCreateContainer('cpp', 'tmpfs-test', 'mock-network');
+            await sessionPool.getOrCreateContainer('sql', 'tmpfs-test', 'mock-network');
+
+            const [cpp] = createdOptions('cpp');
+            expect(Object.keys(cpp.tmpfs)).toEqual(['/app', '/tmp']);
+            expect(cpp.tmpfs['/app']).toMatch(/(^|,)exec(,|$)/);
+            expect(cpp.tmpfs['/app']).toContain('size=256m');
+            expect(createdOptions('sql')[0].tmpfs).toBeUndefined();
+
+            await sessionPool.cleanupSession('tmpfs-test');
+        });
+
+        it('should replace a tmpfs container whose agent did not attach', async () => {
+            (dockerClient.createContainer as jest.Mock)
+                .mockResolvedValueOnce('agentless-container-id')
+                .mockResolvedValueOnce('overlay-container-id');
+            (dockerClient.requiresAgent as jest.Mock).mockImplementation(id => id === 'agentless-container-id');
+            (dockerClient.hasAgent as jest.Mock).mockReturnValueOnce(false);
+
+            const containerId = await sessionPool.getOrCreateContainer('python', 'tmpfs-fallback', 'mock-network');
+
+            expect(containerId).toBe('overlay-container-id');
+            expect(dockerClient.removeContainers).toHaveBeenCalledWith(['agentless-container-id']);
+            await sessionPool.cleanupSession('tmpfs-fallback');
+        });
+    });
+
+    describe('container events', () => {
+        const event = (action: 'die' | 'destroy', id: string) => ({ action, id, labels: {}, host: 'local', time: Date.now() });
+
+        beforeEach(() => {
+            (dockerClient.removeContainers as jest.Mock).mockResolvedValue(undefined);
+        });
+
+        it('should drop a container that died outside the pool', async () => {
+            (dockerClient.createContainer as jest.Mock).mockResolvedValue('dying-container-id');
+            await sessionPool.getOrCreateContainer('python', 'events-test', 'mock-network');
+
+            sessionPool.onContainerEvent(event('die', 'dying-container-id'));
+
+            expect(sessionPool.getStats().bySession['events-test']).toBeUndefined();
+            expect(sessionPool.getMetrics().containersLost).toBe(1);
+            expect(dockerClient.removeContainers).toHaveBeenCalledWith(['dying-container-id']);
+
+            // A replayed event finds nothing left to drop
+            sessionPool.onContainerEvent(event('destroy', 'dying-container-id'));
+            expect(sessionPool.getMetrics().containersLost).toBe(1);
+        });
+
+        it('should not count containers the pool removed itself', async () => {
+            (dockerClient.createContainer as jest.Mock).mockResolvedValue('removed-container-id');
+            await sessionPool.getOrCreateContainer('python', 'events-removed', 'mock-network');
+            (dockerClient.removeContainers as jest.Mock).mockImplementationOnce(async () => {
+                sessionPool.onContainerEvent(event('destroy', 'removed-container-id'));
+            });
+
+            await sessionPool.cleanupSession('events-removed');
+
+            expect(sessionPool.getMetrics().containersLost).toBe(0);
+            expect(sessionPool.getMetrics().containersDeleted).toBe(1);
+        });
+
+        it('should list containers for the orphan sweep only now and then while events flow', async () => {
+            (dockerClient.watchContainerEvents as jest.Mock).mockReturnValue({ connected: () => true, stop: jest.fn() });
+            (dockerClient.listContainers as jest.Mock).mockResolvedValue([]);
+            sessionPool.startEventWatch();
+
+            await sessionPool.cleanupExpiredContainers();
+            await sessionPool.cleanupExpiredContainers();
+
+            expect(dockerClient.watchContainerEvents).toHaveBeenCalledTimes(1);
+            expect(dockerClient.listContainers).toHaveBeenCalledTimes(1);
+            sessionPool.stopEventWatch();
+        });
+    });
+
     describe('getSessionCount', () => {
         it('should return 0 when no sessions exist', () => {
             expect(sessionPool.getSessionCount()).toBe(0);
         });
     });
+
+    describe('orphan sweep', () => {
+        it('should spare containers of live sibling instances', async () => {
+            const old = Date.now() - 60 * 60 * 1000;
+            (dockerClient.listContainers as jest.Mock).mockResolvedValueOnce([
+                { id: 'mine', created: old, labels: { instance: clusterState.instanceId }, host: 'local' },
+                { id: 'sibling', created: old, labels: { instance: `${os.hostname()}-${process.ppid}` }, host: 'local' },
+                { id: 'dead', created: old, labels: { instance: 'gone-host-1' }, host: 'local' },
+                { id: 'fresh', created: Date.now(), labels: { instance: 'gone-host-2' }, host: 'local' },
+            ]);
+            (dockerClient.removeContainers as jest.Mock).mockClear();
+
+            await sessionPool.cleanupExpiredContainers();
+
+            expect(dockerClient.removeContainers).toHaveBeenCalledWith(['mine', 'dead']);
+        });
+    });
 });
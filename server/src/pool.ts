@@ -8,8 +8,17 @@ import {
   listContainers,
   waitForHealthy,
   startContainer,
+  type ContainerEvent,
+  type ContainerEventWatch,
 } from './dockerClient';
 import { getOrCreateSessionNetwork } from './networkManager';
+import { dockerHosts } from './dockerHosts';
+import { clusterState, INSTANCE_LABEL } from './clusterState';
+import { CPP_TOOLCHAIN_WARMER_PATH } from './cppBuild';
+import { javaContainerCommand } from './javaRunner';
+import { agentContainerCommand } from './agent';
+import { checkpointManager, type StartOutcome } from './checkpoints';
+import { JAVA_RUNNER_SPOOL } from './javaRunner';
 
 /**
  * Session Container with TTL
@@ -22,6 +31,30 @@ interface SessionContainer {
   networkName: string;
   lastUsed: number;    // timestamp
   inUse: boolean;      // whether container is currently executing code
+  buildArtifacts: Set<string>; // cpp build cache keys present in /app (see cppBuild.ts)
+  syncedFiles: Map<string, string>; // path → content hash of user files in /app (see fileSync.ts)
+  variant?: ContainerVariant;   // special-purpose container, never used for plain runs
+}
+
+/**
+ * Container variants with extra privileges, kept apart from a session's regular
+ * containers:
+ *   profile → CAP_PERFMON in the bounding set for perf (cpp profiling mode)
+ */
+export type ContainerVariant = 'profile';
+
+const VARIANT_CAPABILITIES: Record<ContainerVariant, string[]> = {
+  profile: ['PERFMON'],
+};
+
+/**
+ * Started container waiting in the standby pool for its first session
+ */
+interface StandbyContainer {
+  containerId: string;
+  language: string;
+  host: string;
+  createdAt: number;
 }
 
 /**
@@ -31,10 +64,40 @@ interface CleanupMetrics {
   containersCreated: number;
   containersReused: number;
   containersDeleted: number;
+  containersLost: number; // died or removed outside the pool (Docker events)
   cleanupErrors: number;
   lastCleanupDuration: number;
   totalActiveContainers: number;
   queueDepth: number; // containers pending cleanup
+  standbyHits: number;   // first runs served from the standby pool
+  standbyMisses: number; // first runs that had to create a container (pool enabled)
+  standbyHitRate: number; // percentage
+  standbyByLanguage: Record<string, number>; // ready standby containers
+  standbyTargets: Record<string, number>;    // current target per language
+}
+
+/** Session label given to standby containers until they are handed out */
+const STANDBY_SESSION = 'standby';
+
+/** Session label of checkpoint template containers (see checkpoints.ts) */
+const CHECKPOINT_SESSION = 'checkpoint';
+
+/** How a session's container came to be: reused, taken from standby, restored or booted */
+export type ContainerSource = 'reused' | 'standby' | 'restored' | 'created';
+
+export interface ContainerStart {
+  source: ContainerSource;
+  /** Checkpoint restore time, part of the container stage */
+  restoreMs?: number;
+}
+
+/**
+ * Standby target for a language: the configured base size, grown to cover the
+ * recent first-run demand, but never above the configured maximum (unless the
+ * base itself is larger).
+ */
+export function computeStandbyTarget(base: number, max: number, recentDemand: number): number {
+  return Math.max(0, Math.min(Math.max(base, recentDemand), Math.max(base, max)));
 }
 
 /**
@@ -50,16 +113,21 @@ class SessionContainerPool {
   // Key: "sessionId:language" -> Promise that resolves to containerId
   private pendingAcquisitions: Map<string, Promise<string>> = new Map();
 
+  // Standby pool (PREWARM_POOL): language -> started containers awaiting a session
+  private standby: Map<string, StandbyContainer[]> = new Map();
+  private standbyCreating: Map<string, number> = new Map();
+  private standbyPendingIds: Set<string> = new Set(); // created, not yet ready (standby or checkpoint template)
+  private containerStarts: Map<string, ContainerStart> = new Map(); // first-run start info, see takeContainerStart
+  private firstRunDemand: Map<string, number[]> = new Map(); // timestamps per language
+  private standbyTimer: NodeJS.Timeout | null = null;
+  private standbyGeneration = 0; // bumped on stop so in-flight creations are discarded
+
+  // Docker die/destroy events (CONTAINER_EVENTS), see onContainerEvent
+  private eventWatch: ContainerEventWatch | null = null;
+  private lastOrphanSweep = 0;
+
   // Cleanup metrics
-  private metrics: CleanupMetrics = {
-    containersCreated: 0,
-    containersReused: 0,
-    containersDeleted: 0,
-    cleanupErrors: 0,
-    lastCleanupDuration: 0,
-    totalActiveContainers: 0,
-    queueDepth: 0,
-  };
+  private metrics: CleanupMetrics = this.emptyMetrics(0);
 
   constructor() {
     logger.info('Pool', 'Initialized session-based container pool with TTL');
@@ -71,17 +139,28 @@ class SessionContainerPool {
   resetMetrics(): void {
     const currentActive = this.metrics.totalActiveContainers; // Preserve current active count
 
-    this.metrics = {
+    // Don't reset the active count to 0 if containers exist
+    this.metrics = this.emptyMetrics(currentActive);
+
+    logger.info('Pool', 'Metrics have been reset');
+  }
+
+  private emptyMetrics(totalActiveContainers: number): CleanupMetrics {
+    return {
       containersCreated: 0,
       containersReused: 0,
       containersDeleted: 0,
+      containersLost: 0,
       cleanupErrors: 0,
       lastCleanupDuration: 0,
-      totalActiveContainers: currentActive, // Don't reset this to 0 if containers exist
+      totalActiveContainers,
       queueDepth: 0,
+      standbyHits: 0,
+      standbyMisses: 0,
+      standbyHitRate: 0,
+      standbyByLanguage: {},
+      standbyTargets: {},
     };
-
-    logger.info('Pool', 'Metrics have been reset');
   }
 
   /**
@@ -103,10 +182,23 @@ class SessionContainerPool {
       if (expiredContainers.length > 0) {
         logger.info('Pool', `Cleaning up ${expiredContainers.length} expired containers for session ${sessionId}`);
 
+        // Remove from pool first, so their die/destroy events aren't taken for losses
+        const remainingContainers = containers.filter(
+          c => !expiredContainers.includes(c)
+        );
+
+        if (remainingContainers.length > 0) {
+          this.pool.set(sessionId, remainingContainers);
+        } else {
+          this.pool.delete(sessionId);
+          clusterState.releaseSession(sessionId);
+        }
+
         // Batch delete containers via SDK (parallel, no process spawning)
         const containerIds = expiredContainers.map(c => c.containerId);
         try {
           await removeContainers(containerIds);
+          clusterState.forgetContainers(containerIds);
           cleanedCount += containerIds.length;
           this.metrics.containersDeleted += containerIds.length;
           logger.info('Pool', `Deleted ${containerIds.length} expired containers`);
@@ -114,44 +206,45 @@ class SessionContainerPool {
           logger.warn('Pool', `Batch deletion error: ${error.message}`);
           this.metrics.cleanupErrors++;
         }
-
-        // Remove from pool
-        const remainingContainers = containers.filter(
-          c => !expiredContainers.includes(c)
-        );
-
-        if (remainingContainers.length > 0) {
-          this.pool.set(sessionId, remainingContainers);
-        } else {
-          this.pool.delete(sessionId);
-        }
       }
     }
 
-    // 2. Safety Net: Find orphaned "coderunner-session" containers not in our pool
-    try {
-      const allSessionContainers = await listContainers({ 'type': 'coderunner-session' });
-
-      const activeContainerIds = new Set<string>();
-      for (const containers of this.pool.values()) {
-        for (const c of containers) {
-          activeContainerIds.add(c.containerId);
-          activeContainerIds.add(c.containerId.substring(0, 12));
+    // 2. Safety Net: Find orphaned "coderunner-session" containers not in our pool.
+    // Containers of a live sibling instance are in its pool, not orphans.
+    // While the Docker event streams are open, dead containers are dropped as they
+    // die, so listing every container is only needed now and then.
+    const sweepDue = !this.eventWatch?.connected()
+      || now - this.lastOrphanSweep >= config.sessionContainers.orphanSweepInterval;
+    if (sweepDue) {
+      try {
+        this.lastOrphanSweep = now;
+        const allSessionContainers = await listContainers({ 'type': 'coderunner-session' });
+
+        const activeContainerIds = new Set<string>();
+        const trackedIds = [
+          ...Array.from(this.pool.values()).flat().map(c => c.containerId),
+          ...Array.from(this.standby.values()).flat().map(c => c.containerId),
+          ...this.standbyPendingIds,
+        ];
+        for (const id of trackedIds) {
+          activeContainerIds.add(id);
+          activeContainerIds.add(id.substring(0, 12));
         }
-      }
 
-      const orphanedIds = allSessionContainers
-        .filter((c) => !activeContainerIds.has(c.id) && !activeContainerIds.has(c.id.substring(0, 12)))
-        .map((c) => c.id);
+        const orphanedIds = allSessionContainers
+          .filter((c) => !activeContainerIds.has(c.id) && !activeContainerIds.has(c.id.substring(0, 12)))
+          .filter((c) => clusterState.mayReap(c.labels?.[INSTANCE_LABEL], c.created, now))
+          .map((c) => c.id);
 
-      if (orphanedIds.length > 0) {
-        logger.info('Pool', `Found ${orphanedIds.length} orphaned containers. Removing...`);
-        await removeContainers(orphanedIds);
-        this.metrics.containersDeleted += orphanedIds.length;
-        cleanedCount += orphanedIds.length;
+        if (orphanedIds.length > 0) {
+          logger.info('Pool', `Found ${orphanedIds.length} orphaned containers. Removing...`);
+          await removeContainers(orphanedIds);
+          this.metrics.containersDeleted += orphanedIds.length;
+          cleanedCount += orphanedIds.length;
+        }
+      } catch (error) {
+        logger.error('Pool', `Safety net cleanup failed: ${error}`);
       }
-    } catch (error) {
-      logger.error('Pool', `Safety net cleanup failed: ${error}`);
     }
 
     const cleanupDuration = Date.now() - startTime;
@@ -178,6 +271,15 @@ class SessionContainerPool {
       .filter(c => !c.inUse && (now - c.lastUsed) > ttl)
       .length;
 
+    const firstRuns = this.metrics.standbyHits + this.metrics.standbyMisses;
+    this.metrics.standbyHitRate = firstRuns > 0 ? Math.round((this.metrics.standbyHits / firstRuns) * 100) : 0;
+    this.metrics.standbyByLanguage = {};
+    this.metrics.standbyTargets = {};
+    for (const language of Object.keys(config.runtimes)) {
+      this.metrics.standbyByLanguage[language] = this.standby.get(language)?.length ?? 0;
+      this.metrics.standbyTargets[language] = this.standbyTimer ? this.getStandbyTarget(language, now) : 0;
+    }
+
     return { ...this.metrics };
   }
 
@@ -190,7 +292,8 @@ class SessionContainerPool {
   async getOrCreateContainer(
     language: string,
     sessionId: string,
-    networkName: string
+    networkName: string,
+    variant?: ContainerVariant
   ): Promise<string> {
     const runtimeConfig = config.runtimes[language as keyof typeof config.runtimes];
     if (!runtimeConfig) {
@@ -200,7 +303,7 @@ class SessionContainerPool {
     // Check if session has an available container (fast path, no mutex needed)
     const sessionContainers = this.pool.get(sessionId) || [];
     const existingContainer = sessionContainers.find(
-      c => c.language === language && !c.inUse
+      c => c.language === language && c.variant === variant && !c.inUse && this.onHealthyHost(c)
     );
 
     if (existingContainer) {
@@ -212,7 +315,7 @@ class SessionContainerPool {
     }
 
     // No available container — use mutex to prevent duplicate creation
-    const mutexKey = `${sessionId}:${language}`;
+    const mutexKey = variant ? `${sessionId}:${language}:${variant}` : `${sessionId}:${language}`;
     const pendingPromise = this.pendingAcquisitions.get(mutexKey);
     if (pendingPromise) {
       // Another request is already creating a container for this session+language.
@@ -222,7 +325,7 @@ class SessionContainerPool {
       // Re-check after the pending creation completes
       const updatedContainers = this.pool.get(sessionId) || [];
       const nowAvailable = updatedContainers.find(
-        c => c.language === language && !c.inUse
+        c => c.language === language && c.variant === variant && !c.inUse && this.onHealthyHost(c)
       );
       if (nowAvailable) {
         nowAvailable.inUse = true;
@@ -240,46 +343,58 @@ class SessionContainerPool {
     const creationPromise = (async () => {
       const startTime = Date.now();
 
-      // Fire network and container creation at the exact same time
-      const [networkName, containerId] = await Promise.all([
+      // First run of this language in the session: hand out a standby container if one is ready
+      if (!variant) {
+        this.recordFirstRunDemand(language, startTime);
+        const standbyContainer = await this.claimStandby(language, sessionId);
+        if (standbyContainer) {
+          return standbyContainer;
+        }
+        if (this.standbyTimer) {
+          this.metrics.standbyMisses++;
+        }
+      }
+
+      // Fire network and container creation at the exact same time, on the session's host
+      const host = dockerHosts.placeSession(sessionId);
+      const [networkName, createdId] = await Promise.all([
         getOrCreateSessionNetwork(sessionId),
-        this.createContainer(language, sessionId)
+        this.createContainer(language, sessionId, variant, host)
       ]);
+      let containerId = createdId;
 
       // Connect the new container to the new network
-      await dockerClient.docker.getNetwork(networkName).connect({
-        Container: containerId
-      });
+      await dockerClient.connectToNetwork(networkName, containerId);
 
       // Start the container AFTER it's connected to the network
-      await dockerClient.startContainer(containerId);
+      let started = await this.startContainer(language, containerId, variant);
+      if (this.lacksWorkspaceAgent(containerId)) {
+        // The image has no agent after all; its next container gets no tmpfs
+        await removeContainers([containerId]);
+        containerId = await this.createContainer(language, sessionId, variant, host);
+        await dockerClient.connectToNetwork(networkName, containerId);
+        started = await this.startContainer(language, containerId, variant);
+      }
+      this.containerStarts.set(containerId, started);
 
-      // For Postgres, wait for initialization with readiness polling after start.
-      // Must use psql (not pg_isready) to verify the devdb database is actually
-      // created and accepting connections — pg_isready returns OK before init scripts
-      // finish creating the database.
       if (language === 'sql') {
-        logger.info('Pool', 'Waiting for Postgres to initialize...');
-        await waitForHealthy(
-          containerId,
-          'PGPASSWORD=root psql -U root -d devdb -c "SELECT 1" -t -A 2>&1',
-          30_000,
-          250,
-        );
-        logger.info('Pool', `Postgres ready in ${containerId.substring(0, 12)}`);
+        await this.waitForPostgres(containerId);
       }
 
       logger.debug('Pool', `Concurrent init for ${containerId.substring(0, 12)} done in ${Date.now() - startTime}ms`);
-      return { containerId, networkName };
+      return { containerId, networkName, fromStandby: false };
     })();
 
     // We only need the container ID for the mutex map
     this.pendingAcquisitions.set(mutexKey, creationPromise.then(res => res.containerId));
 
     try {
-      const { containerId, networkName } = await creationPromise;
+      const { containerId, networkName, fromStandby } = await creationPromise;
 
-      this.metrics.containersCreated++;
+      // Standby containers were counted when they were created
+      if (!fromStandby) {
+        this.metrics.containersCreated++;
+      }
       adminMetrics.trackContainerCreated(containerId);
 
       const newContainer: SessionContainer = {
@@ -289,19 +404,223 @@ class SessionContainerPool {
         networkName,
         lastUsed: Date.now(),
         inUse: true,
+        buildArtifacts: new Set(),
+        syncedFiles: new Map(),
+        variant,
       };
 
       const currentContainers = this.pool.get(sessionId) || [];
+      if (currentContainers.length === 0) {
+        clusterState.claimSession(sessionId);
+      }
       currentContainers.push(newContainer);
       this.pool.set(sessionId, currentContainers);
+      clusterState.recordContainer({
+        containerId,
+        sessionId,
+        language,
+        host: dockerHosts.containerHost(containerId),
+      });
 
-      logger.info('Pool', `Created container ${containerId.substring(0, 12)} for ${sessionId}:${language}`);
+      logger.info('Pool', `${fromStandby ? 'Assigned standby' : 'Created'} container ${containerId.substring(0, 12)} for ${sessionId}:${language}`);
       return containerId;
     } finally {
       this.pendingAcquisitions.delete(mutexKey);
     }
   }
 
+  /**
+   * Wait for Postgres to initialize with readiness polling after start.
+   * Must use psql (not pg_isready) to verify the devdb database is actually
+   * created and accepting connections — pg_isready returns OK before init scripts
+   * finish creating the database.
+   */
+  private async waitForPostgres(containerId: string): Promise<void> {
+    logger.info('Pool', 'Waiting for Postgres to initialize...');
+    await waitForHealthy(
+      containerId,
+      'PGPASSWORD=root psql -U root -d devdb -c "SELECT 1" -t -A 2>&1',
+      30_000,
+      250,
+    );
+    logger.info('Pool', `Postgres ready in ${containerId.substring(0, 12)}`);
+  }
+
+  // ─── Standby Pool ──────────────────────────────────────────────────────────
+
+  /**
+   * Start keeping standby containers for every language (PREWARM_POOL).
+   * Fills the pool right away, then rescales and refills it periodically.
+   */
+  startStandbyPool(): void {
+    if (this.standbyTimer) return;
+    logger.info('Pool', 'Starting standby container pool');
+    this.standbyTimer = setInterval(() => {
+      this.replenishStandby().catch(e => logger.error('Pool', `Standby refill failed: ${e}`));
+    }, config.sessionContainers.preWarmRefillInterval);
+    this.replenishStandby().catch(e => logger.error('Pool', `Standby refill failed: ${e}`));
+  }
+
+  /**
+   * Stop refilling and remove all standby containers.
+   */
+  async stopStandbyPool(): Promise<void> {
+    this.standbyGeneration++;
+    if (this.standbyTimer) {
+      clearInterval(this.standbyTimer);
+      this.standbyTimer = null;
+    }
+    const ids = Array.from(this.standby.values()).flat().map(c => c.containerId);
+    this.standby.clear();
+    if (ids.length > 0) {
+      await removeContainers(ids);
+      this.metrics.containersDeleted += ids.length;
+    }
+  }
+
+  /**
+   * Bring every language's standby count to its current target: create the
+   * missing containers in parallel and drop the oldest surplus ones.
+   */
+  async replenishStandby(): Promise<void> {
+    const now = Date.now();
+    const creations: Promise<void>[] = [];
+    const surplusIds: string[] = [];
+
+    for (const language of Object.keys(config.runtimes)) {
+      const target = this.getStandbyTarget(language, now);
+      const ready = this.standby.get(language) ?? [];
+      // Containers on hosts that stopped taking sessions would never be claimed
+      for (let i = ready.length - 1; i >= 0; i--) {
+        if (!dockerHosts.accepting(ready[i].host)) surplusIds.push(...ready.splice(i, 1).map(c => c.containerId));
+      }
+      const planned = ready.length + (this.standbyCreating.get(language) ?? 0);
+
+      for (let i = planned; i < target; i++) {
+        creations.push(this.createStandby(language));
+      }
+      if (planned > target && ready.length > 0) {
+        const surplus = ready.splice(0, Math.min(ready.length, planned - target));
+        surplusIds.push(...surplus.map(c => c.containerId));
+      }
+    }
+
+    if (surplusIds.length > 0) {
+      logger.info('Pool', `Shrinking standby pool by ${surplusIds.length} containers`);
+      await removeContainers(surplusIds);
+      this.metrics.containersDeleted += surplusIds.length;
+    }
+    await Promise.all(creations);
+  }
+
+  /**
+   * Current standby target for a language (base size scaled by recent demand).
+   */
+  private getStandbyTarget(language: string, now: number): number {
+    const { preWarmSize, preWarmTargets, preWarmMax } = config.sessionContainers;
+    const base = preWarmTargets[language] ?? preWarmSize;
+    return computeStandbyTarget(base, preWarmMax, this.getRecentDemand(language, now));
+  }
+
+  private recordFirstRunDemand(language: string, now: number): void {
+    const timestamps = this.firstRunDemand.get(language) ?? [];
+    timestamps.push(now);
+    this.firstRunDemand.set(language, timestamps);
+    this.getRecentDemand(language, now); // prune
+  }
+
+  /**
+   * First runs of a language within the demand window (prunes older entries).
+   */
+  private getRecentDemand(language: string, now: number): number {
+    const timestamps = this.firstRunDemand.get(language);
+    if (!timestamps) return 0;
+    const cutoff = now - config.sessionContainers.preWarmDemandWindow;
+    while (timestamps.length > 0 && timestamps[0] < cutoff) {
+      timestamps.shift();
+    }
+    return timestamps.length;
+  }
+
+  /**
+   * Create, start and (for sql) health-check one standby container.
+   */
+  private async createStandby(language: string): Promise<void> {
+    this.standbyCreating.set(language, (this.standbyCreating.get(language) ?? 0) + 1);
+    const generation = this.standbyGeneration;
+    let containerId: string | null = null;
+    const host = dockerHosts.pickHost();
+
+    try {
+      containerId = await this.createContainer(language, STANDBY_SESSION, undefined, host);
+      this.standbyPendingIds.add(containerId);
+      await this.startContainer(language, containerId);
+      if (this.lacksWorkspaceAgent(containerId)) {
+        throw new Error('no execution agent for its tmpfs workspace');
+      }
+      if (language === 'sql') {
+        await this.waitForPostgres(containerId);
+      }
+      this.metrics.containersCreated++;
+
+      if (generation !== this.standbyGeneration) {
+        // Pool was stopped while this container was starting
+        await removeContainers([containerId]);
+        return;
+      }
+
+      const ready = this.standby.get(language) ?? [];
+      ready.push({ containerId, language, host, createdAt: Date.now() });
+      this.standby.set(language, ready);
+      logger.debug('Pool', `Standby ${language} container ready: ${containerId.substring(0, 12)}`);
+    } catch (error: any) {
+      logger.warn('Pool', `Failed to create standby ${language} container: ${error.message}`);
+      if (containerId) {
+        await removeContainers([containerId]).catch(() => { /* best effort */ });
+      }
+    } finally {
+      if (containerId) this.standbyPendingIds.delete(containerId);
+      this.standbyCreating.set(language, (this.standbyCreating.get(language) ?? 1) - 1);
+    }
+  }
+
+  /**
+   * Take a ready standby container for the session and connect it to the
+   * session network. Returns null when none is available (or connecting fails).
+   * A placed session only takes standby containers on its own host; an unplaced
+   * one is placed where the standby container is.
+   */
+  private async claimStandby(
+    language: string,
+    sessionId: string
+  ): Promise<{ containerId: string; networkName: string; fromStandby: boolean } | null> {
+    const ready = this.standby.get(language);
+    const pinned = dockerHosts.sessionHost(sessionId);
+    const index = ready?.findIndex(c => pinned !== undefined ? c.host === pinned : dockerHosts.accepting(c.host)) ?? -1;
+    if (!ready || index < 0) return null;
+    const [standbyContainer] = ready.splice(index, 1);
+    dockerHosts.placeSession(sessionId, standbyContainer.host);
+
+    // Refill in the background while this one is handed out
+    if (this.standbyTimer) {
+      this.replenishStandby().catch(e => logger.error('Pool', `Standby refill failed: ${e}`));
+    }
+
+    const { containerId } = standbyContainer;
+    try {
+      const networkName = await getOrCreateSessionNetwork(sessionId);
+      await dockerClient.connectToNetwork(networkName, containerId);
+      this.metrics.standbyHits++;
+      this.containerStarts.set(containerId, { source: 'standby' });
+      return { containerId, networkName, fromStandby: true };
+    } catch (error: any) {
+      logger.warn('Pool', `Failed to assign standby container ${containerId.substring(0, 12)}: ${error.message}`);
+      await removeContainers([containerId]).catch(() => { /* best effort */ });
+      this.metrics.containersDeleted++;
+      return null;
+    }
+  }
+
   /**
    * Return container to pool after execution
    * Cleans container data and updates lastUsed timestamp
@@ -316,7 +635,7 @@ class SessionContainerPool {
     const container = sessionContainers.find(c => c.containerId === containerId);
     if (container) {
       // Clean container data before returning to pool
-      await this.cleanContainer(containerId, container.language);
+      await this.cleanContainer(container);
 
       container.inUse = false;
       container.lastUsed = Date.now();
@@ -328,13 +647,19 @@ class SessionContainerPool {
    * Clean all data from a container's /app directory and temporary build artifacts.
    * Skipped for stateless executions when SKIP_STATELESS_CLEANUP is enabled.
    */
-  private async cleanContainer(containerId: string, language?: string): Promise<void> {
+  private async cleanContainer(container: SessionContainer): Promise<void> {
+    const { containerId, language } = container;
+
     // Skip cleanup for stateless languages (files are overwritten via putArchive anyway)
-    if (config.sessionContainers.skipStatelessCleanup && language && this.isStatelessLanguage(language)) {
+    if (config.sessionContainers.skipStatelessCleanup && this.isStatelessLanguage(language)) {
       logger.debug('Pool', `Skipping cleanup for stateless ${language} container ${containerId.substring(0, 12)}`);
       return;
     }
 
+    // The wipe below removes the build cache and synced files along with everything else
+    container.buildArtifacts.clear();
+    container.syncedFiles.clear();
+
     try {
       await execInContainer(containerId, 'rm -rf /app/* /app/.* /tmp/* 2>/dev/null || true', {
         timeout: config.docker.commandTimeout,
@@ -345,6 +670,39 @@ class SessionContainerPool {
     }
   }
 
+  /**
+   * Whether a cached build artifact is known to be present in the container.
+   */
+  hasBuildArtifact(containerId: string, sessionId: string, key: string): boolean {
+    const container = this.pool.get(sessionId)?.find(c => c.containerId === containerId);
+    return container ? container.buildArtifacts.has(key) : false;
+  }
+
+  /**
+   * Remember that the container now holds the build artifact for `key`.
+   */
+  recordBuildArtifact(containerId: string, sessionId: string, key: string): void {
+    const container = this.pool.get(sessionId)?.find(c => c.containerId === containerId);
+    container?.buildArtifacts.add(key);
+  }
+
+  /**
+   * Content hashes of the user files last synced into the container, or null
+   * when the container is unknown (callers then upload everything).
+   */
+  getSyncedFiles(containerId: string, sessionId: string): Map<string, string> | null {
+    const container = this.pool.get(sessionId)?.find(c => c.containerId === containerId);
+    return container ? container.syncedFiles : null;
+  }
+
+  /**
+   * Replace the record of user files present in the container.
+   */
+  recordSyncedFiles(containerId: string, sessionId: string, hashes: Map<string, string>): void {
+    const container = this.pool.get(sessionId)?.find(c => c.containerId === containerId);
+    if (container) container.syncedFiles = hashes;
+  }
+
   /**
    * Determine if a language produces stateless executions where cleanup can be skipped.
    * Stateless: files are fully overwritten on each run (no persistent side effects).
@@ -353,13 +711,132 @@ class SessionContainerPool {
     return ['javascript', 'cpp', 'java'].includes(language);
   }
 
+  /**
+   * Main process of a session container. cpp containers can run the toolchain
+   * page-cache warmer from the cpp-runtime image instead of idling.
+   */
+  private containerCommand(language: string): string[] | undefined {
+    if (language === 'sql') return undefined;
+    let inner: string[] | undefined;
+    if (language === 'cpp' && config.cppBuild.toolchainWarmer) {
+      inner = [CPP_TOOLCHAIN_WARMER_PATH];
+    } else if (language === 'java') {
+      inner = javaContainerCommand();
+    }
+    // The execution agent supervises the resident service, or idles in place of tail
+    if (config.agent.enabled) return agentContainerCommand(inner);
+    return inner ?? ['tail', '-f', '/dev/null'];
+  }
+
+  /**
+   * Start a created container (from the language's checkpoint when
+   * CHECKPOINT_RESTORE has one ready) and connect to its execution agent.
+   */
+  private async startContainer(language: string, containerId: string, variant?: ContainerVariant): Promise<ContainerStart> {
+    // Variants run with extra capabilities, which the checkpointed template didn't have.
+    // Checkpoints are stored by the primary host's daemon, so only its containers restore
+    let outcome: StartOutcome = { restored: false };
+    if (variant || dockerHosts.containerHost(containerId) !== dockerHosts.primary()) {
+      await dockerClient.startContainer(containerId);
+    } else {
+      outcome = await checkpointManager.startContainer(language, containerId);
+    }
+    await this.attachAgent(language, containerId, outcome.restored);
+    return outcome.restored ? { source: 'restored', restoreMs: outcome.restoreMs } : { source: 'created' };
+  }
+
+  /**
+   * How the container handed out by the last getOrCreateContainer call was
+   * started. Only the first run of a new container gets an answer; reused
+   * containers report 'reused'.
+   */
+  takeContainerStart(containerId: string): ContainerStart {
+    const started = this.containerStarts.get(containerId);
+    this.containerStarts.delete(containerId);
+    return started ?? { source: 'reused' };
+  }
+
+  /**
+   * Prepare checkpoints of initialized runtime containers (CHECKPOINT_RESTORE).
+   */
+  startCheckpoints(): void {
+    checkpointManager.start(async (language) => {
+      const containerId = await this.createContainer(language, CHECKPOINT_SESSION);
+      this.standbyPendingIds.add(containerId);
+      try {
+        await dockerClient.startContainer(containerId);
+        await this.waitForRuntime(language, containerId);
+      } catch (error) {
+        this.standbyPendingIds.delete(containerId);
+        await removeContainers([containerId]).catch(() => { /* best effort */ });
+        throw error;
+      }
+      return { containerId, release: () => this.standbyPendingIds.delete(containerId) };
+    });
+  }
+
+  /**
+   * Wait until the runtime in a booted container finished initializing, which
+   * is the state a checkpoint should capture.
+   */
+  private async waitForRuntime(language: string, containerId: string): Promise<void> {
+    if (language === 'sql') {
+      await this.waitForPostgres(containerId);
+    } else if (language === 'java' && config.javaRunner.daemon) {
+      await waitForHealthy(containerId, `test -f ${JAVA_RUNNER_SPOOL}/ready`, 60_000, 250);
+    }
+  }
+
+  /**
+   * Connect to the container's execution agent so its runs bypass Docker exec.
+   * Failures only mean the container keeps using the Docker API.
+   */
+  private async attachAgent(language: string, containerId: string, restored = false): Promise<void> {
+    if (!config.agent.enabled || language === 'sql') return;
+    const image = config.runtimes[language as keyof typeof config.runtimes].image;
+    try {
+      // A restored container says nothing about the agent in fresh ones
+      await dockerClient.attachAgent(containerId, image, config.agent.helloTimeout, !restored);
+    } catch (error: any) {
+      logger.warn('Pool', `Agent attach failed for ${containerId.substring(0, 12)}: ${error.message}`);
+    }
+  }
+
+  /**
+   * tmpfs mounts for /app and /tmp (WORKSPACE_TMPFS). Uploads and reads of such
+   * a container need its agent, so images known to lack one (and sql, which has
+   * none) keep their workspace on the overlay filesystem. `exec` because compiled
+   * binaries run from /app; mode 1777 because the runtimes run as `runner`.
+   */
+  private workspaceTmpfs(language: string): Record<string, string> | undefined {
+    const { tmpfs, appSize, tmpSize } = config.workspace;
+    const image = config.runtimes[language as keyof typeof config.runtimes].image;
+    if (!tmpfs || !config.agent.enabled || language === 'sql' || dockerClient.isAgentlessImage(image)) {
+      return undefined;
+    }
+    return {
+      '/app': `rw,exec,nosuid,size=${appSize},mode=1777`,
+      '/tmp': `rw,exec,nosuid,size=${tmpSize},mode=1777`,
+    };
+  }
+
+  /**
+   * A started container with a tmpfs workspace whose agent didn't attach: files
+   * could neither be uploaded nor read, so it can't serve runs.
+   */
+  private lacksWorkspaceAgent(containerId: string): boolean {
+    return dockerClient.requiresAgent(containerId) && !dockerClient.hasAgent(containerId);
+  }
+
   /**
    * Create a new container with networking via Docker SDK.
    * Eliminates process-spawning overhead of `docker run`.
    */
   private async createContainer(
     language: string,
-    sessionId: string
+    sessionId: string,
+    variant?: ContainerVariant,
+    host?: string
   ): Promise<string> {
     const runtimeConfig = config.runtimes[language as keyof typeof config.runtimes];
 
@@ -372,15 +849,20 @@ class SessionContainerPool {
           'type': 'coderunner-session',
           'session': sessionId,
           'language': language,
+          ...(variant ? { 'variant': variant } : {}),
         },
         memory,
         cpus: config.docker.cpus,
+        capAdd: variant ? VARIANT_CAPABILITIES[variant] : undefined,
         env: language === 'sql' ? ['POSTGRES_PASSWORD=root', 'POSTGRES_USER=root', 'POSTGRES_DB=devdb'] : undefined,
-        cmd: language === 'sql' ? undefined : ['tail', '-f', '/dev/null'],
+        cmd: this.containerCommand(language),
+        openStdin: config.agent.enabled && language !== 'sql',
+        tmpfs: this.workspaceTmpfs(language),
+        host,
         // NetworkMode will be set manually via network.connect() after creation
       });
 
-      logger.info('Pool', `Container created: ${containerId.substring(0, 12)} (${language})`);
+      logger.info('Pool', `Container created: ${containerId.substring(0, 12)} (${language}${variant ? `, ${variant}` : ''}${host ? ` on ${host}` : ''})`);
 
       return containerId;
     } catch (error: any) {
@@ -389,6 +871,66 @@ class SessionContainerPool {
     }
   }
 
+  // ─── Container Events ──────────────────────────────────────────────────────
+
+  /**
+   * Follow die/destroy events of this instance's session containers
+   * (CONTAINER_EVENTS), so containers that die are dropped when it happens
+   * instead of at the next orphan sweep.
+   */
+  startEventWatch(): void {
+    if (this.eventWatch || !config.sessionContainers.containerEvents) return;
+    logger.info('Pool', 'Following Docker container events');
+    this.eventWatch = dockerClient.watchContainerEvents(
+      { 'type': 'coderunner-session', [INSTANCE_LABEL]: clusterState.instanceId },
+      (event) => this.onContainerEvent(event),
+    );
+  }
+
+  stopEventWatch(): void {
+    this.eventWatch?.stop();
+    this.eventWatch = null;
+  }
+
+  /**
+   * Drop a container Docker reports dead or removed. The pool forgets the
+   * containers it removes before removing them, so one still tracked here died
+   * on its own (e.g. its main process was OOM-killed) or was removed by someone
+   * else. Events replayed after a reconnect find nothing and are ignored.
+   */
+  onContainerEvent(event: ContainerEvent): void {
+    const { id, action } = event;
+    let found = false;
+
+    for (const [sessionId, containers] of this.pool.entries()) {
+      const index = containers.findIndex(c => c.containerId === id);
+      if (index < 0) continue;
+      containers.splice(index, 1);
+      if (containers.length === 0) {
+        this.pool.delete(sessionId);
+        clusterState.releaseSession(sessionId);
+      }
+      found = true;
+      break;
+    }
+    for (const ready of this.standby.values()) {
+      const index = ready.findIndex(c => c.containerId === id);
+      if (index >= 0) {
+        ready.splice(index, 1);
+        found = true;
+      }
+    }
+    if (!found) return;
+
+    this.containerStarts.delete(id);
+    clusterState.forgetContainers([id]);
+    this.metrics.containersLost++;
+    logger.warn('Pool', `Container ${id.substring(0, 12)} ${action === 'die' ? 'died' : 'was removed'} outside the pool; dropped it`);
+    // Removes what a dead container left behind and drops its agent connection
+    // (a 404 for a destroyed one is ignored)
+    removeContainers([id]).catch(() => { /* best effort */ });
+  }
+
   /**
    * Cleanup all containers for a specific session (on disconnect)
    */
@@ -401,14 +943,18 @@ class SessionContainerPool {
     logger.info('Pool', `Cleaning up ${sessionContainers.length} containers for session ${sessionId}`);
 
     const containerIds = sessionContainers.map(c => c.containerId);
+    containerIds.forEach(id => this.containerStarts.delete(id));
+
+    // Forgotten before removal, so their die/destroy events aren't taken for losses
+    this.pool.delete(sessionId);
+    clusterState.releaseSession(sessionId);
 
     if (containerIds.length > 0) {
       await removeContainers(containerIds);
+      clusterState.forgetContainers(containerIds);
       this.metrics.containersDeleted += containerIds.length;
       logger.info('Pool', `Deleted ${containerIds.length} containers for session ${sessionId}`);
     }
-
-    this.pool.delete(sessionId);
     logger.info('Pool', `Session ${sessionId} cleanup completed`);
   }
 
@@ -417,9 +963,22 @@ class SessionContainerPool {
    */
   async cleanupAll(): Promise<void> {
     logger.info('Pool', 'Cleaning up all session containers...');
+    this.stopEventWatch();
 
+    // Standby containers carry the same label and are removed below
+    this.standbyGeneration++;
+    if (this.standbyTimer) {
+      clearInterval(this.standbyTimer);
+      this.standbyTimer = null;
+    }
+    this.standby.clear();
+
+    // Only this instance's containers; siblings keep serving theirs
     try {
-      const allContainers = await listContainers({ 'type': 'coderunner-session' });
+      const allContainers = await listContainers({
+        'type': 'coderunner-session',
+        [INSTANCE_LABEL]: clusterState.instanceId,
+      });
       if (allContainers.length > 0) {
         logger.info('Pool', `Found ${allContainers.length} containers to clean up`);
         await removeContainers(allContainers.map((c) => c.id));
@@ -452,6 +1011,13 @@ class SessionContainerPool {
     return { totalContainers, bySession, byLanguage };
   }
 
+  /**
+   * Reusable only while its host answers; the session gets a new host otherwise
+   */
+  private onHealthyHost(container: SessionContainer): boolean {
+    return dockerHosts.isHealthy(dockerHosts.containerHost(container.containerId));
+  }
+
   /**
    * Get the number of active sessions
    */
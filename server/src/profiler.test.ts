@@ -0,0 +1,90 @@
+/**
+ * Tests for the C++ profiling mode
+ * Covers the perf command and parsing of perf stat / perf report output.
+ */
+
+import {
+  buildProfileRunCommand,
+  commForExecutable,
+  parsePerfStat,
+  parsePerfReport,
+  summarizeProfile,
+  formatProfileSummary,
+  PROFILE_DIR,
+} from './profiler';
+
+const STAT_CSV = [
+  '# started on Mon Jan  1 00:00:00 2026',
+  '',
+  '2000000,,cycles:u,1000000,100.00,,',
+  '3000000,,instructions:u,1000000,100.00,1.50,insn per cycle',
+  '100000,,cache-references:u,1000000,100.00,,',
+  '25000,,cache-misses:u,1000000,100.00,25.00,of all cache refs',
+  '400000,,branch-instructions:u,1000000,100.00,,',
+  '<not supported>,,branch-misses:u,0,100.00,,',
+].join('\n');
+
+const REPORT = [
+  '    62.50%  [.] std::_List_iterator<int>::operator++',
+  '    30.00%  [.] main',
+  '     7.50%  [k] 0xffffffff81000000',
+  '',
+].join('\n');
+
+describe('buildProfileRunCommand', () => {
+  it('should run the program under perf record and perf stat', () => {
+    const command = buildProfileRunCommand('"$C/$K"', 'abc');
+    expect(command).toContain(`P=${PROFILE_DIR}`);
+    expect(command).toContain('perf record -q');
+    expect(command).toContain('perf stat -x, -o "$2/stat.csv" -e cycles,instructions,');
+    expect(command).toContain(`sh "$C/$K" "$P"`);
+    expect(command).toContain("--comm 'abc'");
+  });
+
+  it("should exit with the program's exit code", () => {
+    expect(buildProfileRunCommand('./app', 'app')).toMatch(/exit "\$\(cat "\$P\/exit" 2>\/dev\/null \|\| echo 1\)"$/);
+  });
+});
+
+describe('commForExecutable', () => {
+  it('should truncate the basename like the kernel does', () => {
+    expect(commForExecutable('.coderunner/cache/0123456789abcdef0123')).toBe('0123456789abcde');
+    expect(commForExecutable('app')).toBe('app');
+  });
+});
+
+describe('parsePerfStat', () => {
+  it('should parse counters and mark unsupported events as null', () => {
+    const counters = parsePerfStat(STAT_CSV);
+    expect(counters.cycles).toBe(2000000);
+    expect(counters.instructions).toBe(3000000);
+    expect(counters['branch-misses']).toBeNull();
+  });
+});
+
+describe('parsePerfReport', () => {
+  it('should list functions by sample share', () => {
+    expect(parsePerfReport(REPORT)).toEqual([
+      { symbol: 'std::_List_iterator<int>::operator++', percent: 62.5 },
+      { symbol: 'main', percent: 30 },
+      { symbol: '0xffffffff81000000', percent: 7.5 },
+    ]);
+  });
+});
+
+describe('summarizeProfile', () => {
+  it('should derive IPC and miss rates', () => {
+    const summary = summarizeProfile(STAT_CSV, REPORT);
+    expect(summary.available).toBe(true);
+    expect(summary.ipc).toBe(1.5);
+    expect(summary.cacheMissRate).toBe(25);
+    expect(summary.branchMissRate).toBeNull();
+    expect(summary.hotspots).toHaveLength(3);
+  });
+
+  it('should report unavailable counters when perf produced nothing', () => {
+    const summary = summarizeProfile('', '');
+    expect(summary.available).toBe(false);
+    expect(formatProfileSummary(summary)).toContain('not available');
+  });
+});
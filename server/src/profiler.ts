@@ -0,0 +1,188 @@
+/**
+ * C++ Profiling Mode
+ *
+ * `profile` runs execute the compiled binary under Linux perf inside the
+ * cpp-runtime container:
+ *
+ *   perf record (per-function sampling)
+ *     └─ perf stat (hardware counters, counts only the program)
+ *          └─ program
+ *
+ * Both write their results under /app/.coderunner/profile; once the exec has
+ * finished the server reads them back and turns them into a ProfileSummary that
+ * is sent with the `exit` event.
+ *
+ * perf needs CAP_PERFMON. Profiling runs get a dedicated session container
+ * created with that capability in its bounding set, and the image grants it to
+ * the perf binary only (file capability), so the program itself runs unprivileged.
+ */
+
+import { readFile } from './dockerClient';
+import { shellEscape } from './shell';
+import type { RunWrapper } from './cppBuild';
+
+/** Profiler output directory inside the container, relative to /app */
+export const PROFILE_DIR = '.coderunner/profile';
+
+/** Hardware counters collected by perf stat */
+export const PROFILE_EVENTS = [
+  'cycles',
+  'instructions',
+  'cache-references',
+  'cache-misses',
+  'branch-instructions',
+  'branch-misses',
+] as const;
+
+export type ProfileEvent = typeof PROFILE_EVENTS[number];
+
+/** Sampling frequency for per-function attribution (Hz) */
+const SAMPLE_FREQUENCY = 999;
+
+/** Functions listed in the summary */
+const MAX_HOTSPOTS = 15;
+
+export interface ProfileHotspot {
+  symbol: string;
+  /** Share of sampled cycles, in percent */
+  percent: number;
+}
+
+export interface ProfileSummary {
+  /** False when perf could not count anything (no PMU access on the host) */
+  available: boolean;
+  /** Raw counter values; null when the event isn't supported */
+  counters: Record<ProfileEvent, number | null>;
+  /** Instructions per cycle */
+  ipc: number | null;
+  /** cache-misses / cache-references, in percent */
+  cacheMissRate: number | null;
+  /** branch-misses / branch-instructions, in percent */
+  branchMissRate: number | null;
+  hotspots: ProfileHotspot[];
+}
+
+/**
+ * Shell snippet that runs `binary` under perf and leaves the program's exit
+ * code as the exit status of the command. `comm` is the process name perf
+ * reports the program under (executable basename, truncated by the kernel).
+ */
+export function buildProfileRunCommand(binary: string, comm: string): string {
+  const events = PROFILE_EVENTS.join(',');
+  return [
+    `P=${PROFILE_DIR}`,
+    'rm -rf "$P"',
+    'mkdir -p "$P"',
+    // The inner shell records the program's own exit code; perf record's exit
+    // status is not the workload's
+    `perf record -q -F ${SAMPLE_FREQUENCY} -o "$P/perf.data" -- ` +
+    `sh -c 'perf stat -x, -o "$2/stat.csv" -e ${events} -- "$1"; echo $? > "$2/exit"' sh ${binary} "$P"`,
+    `perf report -i "$P/perf.data" --stdio --no-children --sort symbol -q --comm ${shellEscape(comm)} > "$P/report.txt" 2>/dev/null`,
+    'rm -f "$P/perf.data"',
+    'exit "$(cat "$P/exit" 2>/dev/null || echo 1)"',
+  ].join('; ');
+}
+
+/** Run wrapper for planCppBuild in profiling mode */
+export const profileRunWrapper: RunWrapper = (binary, executablePath) =>
+  buildProfileRunCommand(binary, commForExecutable(executablePath));
+
+/**
+ * Process name of an executable as perf sees it (kernel TASK_COMM_LEN - 1).
+ */
+export function commForExecutable(executablePath: string): string {
+  return (executablePath.split('/').pop() || executablePath).substring(0, 15);
+}
+
+/**
+ * Parse `perf stat -x,` output. Lines look like
+ *   123456,,cycles:u,1000,100.00,,
+ *   <not supported>,,cache-misses:u,0,100.00,,
+ */
+export function parsePerfStat(csv: string): Record<ProfileEvent, number | null> {
+  const counters = Object.fromEntries(PROFILE_EVENTS.map(e => [e, null])) as Record<ProfileEvent, number | null>;
+
+  for (const line of csv.split('\n')) {
+    if (!line || line.startsWith('#')) continue;
+    const fields = line.split(',');
+    if (fields.length < 3) continue;
+
+    const event = fields[2].replace(/:.*$/, '') as ProfileEvent;
+    if (!PROFILE_EVENTS.includes(event)) continue;
+
+    const value = Number(fields[0]);
+    counters[event] = fields[0] !== '' && Number.isFinite(value) ? value : null;
+  }
+  return counters;
+}
+
+/**
+ * Parse `perf report --stdio --sort symbol -q` output. Lines look like
+ *   45.32%  [.] std::_List_iterator<int>::operator++
+ */
+export function parsePerfReport(report: string): ProfileHotspot[] {
+  const hotspots: ProfileHotspot[] = [];
+  for (const line of report.split('\n')) {
+    const match = /^\s*([\d.]+)%\s+\[[^\]]+\]\s+(.+?)\s*$/.exec(line);
+    if (!match) continue;
+    hotspots.push({ symbol: match[2], percent: Number(match[1]) });
+    if (hotspots.length >= MAX_HOTSPOTS) break;
+  }
+  return hotspots;
+}
+
+function ratio(numerator: number | null, denominator: number | null, scale: number): number | null {
+  if (numerator === null || denominator === null || denominator === 0) return null;
+  return Math.round((numerator / denominator) * scale * 100) / 100;
+}
+
+/**
+ * Build the summary from the raw perf outputs.
+ */
+export function summarizeProfile(statCsv: string, report: string): ProfileSummary {
+  const counters = parsePerfStat(statCsv);
+  return {
+    available: Object.values(counters).some(v => v !== null),
+    counters,
+    ipc: ratio(counters.instructions, counters.cycles, 1),
+    cacheMissRate: ratio(counters['cache-misses'], counters['cache-references'], 100),
+    branchMissRate: ratio(counters['branch-misses'], counters['branch-instructions'], 100),
+    hotspots: parsePerfReport(report),
+  };
+}
+
+/**
+ * Read the profiler output of the last run out of the container.
+ */
+export async function collectProfile(containerId: string): Promise<ProfileSummary> {
+  const [stat, report] = await Promise.all([
+    readFile(containerId, `/app/${PROFILE_DIR}/stat.csv`),
+    readFile(containerId, `/app/${PROFILE_DIR}/report.txt`),
+  ]);
+  return summarizeProfile(stat?.toString('utf-8') ?? '', report?.toString('utf-8') ?? '');
+}
+
+/**
+ * Human-readable rendering of a summary for the console.
+ */
+export function formatProfileSummary(summary: ProfileSummary): string {
+  if (!summary.available) {
+    return '[Profile] Hardware counters are not available on this host\n';
+  }
+
+  const format = (v: number | null) => (v === null ? 'n/a' : v.toLocaleString('en-US'));
+  const lines = [
+    '[Profile]',
+    ...PROFILE_EVENTS.map(e => `  ${e.padEnd(20)} ${format(summary.counters[e])}`),
+    `  ${'IPC'.padEnd(20)} ${format(summary.ipc)}`,
+    `  ${'cache miss rate'.padEnd(20)} ${summary.cacheMissRate === null ? 'n/a' : `${summary.cacheMissRate}%`}`,
+    `  ${'branch miss rate'.padEnd(20)} ${summary.branchMissRate === null ? 'n/a' : `${summary.branchMissRate}%`}`,
+  ];
+  if (summary.hotspots.length > 0) {
+    lines.push('  Hottest functions:');
+    for (const hotspot of summary.hotspots) {
+      lines.push(`    ${hotspot.percent.toFixed(2).padStart(6)}%  ${hotspot.symbol}`);
+    }
+  }
+  return lines.join('\n') + '\n';
+}
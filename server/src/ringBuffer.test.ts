@@ -0,0 +1,44 @@
+/**
+ * Tests for the fixed-capacity ring buffer
+ */
+
+import { RingBuffer } from './ringBuffer';
+
+describe('RingBuffer', () => {
+  it('should keep items in order until full', () => {
+    const ring = new RingBuffer<number>(3);
+    ring.push(1);
+    ring.push(2);
+    expect(ring.size).toBe(2);
+    expect(ring.toArray()).toEqual([1, 2]);
+    expect(ring.newest()).toBe(2);
+  });
+
+  it('should overwrite the oldest items once full', () => {
+    const ring = new RingBuffer<number>(3);
+    for (let i = 1; i <= 5; i++) ring.push(i);
+    expect(ring.size).toBe(3);
+    expect(ring.toArray()).toEqual([3, 4, 5]);
+    expect(ring.fromNewest(0)).toBe(5);
+    expect(ring.fromNewest(2)).toBe(3);
+    expect(ring.fromNewest(3)).toBeUndefined();
+  });
+
+  it('should return the newest items oldest first', () => {
+    const ring = new RingBuffer<number>(4);
+    for (let i = 1; i <= 6; i++) ring.push(i);
+    expect(ring.last(2)).toEqual([5, 6]);
+    expect(ring.last(10)).toEqual([3, 4, 5, 6]);
+    expect(ring.last(0)).toEqual([]);
+  });
+
+  it('should empty on clear', () => {
+    const ring = new RingBuffer<string>(2);
+    ring.push('a');
+    ring.clear();
+    expect(ring.size).toBe(0);
+    expect(ring.newest()).toBeUndefined();
+    ring.push('b');
+    expect(ring.toArray()).toEqual(['b']);
+  });
+});
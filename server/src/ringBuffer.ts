@@ -0,0 +1,59 @@
+/**
+ * Fixed-capacity ring buffer
+ *
+ * Keeps the newest `capacity` items; pushing onto a full buffer overwrites the
+ * oldest one in O(1), where Array#shift() would move every element.
+ */
+
+export class RingBuffer<T> {
+  private items: (T | undefined)[];
+  /** Index of the next write */
+  private head = 0;
+  private length = 0;
+
+  constructor(readonly capacity: number) {
+    if (capacity < 1) throw new Error('RingBuffer capacity must be at least 1');
+    this.items = new Array(capacity);
+  }
+
+  get size(): number {
+    return this.length;
+  }
+
+  push(item: T): void {
+    this.items[this.head] = item;
+    this.head = (this.head + 1) % this.capacity;
+    if (this.length < this.capacity) this.length++;
+  }
+
+  /** The i-th newest item (0 = newest), or undefined */
+  fromNewest(i: number): T | undefined {
+    if (i < 0 || i >= this.length) return undefined;
+    return this.items[(this.head - 1 - i + this.capacity) % this.capacity];
+  }
+
+  newest(): T | undefined {
+    return this.fromNewest(0);
+  }
+
+  /** Up to `count` newest items, oldest first */
+  last(count: number): T[] {
+    const n = Math.max(0, Math.min(count, this.length));
+    const out: T[] = new Array(n);
+    for (let i = 0; i < n; i++) {
+      out[n - 1 - i] = this.fromNewest(i) as T;
+    }
+    return out;
+  }
+
+  /** All items, oldest first */
+  toArray(): T[] {
+    return this.last(this.length);
+  }
+
+  clear(): void {
+    this.items = new Array(this.capacity);
+    this.head = 0;
+    this.length = 0;
+  }
+}
@@ -0,0 +1,125 @@
+/**
+ * Tests for the shared Postgres SQL backend
+ * Docker is mocked; assertions are on the SQL and exec options sent to it.
+ */
+
+jest.mock('./dockerClient', () => {
+  let nextId = 0;
+  return {
+    createContainer: jest.fn(async () => `server-${++nextId}-0123456789abcdef`),
+    startContainer: jest.fn().mockResolvedValue(undefined),
+    execInContainer: jest.fn().mockResolvedValue({ stdout: '', stderr: '', exitCode: 0 }),
+    putFiles: jest.fn().mockResolvedValue(1024),
+    removeContainers: jest.fn().mockResolvedValue(undefined),
+    listContainers: jest.fn().mockResolvedValue([]),
+  };
+});
+
+import { SharedPostgres, TEMPLATE_DATABASE, sessionDatabaseName } from './sharedPostgres';
+import { config } from './config';
+import * as dockerClient from './dockerClient';
+
+const mockDocker = dockerClient as jest.Mocked<typeof dockerClient>;
+
+/** SQL scripts passed to admin psql calls (via the CR_SQL environment variable) */
+function adminScripts(): string[] {
+  return mockDocker.execInContainer.mock.calls
+    .map(([, , options]) => options?.env?.find(e => e.startsWith('CR_SQL='))?.substring('CR_SQL='.length))
+    .filter((sql): sql is string => sql !== undefined);
+}
+
+describe('SharedPostgres', () => {
+  let backend: SharedPostgres;
+
+  beforeEach(async () => {
+    jest.clearAllMocks();
+    backend = new SharedPostgres({ ...config.sqlBackend, mode: 'shared', servers: 2, templateSeed: '' });
+    await backend.start();
+  });
+
+  afterEach(async () => {
+    await backend.stop();
+  });
+
+  it('should start the servers and build the template', () => {
+    expect(backend.enabled).toBe(true);
+    expect(mockDocker.createContainer).toHaveBeenCalledTimes(2);
+    expect(mockDocker.createContainer.mock.calls[0][0].labels).toEqual({ type: 'coderunner-sql-server' });
+    const scripts = adminScripts();
+    expect(scripts.some(sql => sql.includes(`CREATE DATABASE ${TEMPLATE_DATABASE};`))).toBe(true);
+    expect(scripts.some(sql => sql.includes(`ALTER DATABASE ${TEMPLATE_DATABASE} IS_TEMPLATE true;`))).toBe(true);
+  });
+
+  it('should clone a session database from the template without exposing passwords in argv', async () => {
+    mockDocker.execInContainer.mockClear();
+    const target = await backend.acquire('session-1');
+
+    const name = sessionDatabaseName('session-1');
+    expect(target.database).toBe(name);
+    expect(target.reused).toBe(false);
+
+    const setup = adminScripts().join('\n');
+    expect(setup).toContain(`CREATE DATABASE ${name} OWNER ${name} TEMPLATE ${TEMPLATE_DATABASE};`);
+    expect(setup).toContain(`REVOKE CONNECT, TEMPORARY ON DATABASE ${name} FROM PUBLIC;`);
+
+    const password = target.options.env[0].substring('PGPASSWORD='.length);
+    for (const [, command] of mockDocker.execInContainer.mock.calls) {
+      expect(command).not.toContain(password);
+    }
+    expect(backend.runCommand(target, 'query.sql')).not.toContain(password);
+  });
+
+  it('should create each session database once', async () => {
+    const [a, b] = await Promise.all([backend.acquire('session-1'), backend.acquire('session-1')]);
+    const again = await backend.acquire('session-1');
+
+    expect(a.database).toBe(b.database);
+    expect(again.reused).toBe(true);
+    expect(adminScripts().filter(sql => sql.includes('CREATE ROLE'))).toHaveLength(1);
+  });
+
+  it('should run sessions as distinct users spread across servers', async () => {
+    const a = await backend.acquire('session-1');
+    const b = await backend.acquire('session-2');
+
+    expect(a.options.user).not.toBe(b.options.user);
+    expect(a.containerId).not.toBe(b.containerId);
+    expect(a.options.workDir).not.toBe(b.options.workDir);
+  });
+
+  it('should upload files into a fresh session directory', async () => {
+    const target = await backend.acquire('session-1');
+    mockDocker.execInContainer.mockClear();
+
+    const result = await backend.syncFiles(target, [{ path: 'query.sql', content: 'SELECT 1;' }]);
+
+    expect(mockDocker.execInContainer.mock.calls[0][1]).toContain(`chown ${target.options.user} ${target.options.workDir}`);
+    expect(mockDocker.putFiles).toHaveBeenCalledWith(target.containerId, expect.any(Array), target.options.workDir);
+    expect(result.bytesSent).toBe(1024);
+  });
+
+  it('should drop the database when the session is released', async () => {
+    const target = await backend.acquire('session-1');
+    await backend.releaseSession('session-1');
+
+    expect(adminScripts().some(sql => sql.includes(`DROP DATABASE IF EXISTS ${target.database} WITH (FORCE);`))).toBe(true);
+    expect(backend.getStats().sessions).toBe(0);
+    expect((await backend.acquire('session-1')).reused).toBe(false);
+  });
+
+  it('should drop databases of idle sessions', async () => {
+    await backend.acquire('session-1');
+    await backend.releaseIdle(Date.now() + config.sessionContainers.ttl + 1);
+
+    expect(backend.getStats().sessions).toBe(0);
+    expect(backend.getStats().databasesDropped).toBe(1);
+  });
+
+  it('should stay disabled in container mode', async () => {
+    const containerMode = new SharedPostgres({ ...config.sqlBackend, mode: 'container' });
+    await containerMode.start();
+
+    expect(containerMode.enabled).toBe(false);
+    await expect(containerMode.acquire('session-1')).rejects.toThrow('not running');
+  });
+});
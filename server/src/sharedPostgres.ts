@@ -0,0 +1,408 @@
+/**
+ * Shared Postgres backend for SQL runs (SQL_BACKEND=shared)
+ *
+ * Instead of booting a postgres-runtime container per session and polling it
+ * until devdb exists, a few long-lived servers are started with the server and
+ * every session gets a database cloned from a pre-seeded template plus a login
+ * role that owns nothing else. Session setup is a CREATE ROLE / CREATE DATABASE
+ * round trip, and the database is dropped when the session ends or idles out.
+ *
+ * Isolation between sessions on the same server:
+ *   - password auth everywhere (also on the local socket); the admin password
+ *     only ever travels in exec environments, never on a command line
+ *   - CONNECT on session databases, the template and `postgres` is revoked from
+ *     PUBLIC, so a role can only reach its own database
+ *   - psql runs as a per-session uid in a 0700 directory holding the session's
+ *     files, so `\!` cannot read other sessions' files or environments
+ */
+
+import { createHash, randomBytes } from 'crypto';
+import * as fs from 'fs';
+import { config } from './config';
+import { logger } from './logger';
+import {
+  createContainer,
+  startContainer,
+  execInContainer,
+  putFiles,
+  removeContainers,
+  listContainers,
+  type FileEntry,
+} from './dockerClient';
+import type { FileSyncResult } from './fileSync';
+import { shellEscape } from './shell';
+import { clusterState, INSTANCE_LABEL } from './clusterState';
+
+export const TEMPLATE_DATABASE = 'coderunner_template';
+const SERVER_LABEL = 'coderunner-sql-server';
+const SESSION_ROOT = '/sessions';
+/** Session directories and psql processes use uid BASE_UID + slot */
+const BASE_UID = 20000;
+const READY_TIMEOUT_MS = 60_000;
+const READY_POLL_MS = 250;
+
+type SqlBackendOptions = typeof config.sqlBackend;
+
+interface SharedServer {
+  containerId: string;
+  sessions: number;
+}
+
+interface SqlSession {
+  server: SharedServer;
+  /** Database and role name */
+  name: string;
+  password: string;
+  slot: number;
+  lastUsed: number;
+}
+
+/** Where and how a session's psql runs */
+export interface SqlRunTarget {
+  containerId: string;
+  database: string;
+  /** False on the session's first run (fresh database) */
+  reused: boolean;
+  options: { workDir: string; user: string; env: string[] };
+}
+
+/**
+ * Database/role name for a session. Session ids are client-supplied, so they
+ * are hashed into a safe identifier rather than quoted.
+ */
+export function sessionDatabaseName(sessionId: string): string {
+  return `cr_${createHash('sha256').update(sessionId).digest('hex').substring(0, 24)}`;
+}
+
+/**
+ * SQL that (re)creates a session's role and database from the template.
+ */
+export function sessionSetupSql(name: string, password: string, connectionLimit: number): string {
+  return [
+    `DROP DATABASE IF EXISTS ${name} WITH (FORCE);`,
+    `DROP ROLE IF EXISTS ${name};`,
+    `CREATE ROLE ${name} LOGIN PASSWORD '${password}' NOSUPERUSER NOCREATEDB NOCREATEROLE NOREPLICATION CONNECTION LIMIT ${connectionLimit};`,
+    `CREATE DATABASE ${name} OWNER ${name} TEMPLATE ${TEMPLATE_DATABASE};`,
+    `REVOKE CONNECT, TEMPORARY ON DATABASE ${name} FROM PUBLIC;`,
+  ].join('\n');
+}
+
+export function sessionTeardownSql(name: string): string {
+  return [
+    `DROP DATABASE IF EXISTS ${name} WITH (FORCE);`,
+    `DROP ROLE IF EXISTS ${name};`,
+  ].join('\n');
+}
+
+export class SharedPostgres {
+  private readonly options: SqlBackendOptions;
+  private readonly adminPassword = randomBytes(24).toString('hex');
+  private servers: SharedServer[] = [];
+  private sessions: Map<string, SqlSession> = new Map();
+  private pending: Map<string, Promise<SqlSession>> = new Map();
+  private usedSlots: Set<number> = new Set();
+  private sweepTimer: NodeJS.Timeout | null = null;
+  private ready = false;
+  private metrics = { databasesCreated: 0, databasesDropped: 0, setupErrors: 0 };
+
+  constructor(options: SqlBackendOptions = config.sqlBackend) {
+    this.options = options;
+  }
+
+  /** True once the shared servers are up; SQL falls back to containers otherwise */
+  get enabled(): boolean {
+    return this.ready;
+  }
+
+  /**
+   * Start the shared servers and build the template (SQL_BACKEND=shared only).
+   */
+  async start(): Promise<void> {
+    if (this.options.mode !== 'shared' || this.ready) return;
+    const startTime = Date.now();
+
+    // Servers left behind by a previous run hold databases nobody owns any more;
+    // those of a live sibling instance still serve its sessions
+    const leftovers = (await listContainers({ 'type': SERVER_LABEL }))
+      .filter(c => clusterState.mayReap(c.labels?.[INSTANCE_LABEL], c.created));
+    if (leftovers.length > 0) {
+      await removeContainers(leftovers.map(c => c.id));
+    }
+
+    const seed = this.options.templateSeed ? fs.readFileSync(this.options.templateSeed, 'utf-8') : null;
+    const results = await Promise.allSettled(
+      Array.from({ length: Math.max(1, this.options.servers) }, () => this.startServer(seed)),
+    );
+
+    for (const result of results) {
+      if (result.status === 'fulfilled') {
+        this.servers.push(result.value);
+      } else {
+        logger.error('SharedPostgres', `Failed to start server: ${result.reason?.message ?? result.reason}`);
+      }
+    }
+    if (this.servers.length === 0) {
+      throw new Error('No shared Postgres server could be started');
+    }
+
+    this.sweepTimer = setInterval(() => {
+      this.releaseIdle().catch(e => logger.error('SharedPostgres', `Idle cleanup failed: ${e}`));
+    }, config.sessionContainers.cleanupInterval);
+    this.ready = true;
+    logger.info('SharedPostgres', `${this.servers.length} shared server(s) ready in ${Date.now() - startTime}ms`);
+  }
+
+  /**
+   * Remove the shared servers (and with them every session database).
+   */
+  async stop(): Promise<void> {
+    this.ready = false;
+    if (this.sweepTimer) {
+      clearInterval(this.sweepTimer);
+      this.sweepTimer = null;
+    }
+    const ids = this.servers.map(s => s.containerId);
+    this.servers = [];
+    this.sessions.clear();
+    this.usedSlots.clear();
+    if (ids.length > 0) {
+      await removeContainers(ids);
+    }
+  }
+
+  /**
+   * The session's database, created from the template on first use.
+   */
+  async acquire(sessionId: string): Promise<SqlRunTarget> {
+    if (!this.ready) {
+      throw new Error('Shared Postgres backend is not running');
+    }
+
+    let session = this.sessions.get(sessionId);
+    const reused = session !== undefined;
+    if (!session) {
+      let creation = this.pending.get(sessionId);
+      if (!creation) {
+        creation = this.createSession(sessionId);
+        this.pending.set(sessionId, creation);
+        creation.finally(() => this.pending.delete(sessionId)).catch(() => { /* handled by awaiter */ });
+      }
+      session = await creation;
+    }
+    session.lastUsed = Date.now();
+
+    return {
+      containerId: session.server.containerId,
+      database: session.name,
+      reused,
+      options: {
+        workDir: `${SESSION_ROOT}/${session.name}`,
+        user: `${BASE_UID + session.slot}:${BASE_UID + session.slot}`,
+        env: [`PGPASSWORD=${session.password}`],
+      },
+    };
+  }
+
+  /**
+   * psql invocation for a run; connects over the local socket as the session role.
+   */
+  runCommand(target: SqlRunTarget, entryFile: string): string {
+    return `psql -X -U ${target.database} -d ${target.database} -f ${shellEscape(entryFile)}`;
+  }
+
+  /**
+   * Replace the files in the session's directory with `files`.
+   */
+  async syncFiles(target: SqlRunTarget, files: FileEntry[]): Promise<FileSyncResult> {
+    const dir = target.options.workDir;
+    const uid = target.options.user;
+    // Recreating the directory drops files removed from the project
+    await this.exec(target.containerId,
+      `rm -rf ${dir} && mkdir -m 700 ${dir} && chown ${uid} ${dir}`);
+    const bytesSent = files.length > 0 ? await putFiles(target.containerId, files, dir) : 0;
+    return { bytesSent, uploaded: files.length, removed: 0, unchanged: 0 };
+  }
+
+  /**
+   * Drop a session's database and role (on disconnect or idle expiry).
+   */
+  async releaseSession(sessionId: string): Promise<void> {
+    const pending = this.pending.get(sessionId);
+    if (pending) {
+      await pending.catch(() => { /* nothing to release */ });
+    }
+    const session = this.sessions.get(sessionId);
+    if (!session) return;
+
+    this.sessions.delete(sessionId);
+    session.server.sessions--;
+    try {
+      await this.adminSql(session.server, sessionTeardownSql(session.name));
+      await this.exec(session.server.containerId, `rm -rf ${SESSION_ROOT}/${session.name}`);
+      this.metrics.databasesDropped++;
+    } catch (error: any) {
+      logger.error('SharedPostgres', `Failed to drop database ${session.name}: ${error.message}`);
+    } finally {
+      this.usedSlots.delete(session.slot);
+    }
+  }
+
+  /**
+   * Drop databases of sessions idle longer than the session TTL.
+   */
+  async releaseIdle(now: number = Date.now()): Promise<void> {
+    const expired = Array.from(this.sessions.entries())
+      .filter(([, session]) => now - session.lastUsed > config.sessionContainers.ttl)
+      .map(([sessionId]) => sessionId);
+    for (const sessionId of expired) {
+      logger.info('SharedPostgres', `Dropping idle session database for ${sessionId}`);
+      await this.releaseSession(sessionId);
+    }
+  }
+
+  getStats() {
+    return {
+      enabled: this.ready,
+      servers: this.servers.map(s => ({ containerId: s.containerId.substring(0, 12), sessions: s.sessions })),
+      sessions: this.sessions.size,
+      ...this.metrics,
+    };
+  }
+
+  private async createSession(sessionId: string): Promise<SqlSession> {
+    const server = this.servers.reduce((least, s) => (s.sessions < least.sessions ? s : least));
+    const name = sessionDatabaseName(sessionId);
+    const password = randomBytes(18).toString('hex');
+    const slot = this.allocateSlot();
+    server.sessions++;
+
+    try {
+      await this.adminSql(server, sessionSetupSql(name, password, this.options.sessionConnectionLimit));
+    } catch (error) {
+      server.sessions--;
+      this.usedSlots.delete(slot);
+      this.metrics.setupErrors++;
+      throw error;
+    }
+
+    const session: SqlSession = { server, name, password, slot, lastUsed: Date.now() };
+    this.sessions.set(sessionId, session);
+    this.metrics.databasesCreated++;
+    logger.debug('SharedPostgres', `Database ${name} created for ${sessionId}`);
+    return session;
+  }
+
+  private allocateSlot(): number {
+    let slot = 0;
+    while (this.usedSlots.has(slot)) slot++;
+    this.usedSlots.add(slot);
+    return slot;
+  }
+
+  private async startServer(seed: string | null): Promise<SharedServer> {
+    const o = this.options;
+    const containerId = await createContainer({
+      image: config.runtimes.sql.image,
+      labels: { 'type': SERVER_LABEL },
+      memory: o.serverMemory,
+      cpus: o.serverCpus,
+      env: [
+        `POSTGRES_PASSWORD=${this.adminPassword}`,
+        'POSTGRES_USER=postgres',
+        'POSTGRES_DB=postgres',
+        // Password auth on the local socket too: sessions run psql inside this container
+        'POSTGRES_INITDB_ARGS=--auth-local=scram-sha-256 --auth-host=scram-sha-256',
+      ],
+      // Same settings as the image's CMD, sized for many sessions
+      cmd: [
+        'postgres',
+        '-c', 'fsync=off',
+        '-c', 'synchronous_commit=off',
+        '-c', 'full_page_writes=off',
+        '-c', 'shared_buffers=128MB',
+        '-c', 'wal_level=minimal',
+        '-c', 'max_wal_senders=0',
+        '-c', 'checkpoint_timeout=30min',
+        '-c', `max_connections=${o.maxConnections}`,
+      ],
+    });
+    const server: SharedServer = { containerId, sessions: 0 };
+
+    try {
+      await startContainer(containerId);
+      await this.waitForServer(server);
+
+      await this.adminSql(server, [
+        `CREATE DATABASE ${TEMPLATE_DATABASE};`,
+        `REVOKE CONNECT, TEMPORARY ON DATABASE ${TEMPLATE_DATABASE} FROM PUBLIC;`,
+        'REVOKE CONNECT, TEMPORARY ON DATABASE postgres FROM PUBLIC;',
+        'REVOKE CONNECT ON DATABASE template1 FROM PUBLIC;',
+      ].join('\n'));
+
+      if (seed) {
+        // Seeds can exceed what fits in an environment variable; load them from a file
+        await putFiles(containerId, [{ path: 'template-seed.sql', content: seed, mode: 0o600 }], '/tmp');
+        await this.exec(containerId,
+          `psql -X -q -v ON_ERROR_STOP=1 -U postgres -d ${TEMPLATE_DATABASE} -f /tmp/template-seed.sql; ` +
+          'status=$?; rm -f /tmp/template-seed.sql; exit $status',
+          [`PGPASSWORD=${this.adminPassword}`]);
+        // Seeded objects belong to the admin role; session roles get full use of them
+        await this.adminSql(server, [
+          'GRANT ALL ON ALL TABLES IN SCHEMA public TO PUBLIC;',
+          'GRANT ALL ON ALL SEQUENCES IN SCHEMA public TO PUBLIC;',
+        ].join('\n'), TEMPLATE_DATABASE);
+      }
+
+      await this.adminSql(server, `ALTER DATABASE ${TEMPLATE_DATABASE} IS_TEMPLATE true;`);
+      await this.exec(containerId, `mkdir -p ${SESSION_ROOT} && chmod 711 ${SESSION_ROOT}`);
+      return server;
+    } catch (error) {
+      await removeContainers([containerId]).catch(() => { /* best effort */ });
+      throw error;
+    }
+  }
+
+  /**
+   * Poll until the server accepts authenticated connections (init scripts done).
+   */
+  private async waitForServer(server: SharedServer): Promise<void> {
+    const start = Date.now();
+    while (Date.now() - start < READY_TIMEOUT_MS) {
+      try {
+        await this.adminSql(server, 'SELECT 1;');
+        return;
+      } catch {
+        // Not ready yet
+      }
+      await new Promise(r => setTimeout(r, READY_POLL_MS));
+    }
+    throw new Error(`Shared Postgres ${server.containerId.substring(0, 12)} not ready after ${READY_TIMEOUT_MS}ms`);
+  }
+
+  /**
+   * Run SQL as the admin role. The script is passed through the exec environment
+   * and piped into psql so neither it nor the password shows up in argv.
+   */
+  private async adminSql(server: SharedServer, sql: string, database: string = 'postgres'): Promise<void> {
+    const result = await execInContainer(
+      server.containerId,
+      `printf '%s' "$CR_SQL" | psql -X -q -v ON_ERROR_STOP=1 -U postgres -d ${database} -f -`,
+      {
+        timeout: config.docker.commandTimeout,
+        env: [`PGPASSWORD=${this.adminPassword}`, `CR_SQL=${sql}`],
+      },
+    );
+    if (result.exitCode !== 0) {
+      throw new Error(`psql failed: ${result.stderr.trim() || `exit code ${result.exitCode}`}`);
+    }
+  }
+
+  private async exec(containerId: string, command: string, env?: string[]): Promise<void> {
+    const result = await execInContainer(containerId, command, { timeout: config.docker.commandTimeout, env });
+    if (result.exitCode !== 0) {
+      throw new Error(`Command failed: ${result.stderr.trim() || `exit code ${result.exitCode}`}`);
+    }
+  }
+}
+
+export const sharedPostgres = new SharedPostgres();
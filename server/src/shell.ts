@@ -0,0 +1,12 @@
+/**
+ * Shell helpers shared by the command builders that run inside containers.
+ */
+
+/**
+ * Shell-escape a filename for safe use in shell commands.
+ * Uses single quotes which prevent all shell interpretation.
+ */
+export function shellEscape(arg: string): string {
+  // Replace single quotes with '\'' (end quote, escaped quote, start quote)
+  return "'" + arg.replace(/'/g, "'\\''") + "'";
+}
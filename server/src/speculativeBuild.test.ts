@@ -0,0 +1,113 @@
+/**
+ * Tests for speculative builds
+ * Covers the build-only commands and how builds and runs of a session interact.
+ */
+
+import { SpeculativeBuildTracker, speculativeBuildCommand } from './speculativeBuild';
+import { planCppBuild } from './cppBuild';
+import { javaBuildKey } from './javaRunner';
+
+const cppFiles = [{ path: 'main.cpp', content: 'int main() { return 0; }' }];
+const javaFiles = [{ path: 'Main.java', content: 'class Main { public static void main(String[] a) {} }' }];
+
+describe('speculativeBuildCommand', () => {
+  it('should plan the same cpp key as the run and stop before executing', () => {
+    const build = speculativeBuildCommand('cpp', cppFiles, 'main.cpp', { profile: 'release' })!;
+    const run = planCppBuild(cppFiles, 'main.cpp', { profile: 'release' });
+
+    expect(build.key).toBe(run.key);
+    expect(build.command.endsWith('; exit 0')).toBe(true);
+    expect(build.cppPlan).not.toBeNull();
+  });
+
+  it('should build java sources into their class cache entry', () => {
+    const build = speculativeBuildCommand('java', javaFiles, 'Main.java')!;
+
+    expect(build.key).toBe(javaBuildKey(javaFiles));
+    expect(build.command).toContain(`CR_JAVA_CLASSES=.coderunner/classes/${build.key}`);
+  });
+
+  it('should skip languages without a build step', () => {
+    expect(speculativeBuildCommand('python', [{ path: 'main.py', content: '' }], 'main.py')).toBeNull();
+  });
+});
+
+describe('SpeculativeBuildTracker', () => {
+  let tracker: SpeculativeBuildTracker;
+
+  beforeEach(() => {
+    tracker = new SpeculativeBuildTracker();
+  });
+
+  it('should deduplicate requests for sources already built or building', () => {
+    const build = tracker.request('s1', 'k1')!;
+    expect(tracker.request('s1', 'k1')).toBeNull();
+
+    tracker.start(build);
+    tracker.finish(build, 'built');
+    expect(tracker.request('s1', 'k1')).toBeNull();
+    expect(tracker.getStats()).toMatchObject({ requested: 1, deduplicated: 2, built: 1 });
+  });
+
+  it('should kill a running build superseded by newer sources', () => {
+    const first = tracker.request('s1', 'k1')!;
+    tracker.start(first);
+    const kill = jest.fn();
+    tracker.onKill(first, kill);
+
+    const second = tracker.request('s1', 'k2')!;
+
+    expect(kill).toHaveBeenCalled();
+    expect(first.cancelled).toBe(true);
+    expect(second.cancelled).toBe(false);
+    expect(tracker.getStats().superseded).toBe(1);
+  });
+
+  it('should let a run wait for the in-flight build of its sources', async () => {
+    const build = tracker.request('s1', 'k1')!;
+    tracker.start(build);
+
+    let settled = false;
+    const run = tracker.beforeRun('s1', 'k1').then((hit) => { settled = true; return hit; });
+    await Promise.resolve();
+    expect(settled).toBe(false);
+
+    tracker.finish(build, 'built');
+    await expect(run).resolves.toBe(true);
+    expect(tracker.getStats()).toMatchObject({ awaitedByRun: 1, usedByRun: 1 });
+  });
+
+  it('should stop a build of other sources before the run', async () => {
+    const build = tracker.request('s1', 'k1')!;
+    tracker.start(build);
+    tracker.onKill(build, () => tracker.finish(build, 'cancelled'));
+
+    await expect(tracker.beforeRun('s1', 'k2')).resolves.toBe(false);
+    expect(tracker.getStats()).toMatchObject({ superseded: 1, cancelled: 1 });
+  });
+
+  it('should drop queued builds for a run and not start builds during one', async () => {
+    const queued = tracker.request('s1', 'k1')!;
+    await expect(tracker.beforeRun('s1', 'k1')).resolves.toBe(false);
+    expect(tracker.start(queued)).toBe(false);
+
+    const during = tracker.request('s1', 'k2')!;
+    expect(tracker.start(during)).toBe(false);
+    expect(tracker.getStats().skipped).toBe(1);
+
+    tracker.runFinished('s1');
+    expect(tracker.start(tracker.request('s1', 'k3')!)).toBe(true);
+  });
+
+  it('should stop the build of a disconnected session', () => {
+    const build = tracker.request('s1', 'k1')!;
+    tracker.start(build);
+    const kill = jest.fn();
+    tracker.onKill(build, kill);
+
+    tracker.forget('s1');
+
+    expect(kill).toHaveBeenCalled();
+    expect(tracker.getStats().inFlight).toBe(0);
+  });
+});
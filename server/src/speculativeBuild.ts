@@ -0,0 +1,221 @@
+/**
+ * Speculative Builds
+ *
+ * For cpp and java files, the editor sends a `build` event on save or after
+ * typing pauses. The server uploads the sources to the session container and
+ * compiles them in the background. These builds take the lowest execution
+ * queue priority and are only accepted while no runs are waiting. A build fills
+ * the content-addressed caches (the cpp binary cache and the java class cache).
+ * Its diagnostics go straight back to the editor, so compile errors appear
+ * before Run is pressed.
+ *
+ * A Run of the same sources waits for a build that is still running, then only
+ * executes the cached artifact. A session has at most one speculative build. A
+ * newer build request or a Run of different sources supersedes it: a queued
+ * build is dropped and a running one is killed.
+ */
+
+import { filterCppFiles, planCppBuild, type BuildProfile, type CppBuildPlan } from './cppBuild';
+import { javaBuildKey, javaRunCommand } from './javaRunner';
+import type { FileEntry } from './dockerClient';
+
+/** Queue priority of speculative builds, below REST (1) and WebSocket (2) runs */
+export const SPECULATIVE_BUILD_PRIORITY = 0;
+
+/** Languages whose build step is worth starting early */
+export const SPECULATIVE_BUILD_LANGUAGES = ['cpp', 'java'];
+
+/** Diagnostics sent back to the editor are cut off after this many bytes */
+export const MAX_DIAGNOSTIC_BYTES = 64 * 1024;
+
+export type SpeculativeBuildOutcome = 'built' | 'failed' | 'cancelled' | 'skipped';
+
+export interface SpeculativeBuildCommand {
+  /** Build cache key; a run of the same sources plans the same key */
+  key: string;
+  command: string;
+  /** Files to upload (cpp builds only get the entry language's sources) */
+  files: FileEntry[];
+  cppPlan: CppBuildPlan | null;
+}
+
+export interface SpeculativeBuild {
+  readonly sessionId: string;
+  readonly key: string;
+  state: 'queued' | 'running' | 'finished';
+  cancelled: boolean;
+  /** Resolves once the build finished and released its container */
+  readonly done: Promise<void>;
+}
+
+interface TrackedBuild extends SpeculativeBuild {
+  kill: (() => void) | null;
+  resolve: () => void;
+}
+
+/**
+ * Build-only command for the sources, or null when the language has no build
+ * cache to fill (or caching is disabled).
+ */
+export function speculativeBuildCommand(
+  language: string,
+  files: FileEntry[],
+  entryPath: string,
+  options: { profile?: BuildProfile; reportDigest?: boolean } = {},
+): SpeculativeBuildCommand | null {
+  if (language === 'cpp') {
+    const sources = filterCppFiles(files, entryPath || undefined);
+    const cppPlan = planCppBuild(sources, entryPath, {
+      profile: options.profile,
+      reportDigest: options.reportDigest,
+      runWrapper: () => 'exit 0',
+    });
+    return cppPlan.key ? { key: cppPlan.key, command: cppPlan.command, files: sources, cppPlan } : null;
+  }
+  if (language === 'java') {
+    const key = javaBuildKey(files);
+    return key ? { key, command: javaRunCommand(entryPath, { key, buildOnly: true }), files, cppPlan: null } : null;
+  }
+  return null;
+}
+
+function emptyStats() {
+  return {
+    requested: 0,
+    deduplicated: 0,
+    started: 0,
+    superseded: 0,
+    built: 0,
+    failed: 0,
+    cancelled: 0,
+    skipped: 0,
+    /** Runs that waited for an in-flight build of their sources */
+    awaitedByRun: 0,
+    /** Runs whose artifact a speculative build had already produced */
+    usedByRun: 0,
+  };
+}
+
+export type SpeculativeBuildStats = ReturnType<typeof emptyStats>;
+
+export class SpeculativeBuildTracker {
+  private readonly builds = new Map<string, TrackedBuild>();
+  /** Last successful build per session, and whether a run already used it */
+  private readonly lastBuilt = new Map<string, { key: string; used: boolean }>();
+  /** Runs in progress per session; builds don't start while one holds the container */
+  private readonly activeRuns = new Map<string, number>();
+  private stats = emptyStats();
+
+  /**
+   * Register a build request. Returns null when it would be redundant, i.e.
+   * the same sources are already being built or were built last.
+   */
+  request(sessionId: string, key: string): SpeculativeBuild | null {
+    const current = this.builds.get(sessionId);
+    if ((current && current.key === key) || (!current && this.lastBuilt.get(sessionId)?.key === key)) {
+      this.stats.deduplicated++;
+      return null;
+    }
+    if (current) this.supersede(current);
+
+    let resolve!: () => void;
+    const done = new Promise<void>((r) => { resolve = r; });
+    const build: TrackedBuild = { sessionId, key, state: 'queued', cancelled: false, done, kill: null, resolve };
+    this.builds.set(sessionId, build);
+    this.stats.requested++;
+    return build;
+  }
+
+  /**
+   * Called when the build's queue slot opens. False means it must not run: it
+   * was superseded, or a run of the session holds the container.
+   */
+  start(build: SpeculativeBuild): boolean {
+    if (build.cancelled || (this.activeRuns.get(build.sessionId) ?? 0) > 0) {
+      this.finish(build, build.cancelled ? 'cancelled' : 'skipped');
+      return false;
+    }
+    build.state = 'running';
+    this.stats.started++;
+    return true;
+  }
+
+  /** Register how to stop the running build; runs it at once if already superseded */
+  onKill(build: SpeculativeBuild, kill: () => void): void {
+    if (build.cancelled) {
+      kill();
+      return;
+    }
+    (build as TrackedBuild).kill = kill;
+  }
+
+  finish(build: SpeculativeBuild, outcome: SpeculativeBuildOutcome): void {
+    const tracked = build as TrackedBuild;
+    if (tracked.state === 'finished') return;
+    tracked.state = 'finished';
+    tracked.kill = null;
+    if (this.builds.get(build.sessionId) === tracked) this.builds.delete(build.sessionId);
+    if (outcome === 'built' && !build.cancelled) {
+      this.lastBuilt.set(build.sessionId, { key: build.key, used: false });
+    }
+    this.stats[outcome]++;
+    tracked.resolve();
+  }
+
+  /**
+   * Called before a run acquires its container. Waits for a running build of
+   * the same sources; a build of other sources is stopped first. Resolves true
+   * when a speculative build left the run's artifact in the cache.
+   */
+  async beforeRun(sessionId: string, key: string): Promise<boolean> {
+    this.activeRuns.set(sessionId, (this.activeRuns.get(sessionId) ?? 0) + 1);
+    const current = this.builds.get(sessionId);
+    if (current) {
+      if (current.state === 'running' && current.key === key) {
+        this.stats.awaitedByRun++;
+      } else {
+        this.supersede(current);
+      }
+      // Queued builds are dropped without waiting; they never got a container
+      if (current.state === 'running') await current.done;
+    }
+    const last = this.lastBuilt.get(sessionId);
+    const hit = key !== '' && last?.key === key;
+    if (hit && last && !last.used) {
+      last.used = true;
+      this.stats.usedByRun++;
+    }
+    return hit;
+  }
+
+  runFinished(sessionId: string): void {
+    const runs = (this.activeRuns.get(sessionId) ?? 0) - 1;
+    if (runs > 0) this.activeRuns.set(sessionId, runs);
+    else this.activeRuns.delete(sessionId);
+  }
+
+  /** Drop all state of a disconnected session, stopping its build */
+  forget(sessionId: string): void {
+    const current = this.builds.get(sessionId);
+    if (current) this.supersede(current);
+    this.lastBuilt.delete(sessionId);
+    this.activeRuns.delete(sessionId);
+  }
+
+  getStats(): SpeculativeBuildStats & { inFlight: number } {
+    return { ...this.stats, inFlight: this.builds.size };
+  }
+
+  resetStats(): void {
+    this.stats = emptyStats();
+  }
+
+  private supersede(build: TrackedBuild): void {
+    build.cancelled = true;
+    this.builds.delete(build.sessionId);
+    this.stats.superseded++;
+    build.kill?.();
+  }
+}
+
+export const speculativeBuilds = new SpeculativeBuildTracker();
@@ -0,0 +1,186 @@
+/**
+ * Tests for the test-case run mode
+ * Covers case validation, the cr-judge commands and reading back its results,
+ * plus the real cr-judge built with the host cc (skipped without one).
+ */
+
+import { execFileSync, spawnSync } from 'child_process';
+import { chmodSync, existsSync, mkdirSync, mkdtempSync, readFileSync, rmSync, writeFileSync } from 'fs';
+import { tmpdir } from 'os';
+import { dirname, join } from 'path';
+
+jest.mock('./dockerClient', () => ({
+  ...jest.requireActual('./dockerClient'),
+  readFile: jest.fn(),
+}));
+
+import { config } from './config';
+import * as dockerClient from './dockerClient';
+import {
+  collectTestCases,
+  compileErrorSummary,
+  parseJudgeResults,
+  parseTestCases,
+  testCaseCommand,
+  testCaseFiles,
+  testCaseRunWrapper,
+  testCaseTimeoutMs,
+  withTestCaseReset,
+  JUDGE_PATH,
+  TEST_CASE_DIR,
+  type TestCase,
+} from './testCases';
+
+const readFile = dockerClient.readFile as jest.Mock;
+
+const containerKb = dockerClient.parseMemoryString(config.docker.memory) / 1024;
+
+describe('parseTestCases', () => {
+  it('should apply the default limits', () => {
+    const cases = parseTestCases([{ stdin: '1 2\n', expectedStdout: '3\n' }]);
+    expect(cases).toEqual([{
+      stdin: '1 2\n',
+      expectedStdout: '3\n',
+      timeLimitMs: config.testCases.defaultTimeLimitMs,
+      memoryLimitKb: Math.min(dockerClient.parseMemoryString(config.testCases.defaultMemoryLimit) / 1024, containerKb),
+    }]);
+  });
+
+  it('should cap limits at the configured maximum and the container memory', () => {
+    const [c] = parseTestCases([{ timeLimitMs: 1e9, memoryLimit: '64g' }]) as TestCase[];
+    expect(c.timeLimitMs).toBe(config.testCases.maxTimeLimitMs);
+    expect(c.memoryLimitKb).toBe(containerKb);
+    expect(c.stdin).toBe('');
+  });
+
+  it('should read plain memory numbers as megabytes', () => {
+    const [c] = parseTestCases([{ memoryLimit: 32 }]) as TestCase[];
+    expect(c.memoryLimitKb).toBe(32 * 1024);
+  });
+
+  it('should reject invalid cases', () => {
+    expect(parseTestCases([])).toEqual(expect.stringContaining('non-empty'));
+    expect(parseTestCases([{ stdin: 5 }])).toEqual(expect.stringContaining('Test case 0'));
+    expect(parseTestCases([{}, { timeLimitMs: -1 }])).toEqual(expect.stringContaining('Test case 1'));
+    expect(parseTestCases([{ memoryLimit: 'lots' }])).toEqual(expect.stringContaining('memoryLimit'));
+    expect(parseTestCases(new Array(config.testCases.maxCases + 1).fill({}))).toEqual(expect.stringContaining('Too many'));
+  });
+});
+
+describe('testCaseFiles', () => {
+  it('should write a manifest line per case and expected outputs only where given', () => {
+    const files = testCaseFiles([
+      { stdin: 'a', expectedStdout: 'A', timeLimitMs: 1000, memoryLimitKb: 2048 },
+      { stdin: 'b', timeLimitMs: 500, memoryLimitKb: 1024 },
+    ]);
+    expect(files).toEqual([
+      { path: `${TEST_CASE_DIR}/manifest`, content: '1000 2048 1\n500 1024 0\n' },
+      { path: `${TEST_CASE_DIR}/0.in`, content: 'a' },
+      { path: `${TEST_CASE_DIR}/0.exp`, content: 'A' },
+      { path: `${TEST_CASE_DIR}/1.in`, content: 'b' },
+    ]);
+  });
+});
+
+describe('judge commands', () => {
+  it('should judge the cpp binary with the data limit', () => {
+    const command = testCaseRunWrapper('"$C/$K"', '.coderunner/cache/abc');
+    expect(command).toMatch(new RegExp(`^exec ${JUDGE_PATH} -d -o \\d+ ${TEST_CASE_DIR} \\d+ "\\$C/\\$K"$`));
+  });
+
+  it('should run interpreters without the data limit', () => {
+    expect(testCaseCommand('python', 'main.py')).toContain(`${TEST_CASE_DIR} 1 python -u 'main.py'`);
+    expect(testCaseCommand('javascript', 'index.js')).not.toContain(' -d ');
+  });
+
+  it('should compile java once and judge cold runs from the class cache', () => {
+    const command = testCaseCommand('java', 'src/Main.java', 'k1');
+    expect(command).toContain('javac');
+    expect(command).toContain(`-cp ".coderunner/classes/k1:." 'Main'`);
+    expect(command).not.toContain('cr-java-run');
+  });
+
+  it('should clear old results before building', () => {
+    expect(withTestCaseReset('make')).toBe(`rm -f ${TEST_CASE_DIR}/results; make`);
+  });
+
+  it('should bound the exec timeout', () => {
+    const many = new Array(100).fill({ stdin: '', timeLimitMs: 10000, memoryLimitKb: 1 });
+    expect(testCaseTimeoutMs(many)).toBe(config.testCases.maxTotalMs);
+    expect(testCaseTimeoutMs([{ stdin: '', timeLimitMs: 1000, memoryLimitKb: 1 }])).toBe(31100);
+  });
+});
+
+describe('parseJudgeResults', () => {
+  it('should convert microseconds and skip malformed lines', () => {
+    const results = parseJudgeResults('accepted 1500 1200 2048 0 0\nbad line\ntime_limit 2000000 1999000 900 -1 9\n');
+    expect(results).toEqual([
+      { index: 0, verdict: 'accepted', timeMs: 1.5, cpuMs: 1.2, memoryKb: 2048, exitCode: 0 },
+      { index: 1, verdict: 'time_limit', timeMs: 2000, cpuMs: 1999, memoryKb: 900, exitCode: -1, signal: 9 },
+    ]);
+  });
+});
+
+describe('collectTestCases', () => {
+  beforeEach(() => readFile.mockReset());
+
+  it('should summarize verdicts and attach stderr of failed cases', async () => {
+    readFile.mockImplementation(async (_id: string, path: string) => {
+      if (path.endsWith('/results')) {
+        return Buffer.from('accepted 1 1 1 0 0\nwrong_answer 1 1 1 0 0\nruntime_error 1 1 1 1 0\n');
+      }
+      return path.endsWith('/2.err') ? Buffer.from('Traceback') : null;
+    });
+
+    const summary = await collectTestCases('c1', 3);
+    expect(summary).toMatchObject({ total: 3, passed: 1, verdicts: { accepted: 1, wrong_answer: 1, runtime_error: 1 } });
+    expect(summary!.cases[2].stderr).toBe('Traceback');
+    expect(summary!.cases[1].stderr).toBeUndefined();
+    expect(readFile).toHaveBeenCalledWith('c1', `/app/${TEST_CASE_DIR}/results`);
+  });
+
+  it('should return null when the judge never ran', async () => {
+    readFile.mockResolvedValue(null);
+    expect(await collectTestCases('c1', 2)).toBeNull();
+  });
+
+  it('should mark every case as a compile error', () => {
+    const summary = compileErrorSummary(parseTestCases([{}, {}]) as TestCase[]);
+    expect(summary).toMatchObject({ total: 2, passed: 0, verdicts: { compile_error: 2 } });
+  });
+});
+
+describe('cr-judge', () => {
+  const hasCc = spawnSync('cc', ['--version']).status === 0;
+  const judgeIt = hasCc ? it : it.skip;
+  let root: string;
+
+  beforeEach(() => {
+    root = mkdtempSync(join(tmpdir(), 'cr-judge-'));
+    // Cases may run under their own uids, which must still reach the program
+    chmodSync(root, 0o755);
+  });
+  afterEach(() => rmSync(root, { recursive: true, force: true }));
+
+  judgeIt('should keep expected outputs out of the judged program\'s reach', () => {
+    const judge = join(root, 'cr-judge');
+    execFileSync('cc', ['-O2', '-o', judge, join(__dirname, '../../runtimes/agent/cr-judge.c')]);
+    const cases = parseTestCases([
+      { stdin: 'cheat\n', expectedStdout: '42\n' },
+      { stdin: 'honest\n', expectedStdout: '42\n' },
+    ]) as TestCase[];
+    for (const file of testCaseFiles(cases)) {
+      mkdirSync(dirname(join(root, file.path)), { recursive: true });
+      writeFileSync(join(root, file.path), file.content);
+    }
+    const dir = join(root, TEST_CASE_DIR);
+    const program = `read mode; if [ "$mode" = cheat ]; then cat ${dir}/*.exp ${dir}/*.out; exit 0; else echo 42; fi`;
+
+    execFileSync(judge, ['-o', '65536', dir, '2', 'sh', '-c', program]);
+
+    const verdicts = parseJudgeResults(readFileSync(join(dir, 'results'), 'utf8')).map((r) => r.verdict);
+    expect(verdicts).toEqual(['wrong_answer', 'accepted']);
+    expect(existsSync(join(dir, '0.exp'))).toBe(false);
+    expect(existsSync(join(dir, '1.out'))).toBe(false);
+  });
+});
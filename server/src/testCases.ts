@@ -0,0 +1,257 @@
+/**
+ * Test-Case Run Mode
+ *
+ * Runs with `testCases` compile the program once and then run it against every
+ * case in the same exec via cr-judge (runtimes/agent/cr-judge.c). The judge
+ * feeds each case's stdin and enforces its time and memory limits. It compares
+ * stdout with the expected output in the container and writes one result line
+ * per case, so only verdicts, timings and short stderr previews come back to
+ * the server. Cases run in parallel, up to the container's CPU quota.
+ *
+ * cpp starts the judge from its build plan's run step (like benchmark runs).
+ * java compiles through the class cache and then judges cold `java` runs.
+ * python and javascript have no build step.
+ */
+
+import { config, containerCpuQuota } from './config';
+import { parseMemoryString, readFile, type FileEntry } from './dockerClient';
+import { COLD_JVM_FLAGS, JAVA_CLASS_CACHE_DIR, javaClassName, javaRunCommand } from './javaRunner';
+import type { RunWrapper } from './cppBuild';
+import { shellEscape } from './shell';
+
+/** Case inputs, outputs and results inside the container, relative to /app */
+export const TEST_CASE_DIR = '.coderunner/cases';
+
+/** cr-judge binary copied into every language image from agent-runtime */
+export const JUDGE_PATH = '/opt/coderunner/bin/cr-judge';
+
+export const TEST_CASE_LANGUAGES = ['python', 'javascript', 'cpp', 'java'];
+
+/** Cases whose stderr preview is read back */
+const MAX_STDERR_PREVIEWS = 10;
+
+export type TestCaseVerdict =
+  | 'accepted'
+  | 'wrong_answer'
+  /** Ran cleanly; the case had no expected output to compare with */
+  | 'ok'
+  | 'time_limit'
+  | 'memory_limit'
+  | 'output_limit'
+  | 'runtime_error'
+  | 'compile_error';
+
+export interface TestCase {
+  stdin: string;
+  expectedStdout?: string;
+  timeLimitMs: number;
+  memoryLimitKb: number;
+}
+
+export interface TestCaseResult {
+  index: number;
+  verdict: TestCaseVerdict;
+  timeMs: number;
+  cpuMs: number;
+  /** Peak resident memory */
+  memoryKb: number;
+  exitCode: number;
+  signal?: number;
+  /** Start of the case's stderr (failed cases only) */
+  stderr?: string;
+}
+
+export interface TestCaseSummary {
+  total: number;
+  /** accepted + ok */
+  passed: number;
+  verdicts: Partial<Record<TestCaseVerdict, number>>;
+  cases: TestCaseResult[];
+}
+
+function memoryLimitKb(value: unknown): number | null {
+  const containerKb = Math.floor(parseMemoryString(config.docker.memory) / 1024);
+  let bytes: number;
+  if (value === undefined) {
+    bytes = parseMemoryString(config.testCases.defaultMemoryLimit);
+  } else if (typeof value === 'number' && Number.isFinite(value) && value > 0) {
+    bytes = value * 1024 * 1024; // plain numbers are megabytes
+  } else if (typeof value === 'string' && /^\d+(b|k|m|g)?$/i.test(value)) {
+    bytes = parseMemoryString(value);
+  } else {
+    return null;
+  }
+  return Math.max(1, Math.min(Math.floor(bytes / 1024), containerKb));
+}
+
+/**
+ * Validate client-supplied test cases and apply the default and maximum limits.
+ * Returns an error message for invalid input.
+ */
+export function parseTestCases(value: unknown): TestCase[] | string {
+  if (!Array.isArray(value) || value.length === 0) {
+    return "'testCases' must be a non-empty array.";
+  }
+  if (value.length > config.testCases.maxCases) {
+    return `Too many test cases: ${value.length} (max: ${config.testCases.maxCases})`;
+  }
+
+  const cases: TestCase[] = [];
+  for (const [index, raw] of value.entries()) {
+    const stdin = raw?.stdin ?? '';
+    const expected = raw?.expectedStdout;
+    if (typeof stdin !== 'string' || (expected !== undefined && typeof expected !== 'string')) {
+      return `Test case ${index}: 'stdin' and 'expectedStdout' must be strings.`;
+    }
+    const time = raw?.timeLimitMs ?? config.testCases.defaultTimeLimitMs;
+    if (typeof time !== 'number' || !Number.isFinite(time) || time <= 0) {
+      return `Test case ${index}: 'timeLimitMs' must be a positive number.`;
+    }
+    const memory = memoryLimitKb(raw?.memoryLimit);
+    if (memory === null) {
+      return `Test case ${index}: 'memoryLimit' must be like "256m" or a number of megabytes.`;
+    }
+    cases.push({
+      stdin,
+      expectedStdout: expected,
+      timeLimitMs: Math.min(Math.ceil(time), config.testCases.maxTimeLimitMs),
+      memoryLimitKb: memory,
+    });
+  }
+  return cases;
+}
+
+/** Cases run at once: the container's CPU quota, at least one */
+export function judgeParallelism(): number {
+  return containerCpuQuota();
+}
+
+/**
+ * Manifest, inputs and expected outputs for cr-judge, uploaded with the run.
+ */
+export function testCaseFiles(cases: TestCase[]): FileEntry[] {
+  const manifest = cases
+    .map(c => `${c.timeLimitMs} ${c.memoryLimitKb} ${c.expectedStdout !== undefined ? 1 : 0}\n`)
+    .join('');
+  const files: FileEntry[] = [{ path: `${TEST_CASE_DIR}/manifest`, content: manifest }];
+  cases.forEach((c, i) => {
+    files.push({ path: `${TEST_CASE_DIR}/${i}.in`, content: c.stdin });
+    if (c.expectedStdout !== undefined) {
+      files.push({ path: `${TEST_CASE_DIR}/${i}.exp`, content: c.expectedStdout });
+    }
+  });
+  return files;
+}
+
+/**
+ * Run every case through cr-judge. `program` is the shell form of the command;
+ * `native` programs also get RLIMIT_DATA as a hard memory limit.
+ */
+function judgeCommand(program: string, native: boolean): string {
+  const limitData = native ? '-d ' : '';
+  return `exec ${JUDGE_PATH} ${limitData}-o ${config.testCases.outputLimitBytes} ` +
+    `${TEST_CASE_DIR} ${judgeParallelism()} ${program}`;
+}
+
+/**
+ * Clear the previous run's results first, so a failed build never reports
+ * stale verdicts.
+ */
+export function withTestCaseReset(command: string): string {
+  return `rm -f ${TEST_CASE_DIR}/results; ${command}`;
+}
+
+/** Run wrapper for planCppBuild that judges the built binary */
+export const testCaseRunWrapper: RunWrapper = (binary) => judgeCommand(binary, true);
+
+/**
+ * Command for a test-case run of the interpreted and JVM languages (cpp uses
+ * testCaseRunWrapper in its build plan).
+ */
+export function testCaseCommand(language: string, entryFile: string, javaKey = ''): string {
+  switch (language) {
+    case 'python': return judgeCommand(`python -u ${shellEscape(entryFile)}`, false);
+    case 'javascript': return judgeCommand(`node ${shellEscape(entryFile)}`, false);
+    case 'java': {
+      // Compile once into the class cache, then judge plain JVM runs of it
+      const classPath = javaKey ? `"${JAVA_CLASS_CACHE_DIR}/${javaKey}:."` : '.';
+      const build = javaRunCommand(entryFile, { key: javaKey, buildOnly: true, daemon: false });
+      const run = `java ${COLD_JVM_FLAGS} -cp ${classPath} ${shellEscape(javaClassName(entryFile))}`;
+      return `${build} && ${judgeCommand(run, false)}`;
+    }
+    default: throw new Error(`Test cases are not supported for ${language}`);
+  }
+}
+
+/**
+ * Exec timeout for a test-case run: all cases back to back at the judge's
+ * parallelism, plus room for compiling.
+ */
+export function testCaseTimeoutMs(cases: TestCase[]): number {
+  const caseMs = cases.reduce((sum, c) => sum + c.timeLimitMs + 100, 0) / judgeParallelism();
+  return Math.min(Math.ceil(caseMs) + 30_000, config.testCases.maxTotalMs);
+}
+
+/**
+ * Parse cr-judge result lines: "<verdict> <wall_us> <cpu_us> <maxrss_kb> <exit_code> <signal>".
+ */
+export function parseJudgeResults(text: string): TestCaseResult[] {
+  const results: TestCaseResult[] = [];
+  for (const line of text.split('\n')) {
+    const [verdict, ...rest] = line.trim().split(/\s+/);
+    const fields = rest.map(Number);
+    if (!verdict || fields.length !== 5 || fields.some(f => !Number.isFinite(f))) continue;
+    const [wallUs, cpuUs, memoryKb, exitCode, signal] = fields;
+    results.push({
+      index: results.length,
+      verdict: verdict as TestCaseVerdict,
+      timeMs: Math.round(wallUs / 100) / 10,
+      cpuMs: Math.round(cpuUs / 100) / 10,
+      memoryKb,
+      exitCode,
+      ...(signal ? { signal } : {}),
+    });
+  }
+  return results;
+}
+
+export function summarizeTestCases(cases: TestCaseResult[]): TestCaseSummary {
+  const verdicts: Partial<Record<TestCaseVerdict, number>> = {};
+  for (const c of cases) {
+    verdicts[c.verdict] = (verdicts[c.verdict] ?? 0) + 1;
+  }
+  return {
+    total: cases.length,
+    passed: (verdicts.accepted ?? 0) + (verdicts.ok ?? 0),
+    verdicts,
+    cases,
+  };
+}
+
+/**
+ * Every case marked as not compiled; the compiler's output is the run's stderr.
+ */
+export function compileErrorSummary(cases: TestCase[]): TestCaseSummary {
+  return summarizeTestCases(cases.map((_c, index) => ({
+    index, verdict: 'compile_error', timeMs: 0, cpuMs: 0, memoryKb: 0, exitCode: -1,
+  })));
+}
+
+/**
+ * Read the judge's results and the stderr of the first failed cases out of
+ * the container. Null when the judge never wrote results.
+ */
+export async function collectTestCases(containerId: string, count: number): Promise<TestCaseSummary | null> {
+  const text = await readFile(containerId, `/app/${TEST_CASE_DIR}/results`);
+  if (!text) return null;
+  const results = parseJudgeResults(text.toString('utf-8')).slice(0, count);
+
+  const failed = results
+    .filter(r => r.verdict === 'runtime_error' || r.verdict === 'memory_limit' || r.verdict === 'time_limit')
+    .slice(0, MAX_STDERR_PREVIEWS);
+  await Promise.all(failed.map(async (r) => {
+    const stderr = await readFile(containerId, `/app/${TEST_CASE_DIR}/${r.index}.err`).catch(() => null);
+    if (stderr && stderr.length > 0) r.stderr = stderr.toString('utf-8');
+  }));
+  return summarizeTestCases(results);
+}
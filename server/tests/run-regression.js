@@ -0,0 +1,170 @@
+#!/usr/bin/env node
+
+/**
+ * Performance Regression Suite
+ * Runs the program corpus in cold-container, warm-container and cached-build
+ * scenarios, compares per-stage p95 latencies against the newest baseline and
+ * exits non-zero if any language/stage regressed
+ *
+ * Usage: node run-regression.js [--server=URL] [--languages=a,b] [--scenarios=cold,warm,cached]
+ *        [--samples=N] [--threshold=PCT] [--min-delta=MS] [--baseline=VERSION]
+ *        [--save-baseline] [--label=TEXT]
+ */
+
+const { selectPrograms } = require('./utils/program-selector');
+const { runRegressionSuite, SCENARIOS } = require('./utils/regression-runner');
+const { generateReportId } = require('./utils/report-manager');
+const {
+    saveBaseline,
+    getBaseline,
+    compareToBaseline,
+    saveRun,
+    DEFAULT_THRESHOLD_PCT,
+    DEFAULT_MIN_DELTA_MS
+} = require('./utils/baseline-manager');
+
+// Parse command line arguments
+const args = process.argv.slice(2);
+const option = (name) => {
+    const arg = args.find(a => a.startsWith(`--${name}=`));
+    return arg ? arg.slice(name.length + 3) : undefined;
+};
+const list = (value) => value ? value.split(',').map(v => v.trim()).filter(Boolean) : undefined;
+
+const serverUrl = option('server') || 'http://localhost:3000';
+const languages = list(option('languages'));
+const scenarios = list(option('scenarios')) || SCENARIOS;
+const samples = parseInt(option('samples') || '5', 10);
+const thresholdPct = parseFloat(option('threshold') || String(DEFAULT_THRESHOLD_PCT));
+const minDeltaMs = parseFloat(option('min-delta') || String(DEFAULT_MIN_DELTA_MS));
+const baselineVersion = option('baseline') ? parseInt(option('baseline'), 10) : undefined;
+const shouldSaveBaseline = args.includes('--save-baseline');
+const label = option('label');
+
+/**
+ * Main execution function
+ */
+async function main() {
+    const unknown = scenarios.filter(s => !SCENARIOS.includes(s));
+    if (unknown.length > 0) {
+        throw new Error(`Unknown scenarios: ${unknown.join(', ')} (expected: ${SCENARIOS.join(', ')})`);
+    }
+
+    console.log('='.repeat(60));
+    console.log('       CodeRunner Performance Regression Suite');
+    console.log('='.repeat(60));
+    console.log(`\nConfiguration:`);
+    console.log(`  Server: ${serverUrl}`);
+    console.log(`  Scenarios: ${scenarios.join(', ')}`);
+    console.log(`  Samples: ${samples} per program and scenario`);
+    console.log(`  Threshold: p95 +${thresholdPct}% and +${minDeltaMs}ms`);
+    console.log('\n' + '-'.repeat(60));
+
+    // Step 1: Select the whole corpus
+    console.log('\nStep 1: Selecting test programs...');
+    const programs = selectPrograms('all', languages);
+    Object.entries(programs).forEach(([lang, p]) => {
+        console.log(`  ${lang}: ${p.length} program(s)`);
+    });
+
+    // Step 2: Run the scenarios
+    console.log('\nStep 2: Running scenarios...');
+    const timestamp = Date.now();
+    const results = await runRegressionSuite(programs, {
+        serverUrl,
+        samples,
+        scenarios,
+        onProgress: (progress) => {
+            console.log(`  Progress: ${progress.current}/${progress.total} tests completed`);
+        }
+    });
+
+    const run = {
+        id: generateReportId('regression'),
+        timestamp,
+        samples,
+        languages: Object.keys(programs),
+        scenarios,
+        results
+    };
+
+    // Step 3: Compare against the baseline
+    console.log('\n' + '-'.repeat(60));
+    console.log('\nStep 3: Comparing against baseline...');
+    const baseline = getBaseline(baselineVersion);
+    let comparison = null;
+    if (!baseline) {
+        if (baselineVersion !== undefined) {
+            throw new Error(`Baseline v${baselineVersion} not found`);
+        }
+        console.log('  No baseline yet; run with --save-baseline to record one.');
+    } else {
+        comparison = compareToBaseline(run, baseline, { thresholdPct, minDeltaMs });
+        displayComparison(comparison);
+    }
+
+    const runId = saveRun(run, comparison);
+    if (shouldSaveBaseline) {
+        const version = saveBaseline(run, label);
+        console.log(`\nSaved baseline v${version}`);
+    }
+
+    displayScenarioHealth(results);
+
+    console.log('\n' + '='.repeat(60));
+    console.log(`Regression ID: ${runId}`);
+    console.log(`View detailed results: server/tests/reports/regression/${runId}.json`);
+    console.log('='.repeat(60));
+
+    if (comparison && !comparison.passed) {
+        console.log(`\n✗ ${comparison.regressed} regression(s), ${comparison.missing} missing measurement(s) against baseline v${comparison.baselineVersion}\n`);
+        process.exit(1);
+    }
+    console.log('\n✓ Regression suite passed!\n');
+}
+
+/**
+ * Print the rows that changed beyond the threshold
+ * @param {Object} comparison
+ */
+function displayComparison(comparison) {
+    const changed = comparison.rows.filter(r => r.status !== 'unchanged');
+    console.log(`  Baseline: v${comparison.baselineVersion}`);
+    console.log(`  Compared: ${comparison.rows.length} language/scenario/stage p95 values`);
+
+    if (changed.length === 0) {
+        console.log('  No changes beyond the threshold.');
+        return;
+    }
+
+    console.log('');
+    console.log(`  ${'Language'.padEnd(12)}${'Scenario'.padEnd(10)}${'Stage'.padEnd(16)}${'Base'.padStart(8)}${'Now'.padStart(8)}${'Delta'.padStart(10)}  Status`);
+    changed.forEach(r => {
+        const delta = r.deltaPct !== null ? `${r.deltaPct > 0 ? '+' : ''}${r.deltaPct}%` : '-';
+        console.log(
+            `  ${r.language.padEnd(12)}${r.scenario.padEnd(10)}${r.stage.padEnd(16)}` +
+            `${String(r.baselineP95 ?? '-').padStart(8)}${String(r.currentP95 ?? '-').padStart(8)}` +
+            `${delta.padStart(10)}  ${r.status.toUpperCase()}`
+        );
+    });
+}
+
+/**
+ * Print failed runs and runs that missed their scenario's conditions
+ * @param {Object} results
+ */
+function displayScenarioHealth(results) {
+    Object.entries(results).forEach(([language, byScenario]) => {
+        Object.entries(byScenario).forEach(([scenario, r]) => {
+            if (r.errors > 0 || r.mismatches > 0) {
+                console.log(`  Warning: ${language}/${scenario}: ${r.errors} failed run(s), ${r.mismatches} run(s) outside the scenario`);
+            }
+        });
+    });
+}
+
+// Run the main function
+main().catch(error => {
+    console.error('\n✗ Error running regression suite:', error);
+    process.exit(1);
+});
@@ -3,8 +3,6 @@
  * Executes HTTP load tests using autocannon
  */
 
-const autocannon = require('autocannon');
-
 const INTENSITY_PRESETS = {
     light: {
         connections: 10,
@@ -64,6 +62,8 @@ function buildRequestBody(program) {
  * @returns {Promise<Object>} Test results
  */
 async function runSingleTest(program, intensity, serverUrl = 'http://localhost:3000') {
+    // Loaded here so the request helpers work without autocannon installed
+    const autocannon = require('autocannon');
     const body = buildRequestBody(program);
     
     // Use language-specific timeout (in ms), fallback to 30s if not defined
@@ -239,5 +239,7 @@ async function runLoadTest(programs, intensityLevel = 'moderate', onProgress = n
 module.exports = {
     runLoadTest,
     runSingleTest,
-    INTENSITY_PRESETS
+    buildRequestBody,
+    INTENSITY_PRESETS,
+    LANGUAGE_TIMEOUTS
 };
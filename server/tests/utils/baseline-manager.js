@@ -0,0 +1,250 @@
+/**
+ * Baseline Manager Utility
+ * Stores versioned performance baselines and regression runs, and compares
+ * a run's per-stage p95 latencies against a baseline
+ */
+
+const fs = require('fs');
+const path = require('path');
+const { execSync } = require('child_process');
+const { REPORTS_DIR, generateReportId } = require('./report-manager');
+
+const BASELINES_DIR = path.join(__dirname, '../baselines');
+const BASELINE_MANIFEST = path.join(BASELINES_DIR, 'manifest.json');
+const RUNS_DIR = path.join(REPORTS_DIR, 'regression');
+const RUN_MANIFEST = path.join(RUNS_DIR, 'manifest.json');
+
+/** Keep at most this many runs; baselines are never pruned */
+const MAX_RUNS = 50;
+
+/** A p95 rise of more than this percentage is a regression... */
+const DEFAULT_THRESHOLD_PCT = 20;
+/** ...if it is also more than this many milliseconds (ignores jitter on tiny stages) */
+const DEFAULT_MIN_DELTA_MS = 25;
+
+function readJson(file, fallback) {
+    if (!fs.existsSync(file)) {
+        return fallback;
+    }
+    try {
+        return JSON.parse(fs.readFileSync(file, 'utf8'));
+    } catch (error) {
+        console.error(`Error reading ${file}:`, error);
+        return fallback;
+    }
+}
+
+function writeJson(file, data) {
+    fs.mkdirSync(path.dirname(file), { recursive: true });
+    fs.writeFileSync(file, JSON.stringify(data, null, 2));
+}
+
+/**
+ * Short commit hash of the server tree, if it is a git checkout
+ * @returns {string|null}
+ */
+function currentCommit() {
+    try {
+        return execSync('git rev-parse --short HEAD', { cwd: __dirname, stdio: ['ignore', 'pipe', 'ignore'] })
+            .toString().trim();
+    } catch {
+        return null;
+    }
+}
+
+/**
+ * Save suite results as the next baseline version
+ * @param {Object} run - Regression run (results, samples, languages, scenarios)
+ * @param {string} [label] - Why the baseline was taken
+ * @returns {number} Baseline version
+ */
+function saveBaseline(run, label) {
+    const manifest = readJson(BASELINE_MANIFEST, []);
+    const version = manifest.reduce((max, b) => Math.max(max, b.version), 0) + 1;
+    const baseline = {
+        version,
+        timestamp: Date.now(),
+        label: label || null,
+        commit: currentCommit(),
+        runId: run.id || null,
+        samples: run.samples,
+        languages: run.languages,
+        scenarios: run.scenarios,
+        results: run.results
+    };
+
+    writeJson(path.join(BASELINES_DIR, `baseline-v${version}.json`), baseline);
+    manifest.push({
+        version,
+        timestamp: baseline.timestamp,
+        date: new Date(baseline.timestamp).toISOString(),
+        label: baseline.label,
+        commit: baseline.commit,
+        languages: baseline.languages
+    });
+    writeJson(BASELINE_MANIFEST, manifest);
+    return version;
+}
+
+/**
+ * Get all baselines metadata
+ * @returns {Array}
+ */
+function getBaselines() {
+    return readJson(BASELINE_MANIFEST, []);
+}
+
+/**
+ * Get a baseline by version, or the newest one
+ * @param {number} [version]
+ * @returns {Object|null}
+ */
+function getBaseline(version) {
+    const manifest = getBaselines();
+    if (version === undefined) {
+        if (manifest.length === 0) return null;
+        version = manifest.reduce((max, b) => Math.max(max, b.version), 0);
+    }
+    return readJson(path.join(BASELINES_DIR, `baseline-v${version}.json`), null);
+}
+
+/**
+ * Compare a run's p95 per language, scenario and stage against a baseline
+ * @param {Object} run - Regression run
+ * @param {Object} baseline
+ * @param {Object} [options]
+ * @param {number} [options.thresholdPct]
+ * @param {number} [options.minDeltaMs]
+ * @returns {Object} Comparison with one row per language/scenario/stage
+ */
+function compareToBaseline(run, baseline, options = {}) {
+    const thresholdPct = options.thresholdPct ?? DEFAULT_THRESHOLD_PCT;
+    const minDeltaMs = options.minDeltaMs ?? DEFAULT_MIN_DELTA_MS;
+    const rows = [];
+
+    const keys = new Set();
+    for (const source of [run.results, baseline.results]) {
+        for (const [language, scenarios] of Object.entries(source)) {
+            // Only what this run set out to measure
+            if (!run.languages.includes(language)) continue;
+            for (const [scenario, result] of Object.entries(scenarios)) {
+                if (!run.scenarios.includes(scenario)) continue;
+                for (const stage of Object.keys(result.stages)) {
+                    keys.add(`${language}/${scenario}/${stage}`);
+                }
+            }
+        }
+    }
+
+    for (const key of keys) {
+        const [language, scenario, stage] = key.split('/');
+        const current = run.results[language]?.[scenario]?.stages[stage];
+        const base = baseline.results[language]?.[scenario]?.stages[stage];
+        const row = {
+            language,
+            scenario,
+            stage,
+            baselineP95: base ? base.p95 : null,
+            currentP95: current ? current.p95 : null,
+            deltaMs: null,
+            deltaPct: null,
+            status: 'unchanged'
+        };
+
+        if (!base) {
+            row.status = 'new';
+        } else if (!current) {
+            // Measured before but not now: every run failed or none met the scenario
+            row.status = 'missing';
+        } else {
+            row.deltaMs = current.p95 - base.p95;
+            row.deltaPct = base.p95 > 0 ? Math.round((row.deltaMs / base.p95) * 1000) / 10 : null;
+            const bound = Math.max((base.p95 * thresholdPct) / 100, minDeltaMs);
+            if (row.deltaMs > bound) row.status = 'regressed';
+            else if (-row.deltaMs > bound) row.status = 'improved';
+        }
+        rows.push(row);
+    }
+
+    rows.sort((a, b) =>
+        a.language.localeCompare(b.language) ||
+        a.scenario.localeCompare(b.scenario) ||
+        a.stage.localeCompare(b.stage));
+
+    const count = status => rows.filter(r => r.status === status).length;
+    return {
+        baselineVersion: baseline.version,
+        thresholdPct,
+        minDeltaMs,
+        regressed: count('regressed'),
+        missing: count('missing'),
+        improved: count('improved'),
+        passed: count('regressed') === 0 && count('missing') === 0,
+        rows
+    };
+}
+
+/**
+ * Save a regression run together with its comparison
+ * @param {Object} run - Regression run
+ * @param {Object|null} comparison
+ * @returns {string} Run ID
+ */
+function saveRun(run, comparison) {
+    const id = run.id || generateReportId('regression');
+    writeJson(path.join(RUNS_DIR, `${id}.json`), { ...run, id, comparison });
+
+    const manifest = readJson(RUN_MANIFEST, []);
+    manifest.push({
+        id,
+        timestamp: run.timestamp,
+        date: new Date(run.timestamp).toISOString(),
+        languages: run.languages,
+        scenarios: run.scenarios,
+        baselineVersion: comparison ? comparison.baselineVersion : null,
+        passed: comparison ? comparison.passed : null,
+        regressed: comparison ? comparison.regressed : 0
+    });
+
+    if (manifest.length > MAX_RUNS) {
+        const removed = manifest.shift();
+        const oldFile = path.join(RUNS_DIR, `${removed.id}.json`);
+        if (fs.existsSync(oldFile)) {
+            fs.unlinkSync(oldFile);
+        }
+    }
+    writeJson(RUN_MANIFEST, manifest);
+    return id;
+}
+
+/**
+ * Get all regression runs metadata
+ * @returns {Array}
+ */
+function getRuns() {
+    return readJson(RUN_MANIFEST, []);
+}
+
+/**
+ * Get a regression run by ID
+ * @param {string} runId
+ * @returns {Object|null}
+ */
+function getRun(runId) {
+    if (!/^regression-\d{8}-\d{6}$/.test(runId)) {
+        return null;
+    }
+    return readJson(path.join(RUNS_DIR, `${runId}.json`), null);
+}
+
+module.exports = {
+    saveBaseline,
+    getBaselines,
+    getBaseline,
+    compareToBaseline,
+    saveRun,
+    getRuns,
+    getRun,
+    DEFAULT_THRESHOLD_PCT,
+    DEFAULT_MIN_DELTA_MS
+};
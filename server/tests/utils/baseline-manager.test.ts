@@ -0,0 +1,77 @@
+/**
+ * Tests for the performance regression suite helpers
+ * Covers stage percentiles, scenario checks and baseline comparison.
+ */
+
+const { compareToBaseline } = require('./baseline-manager');
+const { matchesScenario, scenariosFor, summarizeStages, withNonce } = require('./regression-runner');
+
+const stages = (p95: Record<string, number>) =>
+  Object.fromEntries(Object.entries(p95).map(([stage, value]) => [stage, { count: 10, mean: value, p50: value, p95: value, p99: value }]));
+
+const run = (results: Record<string, Record<string, Record<string, number>>>) => ({
+  languages: Object.keys(results),
+  scenarios: ['cold', 'warm', 'cached'],
+  results: Object.fromEntries(Object.entries(results).map(([language, byScenario]) => [
+    language,
+    Object.fromEntries(Object.entries(byScenario).map(([scenario, p95]) => [scenario, { stages: stages(p95) }])),
+  ])),
+});
+
+describe('summarizeStages', () => {
+  it('should take nearest-rank percentiles of each reported stage', () => {
+    const samples = Array.from({ length: 20 }, (_, i) => ({ totalMs: i + 1, compileMs: i < 10 ? 100 : undefined }));
+    const summary = summarizeStages(samples);
+    expect(summary.totalMs).toEqual({ count: 20, mean: 11, p50: 10, p95: 19, p99: 20 });
+    expect(summary.compileMs.count).toBe(10);
+    expect(summary.networkMs).toBeUndefined();
+  });
+});
+
+describe('scenarios', () => {
+  it('should only run the cached-build scenario for languages with a build cache', () => {
+    expect(scenariosFor('python')).toEqual(['cold', 'warm']);
+    expect(scenariosFor('cpp')).toEqual(['cold', 'warm', 'cached']);
+  });
+
+  it('should reject samples that missed the scenario conditions', () => {
+    expect(matchesScenario('cold', { containerReused: true }, 'python')).toBe(false);
+    expect(matchesScenario('warm', { containerReused: true, buildCache: 'hit' }, 'cpp')).toBe(false);
+    expect(matchesScenario('warm', { containerReused: true, buildCache: 'miss' }, 'cpp')).toBe(true);
+    expect(matchesScenario('cached', { containerReused: true, buildCache: 'host' }, 'java')).toBe(false);
+  });
+
+  it('should vary sources with a comment in the language syntax', () => {
+    expect(withNonce({ language: 'python', content: 'print(1)' }, 'n1').content).toBe('print(1)\n# regression run n1\n');
+    expect(withNonce({ language: 'cpp', content: 'int main() {}\n' }, 'n1').content).toBe('int main() {}\n// regression run n1\n');
+  });
+});
+
+describe('compareToBaseline', () => {
+  const baseline = { version: 3, ...run({ cpp: { cold: { totalMs: 1000, networkMs: 10, compileMs: 500 } } }) };
+
+  it('should flag p95 rises beyond both the percentage and absolute threshold', () => {
+    const current = run({ cpp: { cold: { totalMs: 1300, networkMs: 30, compileMs: 550 } } });
+    const comparison = compareToBaseline(current, baseline, { thresholdPct: 20, minDeltaMs: 25 });
+    const status = Object.fromEntries(comparison.rows.map((r: any) => [r.stage, r.status]));
+    // networkMs tripled but only by 20ms
+    expect(status).toEqual({ compileMs: 'unchanged', networkMs: 'unchanged', totalMs: 'regressed' });
+    expect(comparison).toMatchObject({ baselineVersion: 3, regressed: 1, passed: false });
+    expect(comparison.rows.find((r: any) => r.stage === 'totalMs')).toMatchObject({ deltaMs: 300, deltaPct: 30 });
+  });
+
+  it('should fail on stages the baseline measured but the run did not', () => {
+    const current = run({ cpp: { cold: { totalMs: 600, networkMs: 10 } } });
+    const comparison = compareToBaseline(current, baseline);
+    expect(comparison.rows.find((r: any) => r.stage === 'compileMs').status).toBe('missing');
+    expect(comparison.rows.find((r: any) => r.stage === 'totalMs').status).toBe('improved');
+    expect(comparison.passed).toBe(false);
+  });
+
+  it('should ignore languages the run did not select', () => {
+    const current = run({ python: { cold: { totalMs: 100 } } });
+    const comparison = compareToBaseline(current, baseline);
+    expect(comparison.rows).toEqual([expect.objectContaining({ language: 'python', status: 'new' })]);
+    expect(comparison.passed).toBe(true);
+  });
+});
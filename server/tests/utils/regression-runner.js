@@ -0,0 +1,297 @@
+/**
+ * Regression Runner
+ * Runs the test program corpus in fixed scenarios and collects the server's
+ * per-stage pipeline timings for each run
+ *
+ * Scenarios:
+ *   cold   - every run is a new /api/run session, so it gets its own container
+ *   warm   - runs share one batch lane (one container); each run differs, so
+ *            nothing is served from the build cache
+ *   cached - runs share one batch lane and send identical sources, so cpp and
+ *            java runs hit the build cache
+ *
+ * Runs are sent one at a time so the timings are not skewed by queueing.
+ */
+
+const { buildRequestBody, LANGUAGE_TIMEOUTS } = require('./autocannon-runner');
+
+const SCENARIOS = ['cold', 'warm', 'cached'];
+
+/** Languages with a build cache (cpp binaries, java classes) */
+const CACHED_BUILD_LANGUAGES = ['cpp', 'java'];
+
+/** Pipeline stages reported by the server (PipelineTimings in server/src/pipelineMetrics.ts) */
+const STAGES = [
+    'queueMs',
+    'networkMs',
+    'containerMs',
+    'fileTransferMs',
+    'executionMs',
+    'compileMs',
+    'runMs',
+    'cleanupMs',
+    'totalMs'
+];
+
+const COMMENT_PREFIX = {
+    python: '#',
+    javascript: '//',
+    java: '//',
+    cpp: '//'
+};
+
+/**
+ * Scenarios that apply to a language
+ * @param {string} language
+ * @param {string[]} [scenarios] - Requested scenarios (default: all)
+ * @returns {string[]}
+ */
+function scenariosFor(language, scenarios = SCENARIOS) {
+    return scenarios.filter(s => s !== 'cached' || CACHED_BUILD_LANGUAGES.includes(language));
+}
+
+/**
+ * Append a comment so the sources (and their build cache key) are unique
+ * @param {Object} program - Program object from program-selector
+ * @param {string} nonce
+ * @returns {Object} Program with changed content
+ */
+function withNonce(program, nonce) {
+    const prefix = COMMENT_PREFIX[program.language] || '//';
+    const content = program.content.endsWith('\n') ? program.content : `${program.content}\n`;
+    return { ...program, content: `${content}${prefix} regression run ${nonce}\n` };
+}
+
+/**
+ * Request body for one run, asking the server for its pipeline timings
+ * @param {Object} program
+ * @returns {Object}
+ */
+function runBody(program) {
+    return { ...buildRequestBody(program), timings: true };
+}
+
+/**
+ * POST JSON with a timeout
+ * @returns {Promise<Response>}
+ */
+async function post(url, body, timeoutMs) {
+    return fetch(url, {
+        method: 'POST',
+        headers: {
+            'Content-Type': 'application/json',
+            'X-Load-Test': 'true'
+        },
+        body: JSON.stringify(body),
+        signal: AbortSignal.timeout(timeoutMs)
+    });
+}
+
+/**
+ * Turn one run's result into a sample, or null if the run failed
+ * @param {Object} result - /api/run response or batch result line
+ * @returns {Object|null}
+ */
+function toSample(result) {
+    if (!result || result.error || !result.pipeline || result.exitCode !== 0) {
+        return null;
+    }
+    return result.pipeline;
+}
+
+/**
+ * Run the program in new sessions, one request per sample
+ * @returns {Promise<Object[]>} Results, one per sample
+ */
+async function runCold(program, samples, serverUrl, timeoutMs) {
+    const results = [];
+    for (let i = 0; i < samples; i++) {
+        const body = runBody(withNonce(program, `cold-${Date.now()}-${i}`));
+        try {
+            const res = await post(`${serverUrl}/api/run`, body, timeoutMs);
+            results.push(await res.json());
+        } catch (error) {
+            results.push({ error: error.message });
+        }
+    }
+    return results;
+}
+
+/**
+ * Run the program as one single-lane batch. The first job only warms the lane's
+ * container (and for `identical`, the build cache) and is not reported.
+ * @returns {Promise<Object[]>} Results of the measured jobs
+ */
+async function runInOneLane(program, samples, serverUrl, timeoutMs, identical) {
+    const tag = `lane-${Date.now()}`;
+    const jobs = [];
+    for (let i = 0; i <= samples; i++) {
+        const nonce = identical ? tag : `${tag}-${i}`;
+        jobs.push({ id: String(i), ...runBody(withNonce(program, nonce)) });
+    }
+
+    let lines;
+    try {
+        const res = await post(`${serverUrl}/api/run/batch`, { jobs, lanes: 1 }, timeoutMs * jobs.length);
+        if (!res.ok) {
+            const body = await res.json().catch(() => ({}));
+            return new Array(samples).fill({ error: body.error || `HTTP ${res.status}` });
+        }
+        lines = (await res.text()).split('\n').filter(Boolean).map(line => JSON.parse(line));
+    } catch (error) {
+        return new Array(samples).fill({ error: error.message });
+    }
+
+    return lines
+        .filter(line => !line.done && line.index !== 0)
+        .sort((a, b) => a.index - b.index);
+}
+
+/**
+ * Whether a sample ran under the conditions its scenario promises
+ * @param {string} scenario
+ * @param {Object} sample - Pipeline timings
+ * @param {string} language
+ * @returns {boolean}
+ */
+function matchesScenario(scenario, sample, language) {
+    const compiled = CACHED_BUILD_LANGUAGES.includes(language);
+    switch (scenario) {
+        case 'cold':
+            return !sample.containerReused;
+        case 'warm':
+            return sample.containerReused && (!compiled || sample.buildCache !== 'hit');
+        case 'cached':
+            return sample.containerReused && sample.buildCache === 'hit';
+        default:
+            return true;
+    }
+}
+
+/**
+ * Nearest-rank percentile of sorted values
+ * @param {number[]} sorted
+ * @param {number} p - Percentile (0-100)
+ * @returns {number}
+ */
+function percentile(sorted, p) {
+    if (sorted.length === 0) return 0;
+    const rank = Math.ceil((p / 100) * sorted.length);
+    return sorted[Math.min(sorted.length, Math.max(1, rank)) - 1];
+}
+
+/**
+ * Percentiles of each stage over a set of samples
+ * @param {Object[]} samples - Pipeline timings
+ * @returns {Object} Map of stage to {count, mean, p50, p95, p99}
+ */
+function summarizeStages(samples) {
+    const stages = {};
+    for (const stage of STAGES) {
+        const values = samples
+            .map(s => s[stage])
+            .filter(v => typeof v === 'number')
+            .sort((a, b) => a - b);
+        if (values.length === 0) continue;
+        stages[stage] = {
+            count: values.length,
+            mean: Math.round(values.reduce((a, b) => a + b, 0) / values.length),
+            p50: percentile(values, 50),
+            p95: percentile(values, 95),
+            p99: percentile(values, 99)
+        };
+    }
+    return stages;
+}
+
+/**
+ * Run one scenario for every program of a language
+ * @returns {Promise<Object>} Scenario result with per-stage percentiles
+ */
+async function runScenario(language, programs, scenario, samples, serverUrl) {
+    const timeoutMs = LANGUAGE_TIMEOUTS[language] || 30000;
+    const measured = [];
+    const containerSources = {};
+    let errors = 0;
+    let mismatches = 0;
+
+    for (const program of programs) {
+        console.log(`  Running ${scenario} scenario: ${program.name}`);
+        const results = scenario === 'cold'
+            ? await runCold(program, samples, serverUrl, timeoutMs)
+            : await runInOneLane(program, samples, serverUrl, timeoutMs, scenario === 'cached');
+
+        for (const result of results) {
+            const sample = toSample(result);
+            if (!sample) {
+                errors++;
+                continue;
+            }
+            // Runs that didn't get the scenario's conditions would blur its numbers
+            if (!matchesScenario(scenario, sample, language)) {
+                mismatches++;
+                continue;
+            }
+            if (sample.containerSource) {
+                containerSources[sample.containerSource] = (containerSources[sample.containerSource] || 0) + 1;
+            }
+            measured.push(sample);
+        }
+    }
+
+    return {
+        programs: programs.map(p => p.name),
+        samples: measured.length,
+        errors,
+        mismatches,
+        containerSources,
+        stages: summarizeStages(measured)
+    };
+}
+
+/**
+ * Run the regression suite
+ * @param {Object} programs - Map of language to program array (selectPrograms('all'))
+ * @param {Object} options
+ * @param {string} [options.serverUrl]
+ * @param {number} [options.samples] - Measured runs per program and scenario
+ * @param {string[]} [options.scenarios]
+ * @param {Function} [options.onProgress]
+ * @returns {Promise<Object>} Map of language to scenario to result
+ */
+async function runRegressionSuite(programs, options = {}) {
+    const serverUrl = options.serverUrl || 'http://localhost:3000';
+    const samples = options.samples || 5;
+    const scenarios = options.scenarios || SCENARIOS;
+
+    const plan = Object.entries(programs)
+        .filter(([, list]) => list.length > 0)
+        .flatMap(([language, list]) => scenariosFor(language, scenarios).map(scenario => ({ language, list, scenario })));
+
+    const results = {};
+    let completed = 0;
+    for (const { language, list, scenario } of plan) {
+        if (!results[language]) {
+            console.log(`\nTesting ${language}...`);
+            results[language] = {};
+        }
+        results[language][scenario] = await runScenario(language, list, scenario, samples, serverUrl);
+        completed++;
+        if (options.onProgress) {
+            options.onProgress({ language, scenario, current: completed, total: plan.length, status: 'running' });
+        }
+    }
+
+    return results;
+}
+
+module.exports = {
+    runRegressionSuite,
+    summarizeStages,
+    matchesScenario,
+    scenariosFor,
+    withNonce,
+    percentile,
+    SCENARIOS,
+    STAGES
+};
@@ -49,12 +49,13 @@ function writeManifest(manifest) {
 
 /**
  * Generate a report ID based on timestamp
- * @returns {string} Report ID in format "loadtest-YYYYMMDD-HHMMSS"
+ * @param {string} [prefix] - ID prefix
+ * @returns {string} Report ID in format "<prefix>-YYYYMMDD-HHMMSS"
  */
-function generateReportId() {
+function generateReportId(prefix = 'loadtest') {
     const now = new Date();
     const dateStr = now.toISOString().replace(/[-:]/g, '').replace('T', '-').split('.')[0];
-    return `loadtest-${dateStr}`;
+    return `${prefix}-${dateStr}`;
 }
 
 /**
@@ -276,6 +277,7 @@ function deleteReport(reportId) {
 }
 
 module.exports = {
+    REPORTS_DIR,
     saveReport,
     getReports,
     getReport,